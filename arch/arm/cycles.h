@@ -0,0 +1,117 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef ARM_CYCLES_H_
+#define ARM_CYCLES_H_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Public functions
+ *----------------------------------------------------------------------------*/
+
+/*
+ * Free-running 32-bit core cycle counter: PMCCNTR on ARMv7-A, DWT CYCCNT on
+ * ARMv7-M. The ARM926 (ARMv5TE) has none, arch_cycles_available() tells it.
+ */
+
+#if defined(CONFIG_ARCH_ARMV7A)
+
+static inline bool arch_cycles_available(void)
+{
+	return true;
+}
+
+static inline void arch_cycles_enable(void)
+{
+	uint32_t pmcr;
+
+	/* PMCR: E (enable) and C (cycle counter reset), no divider */
+	asm volatile("mrc p15, 0, %0, c9, c12, 0" : "=r"(pmcr));
+	pmcr = (pmcr & ~(1u << 3)) | (1u << 2) | (1u << 0);
+	asm volatile("mcr p15, 0, %0, c9, c12, 0" :: "r"(pmcr));
+	/* PMCNTENSET: cycle counter */
+	asm volatile("mcr p15, 0, %0, c9, c12, 1" :: "r"(1u << 31));
+}
+
+static inline uint32_t arch_cycles_read(void)
+{
+	uint32_t cycles;
+	asm volatile("mrc p15, 0, %0, c9, c13, 0" : "=r"(cycles));
+	return cycles;
+}
+
+#elif defined(CONFIG_ARCH_ARMV7M)
+
+#define ARCH_DEMCR      (*(volatile uint32_t*)0xE000EDFCu)
+#define ARCH_DWT_CTRL   (*(volatile uint32_t*)0xE0001000u)
+#define ARCH_DWT_CYCCNT (*(volatile uint32_t*)0xE0001004u)
+
+static inline bool arch_cycles_available(void)
+{
+	return true;
+}
+
+static inline void arch_cycles_enable(void)
+{
+	/* DEMCR.TRCENA then DWT_CTRL.CYCCNTENA */
+	ARCH_DEMCR |= 1u << 24;
+	ARCH_DWT_CYCCNT = 0;
+	ARCH_DWT_CTRL |= 1u << 0;
+}
+
+static inline uint32_t arch_cycles_read(void)
+{
+	return ARCH_DWT_CYCCNT;
+}
+
+#else
+
+static inline bool arch_cycles_available(void)
+{
+	return false;
+}
+
+static inline void arch_cycles_enable(void)
+{
+}
+
+static inline uint32_t arch_cycles_read(void)
+{
+	return 0;
+}
+
+#endif
+
+#endif /* ARM_CYCLES_H_ */
@@ -36,6 +36,23 @@
 
 #include <stdint.h>
 
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+#ifdef CONFIG_IRQ_TRACE
+/* Critical section tracking, see drivers/irq/irq_trace.h. The PC recorded
+ * is the address of the inlined masking code in the caller. */
+extern void irq_trace_masked(uint32_t pc);
+extern void irq_trace_unmasked(void);
+#define IRQ_TRACE_MASKED() \
+	do { uint32_t _pc; asm volatile("mov %0, pc" : "=r"(_pc)); irq_trace_masked(_pc); } while (0)
+#define IRQ_TRACE_UNMASKED() irq_trace_unmasked()
+#else
+#define IRQ_TRACE_MASKED() do {} while (0)
+#define IRQ_TRACE_UNMASKED() do {} while (0)
+#endif
+
 /*----------------------------------------------------------------------------
  *        Public functions
  *----------------------------------------------------------------------------*/
@@ -45,6 +62,7 @@
 static inline void arch_irq_enable(void)
 {
 	uint32_t cpsr;
+	IRQ_TRACE_UNMASKED();
 	asm("mrs %0, cpsr" : "=r"(cpsr));
 	asm("msr cpsr_c, %0" :: "r"(cpsr & ~0x80));
 }
@@ -54,30 +72,87 @@ static inline void arch_irq_disable(void)
 	uint32_t cpsr;
 	asm("mrs %0, cpsr" : "=r"(cpsr));
 	asm("msr cpsr_c, %0" :: "r"(cpsr | 0x80));
+	IRQ_TRACE_MASKED();
+}
+
+static inline uint32_t arch_irq_save(void)
+{
+	uint32_t cpsr;
+	asm("mrs %0, cpsr" : "=r"(cpsr));
+	asm("msr cpsr_c, %0" :: "r"(cpsr | 0x80) : "memory");
+	IRQ_TRACE_MASKED();
+	return cpsr & 0x80;
+}
+
+static inline void arch_irq_restore(uint32_t flags)
+{
+	uint32_t cpsr;
+	if (!flags)
+		IRQ_TRACE_UNMASKED();
+	asm("mrs %0, cpsr" : "=r"(cpsr));
+	asm("msr cpsr_c, %0" :: "r"((cpsr & ~0x80) | flags) : "memory");
 }
 
 #elif defined(CONFIG_ARCH_ARMV7A)
 
 static inline void arch_irq_enable(void)
 {
+	IRQ_TRACE_UNMASKED();
 	asm("cpsie if");
 }
 
 static inline void arch_irq_disable(void)
 {
 	asm("cpsid if");
+	IRQ_TRACE_MASKED();
+}
+
+static inline uint32_t arch_irq_save(void)
+{
+	uint32_t cpsr;
+	asm("mrs %0, cpsr" : "=r"(cpsr));
+	asm("cpsid if" ::: "memory");
+	IRQ_TRACE_MASKED();
+	return cpsr & 0xc0;
+}
+
+static inline void arch_irq_restore(uint32_t flags)
+{
+	uint32_t cpsr;
+	if (!(flags & 0x80))
+		IRQ_TRACE_UNMASKED();
+	asm("mrs %0, cpsr" : "=r"(cpsr));
+	asm("msr cpsr_c, %0" :: "r"((cpsr & ~0xc0) | flags) : "memory");
 }
 
 #elif defined(CONFIG_ARCH_ARMV7M)
 
 static inline void arch_irq_enable(void)
 {
+	IRQ_TRACE_UNMASKED();
 	asm("cpsie i");
 }
 
 static inline void arch_irq_disable(void)
 {
 	asm("cpsid i");
+	IRQ_TRACE_MASKED();
+}
+
+static inline uint32_t arch_irq_save(void)
+{
+	uint32_t primask;
+	asm("mrs %0, primask" : "=r"(primask));
+	asm("cpsid i" ::: "memory");
+	IRQ_TRACE_MASKED();
+	return primask;
+}
+
+static inline void arch_irq_restore(uint32_t flags)
+{
+	if (!flags)
+		IRQ_TRACE_UNMASKED();
+	asm("msr primask, %0" :: "r"(flags) : "memory");
 }
 
 #endif
@@ -39,6 +39,8 @@
 #include "callback.h"
 #include "chip.h"
 #include "dma/dma.h"
+#include "errno.h"
+#include "intmath.h"
 #include "mm/cache.h"
 #include "trace.h"
 
@@ -134,6 +136,106 @@ static void _configure_pdmic(struct _audio_desc *desc)
 }
 #endif
 
+/**
+ * Get the DMA resources used by the audio device for its configured
+ * direction: channel, transfer mutex, data register and data width.
+ */
+static int _audio_get_dma(struct _audio_desc *desc,
+		struct _dma_channel **channel, mutex_t **mutex,
+		struct _dma_cfg *cfg_dma, void **reg)
+{
+	switch (desc->type) {
+#if defined(CONFIG_HAVE_CLASSD)
+	case AUDIO_DEVICE_CLASSD:
+		if (desc->direction != AUDIO_DEVICE_PLAY)
+			return -ENOTSUP;
+		*channel = desc->device.classd.desc.tx.dma.channel;
+		*mutex = &desc->device.classd.desc.tx.mutex;
+		*cfg_dma = desc->device.classd.desc.tx.dma.cfg_dma;
+		*reg = (void*)&desc->device.classd.addr->CLASSD_THR;
+		if (desc->device.classd.desc.left_enable &&
+		    desc->device.classd.desc.right_enable)
+			cfg_dma->data_width = DMA_DATA_WIDTH_WORD;
+		else
+			cfg_dma->data_width = DMA_DATA_WIDTH_HALF_WORD;
+		return 0;
+#endif
+#if defined(CONFIG_HAVE_SSC)
+	case AUDIO_DEVICE_SSC:
+		if (desc->direction == AUDIO_DEVICE_PLAY) {
+			*channel = desc->device.ssc.desc.tx.dma.channel;
+			*mutex = &desc->device.ssc.desc.tx.mutex;
+			*cfg_dma = desc->device.ssc.desc.tx.dma.cfg_dma;
+			*reg = (void*)&desc->device.ssc.addr->SSC_THR;
+		} else {
+			*channel = desc->device.ssc.desc.rx.dma.channel;
+			*mutex = &desc->device.ssc.desc.rx.mutex;
+			*cfg_dma = desc->device.ssc.desc.rx.dma.cfg_dma;
+			*reg = (void*)&desc->device.ssc.addr->SSC_RHR;
+		}
+		if (desc->device.ssc.desc.slot_length == 8)
+			cfg_dma->data_width = DMA_DATA_WIDTH_BYTE;
+		else if (desc->device.ssc.desc.slot_length == 16)
+			cfg_dma->data_width = DMA_DATA_WIDTH_HALF_WORD;
+		else
+			cfg_dma->data_width = DMA_DATA_WIDTH_WORD;
+		return 0;
+#endif
+#if defined(CONFIG_HAVE_PDMIC)
+	case AUDIO_DEVICE_PDMIC:
+		if (desc->direction != AUDIO_DEVICE_RECORD)
+			return -ENOTSUP;
+		*channel = desc->device.pdmic.desc.rx.dma.channel;
+		*mutex = &desc->device.pdmic.desc.rx.mutex;
+		*cfg_dma = desc->device.pdmic.desc.rx.dma.cfg_dma;
+		*reg = (void*)&desc->device.pdmic.addr->PDMIC_CDR;
+		if (desc->device.pdmic.desc.dsp_size == PDMIC_CONVERTED_DATA_SIZE_32)
+			cfg_dma->data_width = DMA_DATA_WIDTH_WORD;
+		else
+			cfg_dma->data_width = DMA_DATA_WIDTH_HALF_WORD;
+		return 0;
+#endif
+	default:
+		return -ENODEV;
+	}
+}
+
+static inline uint8_t *_audio_stream_period(struct _audio_stream *stream,
+		uint32_t ptr)
+{
+	return stream->buffer + (ptr % stream->periods) * stream->period_size;
+}
+
+/**
+ * DMA callback, invoked at the end of each period of the circular list
+ */
+static int _audio_stream_dma_callback(void *arg, void *arg2)
+{
+	struct _audio_stream *stream = (struct _audio_stream *)arg;
+	uint32_t hw_ptr = stream->hw_ptr + 1;
+
+	stream->hw_ptr = hw_ptr;
+
+	if (stream->direction == AUDIO_DEVICE_PLAY) {
+		/* The DMA now reads period hw_ptr, which the application has
+		 * not filled. It is too late for that one, but the period
+		 * just completed is no longer read: silence it so that its
+		 * samples are not replayed on the next lap of the ring */
+		if ((int32_t)(stream->appl_ptr - hw_ptr) <= 0) {
+			uint8_t *period = _audio_stream_period(stream, hw_ptr - 1);
+			memset(period, 0, stream->period_size);
+			cache_clean_region(period, stream->period_size);
+			stream->xruns++;
+		}
+	} else {
+		/* The DMA now writes period hw_ptr, overwriting unread data */
+		if (hw_ptr - stream->appl_ptr >= stream->periods)
+			stream->xruns++;
+	}
+
+	return callback_call(&stream->callback, stream);
+}
+
 /**
  * Configure audio play/record
  */
@@ -495,3 +597,154 @@ void audio_sync_adjust(struct _audio_desc *desc, int32_t adjust)
 #endif
 #endif
 }
+
+int audio_stream_init(struct _audio_desc *desc, struct _audio_stream *stream,
+		void *buffer, uint32_t period_size, uint8_t periods,
+		struct _callback *cb)
+{
+	if (periods < 2 || periods > AUDIO_STREAM_MAX_PERIODS)
+		return -EINVAL;
+	if (period_size == 0 || (period_size % L1_CACHE_BYTES) != 0)
+		return -EINVAL;
+	if (((uint32_t)buffer % L1_CACHE_BYTES) != 0)
+		return -EINVAL;
+
+	memset(stream, 0, sizeof(*stream));
+	stream->direction = desc->direction;
+	stream->buffer = (uint8_t *)buffer;
+	stream->period_size = period_size;
+	stream->periods = periods;
+	if (cb)
+		callback_copy(&stream->callback, cb);
+	else
+		callback_set(&stream->callback, NULL, NULL);
+
+	return 0;
+}
+
+int audio_stream_start(struct _audio_desc *desc, struct _audio_stream *stream)
+{
+	struct _dma_channel *channel;
+	struct _dma_cfg cfg_dma;
+	struct _callback cb;
+	mutex_t *mutex;
+	void *reg;
+	uint32_t i;
+	int err;
+
+	err = _audio_get_dma(desc, &channel, &mutex, &cfg_dma, &reg);
+	if (err < 0)
+		return err;
+
+	if (!mutex_try_lock(mutex))
+		return -EBUSY;
+
+	for (i = 0; i < stream->periods; i++) {
+		uint8_t *period = stream->buffer + i * stream->period_size;
+
+		if (stream->direction == AUDIO_DEVICE_PLAY) {
+			stream->dma.cfg[i].saddr = period;
+			stream->dma.cfg[i].daddr = reg;
+		} else {
+			stream->dma.cfg[i].saddr = reg;
+			stream->dma.cfg[i].daddr = period;
+		}
+		stream->dma.cfg[i].len = stream->period_size >> cfg_dma.data_width;
+	}
+
+	stream->hw_ptr = 0;
+	if (stream->direction == AUDIO_DEVICE_PLAY) {
+		/* Play silence until the application catches up */
+		for (i = stream->appl_ptr; i < stream->periods; i++)
+			memset(_audio_stream_period(stream, i), 0, stream->period_size);
+		if (stream->appl_ptr == 0)
+			stream->appl_ptr = 1;
+		cache_clean_region(stream->buffer,
+				stream->periods * stream->period_size);
+	} else {
+		stream->appl_ptr = 0;
+		cache_invalidate_region(stream->buffer,
+				stream->periods * stream->period_size);
+	}
+
+	cfg_dma.loop = true;
+	err = dma_configure_transfer(channel, &cfg_dma, stream->dma.cfg,
+			stream->periods);
+	if (err < 0) {
+		mutex_unlock(mutex);
+		return err;
+	}
+	callback_set(&cb, _audio_stream_dma_callback, stream);
+	dma_set_callback(channel, &cb);
+
+	stream->dma.channel = channel;
+	stream->dma.mutex = mutex;
+	stream->running = true;
+
+	return dma_start_transfer(channel);
+}
+
+void audio_stream_stop(struct _audio_desc *desc, struct _audio_stream *stream)
+{
+	if (!stream->running)
+		return;
+
+	dma_stop_transfer(stream->dma.channel);
+	dma_reset_channel(stream->dma.channel);
+	stream->running = false;
+	stream->hw_ptr = 0;
+	stream->appl_ptr = 0;
+	mutex_unlock(stream->dma.mutex);
+}
+
+void *audio_stream_get_period(struct _audio_stream *stream)
+{
+	uint32_t hw_ptr = stream->hw_ptr;
+	uint8_t *period;
+
+	if (stream->direction == AUDIO_DEVICE_PLAY) {
+		/* After an underrun, skip the periods already played */
+		if (stream->running && (int32_t)(stream->appl_ptr - hw_ptr) <= 0)
+			stream->appl_ptr = hw_ptr + 1;
+		if (stream->appl_ptr - hw_ptr >= stream->periods)
+			return NULL;
+		return _audio_stream_period(stream, stream->appl_ptr);
+	} else {
+		/* After an overrun, drop the periods being overwritten */
+		if (hw_ptr - stream->appl_ptr >= stream->periods)
+			stream->appl_ptr = hw_ptr - (stream->periods - 1);
+		if (hw_ptr == stream->appl_ptr)
+			return NULL;
+		period = _audio_stream_period(stream, stream->appl_ptr);
+		cache_invalidate_region(period, stream->period_size);
+		return period;
+	}
+}
+
+void audio_stream_commit_period(struct _audio_stream *stream)
+{
+	if (stream->direction == AUDIO_DEVICE_PLAY)
+		cache_clean_region(_audio_stream_period(stream, stream->appl_ptr),
+				stream->period_size);
+	stream->appl_ptr++;
+}
+
+uint32_t audio_stream_get_avail(struct _audio_stream *stream)
+{
+	uint32_t hw_ptr = stream->hw_ptr;
+	int32_t queued;
+
+	if (stream->direction == AUDIO_DEVICE_PLAY) {
+		queued = (int32_t)(stream->appl_ptr - hw_ptr);
+		if (queued <= 0)
+			return stream->running ? stream->periods - 1 : stream->periods;
+		return stream->periods - queued;
+	} else {
+		return min_u32(hw_ptr - stream->appl_ptr, stream->periods - 1);
+	}
+}
+
+uint32_t audio_stream_get_xruns(struct _audio_stream *stream)
+{
+	return stream->xruns;
+}
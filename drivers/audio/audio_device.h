@@ -53,9 +53,13 @@
 #include "callback.h"
 #include "dma/dma.h"
 #include "gpio/pio.h"
+#include "mutex.h"
 
 #define AUDIO_PLAY_MAX_VOLUME    (100)
 
+/** Maximum number of periods in an audio stream ring */
+#define AUDIO_STREAM_MAX_PERIODS (16)
+
 /*------------------------------------------------------------------------------
  *        Types
  *----------------------------------------------------------------------------*/
@@ -145,6 +149,37 @@ struct _audio_desc {
 	uint16_t bits_per_sample;
 };
 
+/**
+ * Period-based audio stream.
+ *
+ * The buffer is split in periods chained in a circular DMA linked list.
+ * The DMA owns hw_ptr and the application owns appl_ptr; both are free
+ * running period counters, so the ring can be shared without locking.
+ */
+struct _audio_stream {
+	enum audio_device_direction direction;
+	/* Ring buffer, cache aligned, periods * period_size bytes */
+	uint8_t *buffer;
+	/* Period size in bytes, multiple of the cache line size */
+	uint32_t period_size;
+	/* Number of periods (2..AUDIO_STREAM_MAX_PERIODS) */
+	uint8_t periods;
+	bool running;
+	/* Periods completed by the DMA */
+	volatile uint32_t hw_ptr;
+	/* Periods filled (play) or consumed (record) by the application */
+	volatile uint32_t appl_ptr;
+	/* Periods lost by underrun (play) or overrun (record) */
+	volatile uint32_t xruns;
+	/* Called from the DMA interrupt at the end of each period */
+	struct _callback callback;
+	struct {
+		struct _dma_channel *channel;
+		mutex_t *mutex;
+		struct _dma_transfer_cfg cfg[AUDIO_STREAM_MAX_PERIODS];
+	} dma;
+};
+
 
 /*----------------------------------------------------------------------------
  *        Exported functions
@@ -204,4 +239,67 @@ extern bool audio_transfer_is_done(struct _audio_desc *desc);
  */
 extern void audio_sync_adjust(struct _audio_desc *desc, int32_t adjust);
 
+/**
+ * \brief Initialize a period-based stream on an audio device
+ * \param desc         Audio descriptor
+ * \param stream       Stream instance
+ * \param buffer       Ring buffer of periods * period_size bytes, cache aligned
+ * \param period_size  Period size in bytes, multiple of L1_CACHE_BYTES
+ * \param periods      Number of periods, 2 to AUDIO_STREAM_MAX_PERIODS
+ * \param cb           Optional callback invoked from the DMA interrupt
+ *                     each time a period has been played or recorded
+ * \return 0 on success, -EINVAL on bad parameters
+ */
+extern int audio_stream_init(struct _audio_desc *desc,
+		struct _audio_stream *stream, void *buffer,
+		uint32_t period_size, uint8_t periods, struct _callback *cb);
+
+/**
+ * \brief Start the circular DMA of a stream.
+ * For playback, periods committed before this call are played first and
+ * the remaining ones are filled with silence.
+ * \param desc     Audio descriptor
+ * \param stream   Stream instance
+ * \return 0 on success, -EBUSY if the device is already transferring
+ */
+extern int audio_stream_start(struct _audio_desc *desc,
+		struct _audio_stream *stream);
+
+/**
+ * \brief Stop the circular DMA of a stream
+ * \param desc     Audio descriptor
+ * \param stream   Stream instance
+ */
+extern void audio_stream_stop(struct _audio_desc *desc,
+		struct _audio_stream *stream);
+
+/**
+ * \brief Get the next period owned by the application, without copy.
+ * For playback this is the next free period to fill, for recording the
+ * oldest recorded period. The period must then be released with
+ * audio_stream_commit_period().
+ * \param stream   Stream instance
+ * \return Pointer to the period, or NULL if none is available
+ */
+extern void *audio_stream_get_period(struct _audio_stream *stream);
+
+/**
+ * \brief Hand the period returned by audio_stream_get_period() back to the
+ * DMA (filled for playback, consumed for recording)
+ * \param stream   Stream instance
+ */
+extern void audio_stream_commit_period(struct _audio_stream *stream);
+
+/**
+ * \brief Get the number of periods the application can access
+ * \param stream   Stream instance
+ */
+extern uint32_t audio_stream_get_avail(struct _audio_stream *stream);
+
+/**
+ * \brief Get the number of periods lost by underrun or overrun
+ * \param stream   Stream instance
+ */
+extern uint32_t audio_stream_get_xruns(struct _audio_stream *stream);
+
 #endif /* AUDIO_DEVICE_API_H */
@@ -0,0 +1,694 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "compiler.h"
+#include "crypto/aes_session.h"
+#ifdef CONFIG_HAVE_AES
+#include "crypto/aesd.h"
+#endif
+#include "errno.h"
+#include "intmath.h"
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+#define BLOCK_SIZE 16
+
+enum {
+	SESSION_IDLE,
+	SESSION_AAD,
+	SESSION_TEXT,
+	SESSION_TAIL,   /* engine only: a partial block ended the text */
+};
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+static struct _aes_job* _queue_head;
+static struct _aes_job* _queue_tail;
+
+static struct _aes_session* _last_session;
+static uint8_t _batch;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static bool _is_aligned(const void* p)
+{
+	return ((uint32_t)(uintptr_t)p & 3) == 0;
+}
+
+static bool _use_engine(const struct _aes_session* session)
+{
+	return session->aesd && !session->soft;
+}
+
+static void _store_be64(uint8_t* p, uint64_t v)
+{
+	int i;
+
+	for (i = 7; i >= 0; i--, v >>= 8)
+		p[i] = (uint8_t)v;
+}
+
+/* Advance the counter block by n blocks: 32-bit counter in GCM, 128-bit
+ * counter in CTR mode */
+static void _counter_add(struct _aes_session* session, uint32_t n)
+{
+	uint8_t* ctr = (uint8_t*)session->counter;
+	int last = session->mode == AES_SESSION_GCM ? 12 : 0;
+	int i;
+
+	for (i = BLOCK_SIZE - 1; i >= last && n; i--) {
+		n += ctr[i];
+		ctr[i] = (uint8_t)n;
+		n >>= 8;
+	}
+}
+
+#ifdef CONFIG_HAVE_AES
+static int _load(struct _aes_session* session)
+{
+	if (session->aesd->session.owner == session)
+		return 0;
+	return aesd_session_load(session->aesd, session,
+			session->mode == AES_SESSION_GCM ?
+				AESD_MODE_GCM : AESD_MODE_CTR,
+			session->encrypt, session->key,
+			(enum _aesd_key_size)((session->key_len - 16) / 8));
+}
+
+/* Cipher full blocks and a zero-padded last block (len gives the real
+ * length) with the engine. The engine counter is only 16-bit wide in CTR
+ * mode, the transfer is split where it would wrap. */
+static int _hw_crypt(struct _aes_session* session,
+		const struct _buffer* src, struct _buffer* dst,
+		uint8_t count, uint32_t len)
+{
+	struct _buffer s, d;
+	uint32_t blocks, room, size;
+	int err;
+
+	err = _load(session);
+	if (err < 0)
+		return err;
+
+	if (session->mode == AES_SESSION_GCM) {
+		err = aesd_session_crypt(session->aesd, session->counter,
+				session->hash, src, dst, count, len);
+		if (err == 0)
+			_counter_add(session, (len + BLOCK_SIZE - 1) / BLOCK_SIZE);
+		return err;
+	}
+
+	blocks = (len + BLOCK_SIZE - 1) / BLOCK_SIZE;
+	room = 0x10000 - (((const uint8_t*)session->counter)[14] << 8 |
+			  ((const uint8_t*)session->counter)[15]);
+	if (blocks <= room) {
+		err = aesd_session_crypt(session->aesd, session->counter,
+				NULL, src, dst, count, len);
+		if (err == 0)
+			_counter_add(session, blocks);
+		return err;
+	}
+
+	/* only single buffers are split */
+	if (count != 1)
+		return -EINVAL;
+	s = src[0];
+	d = dst[0];
+	while (len) {
+		size = min_u32(len, room * BLOCK_SIZE);
+		s.size = d.size = ROUND_UP_MULT(size, BLOCK_SIZE);
+		err = aesd_session_crypt(session->aesd, session->counter,
+				NULL, &s, &d, 1, size);
+		if (err < 0)
+			return err;
+		_counter_add(session, s.size / BLOCK_SIZE);
+		s.data += s.size;
+		d.data += d.size;
+		len -= size;
+		room = 0x10000;
+	}
+	return 0;
+}
+#endif
+
+static int _ghash(struct _aes_session* session, const void* data,
+		  uint32_t blocks)
+{
+#ifdef CONFIG_HAVE_AES
+	if (_use_engine(session)) {
+		int err = _load(session);
+		if (err < 0)
+			return err;
+		return aesd_session_ghash(session->aesd, session->hash,
+				data, blocks);
+	}
+#endif
+	aes_soft_ghash(&session->ghash, (uint8_t*)session->hash,
+			(const uint8_t*)data, blocks);
+	return 0;
+}
+
+/* Absorb bytes in the GHASH value, keeping incomplete blocks in the
+ * session until more data or _ghash_flush() */
+static int _ghash_update(struct _aes_session* session, const uint8_t* data,
+			 uint32_t len)
+{
+	uint32_t n;
+	int err;
+
+	while (len) {
+		if (session->partial_len == 0 && len >= BLOCK_SIZE &&
+		    (!_use_engine(session) || _is_aligned(data))) {
+			n = len / BLOCK_SIZE;
+			err = _ghash(session, data, n);
+			if (err < 0)
+				return err;
+			data += n * BLOCK_SIZE;
+			len -= n * BLOCK_SIZE;
+			continue;
+		}
+		n = min_u32(len, BLOCK_SIZE - session->partial_len);
+		memcpy((uint8_t*)session->partial + session->partial_len, data, n);
+		session->partial_len += n;
+		data += n;
+		len -= n;
+		if (session->partial_len == BLOCK_SIZE) {
+			session->partial_len = 0;
+			err = _ghash(session, session->partial, 1);
+			if (err < 0)
+				return err;
+		}
+	}
+	return 0;
+}
+
+static int _ghash_flush(struct _aes_session* session)
+{
+	if (session->partial_len == 0)
+		return 0;
+	memset((uint8_t*)session->partial + session->partial_len, 0,
+	       BLOCK_SIZE - session->partial_len);
+	session->partial_len = 0;
+	return _ghash(session, session->partial, 1);
+}
+
+static int _ghash_lengths(struct _aes_session* session, uint64_t a,
+			  uint64_t c)
+{
+	uint32_t block[BLOCK_SIZE / sizeof(uint32_t)];
+
+	_store_be64((uint8_t*)&block[0], a * 8);
+	_store_be64((uint8_t*)&block[2], c * 8);
+	return _ghash(session, block, 1);
+}
+
+static int _begin_text(struct _aes_session* session)
+{
+	int err;
+
+	if (session->state == SESSION_AAD) {
+		err = _ghash_flush(session);
+		if (err < 0)
+			return err;
+		session->state = SESSION_TEXT;
+	}
+	return session->state == SESSION_TEXT ? 0 : -EINVAL;
+}
+
+static void _soft_crypt(struct _aes_session* session, const uint8_t* in,
+			uint8_t* out, uint32_t len)
+{
+	bool gcm = session->mode == AES_SESSION_GCM;
+	uint8_t* ghash_state = (uint8_t*)session->hash;
+	uint8_t c;
+	int i;
+
+	while (len) {
+		/* key stream and GHASH stay in step: whole blocks are
+		 * processed without buffering */
+		if (session->stream_len == 0 && len >= BLOCK_SIZE) {
+			uint8_t ks[BLOCK_SIZE];
+
+			aes_soft_encrypt(&session->soft_key,
+					(const uint8_t*)session->counter, ks);
+			_counter_add(session, 1);
+			if (gcm && !session->encrypt)
+				aes_soft_ghash(&session->ghash, ghash_state,
+						in, 1);
+			for (i = 0; i < BLOCK_SIZE; i++)
+				out[i] = in[i] ^ ks[i];
+			if (gcm && session->encrypt)
+				aes_soft_ghash(&session->ghash, ghash_state,
+						out, 1);
+			in += BLOCK_SIZE;
+			out += BLOCK_SIZE;
+			len -= BLOCK_SIZE;
+			continue;
+		}
+
+		if (session->stream_len == 0) {
+			aes_soft_encrypt(&session->soft_key,
+					(const uint8_t*)session->counter,
+					(uint8_t*)session->stream);
+			_counter_add(session, 1);
+			session->stream_len = BLOCK_SIZE;
+		}
+		c = *in ^ ((uint8_t*)session->stream)[BLOCK_SIZE - session->stream_len];
+		session->stream_len--;
+		if (gcm)
+			_ghash_update(session, session->encrypt ? &c : in, 1);
+		*out++ = c;
+		in++;
+		len--;
+	}
+}
+
+static int _run_text(struct _aes_job* job)
+{
+	struct _aes_session* session = job->session;
+	uint8_t i;
+	int err;
+
+#ifdef CONFIG_HAVE_AES
+	/* chain the whole scatter list in one engine transfer when every
+	 * buffer but the last one holds complete blocks */
+	if (_use_engine(session) && job->count <= AESD_SESSION_MAX_SG) {
+		struct _buffer src[AESD_SESSION_MAX_SG];
+		struct _buffer dst[AESD_SESSION_MAX_SG];
+		uint32_t len = 0, tail;
+		uint8_t n = 0;
+		bool chain = true;
+
+		for (i = 0; i < job->count && chain; i++) {
+			if (!_is_aligned(job->src[i].data) ||
+			    !_is_aligned(job->dst[i].data) ||
+			    job->dst[i].size < job->src[i].size ||
+			    (i < job->count - 1 &&
+			     (job->src[i].size % BLOCK_SIZE)))
+				chain = false;
+			len += job->src[i].size;
+		}
+		if (chain && session->mode == AES_SESSION_CTR) {
+			const uint8_t* ctr = (const uint8_t*)session->counter;
+			chain = (len / BLOCK_SIZE) <=
+				0x10000 - (ctr[14] << 8 | ctr[15]);
+		}
+		if (chain && len) {
+			err = _begin_text(session);
+			if (err < 0)
+				return err;
+			tail = job->src[job->count - 1].size % BLOCK_SIZE;
+			for (i = 0; i < job->count; i++) {
+				src[n] = job->src[i];
+				dst[n].data = job->dst[i].data;
+				if (i == job->count - 1)
+					src[n].size -= tail;
+				dst[n].size = src[n].size;
+				if (src[n].size)
+					n++;
+			}
+			if (n) {
+				err = _hw_crypt(session, src, dst, n, len - tail);
+				if (err < 0)
+					return err;
+				session->text_len += len - tail;
+			}
+			if (tail) {
+				const struct _buffer* last = &job->src[job->count - 1];
+				return aes_session_update(session,
+						last->data + last->size - tail,
+						job->dst[job->count - 1].data + last->size - tail,
+						tail);
+			}
+			return 0;
+		}
+	}
+#endif
+
+	for (i = 0; i < job->count; i++) {
+		if (job->dst[i].size < job->src[i].size)
+			return -EINVAL;
+		err = aes_session_update(session, job->src[i].data,
+				job->dst[i].data, job->src[i].size);
+		if (err < 0)
+			return err;
+	}
+	return 0;
+}
+
+static int _run_job(struct _aes_job* job)
+{
+	struct _aes_session* session = job->session;
+	uint8_t i;
+	int err;
+
+	err = aes_session_start(session, job->iv, job->iv_len);
+	if (err < 0)
+		return err;
+	for (i = 0; i < job->aad_count; i++) {
+		err = aes_session_update_aad(session, job->aad[i].data,
+				job->aad[i].size);
+		if (err < 0)
+			return err;
+	}
+	err = _run_text(job);
+	if (err < 0) {
+		session->state = SESSION_IDLE;
+		return err;
+	}
+	return aes_session_finish(session, job->tag, job->tag_len);
+}
+
+/* Take the next job, preferring the session which ran last */
+static struct _aes_job* _pop_job(void)
+{
+	struct _aes_job *job = _queue_head, *prev = NULL;
+
+	if (_last_session && _batch < AES_SESSION_MAX_BATCH) {
+		for (; job; prev = job, job = job->next)
+			if (job->session == _last_session)
+				break;
+		if (!job) {
+			job = _queue_head;
+			prev = NULL;
+		}
+	}
+	if (!job)
+		return NULL;
+
+	if (prev)
+		prev->next = job->next;
+	else
+		_queue_head = job->next;
+	if (_queue_tail == job)
+		_queue_tail = prev;
+	job->next = NULL;
+
+	if (job->session == _last_session && _batch < AES_SESSION_MAX_BATCH) {
+		_batch++;
+	} else {
+		_last_session = job->session;
+		_batch = 1;
+	}
+	return job;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+int aes_session_init(struct _aes_session* session, struct _aesd_desc* aesd,
+		     enum _aes_session_mode mode, bool encrypt,
+		     const uint8_t* key, uint8_t key_len)
+{
+	int err;
+
+	if (mode != AES_SESSION_CTR && mode != AES_SESSION_GCM)
+		return -EINVAL;
+#ifndef CONFIG_HAVE_AES
+	if (aesd)
+		return -ENODEV;
+#elif !defined(CONFIG_HAVE_AES_GCM)
+	if (aesd && mode == AES_SESSION_GCM)
+		return -ENOTSUP;
+#endif
+
+	memset(session, 0, sizeof(*session));
+	err = aes_soft_set_key(&session->soft_key, key, key_len);
+	if (err < 0)
+		return err;
+	memcpy(session->key, key, key_len);
+	session->aesd = aesd;
+	session->mode = mode;
+	session->encrypt = encrypt;
+	session->key_len = key_len;
+
+	/* the GHASH table is also needed when the engine is bypassed */
+	if (mode == AES_SESSION_GCM) {
+		uint8_t h[BLOCK_SIZE];
+
+		memset(h, 0, sizeof(h));
+		aes_soft_encrypt(&session->soft_key, h, h);
+		aes_soft_ghash_init(&session->ghash, h);
+	}
+	return 0;
+}
+
+int aes_session_use_engine(struct _aes_session* session, bool engine)
+{
+	if (engine && !session->aesd)
+		return -ENODEV;
+	if (engine == !session->soft)
+		return 0;
+	/* the software key stream and GHASH buffers must be empty */
+	if (session->state == SESSION_TAIL ||
+	    (session->state == SESSION_TEXT &&
+	     (session->stream_len || session->partial_len)))
+		return -EBUSY;
+	session->soft = !engine;
+	return 0;
+}
+
+void aes_session_set_direction(struct _aes_session* session, bool encrypt)
+{
+	if (session->encrypt == encrypt)
+		return;
+#ifdef CONFIG_HAVE_AES
+	/* the direction is part of the engine configuration */
+	if (session->aesd && session->aesd->session.owner == session)
+		session->aesd->session.owner = NULL;
+#endif
+	session->encrypt = encrypt;
+}
+
+void aes_session_free(struct _aes_session* session)
+{
+#ifdef CONFIG_HAVE_AES
+	if (session->aesd && session->aesd->session.owner == session)
+		session->aesd->session.owner = NULL;
+#endif
+	memset(session, 0, sizeof(*session));
+}
+
+int aes_session_start(struct _aes_session* session, const uint8_t* iv,
+		      uint8_t iv_len)
+{
+	int err;
+
+	memset(session->hash, 0, sizeof(session->hash));
+	session->partial_len = 0;
+	session->stream_len = 0;
+	session->aad_len = 0;
+	session->text_len = 0;
+	session->state = SESSION_IDLE;
+
+	if (session->mode == AES_SESSION_CTR) {
+		if (iv_len != BLOCK_SIZE)
+			return -EINVAL;
+		memcpy(session->counter, iv, BLOCK_SIZE);
+		session->state = SESSION_TEXT;
+		return 0;
+	}
+
+	if (iv_len == 0)
+		return -EINVAL;
+	if (iv_len == 12) {
+		memcpy(session->j0, iv, 12);
+		session->j0[3] = 0;
+		((uint8_t*)session->j0)[15] = 1;
+	} else {
+		/* J0 = GHASH(IV || 0-padding || [len(IV)]64) */
+		err = _ghash_update(session, iv, iv_len);
+		if (err == 0)
+			err = _ghash_flush(session);
+		if (err == 0)
+			err = _ghash_lengths(session, 0, iv_len);
+		if (err < 0)
+			return err;
+		memcpy(session->j0, session->hash, BLOCK_SIZE);
+		memset(session->hash, 0, sizeof(session->hash));
+	}
+	memcpy(session->counter, session->j0, BLOCK_SIZE);
+	_counter_add(session, 1);
+	session->state = SESSION_AAD;
+	return 0;
+}
+
+int aes_session_update_aad(struct _aes_session* session, const uint8_t* aad,
+			   uint32_t len)
+{
+	if (session->state != SESSION_AAD)
+		return -EINVAL;
+	session->aad_len += len;
+	return _ghash_update(session, aad, len);
+}
+
+int aes_session_update(struct _aes_session* session, const uint8_t* in,
+		       uint8_t* out, uint32_t len)
+{
+	int err;
+
+	err = _begin_text(session);
+	if (err < 0)
+		return err;
+
+#ifdef CONFIG_HAVE_AES
+	if (_use_engine(session)) {
+		struct _buffer src, dst;
+		uint32_t block[BLOCK_SIZE / sizeof(uint32_t)];
+		uint32_t full = len & ~(BLOCK_SIZE - 1);
+		uint32_t tail = len - full;
+
+		if (!_is_aligned(in) || !_is_aligned(out))
+			return -EINVAL;
+		if (full) {
+			src.data = (uint8_t*)in;
+			src.size = full;
+			dst.data = out;
+			dst.size = full;
+			err = _hw_crypt(session, &src, &dst, 1, full);
+			if (err < 0)
+				return err;
+		}
+		if (tail) {
+			memset(block, 0, sizeof(block));
+			memcpy(block, in + full, tail);
+			src.data = dst.data = (uint8_t*)block;
+			src.size = dst.size = BLOCK_SIZE;
+			err = _hw_crypt(session, &src, &dst, 1, tail);
+			if (err < 0)
+				return err;
+			memcpy(out + full, block, tail);
+			session->state = SESSION_TAIL;
+		}
+		session->text_len += len;
+		return 0;
+	}
+#endif
+
+	_soft_crypt(session, in, out, len);
+	session->text_len += len;
+	return 0;
+}
+
+int aes_session_finish_tag(struct _aes_session* session, uint8_t* tag,
+			   uint8_t tag_len)
+{
+	uint8_t computed[BLOCK_SIZE];
+	uint8_t i;
+	int err;
+
+	if (session->state == SESSION_IDLE)
+		return -EINVAL;
+	session->state = SESSION_IDLE;
+	session->stream_len = 0;
+	memset(session->stream, 0, sizeof(session->stream));
+	if (session->mode == AES_SESSION_CTR)
+		return 0;
+
+	if (!tag || tag_len < 4 || tag_len > BLOCK_SIZE)
+		return -EINVAL;
+
+	err = _ghash_flush(session);
+	if (err == 0)
+		err = _ghash_lengths(session, session->aad_len,
+				session->text_len);
+	if (err < 0)
+		return err;
+
+	/* T = E(K, J0) ^ S, one block is cheaper in software than an
+	 * engine reconfiguration */
+	aes_soft_encrypt(&session->soft_key, (const uint8_t*)session->j0,
+			computed);
+	for (i = 0; i < tag_len; i++)
+		tag[i] = computed[i] ^ ((const uint8_t*)session->hash)[i];
+	return 0;
+}
+
+int aes_session_finish(struct _aes_session* session, uint8_t* tag,
+		       uint8_t tag_len)
+{
+	uint8_t computed[BLOCK_SIZE];
+	uint8_t diff = 0;
+	uint8_t i;
+	int err;
+
+	if (session->encrypt || session->mode == AES_SESSION_CTR)
+		return aes_session_finish_tag(session, tag, tag_len);
+
+	err = aes_session_finish_tag(session, tag ? computed : NULL, tag_len);
+	if (err < 0)
+		return err;
+	for (i = 0; i < tag_len; i++)
+		diff |= tag[i] ^ computed[i];
+	return diff ? -EBADMSG : 0;
+}
+
+int aes_session_submit(struct _aes_job* job)
+{
+	if (!job->session || (job->count && (!job->src || !job->dst)) ||
+	    (job->aad_count && !job->aad))
+		return -EINVAL;
+
+	job->status = -EINPROGRESS;
+	job->next = NULL;
+	if (_queue_tail)
+		_queue_tail->next = job;
+	else
+		_queue_head = job;
+	_queue_tail = job;
+	return 0;
+}
+
+uint32_t aes_session_process(void)
+{
+	struct _aes_job* job;
+	uint32_t done = 0;
+
+	while ((job = _pop_job()) != NULL) {
+		job->status = _run_job(job);
+		callback_call(&job->callback, job);
+		done++;
+	}
+	return done;
+}
@@ -0,0 +1,227 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef _AES_SESSION_H_
+#define _AES_SESSION_H_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "aes_soft.h"
+#include "callback.h"
+#include "io.h"
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Maximum number of consecutive jobs of one session run by
+ * aes_session_process() before the other sessions are served */
+#define AES_SESSION_MAX_BATCH 8
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+struct _aesd_desc;
+
+enum _aes_session_mode {
+	AES_SESSION_CTR,
+	AES_SESSION_GCM,
+};
+
+/** Streaming CTR/GCM context, see aes_session_init() */
+struct _aes_session {
+	struct _aesd_desc *aesd;        /**< Engine, NULL for the software path */
+	enum _aes_session_mode mode;
+	bool encrypt;
+	bool soft;                      /**< Engine bypassed */
+	uint8_t key_len;
+	uint8_t state;
+	uint32_t key[8];
+	struct _aes_soft_key soft_key;
+	struct _aes_soft_ghash ghash;   /**< GCM software path only */
+
+	uint32_t j0[4];                 /**< GCM pre-counter block */
+	uint32_t counter[4];            /**< Counter of the next block */
+	uint32_t hash[4];               /**< GHASH value */
+
+	uint32_t stream[4];             /**< Unused key stream */
+	uint8_t stream_len;
+	uint32_t partial[4];            /**< Data not yet absorbed by GHASH */
+	uint8_t partial_len;
+
+	uint64_t aad_len;
+	uint64_t text_len;
+};
+
+/** Complete CTR or GCM operation, see aes_session_submit() */
+struct _aes_job {
+	struct _aes_session *session;
+	const uint8_t *iv;
+	uint8_t iv_len;
+
+	const struct _buffer *aad;      /**< GCM additional data */
+	uint8_t aad_count;
+	const struct _buffer *src;      /**< Input text */
+	struct _buffer *dst;            /**< Output text, same sizes as src */
+	uint8_t count;
+
+	uint8_t *tag;                   /**< GCM tag, written on encryption and
+	                                     checked on decryption */
+	uint8_t tag_len;
+
+	struct _callback callback;      /**< Called with the job as argument */
+	int status;                     /**< -EINPROGRESS until completed */
+	struct _aes_job *next;
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initialize a session.
+ *
+ * The key is kept by the session. With an engine, the key is only loaded
+ * when another session (or aesd_transfer()) used the engine in between.
+ *
+ * \param session  Session to initialize.
+ * \param aesd     Initialized AES driver, or NULL to use the software
+ *                 implementation.
+ * \param mode     AES_SESSION_CTR or AES_SESSION_GCM.
+ * \param encrypt  Direction.
+ * \param key      Key.
+ * \param key_len  Key length in bytes: 16, 24 or 32.
+ * \return 0 on success, -EINVAL on invalid parameters.
+ */
+extern int aes_session_init(struct _aes_session *session,
+		struct _aesd_desc *aesd, enum _aes_session_mode mode,
+		bool encrypt, const uint8_t *key, uint8_t key_len);
+
+/**
+ * \brief Route the next operations of a session to its engine or to the
+ * software implementation. Both share the counter and GHASH state, the
+ * switch is possible between messages and within a message at a block
+ * boundary.
+ * \return 0 on success, -ENODEV without engine, -EBUSY in the middle of a
+ * block.
+ */
+extern int aes_session_use_engine(struct _aes_session *session, bool engine);
+
+/**
+ * \brief Change the direction of a session, before aes_session_start().
+ */
+extern void aes_session_set_direction(struct _aes_session *session,
+		bool encrypt);
+
+/**
+ * \brief Release a session: the engine forgets it and the key material is
+ * cleared.
+ */
+extern void aes_session_free(struct _aes_session *session);
+
+/**
+ * \brief Start a message.
+ * \param session  Session.
+ * \param iv       CTR: initial counter block (16 bytes). GCM: IV, the
+ *                 recommended length is 12 bytes.
+ * \param iv_len   IV length in bytes.
+ * \return 0 on success, negative error code otherwise.
+ */
+extern int aes_session_start(struct _aes_session *session,
+		const uint8_t *iv, uint8_t iv_len);
+
+/**
+ * \brief Add GCM additional authenticated data. All the AAD must be given
+ * before the text.
+ * \return 0 on success, negative error code otherwise.
+ */
+extern int aes_session_update_aad(struct _aes_session *session,
+		const uint8_t *aad, uint32_t len);
+
+/**
+ * \brief Cipher a chunk of the message.
+ *
+ * With the software implementation, chunks can have any length. With an
+ * engine, buffers must be word aligned and only the last chunk before
+ * aes_session_finish() can have a length which is not a multiple of 16.
+ *
+ * \param session  Session.
+ * \param in       Input text.
+ * \param out      Output text, may be equal to in.
+ * \param len      Length in bytes.
+ * \return 0 on success, negative error code otherwise.
+ */
+extern int aes_session_update(struct _aes_session *session,
+		const uint8_t *in, uint8_t *out, uint32_t len);
+
+/**
+ * \brief End a message. In GCM mode, the tag is written when encrypting and
+ * checked when decrypting.
+ * \param session  Session.
+ * \param tag      GCM tag, NULL in CTR mode.
+ * \param tag_len  Tag length in bytes, 4 to 16.
+ * \return 0 on success, -EBADMSG if the tag does not match, other negative
+ * error code otherwise.
+ */
+extern int aes_session_finish(struct _aes_session *session,
+		uint8_t *tag, uint8_t tag_len);
+
+/**
+ * \brief End a message and write the GCM tag in both directions, for
+ * callers which check the tag themselves.
+ * \return 0 on success, negative error code otherwise.
+ */
+extern int aes_session_finish_tag(struct _aes_session *session,
+		uint8_t *tag, uint8_t tag_len);
+
+/**
+ * \brief Queue a job. The queue is not protected against interrupts, jobs
+ * must be submitted from the context calling aes_session_process().
+ * \return 0 on success, -EINVAL on invalid job.
+ */
+extern int aes_session_submit(struct _aes_job *job);
+
+/**
+ * \brief Run the queued jobs.
+ *
+ * Jobs of the session which ran last are preferred, up to
+ * AES_SESSION_MAX_BATCH in a row, so that the engine key is reloaded as
+ * rarely as possible. Jobs of one session always complete in order.
+ *
+ * \return Number of jobs completed.
+ */
+extern uint32_t aes_session_process(void);
+
+#endif /* _AES_SESSION_H_ */
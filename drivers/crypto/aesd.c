@@ -40,6 +40,7 @@
 #include "crypto/aes.h"
 #include "crypto/aesd.h"
 #include "dma/dma.h"
+#include "errno.h"
 #include "irq/irq.h"
 #include "mm/cache.h"
 #include "peripherals/pmc.h"
@@ -245,6 +246,7 @@ uint32_t aesd_transfer(struct _aesd_desc* desc,
 	static uint32_t one[AES_BLOCK_SIZE / sizeof(uint32_t)] = {BIG_ENDIAN_TO_HOST(1), };
 #endif
 
+	desc->session.owner = NULL;
 	aes_soft_reset();
 	if (desc->cfg.mode != AESD_MODE_XTS) {
 		aes_set_op_mode(desc->cfg.mode);
@@ -402,6 +404,173 @@ void aesd_wait_transfer(struct _aesd_desc* desc)
 	}
 }
 
+/**
+ * \brief Load a session key in the engine.
+ *
+ * The key and mode stay loaded until another session is loaded or
+ * aesd_transfer() is used, the operations of the loaded session only write
+ * the IV and length registers.
+ *
+ * \param desc      AES driver descriptor.
+ * \param owner     Session loaded, recorded in desc->session.owner.
+ * \param mode      AESD_MODE_CTR or AESD_MODE_GCM.
+ * \param encrypt   Cipher direction.
+ * \param key       Key words.
+ * \param key_size  Key size.
+ * \return 0 on success, -EBUSY if the engine is in use.
+ */
+int aesd_session_load(struct _aesd_desc* desc, const void* owner,
+		       enum _aesd_mode mode, bool encrypt,
+		       const uint32_t* key, enum _aesd_key_size key_size)
+{
+	if (!mutex_try_lock(&desc->mutex))
+		return -EBUSY;
+
+	aes_soft_reset();
+	aes_set_op_mode(mode);
+	aes_encrypt_enable(encrypt);
+	aes_set_start_mode(AESD_TRANS_POLLING_AUTO);
+#ifdef CONFIG_HAVE_AES_GCM
+	aes_tag_enable(false);
+#endif
+	aes_set_key_size(key_size);
+	/* in GCM mode, the key write also computes the hash subkey */
+	_aesd_write_key((uint32_t*)key, key_size, mode == AESD_MODE_GCM);
+
+	desc->session.owner = owner;
+	desc->session.mode = mode;
+
+	mutex_unlock(&desc->mutex);
+	return 0;
+}
+
+/**
+ * \brief Absorb blocks in a GHASH value using the GCM engine.
+ *
+ * The data is given to the engine as additional authenticated data, with
+ * the hash registers preloaded with the current value.
+ *
+ * \param desc    AES driver descriptor, with a GCM session loaded.
+ * \param hash    GHASH value, updated.
+ * \param data    Blocks, word aligned.
+ * \param blocks  Number of 16-byte blocks.
+ * \return 0 on success, -ENOTSUP without GCM support.
+ */
+int aesd_session_ghash(struct _aesd_desc* desc, uint32_t* hash,
+		       const void* data, uint32_t blocks)
+{
+#ifdef CONFIG_HAVE_AES_GCM
+	const uint8_t* block = (const uint8_t*)data;
+
+	if (!mutex_try_lock(&desc->mutex))
+		return -EBUSY;
+
+	aes_set_start_mode(AESD_TRANS_POLLING_AUTO);
+	aes_set_aad_len(blocks * AES_BLOCK_SIZE);
+	aes_set_data_len(0);
+	aes_set_gcm_hash(hash);
+	for (; blocks; blocks--, block += AES_BLOCK_SIZE) {
+		aes_set_input((void*)block, AES_BLOCK_SIZE);
+		while ((aes_get_status() & AES_ISR_DATRDY) != AES_ISR_DATRDY);
+	}
+	aes_get_gcm_hash(hash);
+
+	mutex_unlock(&desc->mutex);
+	return 0;
+#else
+	return -ENOTSUP;
+#endif
+}
+
+/**
+ * \brief Cipher a scatter list with the loaded session.
+ *
+ * All the buffers are chained in a single DMA linked list, the engine is
+ * only given the IV (and the GHASH value in GCM mode) before the transfer.
+ * Each buffer size must be a multiple of AES_BLOCK_SIZE, the last block may
+ * be zero-padded in which case len gives the real data length.
+ *
+ * \param desc   AES driver descriptor, with a session loaded.
+ * \param iv     Counter block of the first block.
+ * \param hash   GCM: GHASH value, updated with the ciphertext. NULL in CTR
+ *               mode.
+ * \param src    Input buffers.
+ * \param dst    Output buffers, same sizes as the input buffers.
+ * \param count  Number of buffers, up to AESD_SESSION_MAX_SG.
+ * \param len    Data length in bytes.
+ * \return 0 on success, -EINVAL on invalid scatter list, -EBUSY if the
+ * engine is in use.
+ */
+int aesd_session_crypt(struct _aesd_desc* desc, const uint32_t* iv,
+		       uint32_t* hash, const struct _buffer* src,
+		       struct _buffer* dst, uint8_t count, uint32_t len)
+{
+	struct _dma_transfer_cfg tx[AESD_SESSION_MAX_SG];
+	struct _dma_transfer_cfg rx[AESD_SESSION_MAX_SG];
+	struct _dma_cfg cfg_dma;
+	uint8_t i;
+
+	if (count == 0 || count > AESD_SESSION_MAX_SG)
+		return -EINVAL;
+	for (i = 0; i < count; i++) {
+		if ((src[i].size % AES_BLOCK_SIZE) || dst[i].size != src[i].size)
+			return -EINVAL;
+	}
+	if (!mutex_try_lock(&desc->mutex))
+		return -EBUSY;
+
+	for (i = 0; i < count; i++) {
+		cache_clean_region(src[i].data, src[i].size);
+		cache_clean_region(dst[i].data, dst[i].size);
+		tx[i].saddr = src[i].data;
+		tx[i].daddr = (void*)AES->AES_IDATAR;
+		tx[i].len = src[i].size / sizeof(uint32_t);
+		rx[i].saddr = (void*)AES->AES_ODATAR;
+		rx[i].daddr = dst[i].data;
+		rx[i].len = dst[i].size / sizeof(uint32_t);
+	}
+
+	aes_set_start_mode(AESD_TRANS_DMA);
+#ifdef CONFIG_HAVE_AES_GCM
+	if (hash) {
+		aes_set_aad_len(0);
+		aes_set_data_len(len);
+		aes_set_gcm_hash(hash);
+	}
+#endif
+	aes_set_vector(iv);
+
+	memset(&cfg_dma, 0, sizeof(cfg_dma));
+	cfg_dma.data_width = DMA_DATA_WIDTH_WORD;
+	cfg_dma.chunk_size = DMA_CHUNK_SIZE_4;
+	cfg_dma.incr_saddr = true;
+	cfg_dma.incr_daddr = false;
+	dma_configure_transfer(desc->xfer.dma.tx.channel, &cfg_dma, tx, count);
+	dma_set_callback(desc->xfer.dma.tx.channel, NULL);
+	cfg_dma.incr_saddr = false;
+	cfg_dma.incr_daddr = true;
+	dma_configure_transfer(desc->xfer.dma.rx.channel, &cfg_dma, rx, count);
+	dma_set_callback(desc->xfer.dma.rx.channel, NULL);
+
+	dma_start_transfer(desc->xfer.dma.rx.channel);
+	dma_start_transfer(desc->xfer.dma.tx.channel);
+	while (!dma_is_transfer_done(desc->xfer.dma.rx.channel))
+		dma_poll();
+	dma_reset_channel(desc->xfer.dma.tx.channel);
+	dma_reset_channel(desc->xfer.dma.rx.channel);
+
+	for (i = 0; i < count; i++)
+		cache_invalidate_region(dst[i].data, dst[i].size);
+
+#ifdef CONFIG_HAVE_AES_GCM
+	if (hash)
+		aes_get_gcm_hash(hash);
+#endif
+
+	mutex_unlock(&desc->mutex);
+	return 0;
+}
+
 void aesd_init(struct _aesd_desc* desc)
 {
 	/* Enable peripheral clock */
@@ -53,6 +53,9 @@
 #define AES_BLOCK_SIZE       16
 #define IV_LENGTH_96         12
 
+/* Maximum number of buffers in a scatter list given to aesd_session_crypt() */
+#define AESD_SESSION_MAX_SG  16
+
 enum _aesd_trans_mode
 {
 	AESD_TRANS_POLLING_MANUAL = 0,
@@ -121,6 +124,12 @@ struct _aesd_desc {
 #ifdef CONFIG_HAVE_AES_GCM
 	uint8_t* buffer;
 #endif
+
+	/* session whose key is loaded in the engine, see aes_session.h */
+	struct {
+		const void *owner;
+		enum _aesd_mode mode;
+	} session;
 };
 
 /*------------------------------------------------------------------------------
@@ -140,4 +149,15 @@ extern bool aesd_is_busy(struct _aesd_desc* desc);
 
 extern void aesd_wait_transfer(struct _aesd_desc* desc);
 
+extern int aesd_session_load(struct _aesd_desc* desc, const void* owner,
+			     enum _aesd_mode mode, bool encrypt,
+			     const uint32_t* key, enum _aesd_key_size key_size);
+
+extern int aesd_session_ghash(struct _aesd_desc* desc, uint32_t* hash,
+			      const void* data, uint32_t blocks);
+
+extern int aesd_session_crypt(struct _aesd_desc* desc, const uint32_t* iv,
+			      uint32_t* hash, const struct _buffer* src,
+			      struct _buffer* dst, uint8_t count, uint32_t len);
+
 #endif /* AESD_HEADER__ */
@@ -0,0 +1,392 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "chip.h"
+#include "compiler.h"
+#include "errno.h"
+#include "intmath.h"
+#include "irq/irq.h"
+#include "mm/cache.h"
+
+#include "crypto/icm.h"
+#include "crypto/icm_monitor.h"
+
+#include <assert.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/* Main list, the start address is a multiple of 64 bytes */
+ALIGNED(64) static struct _icm_region_desc _icm_main_list[ICM_MONITOR_SLOTS];
+
+/* Hash area, the start address is a multiple of 128 bytes */
+ALIGNED(128) static uint32_t _icm_hash_area[ICM_MONITOR_SLOTS * 8];
+
+static struct _icm_monitor* _icm_owner;
+static uint8_t _icm_bbc;
+
+/* results accumulated by the interrupt handler during a pass */
+static uint8_t _icm_mismatch;
+static uint8_t _icm_bus_error;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static uint32_t _icm_rcfg_algo(enum _icm_monitor_algo algo)
+{
+	switch (algo) {
+	case ICM_MONITOR_SHA224:
+		return ICM_RCFG_ALGO_SHA224;
+	case ICM_MONITOR_SHA256:
+		return ICM_RCFG_ALGO_SHA256;
+	default:
+		return ICM_RCFG_ALGO_SHA1;
+	}
+}
+
+static uint8_t _icm_digest_words(enum _icm_monitor_algo algo)
+{
+	switch (algo) {
+	case ICM_MONITOR_SHA224:
+		return 7;
+	case ICM_MONITOR_SHA256:
+		return 8;
+	default:
+		return 5;
+	}
+}
+
+static void _icm_mark_dirty(struct _icm_monitor* mon, uint32_t start, uint32_t end)
+{
+	struct _icm_monitor_slice* slice;
+	uint16_t i;
+
+	for (i = 0; i < mon->num_slices; i++) {
+		slice = &mon->slices[i];
+		if (slice->addr >= end || slice->addr + slice->size <= start)
+			continue;
+		if (slice->state != ICM_MONITOR_SLICE_DIRTY) {
+			slice->state = ICM_MONITOR_SLICE_DIRTY;
+			mon->dirty++;
+		}
+	}
+}
+
+static void _icm_start_pass(struct _icm_monitor* mon)
+{
+	uint8_t slots;
+
+	mon->pass_count = icm_monitor_build_pass(mon, _icm_main_list, _icm_hash_area);
+	if (mon->pass_count == 0) {
+		mon->busy = false;
+		return;
+	}
+	mon->busy = true;
+	slots = (1 << mon->pass_count) - 1;
+	_icm_mismatch = 0;
+	_icm_bus_error = 0;
+
+	cache_clean_region(_icm_main_list, sizeof(_icm_main_list));
+	cache_clean_region(_icm_hash_area, sizeof(_icm_hash_area));
+
+	/* the descriptor and hash areas cannot change while the ICM is
+	 * enabled, reset it between passes */
+	icm_swrst();
+	icm_configure(ICM_CFG_SLBDIS | ICM_CFG_BBC(_icm_bbc));
+	icm_set_desc_address((uint32_t)_icm_main_list);
+	icm_set_hash_address((uint32_t)_icm_hash_area);
+	icm_enable_it(ICM_IER_RDM(slots) | ICM_IER_RBE(slots) | ICM_IER_REC(slots));
+	icm_enable_monitor(slots);
+	icm_enable();
+}
+
+static void _icm_handler(uint32_t source, void* user_arg)
+{
+	struct _icm_monitor* mon = _icm_owner;
+	uint32_t status;
+	uint8_t last;
+
+	assert(source == ID_ICM);
+
+	status = icm_get_int_status() & icm_get_int_mask();
+	_icm_mismatch |= (status & ICM_ISR_RDM_Msk) >> ICM_ISR_RDM_Pos;
+	_icm_bus_error |= (status & ICM_ISR_RBE_Msk) >> ICM_ISR_RBE_Pos;
+
+	if (!mon || !mon->busy)
+		return;
+
+	/* the pass ends with the End Of Monitoring descriptor, or on a bus
+	 * error as the ICM stops fetching the list */
+	last = 1 << (mon->pass_count - 1);
+	if (!(status & (last << ICM_ISR_REC_Pos)) && !_icm_bus_error)
+		return;
+
+	icm_disable_it(~0u);
+	icm_disable();
+	cache_invalidate_region(_icm_hash_area, sizeof(_icm_hash_area));
+	icm_monitor_complete_pass(mon, _icm_hash_area, _icm_mismatch, _icm_bus_error);
+
+	mon->busy = false;
+	if (mon->continuous && _icm_owner == mon)
+		_icm_start_pass(mon);
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+int icm_monitor_init(struct _icm_monitor* mon, uint32_t slice_size,
+		struct _callback* cb)
+{
+	if (slice_size == 0 || slice_size % ICM_MONITOR_BLOCK_SIZE ||
+	    slice_size > ICM_MONITOR_MAX_SLICE_SIZE)
+		return -EINVAL;
+
+	memset(mon, 0, sizeof(*mon));
+	mon->slice_size = slice_size;
+	if (cb)
+		callback_copy(&mon->callback, cb);
+	return 0;
+}
+
+int icm_monitor_add_region(struct _icm_monitor* mon, const void* addr,
+		uint32_t size, enum _icm_monitor_algo algo)
+{
+	struct _icm_monitor_region* region;
+	struct _icm_monitor_slice* slice;
+	uint32_t start = (uint32_t)addr;
+	uint32_t offset, count;
+
+	if (size == 0 || size % ICM_MONITOR_BLOCK_SIZE || start & 3 ||
+	    algo > ICM_MONITOR_SHA256)
+		return -EINVAL;
+	if (mon->num_regions >= ICM_MONITOR_MAX_REGIONS)
+		return -ENOMEM;
+	count = (size + mon->slice_size - 1) / mon->slice_size;
+	if (mon->num_slices + count > ICM_MONITOR_MAX_SLICES)
+		return -ENOMEM;
+
+	region = &mon->regions[mon->num_regions];
+	region->addr = start;
+	region->size = size;
+	region->algo = algo;
+	region->first_slice = mon->num_slices;
+	region->num_slices = count;
+	region->mismatches = 0;
+
+	for (offset = 0; offset < size; offset += mon->slice_size) {
+		slice = &mon->slices[mon->num_slices++];
+		slice->addr = start + offset;
+		slice->size = min_u32(size - offset, mon->slice_size);
+		slice->region = mon->num_regions;
+		slice->state = ICM_MONITOR_SLICE_DIRTY;
+		memset(slice->digest, 0, sizeof(slice->digest));
+		mon->dirty++;
+	}
+
+	cache_clean_region(addr, size);
+	return mon->num_regions++;
+}
+
+void icm_monitor_update(struct _icm_monitor* mon, const void* addr,
+		uint32_t len)
+{
+	uint32_t start = (uint32_t)addr;
+
+	cache_clean_region(addr, len);
+
+	irq_disable(ID_ICM);
+	_icm_mark_dirty(mon, start, start + len);
+	irq_enable(ID_ICM);
+}
+
+uint8_t icm_monitor_build_pass(struct _icm_monitor* mon,
+		struct _icm_region_desc* desc, uint32_t* hash)
+{
+	struct _icm_monitor_slice* slice;
+	uint8_t count = 0;
+	uint16_t i;
+
+	/* new references first */
+	for (i = 0; i < mon->num_slices && mon->dirty &&
+	            count < ICM_MONITOR_SLOTS; i++) {
+		slice = &mon->slices[i];
+		if (slice->state != ICM_MONITOR_SLICE_DIRTY)
+			continue;
+		slice->state = ICM_MONITOR_SLICE_HASHING;
+		mon->dirty--;
+		mon->pass[count++] = i;
+	}
+
+	/* then the checks, in round-robin */
+	for (i = 0; i < mon->num_slices && count < ICM_MONITOR_SLOTS; i++) {
+		if (mon->slices[mon->cursor].state == ICM_MONITOR_SLICE_VALID)
+			mon->pass[count++] = mon->cursor;
+		if (++mon->cursor >= mon->num_slices) {
+			mon->cursor = 0;
+			mon->stats.scans++;
+		}
+	}
+
+	for (i = 0; i < count; i++) {
+		slice = &mon->slices[mon->pass[i]];
+		desc[i].icm_raddr = slice->addr;
+		desc[i].icm_rcfg = _icm_rcfg_algo(mon->regions[slice->region].algo);
+		if (slice->state == ICM_MONITOR_SLICE_VALID) {
+			desc[i].icm_rcfg |= ICM_RCFG_CDWBN;
+			memcpy(&hash[8 * i], slice->digest, sizeof(slice->digest));
+		} else {
+			memset(&hash[8 * i], 0, sizeof(slice->digest));
+		}
+		if (i == count - 1)
+			desc[i].icm_rcfg |= ICM_RCFG_EOM;
+		/* (TRSIZE + 1) blocks of 512 bits */
+		desc[i].icm_rctrl = slice->size / ICM_MONITOR_BLOCK_SIZE - 1;
+		desc[i].icm_rnext = 0;
+		mon->stats.bytes += slice->size;
+	}
+
+	if (count)
+		mon->stats.passes++;
+	return count;
+}
+
+void icm_monitor_complete_pass(struct _icm_monitor* mon,
+		const uint32_t* hash, uint8_t mismatch, uint8_t bus_error)
+{
+	struct _icm_monitor_event event;
+	struct _icm_monitor_slice* slice;
+	uint8_t i, words;
+	bool aborted = false;
+
+	for (i = 0; i < mon->pass_count; i++) {
+		slice = &mon->slices[mon->pass[i]];
+
+		if (aborted) {
+			/* not processed after the bus error, the hash area
+			 * holds no digest for it: hash it again later */
+			if (slice->state == ICM_MONITOR_SLICE_HASHING) {
+				slice->state = ICM_MONITOR_SLICE_DIRTY;
+				mon->dirty++;
+			}
+			continue;
+		}
+
+		if (bus_error & (1 << i)) {
+			aborted = true;
+			mon->stats.bus_errors++;
+			event.status = -EIO;
+		} else if (slice->state == ICM_MONITOR_SLICE_HASHING) {
+			words = _icm_digest_words(mon->regions[slice->region].algo);
+			memset(slice->digest, 0, sizeof(slice->digest));
+			memcpy(slice->digest, &hash[8 * i], words * sizeof(uint32_t));
+			slice->state = ICM_MONITOR_SLICE_VALID;
+			mon->stats.rehashes++;
+			continue;
+		} else if (slice->state == ICM_MONITOR_SLICE_VALID &&
+		           (mismatch & (1 << i))) {
+			mon->stats.mismatches++;
+			mon->regions[slice->region].mismatches++;
+			event.status = -EBADMSG;
+		} else {
+			/* matched, or updated while the pass was running */
+			continue;
+		}
+
+		/* retry the reference of a slice that could not be read */
+		if (slice->state == ICM_MONITOR_SLICE_HASHING) {
+			slice->state = ICM_MONITOR_SLICE_DIRTY;
+			mon->dirty++;
+		}
+
+		event.region = slice->region;
+		event.addr = slice->addr;
+		event.size = slice->size;
+		callback_call(&mon->callback, &event);
+	}
+	mon->pass_count = 0;
+}
+
+int icm_monitor_start(struct _icm_monitor* mon, bool continuous, uint8_t bbc)
+{
+	if (_icm_owner && _icm_owner != mon)
+		return -EBUSY;
+
+	_icm_owner = mon;
+	_icm_bbc = bbc;
+	mon->continuous = continuous;
+
+	irq_add_handler(ID_ICM, _icm_handler, NULL);
+	irq_enable(ID_ICM);
+
+	if (continuous)
+		return icm_monitor_step(mon);
+	return 0;
+}
+
+int icm_monitor_step(struct _icm_monitor* mon)
+{
+	int err = 0;
+
+	if (_icm_owner != mon)
+		return -EINVAL;
+
+	irq_disable(ID_ICM);
+	if (mon->busy) {
+		err = -EBUSY;
+	} else {
+		_icm_start_pass(mon);
+		if (!mon->busy)
+			err = -ENODEV;
+	}
+	irq_enable(ID_ICM);
+	return err;
+}
+
+void icm_monitor_stop(struct _icm_monitor* mon)
+{
+	if (_icm_owner != mon)
+		return;
+
+	mon->continuous = false;
+	while (mon->busy);
+
+	irq_disable(ID_ICM);
+	irq_remove_handler(ID_ICM, _icm_handler);
+	icm_disable_it(~0u);
+	icm_disable();
+	_icm_owner = NULL;
+}
@@ -0,0 +1,230 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef _ICM_MONITOR_H_
+#define _ICM_MONITOR_H_
+
+#ifdef CONFIG_HAVE_ICM
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "callback.h"
+#include "crypto/icm.h"
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Number of ICM hardware regions, i.e. slices checked in one pass */
+#define ICM_MONITOR_SLOTS 4
+
+/** Maximum number of monitored memory regions */
+#define ICM_MONITOR_MAX_REGIONS 16
+
+/** Maximum number of slices for all regions */
+#define ICM_MONITOR_MAX_SLICES 64
+
+/** ICM block size, sizes and slice sizes are multiples of it */
+#define ICM_MONITOR_BLOCK_SIZE 64
+
+/** Largest slice, limited by the descriptor TRSIZE field */
+#define ICM_MONITOR_MAX_SLICE_SIZE (65536 * ICM_MONITOR_BLOCK_SIZE)
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+enum _icm_monitor_algo {
+	ICM_MONITOR_SHA1,
+	ICM_MONITOR_SHA224,
+	ICM_MONITOR_SHA256,
+};
+
+enum _icm_monitor_slice_state {
+	ICM_MONITOR_SLICE_DIRTY,     /**< Reference digest to (re)compute */
+	ICM_MONITOR_SLICE_HASHING,   /**< Reference digest computed by the
+	                                  running pass */
+	ICM_MONITOR_SLICE_VALID,     /**< Checked against the reference */
+};
+
+/** Part of a region hashed by one ICM descriptor */
+struct _icm_monitor_slice {
+	uint32_t addr;
+	uint32_t size;
+	uint8_t region;
+	uint8_t state;               /**< enum _icm_monitor_slice_state */
+	uint32_t digest[8];          /**< Reference digest */
+};
+
+struct _icm_monitor_region {
+	uint32_t addr;
+	uint32_t size;
+	enum _icm_monitor_algo algo;
+	uint16_t first_slice;
+	uint16_t num_slices;
+	uint32_t mismatches;
+};
+
+/** Argument of the event callback */
+struct _icm_monitor_event {
+	uint8_t region;              /**< Index returned by icm_monitor_add_region() */
+	uint32_t addr;               /**< Slice that failed */
+	uint32_t size;
+	int status;                  /**< -EBADMSG on digest mismatch, -EIO on bus error */
+};
+
+struct _icm_monitor_stats {
+	uint32_t passes;             /**< ICM runs */
+	uint32_t scans;              /**< Complete scans of all slices */
+	uint64_t bytes;              /**< Bytes hashed */
+	uint32_t rehashes;           /**< Slices hashed to refresh a reference */
+	uint32_t mismatches;
+	uint32_t bus_errors;
+};
+
+struct _icm_monitor {
+	struct _icm_monitor_region regions[ICM_MONITOR_MAX_REGIONS];
+	uint8_t num_regions;
+	struct _icm_monitor_slice slices[ICM_MONITOR_MAX_SLICES];
+	uint16_t num_slices;
+	uint32_t slice_size;
+
+	/* scheduler */
+	uint16_t cursor;             /**< Next slice to check */
+	uint16_t dirty;              /**< Number of dirty slices */
+	uint16_t pass[ICM_MONITOR_SLOTS];
+	uint8_t pass_count;
+	volatile bool busy;
+	bool continuous;
+
+	struct _callback callback;   /**< Called with a struct _icm_monitor_event */
+	struct _icm_monitor_stats stats;
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/*
+ * The ICM has four hardware regions. The monitor splits each memory region
+ * in slices of at most slice_size bytes and runs the ICM in passes of up
+ * to four slices, in round-robin, so that any number of regions can be
+ * checked and the length of a burst of ICM bus traffic is bounded by four
+ * slices. Dirty slices (new regions, or memory changed through
+ * icm_monitor_update()) are scheduled first, in write-back mode, to compute
+ * their reference digest; the other slices are compared with it.
+ *
+ * icm_monitor_build_pass() and icm_monitor_complete_pass() contain the
+ * scheduling and do not access the peripheral.
+ */
+
+/**
+ * \brief Initialize a monitor.
+ * \param mon         Monitor to initialize.
+ * \param slice_size  Maximum bytes per ICM descriptor, a multiple of
+ *                    ICM_MONITOR_BLOCK_SIZE up to ICM_MONITOR_MAX_SLICE_SIZE.
+ * \param cb          Event callback, may be NULL.
+ * \return 0 on success, -EINVAL on invalid slice size.
+ */
+extern int icm_monitor_init(struct _icm_monitor* mon, uint32_t slice_size,
+		struct _callback* cb);
+
+/**
+ * \brief Add a memory region to monitor. Its reference digests are computed
+ * by the next passes.
+ * \param addr  Start address, word aligned.
+ * \param size  Size in bytes, a multiple of ICM_MONITOR_BLOCK_SIZE.
+ * \return the region index, -EINVAL on invalid parameters, -ENOMEM when the
+ * region or slice tables are full.
+ */
+extern int icm_monitor_add_region(struct _icm_monitor* mon, const void* addr,
+		uint32_t size, enum _icm_monitor_algo algo);
+
+/**
+ * \brief Notify a legitimate change of monitored memory. The slices
+ * overlapping the range get a new reference digest on the next pass, the
+ * rest of the region is not rehashed. The range is cleaned from the data
+ * cache.
+ */
+extern void icm_monitor_update(struct _icm_monitor* mon, const void* addr,
+		uint32_t len);
+
+/**
+ * \brief Select the slices of the next pass and fill the ICM main list and
+ * hash area for them.
+ * \param desc  Main list, ICM_MONITOR_SLOTS descriptors.
+ * \param hash  Hash area, 8 words per slot.
+ * \return the number of slices in the pass.
+ */
+extern uint8_t icm_monitor_build_pass(struct _icm_monitor* mon,
+		struct _icm_region_desc* desc, uint32_t* hash);
+
+/**
+ * \brief Process the result of a pass: store the digests of the dirty
+ * slices and report the mismatches and bus errors. The ICM stops at the
+ * first slot with a bus error: the dirty slices of that slot and of the
+ * following ones are hashed again by a later pass.
+ * \param hash      Hash area written by the ICM.
+ * \param mismatch  Slots with a digest mismatch (ICM_ISR RDM field).
+ * \param bus_error Slots with a bus error (ICM_ISR RBE field).
+ */
+extern void icm_monitor_complete_pass(struct _icm_monitor* mon,
+		const uint32_t* hash, uint8_t mismatch, uint8_t bus_error);
+
+/**
+ * \brief Start checking the regions.
+ * \param continuous  Start the next pass from the interrupt handler when a
+ *                    pass completes, otherwise each pass is started by
+ *                    icm_monitor_step().
+ * \param bbc         ICM bus burden control, 2^bbc cycles between blocks.
+ * \return 0 on success, -EBUSY if the ICM is used by another monitor.
+ */
+extern int icm_monitor_start(struct _icm_monitor* mon, bool continuous,
+		uint8_t bbc);
+
+/**
+ * \brief Start one pass if the ICM is idle.
+ * \return 0 if a pass was started, -EBUSY if a pass is running, -ENODEV
+ * if there is nothing to check.
+ */
+extern int icm_monitor_step(struct _icm_monitor* mon);
+
+/**
+ * \brief Stop checking after the running pass.
+ */
+extern void icm_monitor_stop(struct _icm_monitor* mon);
+
+#endif /* CONFIG_HAVE_ICM */
+
+#endif /* _ICM_MONITOR_H_ */
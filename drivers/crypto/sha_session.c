@@ -0,0 +1,605 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "compiler.h"
+#include "crypto/sha_session.h"
+#include "errno.h"
+#include "intmath.h"
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/* Whether the engine can be given back a saved intermediate hash */
+#if defined(CONFIG_HAVE_SHA) && !defined(SHA_CR_WUIHV)
+#define ENGINE_CAN_RESTORE false
+#else
+#define ENGINE_CAN_RESTORE true
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+static struct _sha_job* _queue_head;
+static struct _sha_job* _queue_tail;
+
+static struct _sha_session* _last_session;
+static uint8_t _batch;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static enum _sha_soft_algo _soft_algo(enum _shad_algo algo)
+{
+	switch (algo) {
+	case ALGO_SHA_1:
+		return SHA_SOFT_SHA1;
+	case ALGO_SHA_224:
+		return SHA_SOFT_SHA224;
+	case ALGO_SHA_384:
+		return SHA_SOFT_SHA384;
+	case ALGO_SHA_512:
+		return SHA_SOFT_SHA512;
+	default:
+		return SHA_SOFT_SHA256;
+	}
+}
+
+/* Same as shad_get_digest_size(), which only exists with the engine */
+static int _digest_size(enum _shad_algo algo)
+{
+	switch (algo) {
+	case ALGO_SHA_1:
+		return 20;
+	case ALGO_SHA_224:
+		return 28;
+	case ALGO_SHA_256:
+		return 32;
+	case ALGO_SHA_384:
+		return 48;
+	case ALGO_SHA_512:
+		return 64;
+	default:
+		return -EINVAL;
+	}
+}
+
+static bool _can_restore(struct _sha_session* session)
+{
+	return !session->shad || ENGINE_CAN_RESTORE;
+}
+
+#ifdef CONFIG_HAVE_SHA
+static bool _is_aligned(const void* p)
+{
+	return ((uint32_t)(uintptr_t)p & 3) == 0;
+}
+
+static bool _use_engine(const struct _sha_session* session)
+{
+	return session->shad && !session->soft;
+}
+
+/* Make the engine hold the session state: start a new message when no
+ * block was hashed yet, restore the saved state otherwise */
+static int _hw_blocks(struct _sha_session* session, const struct _buffer* sg,
+		      uint8_t count)
+{
+	int err;
+
+	if (session->shad->session.owner != session) {
+		err = shad_session_load(session->shad, session, session->algo,
+				session->fresh ? NULL : session->state);
+		if (err < 0)
+			return err;
+	}
+	err = shad_session_blocks(session->shad, sg, count, session->state);
+	if (err == 0)
+		session->fresh = false;
+	return err;
+}
+#endif
+
+/* Hash whole blocks from a contiguous area */
+static int _blocks(struct _sha_session* session, const uint8_t* data,
+		   uint32_t blocks)
+{
+#ifdef CONFIG_HAVE_SHA
+	if (_use_engine(session)) {
+		struct _buffer buf;
+		uint32_t block[32];
+		int err;
+
+		if (_is_aligned(data)) {
+			buf.data = (uint8_t*)data;
+			buf.size = blocks * session->block_size;
+			return _hw_blocks(session, &buf, 1);
+		}
+		/* unaligned data is copied block by block */
+		buf.data = (uint8_t*)block;
+		buf.size = session->block_size;
+		for (; blocks; blocks--, data += session->block_size) {
+			memcpy(block, data, session->block_size);
+			err = _hw_blocks(session, &buf, 1);
+			if (err < 0)
+				return err;
+		}
+		return 0;
+	}
+#endif
+	sha_soft_blocks(_soft_algo(session->algo), session->state, data, blocks);
+	session->fresh = false;
+	return 0;
+}
+
+static int _update_linear(struct _sha_session* session, const uint8_t* data,
+			  uint32_t len)
+{
+	uint8_t* buffer = (uint8_t*)session->buffer;
+	uint32_t n;
+	int err;
+
+	session->length += len;
+
+	if (session->buffer_len) {
+		n = min_u32(len, session->block_size - session->buffer_len);
+		memcpy(&buffer[session->buffer_len], data, n);
+		session->buffer_len += n;
+		data += n;
+		len -= n;
+		if (session->buffer_len < session->block_size)
+			return 0;
+		session->buffer_len = 0;
+		err = _blocks(session, buffer, 1);
+		if (err < 0)
+			return err;
+	}
+
+	n = len / session->block_size;
+	if (n) {
+		err = _blocks(session, data, n);
+		if (err < 0)
+			return err;
+		data += n * session->block_size;
+		len -= n * session->block_size;
+	}
+
+	memcpy(buffer, data, len);
+	session->buffer_len = len;
+	return 0;
+}
+
+#ifdef CONFIG_HAVE_SHA
+/* Chain the buffered bytes and the segments in one engine transfer, up to
+ * the last complete block. Returns 1 when the scatter list cannot be
+ * chained this way. */
+static int _hw_update_sg(struct _sha_session* session,
+			 const struct _buffer* sg, uint8_t count)
+{
+	struct _buffer list[SHAD_SESSION_MAX_SG];
+	uint8_t* buffer = (uint8_t*)session->buffer;
+	uint32_t total, hashed, pos, start, end;
+	uint8_t i, items = 0;
+	int err;
+
+	if (count > SHA_SESSION_MAX_SG || (session->buffer_len & 3))
+		return 1;
+	total = session->buffer_len;
+	for (i = 0; i < count; i++) {
+		if (!_is_aligned(sg[i].data) ||
+		    (i < count - 1 && (sg[i].size & 3)))
+			return 1;
+		total += sg[i].size;
+	}
+	hashed = total - total % session->block_size;
+	if (hashed == 0)
+		return 1;
+
+	if (session->buffer_len) {
+		list[items].data = buffer;
+		list[items].size = session->buffer_len;
+		items++;
+	}
+	pos = session->buffer_len;
+	for (i = 0; i < count && pos < hashed; i++) {
+		list[items].data = sg[i].data;
+		list[items].size = min_u32(sg[i].size, hashed - pos);
+		pos += list[items].size;
+		items++;
+	}
+	err = _hw_blocks(session, list, items);
+	if (err < 0)
+		return err;
+
+	/* keep the bytes following the last complete block, they all come
+	 * from the segments since the buffer holds less than a block */
+	session->length += total - session->buffer_len;
+	session->buffer_len = total - hashed;
+	pos = total;
+	for (i = count; i > 0; i--) {
+		end = pos;
+		pos -= sg[i - 1].size;
+		if (end <= hashed)
+			break;
+		start = max_u32(pos, hashed);
+		memcpy(&buffer[start - hashed], sg[i - 1].data + (start - pos),
+		       end - start);
+	}
+	return 0;
+}
+#endif
+
+static int _pad(struct _sha_session* session)
+{
+	uint8_t* buffer = (uint8_t*)session->buffer;
+	uint32_t len_size = session->block_size == 128 ? 16 : 8;
+	uint32_t padded;
+	uint64_t bits = session->length * 8;
+	int i;
+
+	padded = ROUND_UP_MULT(session->buffer_len + 1 + len_size,
+			session->block_size);
+	buffer[session->buffer_len] = 0x80;
+	memset(&buffer[session->buffer_len + 1], 0,
+	       padded - session->buffer_len - 1);
+	for (i = 1; i <= 8; i++, bits >>= 8)
+		buffer[padded - i] = (uint8_t)bits;
+	session->buffer_len = 0;
+	return _blocks(session, buffer, padded / session->block_size);
+}
+
+/* Start a message from the HMAC inner or outer pad */
+static int _start_pad(struct _sha_session* session, const uint8_t* pad)
+{
+	session->buffer_len = 0;
+	session->open = true;
+#ifdef CONFIG_HAVE_SHA
+	if (session->shad && session->shad->session.owner == session)
+		session->shad->session.owner = NULL;
+#endif
+	if (_can_restore(session)) {
+		memcpy(session->state, pad, session->state_size);
+		session->length = session->block_size;
+		session->fresh = false;
+		return 0;
+	}
+	sha_soft_init(_soft_algo(session->algo), session->state);
+	session->length = 0;
+	session->fresh = true;
+	return _update_linear(session, pad, session->block_size);
+}
+
+static int _run_job(struct _sha_job* job)
+{
+	int err;
+
+	if (job->start) {
+		err = sha_session_start(job->session);
+		if (err < 0)
+			return err;
+	}
+	if (job->count) {
+		err = sha_session_update_sg(job->session, job->src, job->count);
+		if (err < 0)
+			return err;
+	}
+	if (job->digest)
+		return sha_session_finish(job->session, job->digest);
+	return 0;
+}
+
+/* Whether a job can use the engine now: without state restore, the
+ * message of another session must be finished first */
+static bool _is_runnable(struct _sha_job* job)
+{
+#ifdef CONFIG_HAVE_SHA
+	const struct _sha_session* owner;
+
+	if (!ENGINE_CAN_RESTORE && _use_engine(job->session)) {
+		owner = (const struct _sha_session*)job->session->shad->session.owner;
+		if (owner && owner != job->session && owner->open)
+			return false;
+	}
+#endif
+	return true;
+}
+
+/* Take the next job, preferring the session which ran last */
+static struct _sha_job* _pop_job(void)
+{
+	struct _sha_job *job, *prev = NULL;
+
+	if (_last_session && _batch < SHA_SESSION_MAX_BATCH) {
+		for (job = _queue_head; job; prev = job, job = job->next)
+			if (job->session == _last_session)
+				break;
+		if (job && !_is_runnable(job))
+			job = NULL;
+	} else {
+		job = NULL;
+	}
+	if (!job) {
+		prev = NULL;
+		for (job = _queue_head; job; prev = job, job = job->next)
+			if (_is_runnable(job))
+				break;
+	}
+	if (!job)
+		return NULL;
+
+	if (prev)
+		prev->next = job->next;
+	else
+		_queue_head = job->next;
+	if (_queue_tail == job)
+		_queue_tail = prev;
+	job->next = NULL;
+
+	if (job->session == _last_session && _batch < SHA_SESSION_MAX_BATCH) {
+		_batch++;
+	} else {
+		_last_session = job->session;
+		_batch = 1;
+	}
+	return job;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+int sha_session_init(struct _sha_session* session, struct _shad_desc* shad,
+		     enum _shad_algo algo)
+{
+	int digest_size = _digest_size(algo);
+
+	if (digest_size < 0)
+		return -EINVAL;
+#ifndef CONFIG_HAVE_SHA
+	if (shad)
+		return -ENODEV;
+#endif
+
+	memset(session, 0, sizeof(*session));
+	session->shad = shad;
+	session->algo = algo;
+	session->block_size = sha_soft_block_size(_soft_algo(algo));
+	session->state_size = sha_soft_state_size(_soft_algo(algo));
+	session->digest_size = digest_size;
+	return 0;
+}
+
+int sha_session_set_hmac_key(struct _sha_session* session,
+			     const uint8_t* key, uint32_t key_len)
+{
+	uint8_t k0[128];
+	uint32_t i;
+	int err;
+
+	if (session->open)
+		return -EBUSY;
+
+	/* K0: the key, hashed if longer than a block, padded with zeros */
+	session->hmac = false;
+	memset(k0, 0, sizeof(k0));
+	if (key_len > session->block_size) {
+		err = sha_session_start(session);
+		if (err == 0)
+			err = sha_session_update(session, key, key_len);
+		if (err == 0)
+			err = sha_session_finish(session, k0);
+		if (err < 0)
+			return err;
+	} else {
+		memcpy(k0, key, key_len);
+	}
+
+	for (i = 0; i < session->block_size; i++) {
+		session->inner[i] = k0[i] ^ 0x36;
+		session->outer[i] = k0[i] ^ 0x5c;
+	}
+	memset(k0, 0, sizeof(k0));
+
+	if (_can_restore(session)) {
+		/* keep the states after the pad blocks instead of the
+		 * blocks */
+		err = sha_session_start(session);
+		if (err == 0)
+			err = _update_linear(session, session->inner,
+					session->block_size);
+		if (err < 0)
+			return err;
+		memcpy(session->inner, session->state, session->state_size);
+
+		err = sha_session_start(session);
+		if (err == 0)
+			err = _update_linear(session, session->outer,
+					session->block_size);
+		if (err < 0)
+			return err;
+		memcpy(session->outer, session->state, session->state_size);
+		session->open = false;
+	}
+	session->hmac = true;
+	return 0;
+}
+
+int sha_session_use_engine(struct _sha_session* session, bool engine)
+{
+	if (engine && !session->shad)
+		return -ENODEV;
+	if (engine == !session->soft)
+		return 0;
+	if (engine) {
+		if (session->open && !session->fresh && !ENGINE_CAN_RESTORE)
+			return -EBUSY;
+	} else {
+#ifdef CONFIG_HAVE_SHA
+		/* the engine copy of the state becomes stale */
+		if (session->shad->session.owner == session)
+			session->shad->session.owner = NULL;
+#endif
+	}
+	session->soft = !engine;
+	return 0;
+}
+
+void sha_session_free(struct _sha_session* session)
+{
+#ifdef CONFIG_HAVE_SHA
+	if (session->shad && session->shad->session.owner == session)
+		session->shad->session.owner = NULL;
+#endif
+	memset(session, 0, sizeof(*session));
+}
+
+int sha_session_start(struct _sha_session* session)
+{
+	if (session->hmac)
+		return _start_pad(session, session->inner);
+
+#ifdef CONFIG_HAVE_SHA
+	if (session->shad && session->shad->session.owner == session)
+		session->shad->session.owner = NULL;
+#endif
+	sha_soft_init(_soft_algo(session->algo), session->state);
+	session->length = 0;
+	session->buffer_len = 0;
+	session->fresh = true;
+	session->open = true;
+	return 0;
+}
+
+int sha_session_update(struct _sha_session* session, const uint8_t* data,
+		       uint32_t len)
+{
+	if (!session->open)
+		return -EINVAL;
+	return _update_linear(session, data, len);
+}
+
+int sha_session_compress(struct _sha_session* session, const uint8_t* block)
+{
+	if (!session->open)
+		return -EINVAL;
+	return _blocks(session, block, 1);
+}
+
+int sha_session_update_sg(struct _sha_session* session,
+			  const struct _buffer* sg, uint8_t count)
+{
+	uint8_t i;
+	int err;
+
+	if (!session->open)
+		return -EINVAL;
+
+#ifdef CONFIG_HAVE_SHA
+	if (_use_engine(session)) {
+		err = _hw_update_sg(session, sg, count);
+		if (err <= 0)
+			return err;
+	}
+#endif
+	for (i = 0; i < count; i++) {
+		err = _update_linear(session, sg[i].data, sg[i].size);
+		if (err < 0)
+			return err;
+	}
+	return 0;
+}
+
+int sha_session_finish(struct _sha_session* session, uint8_t* digest)
+{
+	uint8_t inner[64];
+	int err;
+
+	if (!session->open)
+		return -EINVAL;
+
+	err = _pad(session);
+	if (err < 0)
+		goto exit;
+
+	if (session->hmac) {
+		/* H((K0 ^ opad) || H((K0 ^ ipad) || text)) */
+		memcpy(inner, session->state, session->digest_size);
+		err = _start_pad(session, session->outer);
+		if (err == 0)
+			err = _update_linear(session, inner,
+					session->digest_size);
+		if (err == 0)
+			err = _pad(session);
+		if (err < 0)
+			goto exit;
+	}
+	memcpy(digest, session->state, session->digest_size);
+
+exit:
+	session->open = false;
+	return err;
+}
+
+int sha_session_submit(struct _sha_job* job)
+{
+	if (!job->session || (job->count && !job->src))
+		return -EINVAL;
+
+	job->status = -EINPROGRESS;
+	job->next = NULL;
+	if (_queue_tail)
+		_queue_tail->next = job;
+	else
+		_queue_head = job;
+	_queue_tail = job;
+	return 0;
+}
+
+uint32_t sha_session_process(void)
+{
+	struct _sha_job* job;
+	uint32_t done = 0;
+
+	while ((job = _pop_job()) != NULL) {
+		job->status = _run_job(job);
+		callback_call(&job->callback, job);
+		done++;
+	}
+	return done;
+}
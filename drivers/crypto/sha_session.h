@@ -0,0 +1,201 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef _SHA_SESSION_H_
+#define _SHA_SESSION_H_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "callback.h"
+#include "crypto/shad.h"
+#include "io.h"
+#include "sha_soft.h"
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Maximum number of buffers of a job chained in one engine transfer */
+#define SHA_SESSION_MAX_SG (SHAD_SESSION_MAX_SG - 1)
+
+/** Maximum number of consecutive jobs of one session run by
+ * sha_session_process() before the other sessions are served */
+#define SHA_SESSION_MAX_BATCH 8
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** Hash stream (SHA or HMAC), see sha_session_init() */
+struct _sha_session {
+	struct _shad_desc *shad;        /**< Engine, NULL for the software path */
+	enum _shad_algo algo;
+	uint8_t block_size;
+	uint8_t state_size;
+	uint8_t digest_size;
+	bool soft;                      /**< Engine bypassed */
+	bool hmac;
+	bool open;                      /**< A message is in progress */
+	bool fresh;                     /**< No block hashed in the message */
+
+	uint8_t state[SHA_SOFT_STATE_MAX];
+	uint64_t length;                /**< Message bytes, padding excluded */
+	uint32_t buffer[64];            /**< Pending bytes and padding */
+	uint8_t buffer_len;
+
+	/* HMAC: states after the K0 ^ ipad and K0 ^ opad blocks, or the
+	 * blocks themselves when the engine cannot restore a state */
+	uint8_t inner[128];
+	uint8_t outer[128];
+};
+
+/** Segments of a message, see sha_session_submit() */
+struct _sha_job {
+	struct _sha_session *session;
+	bool start;                     /**< Start a new message first */
+	const struct _buffer *src;
+	uint8_t count;
+	uint8_t *digest;                /**< Finish the message and write the
+	                                     digest, NULL to keep it open */
+
+	struct _callback callback;      /**< Called with the job as argument */
+	int status;                     /**< -EINPROGRESS until completed */
+	struct _sha_job *next;
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initialize a hash session.
+ *
+ * Several sessions can share one engine: the intermediate hash of a
+ * session is saved after each operation and written back as user initial
+ * hash value when another session used the engine in between. On engines
+ * without user initial hash values, a message must be finished before a
+ * message of another session is started.
+ *
+ * \param session  Session to initialize.
+ * \param shad     Initialized SHA driver, or NULL to use the software
+ *                 implementation.
+ * \param algo     ALGO_SHA_1..ALGO_SHA_512.
+ * \return 0 on success, -EINVAL on invalid algorithm.
+ */
+extern int sha_session_init(struct _sha_session *session,
+		struct _shad_desc *shad, enum _shad_algo algo);
+
+/**
+ * \brief Turn the session into an HMAC session. The hashes of the padded
+ * key blocks are computed once, each message then costs the same number
+ * of blocks as a plain hash plus one outer block.
+ * \return 0 on success, negative error code otherwise.
+ */
+extern int sha_session_set_hmac_key(struct _sha_session *session,
+		const uint8_t *key, uint32_t key_len);
+
+/**
+ * \brief Route the next operations of a session to its engine or to the
+ * software implementation. Both use the same state layout, so the switch
+ * is possible within a message, except towards an engine which cannot
+ * restore a state.
+ * \return 0 on success, -ENODEV without engine, -EBUSY if the engine
+ * cannot take over the message.
+ */
+extern int sha_session_use_engine(struct _sha_session *session, bool engine);
+
+/**
+ * \brief Release a session: the engine forgets it and the key material is
+ * cleared.
+ */
+extern void sha_session_free(struct _sha_session *session);
+
+/**
+ * \brief Start a message.
+ */
+extern int sha_session_start(struct _sha_session *session);
+
+/**
+ * \brief Hash a chunk of the message, of any length and alignment.
+ * \return 0 on success, negative error code otherwise.
+ */
+extern int sha_session_update(struct _sha_session *session,
+		const uint8_t *data, uint32_t len);
+
+/**
+ * \brief Hash a scatter list. With an engine, the segments are chained in
+ * one DMA transfer when they are word aligned and all sizes but the last
+ * are multiples of 4 bytes.
+ * \return 0 on success, negative error code otherwise.
+ */
+extern int sha_session_update_sg(struct _sha_session *session,
+		const struct _buffer *sg, uint8_t count);
+
+/**
+ * \brief Run the compression function on exactly one block: the
+ * intermediate hash is updated, the message length and the pending bytes
+ * are left untouched.
+ * \param block  One block of the algorithm (64 or 128 bytes).
+ * \return 0 on success, negative error code otherwise.
+ */
+extern int sha_session_compress(struct _sha_session *session,
+		const uint8_t *block);
+
+/**
+ * \brief Finish the message.
+ * \param session  Session.
+ * \param digest   Digest (or HMAC), digest size of the algorithm.
+ * \return 0 on success, negative error code otherwise.
+ */
+extern int sha_session_finish(struct _sha_session *session, uint8_t *digest);
+
+/**
+ * \brief Queue a job. The queue is not protected against interrupts, jobs
+ * must be submitted from the context calling sha_session_process().
+ * \return 0 on success, -EINVAL on invalid job.
+ */
+extern int sha_session_submit(struct _sha_job *job);
+
+/**
+ * \brief Run the queued jobs.
+ *
+ * Jobs of the session which ran last are preferred, up to
+ * SHA_SESSION_MAX_BATCH in a row, so that its state stays in the engine.
+ * Jobs of one session always complete in order.
+ *
+ * \return Number of jobs completed.
+ */
+extern uint32_t sha_session_process(void);
+
+#endif /* _SHA_SESSION_H_ */
@@ -70,6 +70,44 @@ static uint8_t _shad_get_block_size(enum _shad_algo algo)
 		return 64;
 }
 
+static int _shad_get_mr_algo(enum _shad_algo algo, uint32_t* mr)
+{
+	switch (algo) {
+	case ALGO_SHA_1:
+		*mr = SHA_MR_ALGO_SHA1;
+		break;
+	case ALGO_SHA_224:
+		*mr = SHA_MR_ALGO_SHA224;
+		break;
+	case ALGO_SHA_256:
+		*mr = SHA_MR_ALGO_SHA256;
+		break;
+#ifdef SHA_MR_ALGO_SHA384
+	case ALGO_SHA_384:
+		*mr = SHA_MR_ALGO_SHA384;
+		break;
+#endif
+#ifdef SHA_MR_ALGO_SHA512
+	case ALGO_SHA_512:
+		*mr = SHA_MR_ALGO_SHA512;
+		break;
+#endif
+	default:
+		return -EINVAL;
+	}
+	return 0;
+}
+
+static uint8_t _shad_get_state_size(enum _shad_algo algo)
+{
+	if (algo == ALGO_SHA_1)
+		return 20;
+	else if (algo == ALGO_SHA_384 || algo == ALGO_SHA_512)
+		return 64;
+	else
+		return 32;
+}
+
 static uint32_t _shad_get_padded_message_len(uint8_t mode, uint32_t len)
 {
 	uint32_t k;
@@ -412,29 +450,8 @@ int shad_start(struct _shad_desc* desc)
 {
 	uint32_t algo, mode;
 
-	switch (desc->cfg.algo) {
-	case ALGO_SHA_1:
-		algo = SHA_MR_ALGO_SHA1;
-		break;
-	case ALGO_SHA_224:
-		algo = SHA_MR_ALGO_SHA224;
-		break;
-	case ALGO_SHA_256:
-		algo = SHA_MR_ALGO_SHA256;
-		break;
-#ifdef SHA_MR_ALGO_SHA384
-	case ALGO_SHA_384:
-		algo = SHA_MR_ALGO_SHA384;
-		break;
-#endif
-#ifdef SHA_MR_ALGO_SHA512
-	case ALGO_SHA_512:
-		algo = SHA_MR_ALGO_SHA512;
-		break;
-#endif
-	default:
+	if (_shad_get_mr_algo(desc->cfg.algo, &algo) < 0)
 		return -EINVAL;
-	}
 
 	switch (desc->cfg.transfer_mode) {
 	case SHAD_TRANS_POLLING:
@@ -447,6 +464,7 @@ int shad_start(struct _shad_desc* desc)
 		return -EINVAL;
 	}
 
+	desc->session.owner = NULL;
 	sha_soft_reset();
 	sha_configure(algo | mode | SHA_MR_PROCDLY_LONGEST);
 	memset(&desc->xfer, 0, sizeof(desc->xfer));
@@ -550,6 +568,89 @@ void shad_wait_completion(struct _shad_desc* desc)
 	}
 }
 
+int shad_session_load(struct _shad_desc* desc, const void* owner,
+		      enum _shad_algo algo, const uint8_t* state)
+{
+	uint32_t mr;
+
+	if (_shad_get_mr_algo(algo, &mr) < 0)
+		return -EINVAL;
+#ifndef SHA_CR_WUIHV
+	if (state)
+		return -ENOTSUP;
+#endif
+	if (!mutex_try_lock(&desc->mutex))
+		return -EBUSY;
+
+	sha_soft_reset();
+	mr |= SHA_MR_SMOD_IDATAR0_START | SHA_MR_PROCDLY_LONGEST;
+#ifdef SHA_CR_WUIHV
+	if (state) {
+		/* The intermediate hash is written as user initial hash
+		 * value, SHA-224 and SHA-384 use the full SHA-256 and
+		 * SHA-512 state */
+		SHA->SHA_CR = SHA_CR_WUIHV;
+		sha_set_input(state, _shad_get_state_size(algo));
+		sha_first_block();
+		mr |= SHA_MR_UIHV;
+	} else
+#endif
+	{
+		sha_first_block();
+	}
+	sha_configure(mr);
+
+	desc->session.owner = owner;
+	desc->session.algo = algo;
+
+	mutex_unlock(&desc->mutex);
+	return 0;
+}
+
+int shad_session_blocks(struct _shad_desc* desc, const struct _buffer* sg,
+			uint8_t count, uint8_t* state)
+{
+	struct _dma_transfer_cfg cfg[SHAD_SESSION_MAX_SG];
+	struct _dma_cfg cfg_dma;
+	uint32_t len = 0;
+	uint8_t i;
+
+	if (count == 0 || count > SHAD_SESSION_MAX_SG)
+		return -EINVAL;
+	for (i = 0; i < count; i++) {
+		if ((sg[i].size & 3) || (((uint32_t)sg[i].data) & 3))
+			return -EINVAL;
+		len += sg[i].size;
+	}
+	if (len % _shad_get_block_size(desc->session.algo))
+		return -EINVAL;
+	if (!mutex_try_lock(&desc->mutex))
+		return -EBUSY;
+
+	for (i = 0; i < count; i++)
+		_shad_prepare_dma_sg(&cfg[i], sg[i].data, sg[i].size);
+
+	memset(&cfg_dma, 0, sizeof(cfg_dma));
+	cfg_dma.incr_saddr = true;
+	cfg_dma.incr_daddr = false;
+	cfg_dma.data_width = DMA_DATA_WIDTH_WORD;
+	cfg_dma.chunk_size = _shad_get_dma_chunk_size(desc->session.algo);
+	dma_configure_transfer(desc->dma_channel, &cfg_dma, cfg, count);
+	dma_set_callback(desc->dma_channel, NULL);
+	dma_start_transfer(desc->dma_channel);
+	while (!dma_is_transfer_done(desc->dma_channel))
+		dma_poll();
+	dma_reset_channel(desc->dma_channel);
+
+	/* Wait for the DATRDY bit (Data Ready) in the status register */
+	while ((sha_get_status() & SHA_ISR_DATRDY) == 0);
+
+	sha_get_output(state, _shad_get_state_size(desc->session.algo));
+
+	mutex_unlock(&desc->mutex);
+	return 0;
+}
+
 static void hmac_precompute_key(struct _shad_desc* desc, struct _buffer* key)
 {
 	uint32_t digest_size = shad_get_digest_size(desc->cfg.algo);
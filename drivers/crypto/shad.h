@@ -43,6 +43,9 @@
 #include "io.h"
 #include "mutex.h"
 
+/* Maximum number of buffers in a scatter list given to shad_session_blocks() */
+#define SHAD_SESSION_MAX_SG 17
+
 /*------------------------------------------------------------------------------
  *        Types
  *----------------------------------------------------------------------------*/
@@ -81,6 +84,12 @@ struct _shad_desc {
 		uint32_t processed; /* cumulated data processed, value is included in padding data */
 		struct _buffer* buffer;
 	} xfer;
+
+	/* context whose state is loaded in the engine, see sha_session.h */
+	struct {
+		const void *owner;
+		enum _shad_algo algo;
+	} session;
 };
 
 /*------------------------------------------------------------------------------
@@ -182,4 +191,35 @@ extern int shad_compute_hmac(struct _shad_desc* desc,
 					  struct _buffer* text,
 					  struct _buffer* digest,
 					  struct _callback* cb);
+
+/**
+ * \brief Load a hash state in the engine.
+ *
+ * The engine is configured for DMA input. The state stays loaded until
+ * another state is loaded or shad_start() is used.
+ *
+ * \param desc   a SHA driver descriptor
+ * \param owner  context loaded, recorded in desc->session.owner
+ * \param algo   SHA algorithm
+ * \param state  intermediate hash to restore, NULL to start a new message
+ * \return 0 on success, -ENOTSUP if the engine cannot restore a state,
+ * -EBUSY if the engine is in use
+ */
+extern int shad_session_load(struct _shad_desc* desc, const void* owner,
+			     enum _shad_algo algo, const uint8_t* state);
+
+/**
+ * \brief Hash complete blocks from a scatter list chained in a single DMA
+ * transfer, and read back the intermediate hash.
+ * \param desc   a SHA driver descriptor, with a state loaded
+ * \param sg     buffers, word aligned with sizes multiple of 4 bytes; the
+ * total size must be a multiple of the block size
+ * \param count  number of buffers, up to SHAD_SESSION_MAX_SG
+ * \param state  updated intermediate hash
+ * \return 0 on success, <0 on error
+ */
+extern int shad_session_blocks(struct _shad_desc* desc,
+			       const struct _buffer* sg, uint8_t count,
+			       uint8_t* state);
+
 #endif /* SHAD_H */
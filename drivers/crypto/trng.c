@@ -69,25 +69,115 @@
 #include "peripherals/pmc.h"
 #include "crypto/trng.h"
 
+#include "errno.h"
+
 #include <assert.h>
 #include <stdlib.h>
+#include <string.h>
 
 /*----------------------------------------------------------------------------
  *        Local Data
  *----------------------------------------------------------------------------*/
 
+/* Health tests cutoffs, SP 800-90B 4.4 with alpha = 2^-20: a 32-bit word
+ * must never repeat, and a byte value must not appear more than
+ * APT_CUTOFF times in a window of APT_WINDOW bytes */
+#define RCT_CUTOFF 2
+#define APT_WINDOW 512
+#define APT_CUTOFF 13
+
 static trng_callback_t _trng_callback;
 static void*           _trng_callback_arg;
 
+static struct {
+	uint32_t ring[TRNG_POOL_WORDS];
+	volatile uint32_t head;   /* written by the interrupt handler */
+	volatile uint32_t tail;
+	volatile bool running;
+	volatile bool refilling;
+	volatile bool failed;
+
+	uint32_t rct_value;
+	uint8_t rct_count;
+	uint8_t apt_value;
+	uint16_t apt_count;
+	uint16_t apt_samples;
+
+	struct _trng_pool_stats stats;
+} _pool;
+
 /*------------------------------------------------------------------------------
  *         Local functions
  *------------------------------------------------------------------------------*/
 
+static bool _trng_health_test(uint32_t value)
+{
+	int i;
+
+	if (_pool.stats.words && value == _pool.rct_value) {
+		if (++_pool.rct_count >= RCT_CUTOFF - 1) {
+			_pool.stats.rct_failures++;
+			return false;
+		}
+	} else {
+		_pool.rct_value = value;
+		_pool.rct_count = 0;
+	}
+
+	for (i = 0; i < 4; i++, value >>= 8) {
+		if (_pool.apt_samples == 0) {
+			_pool.apt_value = (uint8_t)value;
+			_pool.apt_count = 1;
+		} else if ((uint8_t)value == _pool.apt_value) {
+			if (++_pool.apt_count >= APT_CUTOFF) {
+				_pool.stats.apt_failures++;
+				return false;
+			}
+		}
+		if (++_pool.apt_samples == APT_WINDOW)
+			_pool.apt_samples = 0;
+	}
+	return true;
+}
+
+static void _trng_pool_push(uint32_t value)
+{
+	uint32_t head = _pool.head;
+
+	if (!_trng_health_test(value)) {
+		_pool.failed = true;
+		_pool.refilling = false;
+		TRNG->TRNG_IDR = TRNG_IDR_DATRDY;
+		return;
+	}
+
+	_pool.ring[head & (TRNG_POOL_WORDS - 1)] = value;
+	_pool.head = head + 1;
+	_pool.stats.words++;
+
+	/* end of the refill burst */
+	if (_pool.head - _pool.tail >= TRNG_POOL_WORDS) {
+		_pool.refilling = false;
+		TRNG->TRNG_IDR = TRNG_IDR_DATRDY;
+	}
+}
+
+static void _trng_pool_refill(void)
+{
+	if (_pool.refilling || _pool.failed)
+		return;
+	_pool.refilling = true;
+	_pool.stats.refills++;
+	TRNG->TRNG_IER = TRNG_IER_DATRDY;
+}
+
 static void _trng_handler(uint32_t source, void* user_arg)
 {
 	assert(source == ID_TRNG);
 	if (TRNG->TRNG_ISR & TRNG_ISR_DATRDY) {
-		if (_trng_callback) {
+		if (_pool.running) {
+			_trng_pool_push(TRNG->TRNG_ODATA);
+		} else if (_trng_callback) {
 			_trng_callback(TRNG->TRNG_ODATA, _trng_callback_arg);
 		}
 	}
@@ -131,3 +221,65 @@ uint32_t trng_get_random_data(void)
 	while (!(TRNG->TRNG_ISR & TRNG_ISR_DATRDY));
 	return TRNG->TRNG_ODATA;
 }
+
+void trng_pool_start(void)
+{
+	irq_disable(ID_TRNG);
+	TRNG->TRNG_IDR = TRNG_IDR_DATRDY;
+	memset(&_pool, 0, sizeof(_pool));
+	_pool.running = true;
+
+	trng_enable();
+	irq_add_handler(ID_TRNG, _trng_handler, NULL);
+	irq_enable(ID_TRNG);
+	_trng_pool_refill();
+}
+
+void trng_pool_stop(void)
+{
+	TRNG->TRNG_IDR = TRNG_IDR_DATRDY;
+	irq_disable(ID_TRNG);
+	_pool.running = false;
+	_pool.refilling = false;
+	memset(_pool.ring, 0, sizeof(_pool.ring));
+}
+
+int trng_pool_read(void* buffer, uint32_t len)
+{
+	uint8_t* out = (uint8_t*)buffer;
+	uint32_t tail, value, n, done = 0;
+
+	if (!_pool.running)
+		return -EPERM;
+
+	while (done < len) {
+		if (_pool.failed)
+			return -EIO;
+		tail = _pool.tail;
+		if (_pool.head == tail) {
+			_trng_pool_refill();
+			continue;
+		}
+		value = _pool.ring[tail & (TRNG_POOL_WORDS - 1)];
+		_pool.ring[tail & (TRNG_POOL_WORDS - 1)] = 0;
+		_pool.tail = tail + 1;
+
+		n = len - done < 4 ? len - done : 4;
+		memcpy(&out[done], &value, n);
+		done += n;
+	}
+
+	if (_pool.head - _pool.tail <= TRNG_POOL_WORDS / 2)
+		_trng_pool_refill();
+	return (int)len;
+}
+
+uint32_t trng_pool_available(void)
+{
+	return (_pool.head - _pool.tail) * sizeof(uint32_t);
+}
+
+void trng_pool_get_stats(struct _trng_pool_stats* stats)
+{
+	*stats = _pool.stats;
+}
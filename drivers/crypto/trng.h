@@ -36,15 +36,30 @@
  *         Headers
  *------------------------------------------------------------------------------*/
 
+#include <stdbool.h>
 #include <stdint.h>
 #include "chip.h"
 
+/*------------------------------------------------------------------------------
+ *         Definitions
+ *------------------------------------------------------------------------------*/
+
+/** Entropy pool size in 32-bit words, power of two */
+#define TRNG_POOL_WORDS 64
+
 /*------------------------------------------------------------------------------
  *         Types
  *------------------------------------------------------------------------------*/
 
 typedef void (*trng_callback_t)(uint32_t random_value, void* user_arg);
 
+struct _trng_pool_stats {
+	uint32_t words;         /**< Words accepted in the pool */
+	uint32_t refills;       /**< Refill bursts started */
+	uint32_t rct_failures;  /**< Repetition count test failures */
+	uint32_t apt_failures;  /**< Adaptive proportion test failures */
+};
+
 /*------------------------------------------------------------------------------
  *         Exported functions
  *------------------------------------------------------------------------------*/
@@ -80,6 +95,45 @@ extern void trng_disable_it(void);
  */
 extern uint32_t trng_get_random_data(void);
 
+/**
+ * \brief Start the entropy pool.
+ *
+ * The TRNG interrupt fills a ring of TRNG_POOL_WORDS words. It is enabled
+ * when the ring is half empty and disabled when it is full, so the TRNG
+ * interrupts come in bursts instead of once per word forever. Every word
+ * goes through a repetition count test and an adaptive proportion test
+ * (NIST SP 800-90B 4.4), a failure stops the pool output until the next
+ * trng_pool_start().
+ *
+ * The pool replaces the trng_enable_it() callback while it runs.
+ */
+extern void trng_pool_start(void);
+
+/**
+ * \brief Stop the entropy pool and the TRNG interrupt.
+ */
+extern void trng_pool_stop(void);
+
+/**
+ * \brief Read entropy from the pool, waiting for the TRNG if the pool runs
+ * dry. Words handed out are cleared from the pool.
+ * \param buffer  destination
+ * \param len     number of bytes
+ * \return len on success, -EIO after a health test failure, -EPERM if the
+ * pool is not started
+ */
+extern int trng_pool_read(void* buffer, uint32_t len);
+
+/**
+ * \brief Get the number of bytes immediately available in the pool.
+ */
+extern uint32_t trng_pool_available(void);
+
+/**
+ * \brief Get the pool statistics.
+ */
+extern void trng_pool_get_stats(struct _trng_pool_stats* stats);
+
 #endif /* CONFIG_HAVE_TRNG */
 
 #endif /* _TRNG_H_ */
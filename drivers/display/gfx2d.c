@@ -0,0 +1,410 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stddef.h>
+#include <string.h>
+
+#include "chip.h"
+#include "compiler.h"
+#include "display/gfx2d.h"
+#include "display/lcdc.h"
+#include "errno.h"
+#include "intmath.h"
+#include "mm/cache.h"
+#include "pixel.h"
+
+#ifdef CONFIG_HAVE_XDMAC
+#include "dma/dma.h"
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+#ifdef CONFIG_HAVE_XDMAC
+/** Memory to memory channel, NULL when the CPU does all the work */
+static struct _dma_channel *gfx2d_dma;
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static inline uint8_t *_pixel_addr(const struct _gfx2d_surface *surface,
+		uint32_t x, uint32_t y)
+{
+	return (uint8_t *)surface->buffer + y * surface->pitch +
+		x * (surface->bpp / 8);
+}
+
+static inline uint32_t _area(uint32_t x1, uint32_t y1, uint32_t x2, uint32_t y2)
+{
+	return (x2 - x1) * (y2 - y1);
+}
+
+/**
+ * Clip a rectangle to a surface
+ * \return false if nothing is left.
+ */
+static bool _clip(const struct _gfx2d_surface *surface,
+		const struct _gfx2d_rect *rect, struct _gfx2d_rect *out)
+{
+	if (rect->x >= surface->width || rect->y >= surface->height)
+		return false;
+	out->x = rect->x;
+	out->y = rect->y;
+	out->width = min_u32(rect->width, surface->width - rect->x);
+	out->height = min_u32(rect->height, surface->height - rect->y);
+	return out->width && out->height;
+}
+
+/**
+ * Clip a copy of src_rect to (x, y) so that it fits in both surfaces.
+ * \return false if nothing is left.
+ */
+static bool _clip_copy(const struct _gfx2d_surface *dst, uint16_t x,
+		uint16_t y, const struct _gfx2d_surface *src,
+		const struct _gfx2d_rect *src_rect, struct _gfx2d_rect *out)
+{
+	if (!_clip(src, src_rect, out))
+		return false;
+	if (x >= dst->width || y >= dst->height)
+		return false;
+	out->width = min_u32(out->width, dst->width - x);
+	out->height = min_u32(out->height, dst->height - y);
+	return true;
+}
+
+/**
+ * Add a rectangle to the dirty list. Overlapping or touching rectangles
+ * are merged, when the list is full the rectangle is merged with the entry
+ * whose bounding box grows the least.
+ */
+static void _add_dirty(struct _gfx2d_surface *surface,
+		const struct _gfx2d_rect *rect)
+{
+	uint32_t x1 = rect->x, y1 = rect->y;
+	uint32_t x2 = x1 + rect->width, y2 = y1 + rect->height;
+	uint32_t best_cost = UINT32_MAX;
+	int best = -1;
+	int i;
+
+	for (i = 0; i < surface->num_dirty; i++) {
+		struct _gfx2d_rect *d = &surface->dirty[i];
+		uint32_t dx2 = d->x + d->width, dy2 = d->y + d->height;
+		uint32_t ux1 = min_u32(x1, d->x), uy1 = min_u32(y1, d->y);
+		uint32_t ux2 = max_u32(x2, dx2), uy2 = max_u32(y2, dy2);
+		uint32_t cost;
+
+		if (x1 >= d->x && y1 >= d->y && x2 <= dx2 && y2 <= dy2)
+			return;
+
+		cost = _area(ux1, uy1, ux2, uy2) - _area(d->x, d->y, dx2, dy2);
+		if (x1 <= dx2 && d->x <= x2 && y1 <= dy2 && d->y <= y2) {
+			/* overlapping or adjacent: always merge */
+			best = i;
+			break;
+		}
+		if (cost < best_cost) {
+			best_cost = cost;
+			best = i;
+		}
+	}
+
+	if (i == surface->num_dirty && surface->num_dirty < GFX2D_MAX_DIRTY) {
+		surface->dirty[surface->num_dirty++] = *rect;
+		return;
+	}
+
+	if (best >= 0) {
+		struct _gfx2d_rect *d = &surface->dirty[best];
+		uint32_t ux2 = max_u32(x2, d->x + d->width);
+		uint32_t uy2 = max_u32(y2, d->y + d->height);
+
+		d->x = min_u32(x1, d->x);
+		d->y = min_u32(y1, d->y);
+		d->width = ux2 - d->x;
+		d->height = uy2 - d->y;
+	}
+}
+
+#ifdef CONFIG_HAVE_XDMAC
+/**
+ * Run a 2D transfer on the XDMAC: one microblock per row, the microblock
+ * strides skip the rest of the rows. When src is NULL the destination is
+ * filled with pattern.
+ * \return 0 on success, -ENOTSUP if the transfer must be done by the CPU.
+ */
+static int _dma_2d(uint8_t *dst, uint32_t dst_pitch, const uint8_t *src,
+		uint32_t src_pitch, uint32_t row_bytes, uint32_t rows,
+		uint32_t pattern)
+{
+	struct _xdmacd_cfg cfg;
+	uint32_t align, width, dst_len, src_len;
+
+	if (!gfx2d_dma || rows > XDMAC_MAX_BLOCK_LEN + 1 ||
+	    row_bytes * rows < GFX2D_DMA_THRESHOLD)
+		return -ENOTSUP;
+
+	align = (uint32_t)dst | dst_pitch | row_bytes;
+	if (src)
+		align |= (uint32_t)src | src_pitch;
+	if (!(align & 3))
+		width = DMA_DATA_WIDTH_WORD;
+	else if (!(align & 1))
+		width = DMA_DATA_WIDTH_HALF_WORD;
+	else
+		width = DMA_DATA_WIDTH_BYTE;
+
+	cfg.ubc = row_bytes >> width;
+	cfg.bc = rows - 1;
+	cfg.dus = dst_pitch - row_bytes;
+	cfg.da = dst;
+	cfg.cfg = XDMAC_CC_TYPE_MEM_TRAN | XDMAC_CC_MBSIZE_SIXTEEN |
+		XDMAC_CC_SWREQ_SWR_CONNECTED | XDMAC_CC_DSYNC_MEM2PER |
+		XDMAC_CC_CSIZE_CHK_1 | XDMAC_CC_DWIDTH(width) |
+		XDMAC_CC_SIF_AHB_IF0 | XDMAC_CC_DIF_AHB_IF0 |
+		XDMAC_CC_DAM_UBS_AM;
+	if (src) {
+		cfg.sa = (void *)src;
+		cfg.sus = src_pitch - row_bytes;
+		cfg.ds = 0;
+		cfg.cfg |= XDMAC_CC_SAM_UBS_AM;
+	} else {
+		cfg.sa = NULL;
+		cfg.sus = 0;
+		cfg.ds = pattern;
+		cfg.cfg |= XDMAC_CC_SAM_FIXED_AM | XDMAC_CC_MEMSET_HW_MODE;
+	}
+
+	/* Write back what the CPU drew before the DMA accesses memory, the
+	 * destination lines are invalidated once the DMA is done */
+	dst_len = (rows - 1) * dst_pitch + row_bytes;
+	cache_clean_region(dst, dst_len);
+	if (src) {
+		src_len = (rows - 1) * src_pitch + row_bytes;
+		cache_clean_region(src, src_len);
+	}
+
+	if (xdmacd_configure_transfer(gfx2d_dma, &cfg, 0, NULL) < 0)
+		return -ENOTSUP;
+	dma_start_transfer(gfx2d_dma);
+	while (!dma_is_transfer_done(gfx2d_dma))
+		dma_poll();
+	dma_reset_channel(gfx2d_dma);
+
+	cache_invalidate_region(dst, dst_len);
+	return 0;
+}
+#endif /* CONFIG_HAVE_XDMAC */
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+int gfx2d_initialize(bool use_dma)
+{
+#ifdef CONFIG_HAVE_XDMAC
+	if (gfx2d_dma) {
+		dma_free_channel(gfx2d_dma);
+		gfx2d_dma = NULL;
+	}
+	if (use_dma) {
+		gfx2d_dma = dma_allocate_channel(DMA_PERIPH_MEMORY,
+				DMA_PERIPH_MEMORY);
+		if (!gfx2d_dma)
+			return -ENODEV;
+		dma_prepare_channel(gfx2d_dma);
+	}
+	return 0;
+#else
+	return use_dma ? -ENODEV : 0;
+#endif
+}
+
+int gfx2d_surface_init(struct _gfx2d_surface *surface, void *buffer,
+		uint16_t width, uint16_t height, uint8_t bpp)
+{
+	if (bpp != 16 && bpp != 24 && bpp != 32)
+		return -EINVAL;
+
+	surface->buffer = buffer;
+	surface->width = width;
+	surface->height = height;
+	surface->bpp = bpp;
+	surface->pitch = ROUND_UP_MULT(width * (bpp / 8), 4);
+	surface->num_dirty = 0;
+	return 0;
+}
+
+int gfx2d_surface_from_canvas(struct _gfx2d_surface *surface)
+{
+	struct _lcdc_layer *canvas = lcdc_get_canvas();
+
+	if (!canvas || !canvas->buffer)
+		return -ENODEV;
+	return gfx2d_surface_init(surface, canvas->buffer, canvas->width,
+			canvas->height, canvas->bpp);
+}
+
+void gfx2d_invalidate(struct _gfx2d_surface *surface,
+		const struct _gfx2d_rect *rect)
+{
+	struct _gfx2d_rect r;
+
+	if (_clip(surface, rect, &r))
+		_add_dirty(surface, &r);
+}
+
+void gfx2d_fill_rect(struct _gfx2d_surface *surface,
+		const struct _gfx2d_rect *rect, uint32_t color)
+{
+	struct _gfx2d_rect r;
+	uint32_t row_bytes, i;
+	uint8_t *dst;
+	int err = -ENOTSUP;
+
+	if (!_clip(surface, rect, &r))
+		return;
+
+	dst = _pixel_addr(surface, r.x, r.y);
+	row_bytes = r.width * (surface->bpp / 8);
+
+#ifdef CONFIG_HAVE_XDMAC
+	/* 24 bpp patterns do not fit the 32-bit memset pattern */
+	if (surface->bpp != 24) {
+		uint32_t pattern = color;
+
+		if (surface->bpp == 16)
+			pattern = PIXEL_ARGB_TO_RGB565(color) * 0x00010001u;
+		err = _dma_2d(dst, surface->pitch, NULL, 0, row_bytes,
+				r.height, pattern);
+	}
+#endif
+
+	if (err < 0) {
+		/* fill the first row, copy it to the others */
+		pixel_fill(dst, color, r.width, surface->bpp);
+		for (i = 1; i < r.height; i++)
+			memcpy(dst + i * surface->pitch, dst, row_bytes);
+	}
+	_add_dirty(surface, &r);
+}
+
+void gfx2d_copy_rect(struct _gfx2d_surface *dst, uint16_t x, uint16_t y,
+		const struct _gfx2d_surface *src,
+		const struct _gfx2d_rect *src_rect)
+{
+	struct _gfx2d_rect r;
+	const uint8_t *s;
+	uint8_t *d;
+	uint32_t i;
+
+	if (!_clip_copy(dst, x, y, src, src_rect, &r))
+		return;
+
+	s = _pixel_addr(src, r.x, r.y);
+	d = _pixel_addr(dst, x, y);
+	r.x = x;
+	r.y = y;
+
+	if (dst->bpp == src->bpp) {
+		uint32_t row_bytes = r.width * (dst->bpp / 8);
+		int err = -ENOTSUP;
+
+#ifdef CONFIG_HAVE_XDMAC
+		err = _dma_2d(d, dst->pitch, s, src->pitch, row_bytes,
+				r.height, 0);
+#endif
+		if (err < 0) {
+			for (i = 0; i < r.height; i++)
+				memcpy(d + i * dst->pitch, s + i * src->pitch,
+						row_bytes);
+		}
+	} else {
+		for (i = 0; i < r.height; i++)
+			pixel_convert(d + i * dst->pitch, dst->bpp,
+					s + i * src->pitch, src->bpp, r.width);
+	}
+	_add_dirty(dst, &r);
+}
+
+int gfx2d_blend_rect(struct _gfx2d_surface *dst, uint16_t x, uint16_t y,
+		const struct _gfx2d_surface *src,
+		const struct _gfx2d_rect *src_rect)
+{
+	struct _gfx2d_rect r;
+	const uint8_t *s;
+	uint8_t *d;
+	uint32_t i;
+
+	if (src->bpp != 32)
+		return -EINVAL;
+	if (!_clip_copy(dst, x, y, src, src_rect, &r))
+		return 0;
+
+	s = _pixel_addr(src, r.x, r.y);
+	d = _pixel_addr(dst, x, y);
+	for (i = 0; i < r.height; i++)
+		pixel_blend(d + i * dst->pitch, dst->bpp,
+				(const uint32_t *)(s + i * src->pitch), r.width);
+
+	r.x = x;
+	r.y = y;
+	_add_dirty(dst, &r);
+	return 0;
+}
+
+void gfx2d_flush(struct _gfx2d_surface *surface)
+{
+	uint8_t i;
+	uint32_t row;
+
+	for (i = 0; i < surface->num_dirty; i++) {
+		const struct _gfx2d_rect *r = &surface->dirty[i];
+		uint8_t *start = _pixel_addr(surface, r->x, r->y);
+		uint32_t row_bytes = r->width * (surface->bpp / 8);
+
+		/* narrow rectangles are cleaned row by row, so that the
+		 * untouched part of the rows is not walked */
+		if (2 * row_bytes >= surface->pitch || r->height == 1) {
+			cache_clean_region(start,
+					(r->height - 1) * surface->pitch + row_bytes);
+		} else {
+			for (row = 0; row < r->height; row++)
+				cache_clean_region(start + row * surface->pitch,
+						row_bytes);
+		}
+	}
+	surface->num_dirty = 0;
+}
@@ -0,0 +1,166 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \file
+ *
+ * 2D drawing on LCDC layer buffers with dirty-rectangle tracking.
+ *
+ * Drawing operations record the rectangles they modify on the surface,
+ * gfx2d_flush() then cleans only those regions from the data cache before
+ * the LCDC fetches the frame. Same-format copies and 16/32 bpp fills are
+ * done by the XDMAC in microblock stride mode (one microblock per row)
+ * when the device has one, format conversions and alpha blending use the
+ * row kernels of utils/pixel.h.
+ */
+
+#ifndef GFX2D_H_
+#define GFX2D_H_
+
+#ifdef CONFIG_HAVE_LCDC
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Number of dirty rectangles tracked per surface, more are merged */
+#define GFX2D_MAX_DIRTY 8
+
+/** Operations smaller than this (in bytes) are not worth a DMA setup */
+#define GFX2D_DMA_THRESHOLD 1024
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** Rectangle */
+struct _gfx2d_rect {
+	uint16_t x;
+	uint16_t y;
+	uint16_t width;
+	uint16_t height;
+};
+
+/** Drawing surface */
+struct _gfx2d_surface {
+	void    *buffer;   /**< First pixel */
+	uint32_t pitch;    /**< Bytes between two rows */
+	uint16_t width;    /**< Width in pixels */
+	uint16_t height;   /**< Height in pixels */
+	uint8_t  bpp;      /**< Bits per pixel (16, 24 or 32) */
+
+	uint8_t  num_dirty;                        /**< Dirty rectangles */
+	struct _gfx2d_rect dirty[GFX2D_MAX_DIRTY]; /**< Not yet flushed */
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initialize the 2D module.
+ * \param use_dma  Use the DMA for fills and copies when available.
+ * \return 0 on success, -ENODEV if no DMA channel is available (the module
+ * then works with the CPU only).
+ */
+extern int gfx2d_initialize(bool use_dma);
+
+/**
+ * \brief Describe a buffer as a surface. Rows are 4-byte aligned, as for
+ * the LCDC canvas.
+ * \return 0 on success, -EINVAL on unsupported bpp.
+ */
+extern int gfx2d_surface_init(struct _gfx2d_surface *surface, void *buffer,
+		uint16_t width, uint16_t height, uint8_t bpp);
+
+/**
+ * \brief Describe the current LCDC canvas (see lcdc_get_canvas()) as a
+ * surface.
+ * \return 0 on success, -ENODEV if there is no canvas.
+ */
+extern int gfx2d_surface_from_canvas(struct _gfx2d_surface *surface);
+
+/**
+ * \brief Mark a rectangle as modified, for drawing done outside of this
+ * module.
+ */
+extern void gfx2d_invalidate(struct _gfx2d_surface *surface,
+		const struct _gfx2d_rect *rect);
+
+/**
+ * \brief Fill a rectangle with a color.
+ * \param surface  Destination surface.
+ * \param rect     Rectangle, clipped to the surface.
+ * \param color    Color, 0xAARRGGBB.
+ */
+extern void gfx2d_fill_rect(struct _gfx2d_surface *surface,
+		const struct _gfx2d_rect *rect, uint32_t color);
+
+/**
+ * \brief Copy a rectangle between surfaces, converting the pixel format if
+ * needed.
+ * \param dst       Destination surface.
+ * \param x         Destination X coordinate.
+ * \param y         Destination Y coordinate.
+ * \param src       Source surface, must not overlap with the destination.
+ * \param src_rect  Source rectangle.
+ */
+extern void gfx2d_copy_rect(struct _gfx2d_surface *dst, uint16_t x,
+		uint16_t y, const struct _gfx2d_surface *src,
+		const struct _gfx2d_rect *src_rect);
+
+/**
+ * \brief Blend an ARGB8888 rectangle over a surface (source over).
+ * \param dst       Destination surface.
+ * \param x         Destination X coordinate.
+ * \param y         Destination Y coordinate.
+ * \param src       Source surface, 32 bpp.
+ * \param src_rect  Source rectangle.
+ * \return 0 on success, -EINVAL if the source is not 32 bpp.
+ */
+extern int gfx2d_blend_rect(struct _gfx2d_surface *dst, uint16_t x,
+		uint16_t y, const struct _gfx2d_surface *src,
+		const struct _gfx2d_rect *src_rect);
+
+/**
+ * \brief Write the dirty regions of a surface back to memory so that the
+ * LCDC displays them, and reset the dirty list.
+ */
+extern void gfx2d_flush(struct _gfx2d_surface *surface);
+
+#endif /* CONFIG_HAVE_LCDC */
+
+#endif /* GFX2D_H_ */
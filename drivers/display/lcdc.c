@@ -40,9 +40,12 @@
 #include "chip.h"
 #include "compiler.h"
 #include "display/lcdc.h"
+#include "errno.h"
 #include "gpio/pio.h"
+#include "irq/irq.h"
 #include "mm/cache.h"
 #include "peripherals/pmc.h"
+#include "timer.h"
 #include "trace.h"
 
 /** \addtogroup lcdc_base
@@ -71,6 +74,7 @@ struct _layer_info {
 	volatile uint32_t  *reg_color;      /**< regs: RGB Default, RGB Key, RGB Mask */
 	volatile uint32_t  *reg_scale;      /**< regs: scale */
 	volatile uint32_t  *reg_clut;       /**< regs: CLUT */
+	uint32_t            irq_mask;       /**< layer bit in LCDC_LCDIER */
 };
 
 /** DMA descriptor for LCDC */
@@ -87,9 +91,26 @@ struct _layer_data {
 	struct _lcdc_dma_desc *dma_u_desc;
 	struct _lcdc_dma_desc *dma_v_desc;
 	void                  *buffer;
+	uint32_t               size;    /**< bytes of the RGB image buffer */
 	uint8_t                bpp;
 };
 
+/** Swap chain of a layer, buffer indexes are -1 when unused */
+struct _swap_chain {
+	void                  *buffers[LCDC_SWAP_MAX_BUFFERS];
+	uint8_t                count;
+	volatile int8_t        front;   /**< buffer being scanned out */
+	volatile int8_t        pending; /**< buffer added to the DMA queue */
+	volatile int8_t        queued;  /**< buffer presented while one is pending */
+	int8_t                 back;    /**< buffer handed to the application */
+	struct _callback       callback;
+	struct _lcdc_swap_stats stats;
+	uint32_t               last_flip;
+};
+
+/** Number of entries in the layer table */
+#define LCDC_LAYER_SLOTS 6
+
 /*----------------------------------------------------------------------------
  *        Local variables
  *----------------------------------------------------------------------------*/
@@ -135,6 +156,11 @@ static struct _lcdc_dma_desc pp_dma_desc;    /**< DMA desc. for PP Layer */
 static struct _layer_data lcdc_pp;           /**< PP Layer */
 #endif
 
+CACHE_ALIGNED_DDR
+static struct _lcdc_dma_desc swap_dma_desc[LCDC_LAYER_SLOTS][LCDC_SWAP_MAX_BUFFERS];
+
+static struct _swap_chain swap_chains[LCDC_LAYER_SLOTS];
+
 /*----------------------------------------------------------------------------
  *        Local constants
  *----------------------------------------------------------------------------*/
@@ -156,7 +182,8 @@ static const struct _layer_info lcdc_layers[] = {
 		.reg_cfg = &LCDC->LCDC_BASECFG0,
 		.reg_stride = &LCDC->LCDC_BASECFG2,
 		.reg_color = &LCDC->LCDC_BASECFG3,
-		.reg_clut = &LCDC->LCDC_BASECLUT[0]
+		.reg_clut = &LCDC->LCDC_BASECLUT[0],
+		.irq_mask = LCDC_LCDIER_BASEIE,
 	},
 #ifdef CONFIG_HAVE_LCDC_OVR1
 	/* 2: LCDC_OVR1 */
@@ -171,6 +198,7 @@ static const struct _layer_info lcdc_layers[] = {
 		.reg_stride = &LCDC->LCDC_OVR1CFG4,
 		.reg_color = &LCDC->LCDC_OVR1CFG6,
 		.reg_clut = &LCDC->LCDC_OVR1CLUT[0],
+		.irq_mask = LCDC_LCDIER_OVR1IE,
 	},
 #else
 	/* 2: N/A */
@@ -193,6 +221,7 @@ static const struct _layer_info lcdc_layers[] = {
 		.reg_color = &LCDC->LCDC_HEOCFG9,
 		.reg_scale = &LCDC->LCDC_HEOCFG13,
 		.reg_clut = &LCDC->LCDC_HEOCLUT[0],
+		.irq_mask = LCDC_LCDIER_HEOIE,
 	},
 #ifdef CONFIG_HAVE_LCDC_OVR2
 	/* 4: LCDC_OVR2 */
@@ -207,6 +236,7 @@ static const struct _layer_info lcdc_layers[] = {
 		.reg_stride = &LCDC->LCDC_OVR2CFG4,
 		.reg_color = &LCDC->LCDC_OVR2CFG6,
 		.reg_clut = &LCDC->LCDC_OVR2CLUT[0],
+		.irq_mask = LCDC_LCDIER_OVR2IE,
 	},
 #else
 	/* 4: N/A */
@@ -223,6 +253,7 @@ static const struct _layer_info lcdc_layers[] = {
 		.reg_dma_head = &LCDC->LCDC_PPHEAD,
 		.reg_cfg = &LCDC->LCDC_PPCFG0,
 		.reg_stride = &LCDC->LCDC_PPCFG2,
+		.irq_mask = LCDC_LCDIER_PPIE,
 	},
 #else
 	/* 5: N/A */
@@ -341,6 +372,88 @@ static void _clear_dma_desc(struct _lcdc_dma_desc *desc,
 	dma_head_reg[3] = (uint32_t)desc;
 }
 
+/**
+ * Add the descriptor of a swap chain buffer to the layer DMA queue. The
+ * LCDC loads it at the end of the current frame.
+ */
+static void _swap_queue(uint8_t layer_id, struct _swap_chain *chain,
+		int8_t index)
+{
+	const struct _layer_info *layer = &lcdc_layers[layer_id];
+	struct _lcdc_dma_desc *desc = &swap_dma_desc[layer_id][index];
+
+	desc->addr = (uint32_t)chain->buffers[index];
+	desc->ctrl = LCDC_BASECTRL_DFETCH | LCDC_BASECTRL_DMAIEN |
+		LCDC_BASECTRL_ADDIEN;
+	desc->next = (uint32_t)desc;
+	cache_clean_region(desc, sizeof(*desc));
+	layer->reg_dma_head[0] = (uint32_t)desc;
+	layer->reg_enable[0] = LCDC_BASECHER_A2QEN;
+}
+
+/**
+ * Called when the pending buffer of a swap chain has been loaded: it is now
+ * scanned out and the previous front buffer is released.
+ */
+static void _swap_flip_done(uint8_t layer_id, struct _swap_chain *chain)
+{
+	int8_t released = chain->front;
+	uint32_t now, elapsed;
+
+	if (chain->pending < 0)
+		return;
+
+	chain->front = chain->pending;
+	chain->pending = -1;
+	lcdc_layers[layer_id].data->buffer = chain->buffers[chain->front];
+
+	now = timer_get_tick();
+	if (chain->stats.flips) {
+		elapsed = timer_get_interval(chain->last_flip, now);
+		chain->stats.frame_time_last = elapsed;
+		if (elapsed < chain->stats.frame_time_min)
+			chain->stats.frame_time_min = elapsed;
+		if (elapsed > chain->stats.frame_time_max)
+			chain->stats.frame_time_max = elapsed;
+	}
+	chain->last_flip = now;
+	chain->stats.flips++;
+
+	if (chain->queued >= 0) {
+		_swap_queue(layer_id, chain, chain->queued);
+		chain->pending = chain->queued;
+		chain->queued = -1;
+	}
+
+	if (released >= 0)
+		callback_call(&chain->callback, chain->buffers[released]);
+}
+
+/**
+ * LCDC interrupt handler, drives the swap chains
+ */
+static void _lcdc_handler(uint32_t source, void *user_arg)
+{
+	uint8_t id;
+	uint32_t status;
+
+	(void)LCDC->LCDC_LCDISR;
+
+	for (id = LCDC_BASE; id < ARRAY_SIZE(lcdc_layers); id++) {
+		struct _swap_chain *chain = &swap_chains[id];
+
+		if (!chain->count)
+			continue;
+
+		/* reading _ISR clears the layer interrupts */
+		status = lcdc_layers[id].reg_enable[6];
+		if (status & LCDC_BASEISR_DMA)
+			chain->stats.frames++;
+		if (status & LCDC_BASEISR_ADD)
+			_swap_flip_done(id, chain);
+	}
+}
+
 /**
  * Compute scaling factors
  */
@@ -937,6 +1050,7 @@ void * lcdc_put_image_rotated(uint8_t layer_id,
 		bytes_per_row++;
 	if (bytes_per_row & 0x3)
 		padding = 4 - (bytes_per_row & 0x3);
+	data->size = (bytes_per_row + padding) * img_h;
 
 	/* No X mirror supported layer, no Right->Left scan */
 	if (!layer->stride_supported)
@@ -1881,4 +1995,186 @@ uint32_t lcdc_configure_get_mode(uint8_t layer_id)
 	return layer->reg_cfg[1];
 }
 
+/**
+ * \brief Attach a swap chain to a layer.
+ *
+ * The layer must have been set up first (lcdc_put_image(),
+ * lcdc_create_canvas()...), the swap chain then only replaces the frame
+ * buffer address. The first buffer is displayed right away. Only single
+ * plane (RGB or packed YUV) layouts are supported.
+ *
+ * \param layer_id  Layer ID.
+ * \param buffers   Frame buffers, all of the size of the layer image.
+ * \param count     Number of buffers (2 or LCDC_SWAP_MAX_BUFFERS).
+ * \param cb        Callback invoked each time a buffer leaves the screen
+ *                  (from the LCDC interrupt) or is dropped before reaching
+ *                  it (from lcdc_swap_present()), with the buffer as
+ *                  argument (optional).
+ * \return 0 on success, -EINVAL on invalid parameter.
+ */
+int lcdc_swap_init(uint8_t layer_id, void * const *buffers, uint8_t count,
+		struct _callback *cb)
+{
+	const struct _layer_info *layer;
+	struct _swap_chain *chain;
+	uint8_t i;
+
+	if (layer_id == LCDC_CONTROLLER || layer_id >= ARRAY_SIZE(lcdc_layers))
+		return -EINVAL;
+	layer = &lcdc_layers[layer_id];
+	if (!layer->data || !layer->irq_mask)
+		return -EINVAL;
+	if (count < 2 || count > LCDC_SWAP_MAX_BUFFERS)
+		return -EINVAL;
+
+	lcdc_swap_deinit(layer_id);
+
+	chain = &swap_chains[layer_id];
+	memset(chain, 0, sizeof(*chain));
+	for (i = 0; i < count; i++)
+		chain->buffers[i] = buffers[i];
+	chain->front = -1;
+	chain->pending = -1;
+	chain->queued = -1;
+	chain->back = -1;
+	chain->stats.frame_time_min = UINT32_MAX;
+	callback_copy(&chain->callback, cb);
+
+	irq_add_handler(ID_LCDC, _lcdc_handler, NULL);
+
+	if (layer->reg_enable[2] & LCDC_BASECHSR_CHSR) {
+		/* channel running: switch to buffer 0 at the next frame */
+		_swap_queue(layer_id, chain, 0);
+		chain->pending = 0;
+	} else {
+		_set_dma_desc(buffers[0], &swap_dma_desc[layer_id][0],
+				layer->reg_dma_head);
+		swap_dma_desc[layer_id][0].ctrl |= LCDC_BASECTRL_DMAIEN |
+			LCDC_BASECTRL_ADDIEN;
+		cache_clean_region(&swap_dma_desc[layer_id][0],
+				sizeof(struct _lcdc_dma_desc));
+		chain->front = 0;
+		layer->data->buffer = buffers[0];
+	}
+	chain->count = count;
+
+	layer->reg_enable[3] = LCDC_BASEIER_DMA | LCDC_BASEIER_ADD;
+	LCDC->LCDC_LCDIER = layer->irq_mask;
+	irq_enable(ID_LCDC);
+
+	return 0;
+}
+
+/**
+ * \brief Detach the swap chain of a layer. The buffer on screen stays
+ * displayed.
+ * \param layer_id  Layer ID.
+ */
+void lcdc_swap_deinit(uint8_t layer_id)
+{
+	const struct _layer_info *layer;
+
+	if (layer_id == LCDC_CONTROLLER || layer_id >= ARRAY_SIZE(lcdc_layers))
+		return;
+	layer = &lcdc_layers[layer_id];
+	if (!swap_chains[layer_id].count)
+		return;
+
+	irq_disable(ID_LCDC);
+	LCDC->LCDC_LCDIDR = layer->irq_mask;
+	layer->reg_enable[4] = LCDC_BASEIDR_DMA | LCDC_BASEIDR_ADD;
+	swap_chains[layer_id].count = 0;
+	irq_enable(ID_LCDC);
+}
+
+/**
+ * \brief Get the buffer to render the next frame into.
+ *
+ * The same buffer is returned until it is passed to lcdc_swap_present().
+ *
+ * \param layer_id  Layer ID.
+ * \return Pointer to the buffer, NULL if all buffers are on screen or
+ * waiting to be displayed.
+ */
+void *lcdc_swap_get_back(uint8_t layer_id)
+{
+	struct _swap_chain *chain = &swap_chains[layer_id];
+	void *buffer = NULL;
+	int8_t i;
+
+	if (!chain->count)
+		return NULL;
+	if (chain->back >= 0)
+		return chain->buffers[chain->back];
+
+	irq_disable(ID_LCDC);
+	for (i = 0; i < chain->count; i++) {
+		if (i != chain->front && i != chain->pending && i != chain->queued) {
+			chain->back = i;
+			buffer = chain->buffers[i];
+			break;
+		}
+	}
+	if (!buffer)
+		chain->stats.stalls++;
+	irq_enable(ID_LCDC);
+
+	return buffer;
+}
+
+/**
+ * \brief Present the buffer returned by lcdc_swap_get_back().
+ *
+ * The buffer is added to the layer DMA queue and displayed from the next
+ * frame on, the controller switches buffers between frames so there is no
+ * tearing. If a buffer presented earlier has not reached the screen yet,
+ * it is replaced (triple buffering), counted as dropped and given back
+ * through the swap chain callback.
+ *
+ * \param layer_id  Layer ID.
+ * \return 0 on success, -EINVAL if there is no back buffer.
+ */
+int lcdc_swap_present(uint8_t layer_id)
+{
+	struct _swap_chain *chain = &swap_chains[layer_id];
+	int8_t dropped = -1;
+
+	if (!chain->count || chain->back < 0)
+		return -EINVAL;
+
+	cache_clean_region(chain->buffers[chain->back],
+			lcdc_layers[layer_id].data->size);
+
+	irq_disable(ID_LCDC);
+	if (chain->pending < 0) {
+		_swap_queue(layer_id, chain, chain->back);
+		chain->pending = chain->back;
+	} else {
+		if (chain->queued >= 0) {
+			chain->stats.dropped++;
+			dropped = chain->queued;
+		}
+		chain->queued = chain->back;
+	}
+	chain->back = -1;
+	irq_enable(ID_LCDC);
+
+	if (dropped >= 0)
+		callback_call(&chain->callback, chain->buffers[dropped]);
+
+	return 0;
+}
+
+/**
+ * \brief Get the statistics of the swap chain of a layer.
+ * \param layer_id  Layer ID.
+ * \param stats     Returns the statistics.
+ */
+void lcdc_swap_get_stats(uint8_t layer_id, struct _lcdc_swap_stats *stats)
+{
+	irq_disable(ID_LCDC);
+	*stats = swap_chains[layer_id].stats;
+	irq_enable(ID_LCDC);
+}
+
 /**@}*/
@@ -58,6 +58,11 @@
  *    -# lcdc_show_base(), lcdc_stop_base()
  *    -# lcdc_show_ovr1(), lcdc_stop_ovr1()
  *    -# lcdc_show_heo(), lcdc_stop_heo()
+ * -# Tear-free animation with a swap chain of 2 or 3 buffers per layer:
+ *    -# lcdc_swap_init(): Attach the buffers to a configured layer
+ *    -# lcdc_swap_get_back(): Get a buffer to render into
+ *    -# lcdc_swap_present(): Queue it, it is displayed from the next frame
+ *    -# lcdc_swap_get_stats(): Frame counters and frame times
  * -# Drawing supporting functions, for drawing canvas:
  *    -# lcdc_create_canvas(): Create blank canvas on specified layer for
  *                            drawing on
@@ -118,6 +123,11 @@ enum {
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "callback.h"
+
+/** Maximum number of buffers in a layer swap chain */
+#define LCDC_SWAP_MAX_BUFFERS 3
+
 /*----------------------------------------------------------------------------
  *        Types
  *----------------------------------------------------------------------------*/
@@ -145,6 +155,17 @@ struct _lcdc_desc {
 	uint8_t timing_hpw; /**< Horizontal pulse width in LCDDOTCLK cycles */
 };
 
+/** Swap chain statistics */
+struct _lcdc_swap_stats {
+	uint32_t frames;          /**< Frames scanned out */
+	uint32_t flips;           /**< Presented buffers that reached the screen */
+	uint32_t dropped;         /**< Presented buffers replaced before reaching the screen */
+	uint32_t stalls;          /**< lcdc_swap_get_back() calls without free buffer */
+	uint32_t frame_time_last; /**< Time between the last two flips, in ms */
+	uint32_t frame_time_min;  /**< Shortest time between two flips, in ms */
+	uint32_t frame_time_max;  /**< Longest time between two flips, in ms */
+};
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -234,6 +255,18 @@ extern void *lcdc_create_canvas_yuv_semiplanar(uint8_t layer,
 #ifdef CONFIG_HAVE_LCDC_PP
 extern void lcdc_configure_pp(void *buffer, uint32_t output_mode);
 #endif
+
+extern int lcdc_swap_init(uint8_t layer_id, void * const *buffers,
+		uint8_t count, struct _callback *cb);
+
+extern void lcdc_swap_deinit(uint8_t layer_id);
+
+extern void *lcdc_swap_get_back(uint8_t layer_id);
+
+extern int lcdc_swap_present(uint8_t layer_id);
+
+extern void lcdc_swap_get_stats(uint8_t layer_id,
+		struct _lcdc_swap_stats *stats);
 /**  @}*/
 
 #endif /* CONFIG_HAVE_LCDC */
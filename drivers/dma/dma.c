@@ -217,6 +217,7 @@ static void _dma_sg_desc_free(struct _dma_sg_desc* list_head)
 {
 	struct _dma_sg_desc* curr = list_head;
 	struct _dma_sg_desc* tail;
+	uint8_t count = 0;
 
 	if (list_head == NULL)
 		return;
@@ -224,6 +225,7 @@ static void _dma_sg_desc_free(struct _dma_sg_desc* list_head)
 	do {
 		tail = curr;
 		curr = DMA_SG_DESC_GET_NEXT(curr);
+		count++;
 	} while ((curr != NULL) && (curr != list_head));
 	curr = list_head;
 
@@ -236,6 +238,7 @@ static void _dma_sg_desc_free(struct _dma_sg_desc* list_head)
 		DMA_SG_DESC_SET_NEXT(_dma_sg_pool.tail, list_head);
 	_dma_sg_pool.tail = tail;
 	DMA_SG_DESC_SET_NEXT(_dma_sg_pool.tail, 0);
+	_dma_sg_pool.count += count;
 
 	mutex_unlock(&_dma_sg_pool.mutex);
 }
@@ -256,6 +259,8 @@ static int _dma_configure_transfer(struct _dma_channel* channel,
 
 	memset(&desc, 0, sizeof(desc));
 
+	channel->loop = false;
+
 	src_is_periph = is_source_periph(channel);
 	dst_is_periph = is_dest_periph(channel);
 
@@ -367,6 +372,10 @@ static int _dma_sg_configure_transfer(struct _dma_channel* channel,
 	src_is_periph = is_source_periph(channel);
 	dst_is_periph = is_dest_periph(channel);
 
+	/* Release the list of a previous configuration */
+	_dma_sg_desc_free(channel->sg_list);
+	channel->sg_list = NULL;
+
 	_sg_head = _dma_sg_desc_alloc(sg_list_size);
 	if (_sg_head == NULL)
 		return -ENOMEM;
@@ -427,6 +436,7 @@ static int _dma_sg_configure_transfer(struct _dma_channel* channel,
 		curr = DMA_SG_DESC_GET_NEXT(curr);
 	}
 	channel->sg_list = _sg_head;
+	channel->loop = cfg_dma->loop;
 
 	cache_clean_region(_dma_sg_pool.desc, sizeof(_dma_sg_pool.desc));
 
@@ -434,6 +444,7 @@ static int _dma_sg_configure_transfer(struct _dma_channel* channel,
 #if defined(CONFIG_HAVE_XDMAC)
 	struct _xdmacd_cfg xdmacd_cfg;
 	uint32_t desc_ctrl;
+	int err;
 
 	xdmacd_cfg.cfg = (src_is_periph | dst_is_periph) ? XDMAC_CC_TYPE_PER_TRAN : XDMAC_CC_TYPE_MEM_TRAN;
 	xdmacd_cfg.cfg |= src_is_periph ? XDMAC_CC_DSYNC_PER2MEM : XDMAC_CC_DSYNC_MEM2PER;
@@ -454,7 +465,12 @@ static int _dma_sg_configure_transfer(struct _dma_channel* channel,
 	           | XDMAC_CNDC_NDSUP_SRC_PARAMS_UPDATED
 	           | XDMAC_CNDC_NDDUP_DST_PARAMS_UPDATED;
 
-	return xdmacd_configure_transfer(channel, &xdmacd_cfg, desc_ctrl, (void *)_sg_head);
+	err = xdmacd_configure_transfer(channel, &xdmacd_cfg, desc_ctrl, (void *)_sg_head);
+	if (err == 0 && cfg_dma->loop) {
+		/* A circular list never ends, report the end of each item */
+		xdmac_enable_channel_it(channel->hw, channel->id, XDMAC_CIE_BIE);
+	}
+	return err;
 #elif defined(CONFIG_HAVE_DMAC)
 	struct _dmacd_cfg dmacd_cfg;
 
@@ -559,6 +575,7 @@ struct _dma_channel* dma_allocate_channel(uint8_t src, uint8_t dest)
 				dma_prepare_channel(channel);
 
 				channel->sg_list = NULL;
+				channel->loop = false;
 
 				return channel;
 			}
@@ -569,8 +586,12 @@ struct _dma_channel* dma_allocate_channel(uint8_t src, uint8_t dest)
 
 int dma_reset_channel(struct _dma_channel* channel)
 {
-	if (channel->state == DMA_STATE_ALLOCATED)
+	if (channel->state == DMA_STATE_ALLOCATED) {
+		/* Release the list left by a stopped transfer */
+		_dma_sg_desc_free(channel->sg_list);
+		channel->sg_list = NULL;
 		return 0;
+	}
 
 	if (channel->state == DMA_STATE_STARTED)
 		return -EBUSY;
@@ -132,6 +132,7 @@ struct _dma_channel {
 	volatile uint32_t rep_count;/* repeat count in auto mode */
 #endif
 	volatile uint8_t state;		/* Channel State */
+	bool loop;			/* Circular scatter/gather list */
 
 	struct _dma_sg_desc* sg_list;
 };
@@ -147,7 +148,8 @@ struct _dma_cfg {
 	uint32_t chunk_size;
 	bool incr_saddr;
 	bool incr_daddr;
-	bool loop; /* Used by scatter/gather only */
+	bool loop; /* Used by scatter/gather only, the callback is then
+		      invoked at the end of each item of the list */
 };
 
 struct _dma_controller {
@@ -187,6 +187,9 @@ void dma_irq_handler(uint32_t source, void* user_arg)
 				channel->state = DMA_STATE_DONE;
 				exec = 1;
 			}
+		} else if ((gis & (DMAC_EBCISR_BTC0 << chan)) && channel->loop) {
+			/* End of one buffer of a circular list */
+			exec = 1;
 		}
 		/* Execute callback */
 		if (exec)
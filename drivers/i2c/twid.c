@@ -57,6 +57,13 @@
 #define TWID_POLLING_THRESHOLD  16
 #define TWID_TIMEOUT            100
 
+#ifdef CONFIG_HAVE_TWI_ALTERNATE_CMD
+/** Maximum data length of an alternative command (TWI_ACR.DATAL) */
+#define TWID_ACM_MAX_SIZE       255
+/** Maximum internal address length (TWI_MMR.IADRSZ) */
+#define TWID_IADR_MAX_SIZE      3
+#endif
+
 /** \brief twi asynchronous transfer descriptor.*/
 struct _async_desc
 {
@@ -173,6 +180,56 @@ static int _twid_wait_twi_transfer(struct _twi_desc* desc)
 	return 0;
 }
 
+#ifdef CONFIG_HAVE_TWI_FIFO
+
+/*
+ * Select the widest RXRDY threshold matching the transfer size and return
+ * the DMA data width to use with it.
+ */
+static uint32_t _twid_fifo_set_rx_threshold(struct _twi_desc* desc, uint32_t size)
+{
+	uint32_t rdym, width;
+
+	if ((size % 4) == 0) {
+		rdym = TWI_FMR_RXRDYM_FOUR_DATA;
+		width = DMA_DATA_WIDTH_WORD;
+	} else if ((size % 2) == 0) {
+		rdym = TWI_FMR_RXRDYM_TWO_DATA;
+		width = DMA_DATA_WIDTH_HALF_WORD;
+	} else {
+		rdym = TWI_FMR_RXRDYM_ONE_DATA;
+		width = DMA_DATA_WIDTH_BYTE;
+	}
+	desc->addr->TWI_FMR = (desc->addr->TWI_FMR & ~TWI_FMR_RXRDYM_Msk) | rdym;
+
+	return width;
+}
+
+/*
+ * Select the widest TXRDY threshold matching the transfer size and return
+ * the DMA data width to use with it.
+ */
+static uint32_t _twid_fifo_set_tx_threshold(struct _twi_desc* desc, uint32_t size)
+{
+	uint32_t rdym, width;
+
+	if ((size % 4) == 0) {
+		rdym = TWI_FMR_TXRDYM_FOUR_DATA;
+		width = DMA_DATA_WIDTH_WORD;
+	} else if ((size % 2) == 0) {
+		rdym = TWI_FMR_TXRDYM_TWO_DATA;
+		width = DMA_DATA_WIDTH_HALF_WORD;
+	} else {
+		rdym = TWI_FMR_TXRDYM_ONE_DATA;
+		width = DMA_DATA_WIDTH_BYTE;
+	}
+	desc->addr->TWI_FMR = (desc->addr->TWI_FMR & ~TWI_FMR_TXRDYM_Msk) | rdym;
+
+	return width;
+}
+
+#endif /* CONFIG_HAVE_TWI_FIFO */
+
 static int _twid_dma_read_callback(void* arg, void* arg2)
 {
 	struct _twi_desc* desc = (struct _twi_desc *)arg;
@@ -226,16 +283,7 @@ static void _twid_dma_read(struct _twi_desc* desc, struct _buffer* buffer)
 
 #ifdef CONFIG_HAVE_TWI_FIFO
 	if (desc->use_fifo) {
-		if ((buffer->size % 4) == 0) {
-			desc->addr->TWI_FMR = (desc->addr->TWI_FMR & ~TWI_FMR_RXRDYM_Msk) | TWI_FMR_RXRDYM_FOUR_DATA;
-			desc->dma.rx.cfg_dma.data_width = DMA_DATA_WIDTH_WORD;
-		} else if ((buffer->size % 2) == 0)  {
-			desc->addr->TWI_FMR = (desc->addr->TWI_FMR & ~TWI_FMR_RXRDYM_Msk) | TWI_FMR_RXRDYM_TWO_DATA;
-			desc->dma.rx.cfg_dma.data_width = DMA_DATA_WIDTH_HALF_WORD;
-		} else {
-			desc->addr->TWI_FMR = (desc->addr->TWI_FMR & ~TWI_FMR_RXRDYM_Msk) | TWI_FMR_RXRDYM_ONE_DATA;
-			desc->dma.rx.cfg_dma.data_width = DMA_DATA_WIDTH_BYTE;
-		}
+		desc->dma.rx.cfg_dma.data_width = _twid_fifo_set_rx_threshold(desc, buffer->size);
 		desc->dma.rx.cfg.len = buffer->size;
 	} else {
 		desc->dma.rx.cfg.len = buffer->size - 2;
@@ -296,16 +344,7 @@ static void _twid_dma_write(struct _twi_desc* desc, struct _buffer* buffer)
 	desc->dma.tx.cfg.daddr = (void*)&desc->addr->TWI_THR;
 #ifdef CONFIG_HAVE_TWI_FIFO
 	if (desc->use_fifo) {
-		if ((buffer->size % 4) == 0) {
-			desc->addr->TWI_FMR = (desc->addr->TWI_FMR & ~TWI_FMR_TXRDYM_Msk) | TWI_FMR_TXRDYM_FOUR_DATA;
-			desc->dma.tx.cfg_dma.data_width = DMA_DATA_WIDTH_WORD;
-		} else if ((buffer->size % 2) == 0) {
-			desc->addr->TWI_FMR = (desc->addr->TWI_FMR & ~TWI_FMR_TXRDYM_Msk) | TWI_FMR_TXRDYM_TWO_DATA;
-			desc->dma.tx.cfg_dma.data_width = DMA_DATA_WIDTH_HALF_WORD;
-		} else {
-			desc->addr->TWI_FMR = (desc->addr->TWI_FMR & ~TWI_FMR_TXRDYM_Msk) | TWI_FMR_TXRDYM_ONE_DATA;
-			desc->dma.tx.cfg_dma.data_width = DMA_DATA_WIDTH_BYTE;
-		}
+		desc->dma.tx.cfg_dma.data_width = _twid_fifo_set_tx_threshold(desc, buffer->size);
 		desc->dma.tx.cfg.len = buffer->size;
 	} else {
 		desc->addr->TWI_FMR = (desc->addr->TWI_FMR & ~TWI_FMR_TXRDYM_Msk) | TWI_FMR_TXRDYM_ONE_DATA;
@@ -323,6 +362,288 @@ static void _twid_dma_write(struct _twi_desc* desc, struct _buffer* buffer)
 	dma_start_transfer(desc->dma.tx.channel);
 }
 
+#ifdef CONFIG_HAVE_TWI_ALTERNATE_CMD
+
+/*
+ * Alternative command fast path: the TWI generates the (repeated) START,
+ * the STOP and the NACK of the last read byte by itself, so DMA moves the
+ * whole buffer and the CPU is only involved once at TXCOMP.
+ */
+
+static void _twid_acm_abort(struct _twi_desc* desc)
+{
+#ifdef CONFIG_HAVE_TWI_FIFO
+	if (desc->use_fifo) {
+		twi_fifo_unlock(desc->addr);
+		twi_fifo_flush_tx(desc->addr);
+		twi_fifo_flush_rx(desc->addr);
+	}
+#endif
+	twi_alt_cmd_disable(desc->addr);
+}
+
+static int _twid_acm_wait_status(struct _twi_desc* desc, uint32_t mask)
+{
+	struct _timeout timeout;
+	uint32_t status;
+
+	timer_start_timeout(&timeout, desc->timeout);
+	do {
+		status = twi_get_status(desc->addr);
+		if (TWI_STATUS_NACK(status)) {
+			trace_error("twid: command NACK\r\n");
+			return -ECONNABORTED;
+		}
+		if (timer_timeout_reached(&timeout)) {
+			trace_error("twid: Device doesn't answer (TIMEOUT)\r\n");
+			return -ETIMEDOUT;
+		}
+	} while ((status & mask) == 0);
+
+	return 0;
+}
+
+static int _twid_acm_poll(struct _twi_desc* desc, struct _buffer* buffer)
+{
+	int err;
+	int i;
+
+#ifdef CONFIG_HAVE_TWI_FIFO
+	if (desc->use_fifo)
+		desc->addr->TWI_FMR = (desc->addr->TWI_FMR & ~(TWI_FMR_RXRDYM_Msk | TWI_FMR_TXRDYM_Msk))
+		                    | TWI_FMR_RXRDYM_ONE_DATA | TWI_FMR_TXRDYM_ONE_DATA;
+#endif
+
+	if (buffer->attr & BUS_BUF_ATTR_TX) {
+		/* first byte written starts the command */
+		for (i = 0 ; i < buffer->size ; i++) {
+			err = _twid_acm_wait_status(desc, TWI_SR_TXRDY);
+			if (err < 0)
+				return err;
+			twi_write_byte(desc->addr, buffer->data[i]);
+		}
+	} else {
+		twi_send_start_condition(desc->addr);
+		for (i = 0 ; i < buffer->size ; i++) {
+			err = _twid_acm_wait_status(desc, TWI_SR_RXRDY);
+			if (err < 0)
+				return err;
+			buffer->data[i] = twi_read_byte(desc->addr);
+		}
+	}
+
+	return _twid_acm_wait_status(desc, TWI_SR_TXCOMP);
+}
+
+static void _twid_acm_handler(uint32_t source, void* user_arg)
+{
+	struct _twi_desc* desc = (struct _twi_desc*)user_arg;
+	uint32_t status = twi_get_masked_status(desc->addr);
+	int err = 0;
+
+	if (TWI_STATUS_NACK(status)) {
+		trace_error("twid: command NACK\r\n");
+		if (desc->flags & BUS_BUF_ATTR_TX)
+			dma_stop_transfer(desc->dma.tx.channel);
+		else
+			dma_stop_transfer(desc->dma.rx.channel);
+		err = -ECONNABORTED;
+	} else if (!TWI_STATUS_TXCOMP(status)) {
+		return;
+	}
+
+	twi_disable_it(desc->addr, TWI_IDR_NACK | TWI_IDR_TXCOMP);
+	irq_disable(source);
+	if (err < 0)
+		_twid_acm_abort(desc);
+	else
+		twi_alt_cmd_disable(desc->addr);
+
+	mutex_unlock(&desc->mutex);
+
+	/* the callback is always called so that the bus is released, an
+	 * aborted command is reported through arg2 */
+	callback_call(&desc->callback, (void*)err);
+}
+
+static int _twid_acm_dma_callback(void* arg, void* arg2)
+{
+	struct _twi_desc* desc = (struct _twi_desc *)arg;
+
+	if (desc->flags & BUS_BUF_ATTR_TX) {
+		dma_reset_channel(desc->dma.tx.channel);
+	} else {
+		cache_invalidate_region(desc->dma.rx.cfg.daddr, desc->dma.rx.cfg.len);
+		dma_reset_channel(desc->dma.rx.channel);
+	}
+
+	/* STOP is sent by the TWI, completion is signaled by TXCOMP */
+	twi_enable_it(desc->addr, TWI_IER_TXCOMP);
+
+	return 0;
+}
+
+static void _twid_acm_dma_read(struct _twi_desc* desc, struct _buffer* buffer)
+{
+	struct _callback _cb;
+	uint32_t id = get_twi_id_from_addr(desc->addr);
+
+	memset(&desc->dma.rx.cfg, 0x0, sizeof(desc->dma.rx.cfg));
+
+	desc->dma.rx.cfg.saddr = (void*)&desc->addr->TWI_RHR;
+	desc->dma.rx.cfg.daddr = buffer->data;
+	desc->dma.rx.cfg.len = buffer->size;
+
+	if(!desc->dma.rx.channel)
+		desc->dma.rx.channel = dma_allocate_channel(id, DMA_PERIPH_MEMORY);
+	assert(desc->dma.rx.channel);
+
+	desc->dma.rx.cfg_dma.data_width = DMA_DATA_WIDTH_BYTE;
+#ifdef CONFIG_HAVE_TWI_FIFO
+	if (desc->use_fifo)
+		desc->dma.rx.cfg_dma.data_width = _twid_fifo_set_rx_threshold(desc, buffer->size);
+#endif
+	dma_configure_transfer(desc->dma.rx.channel, &desc->dma.rx.cfg_dma, &desc->dma.rx.cfg, 1);
+	callback_set(&_cb, _twid_acm_dma_callback, (void*)desc);
+	dma_set_callback(desc->dma.rx.channel, &_cb);
+	dma_start_transfer(desc->dma.rx.channel);
+
+	twi_enable_it(desc->addr, TWI_IER_NACK);
+	twi_send_start_condition(desc->addr);
+}
+
+static void _twid_acm_dma_write(struct _twi_desc* desc, struct _buffer* buffer)
+{
+	struct _callback _cb;
+	uint32_t id = get_twi_id_from_addr(desc->addr);
+
+	memset(&desc->dma.tx.cfg, 0x0, sizeof(desc->dma.tx.cfg));
+
+	desc->dma.tx.cfg.saddr = buffer->data;
+	desc->dma.tx.cfg.daddr = (void*)&desc->addr->TWI_THR;
+	desc->dma.tx.cfg.len = buffer->size;
+
+	if(!desc->dma.tx.channel)
+		desc->dma.tx.channel = dma_allocate_channel(DMA_PERIPH_MEMORY, id);
+	assert(desc->dma.tx.channel);
+
+	desc->dma.tx.cfg_dma.data_width = DMA_DATA_WIDTH_BYTE;
+#ifdef CONFIG_HAVE_TWI_FIFO
+	if (desc->use_fifo)
+		desc->dma.tx.cfg_dma.data_width = _twid_fifo_set_tx_threshold(desc, buffer->size);
+#endif
+	dma_configure_transfer(desc->dma.tx.channel, &desc->dma.tx.cfg_dma, &desc->dma.tx.cfg, 1);
+	callback_set(&_cb, _twid_acm_dma_callback, (void*)desc);
+	dma_set_callback(desc->dma.tx.channel, &_cb);
+	cache_clean_region(desc->dma.tx.cfg.saddr, desc->dma.tx.cfg.len);
+
+	/* the first data written by the DMA starts the command */
+	twi_enable_it(desc->addr, TWI_IER_NACK);
+	dma_start_transfer(desc->dma.tx.channel);
+}
+
+/*
+ * Buffer lists handled by a single alternative command:
+ * - one complete message (START and STOP) of up to 255 bytes,
+ * - a register access: a write of at most 3 bytes with START but no STOP,
+ *   sent as internal address, followed either by a read with (repeated)
+ *   START and STOP or by a write with STOP only.
+ */
+static bool _twid_acm_match(const struct _twi_desc* desc, const struct _buffer* buf, int buffers)
+{
+	const uint32_t mask = BUS_BUF_ATTR_TX | BUS_BUF_ATTR_RX | BUS_I2C_BUF_ATTR_START | BUS_I2C_BUF_ATTR_STOP;
+	const struct _buffer* data = &buf[buffers - 1];
+
+	if (desc->transfer_mode != BUS_TRANSFER_MODE_DMA)
+		return false;
+
+	if (data->size == 0 || data->size > TWID_ACM_MAX_SIZE)
+		return false;
+
+	if (buffers == 1)
+		return (data->attr & mask) == (BUS_BUF_ATTR_TX | BUS_I2C_BUF_ATTR_START | BUS_I2C_BUF_ATTR_STOP) ||
+		       (data->attr & mask) == (BUS_BUF_ATTR_RX | BUS_I2C_BUF_ATTR_START | BUS_I2C_BUF_ATTR_STOP);
+
+	if (buffers != 2)
+		return false;
+
+	if ((buf[0].attr & mask) != (BUS_BUF_ATTR_TX | BUS_I2C_BUF_ATTR_START))
+		return false;
+	if (buf[0].size == 0 || buf[0].size > TWID_IADR_MAX_SIZE)
+		return false;
+
+	return (data->attr & mask) == (BUS_BUF_ATTR_RX | BUS_I2C_BUF_ATTR_START | BUS_I2C_BUF_ATTR_STOP) ||
+	       (data->attr & mask) == (BUS_BUF_ATTR_TX | BUS_I2C_BUF_ATTR_STOP);
+}
+
+static int _twid_acm_transfer(struct _twi_desc* desc, struct _buffer* buf, int buffers, struct _callback* cb)
+{
+	struct _buffer* data = &buf[buffers - 1];
+	uint32_t iaddr = 0;
+	uint8_t isize = 0;
+	uint32_t id;
+	int err;
+	int i;
+
+	if (!mutex_try_lock(&desc->mutex))
+		return -EBUSY;
+
+	callback_copy(&desc->callback, cb);
+	desc->flags = data->attr;
+
+	/* register address goes out MSB first from TWI_IADR */
+	if (buffers > 1) {
+		isize = buf[0].size;
+		for (i = 0 ; i < isize ; i++)
+			iaddr = (iaddr << 8) | buf[0].data[i];
+	}
+
+	if (data->attr & BUS_BUF_ATTR_TX)
+		twi_init_write(desc->addr, desc->slave_addr, iaddr, isize);
+	else
+		twi_init_read(desc->addr, desc->slave_addr, iaddr, isize);
+#ifdef CONFIG_HAVE_TWI_FIFO
+	if (desc->use_fifo) {
+		twi_fifo_flush_tx(desc->addr);
+		twi_fifo_flush_rx(desc->addr);
+	}
+#endif
+	/* clear a stale NACK */
+	twi_get_status(desc->addr);
+
+	twi_alt_cmd_enable(desc->addr);
+	if (data->attr & BUS_BUF_ATTR_TX)
+		twi_alt_cmd_configure_write(desc->addr, data->size);
+	else
+		twi_alt_cmd_configure_read(desc->addr, data->size);
+
+	/* short transfers: DMA setup costs more than the transfer itself */
+	if (data->size < TWID_POLLING_THRESHOLD) {
+		err = _twid_acm_poll(desc, data);
+		if (err < 0) {
+			_twid_acm_abort(desc);
+		} else {
+			twi_alt_cmd_disable(desc->addr);
+			callback_call(&desc->callback, NULL);
+		}
+		mutex_unlock(&desc->mutex);
+		return err;
+	}
+
+	id = get_twi_id_from_addr(desc->addr);
+	irq_add_handler(id, _twid_acm_handler, desc);
+	irq_enable(id);
+
+	if (data->attr & BUS_BUF_ATTR_TX)
+		_twid_acm_dma_write(desc, data);
+	else
+		_twid_acm_dma_read(desc, data);
+
+	return 0;
+}
+
+#endif /* CONFIG_HAVE_TWI_ALTERNATE_CMD */
+
 /*
  *
  */
@@ -854,6 +1175,11 @@ int twid_transfer(struct _twi_desc* desc, struct _buffer* buf, int buffers, stru
 	if (buf == NULL)
 		return -EINVAL;
 
+#ifdef CONFIG_HAVE_TWI_ALTERNATE_CMD
+	if (_twid_acm_match(desc, buf, buffers))
+		return _twid_acm_transfer(desc, buf, buffers, cb);
+#endif
+
 	for (b = 0 ; b < buffers ; b++) {
 		if ((buf[b].attr & (BUS_BUF_ATTR_TX | BUS_BUF_ATTR_RX)) == 0)
 			return -EINVAL;
@@ -116,6 +116,14 @@ extern void aic_enable(uint32_t source);
  */
 extern void aic_disable(uint32_t source);
 
+/**
+ * \brief Set an interrupt source pending by software (ID_xxx).
+ *
+ * \note Only effective on edge-triggered sources.
+ * \param source  Interrupt source to trigger
+ */
+extern void aic_trigger(uint32_t source);
+
 /**
  * \brief Get the current interrupt source number
  *
@@ -132,6 +132,11 @@ void aic_disable(uint32_t source)
 	AIC->AIC_IDCR = 1 << source;
 }
 
+void aic_trigger(uint32_t source)
+{
+	AIC->AIC_ISCR = 1 << source;
+}
+
 uint32_t aic_get_current_interrupt_source(void)
 {
 	return AIC->AIC_ISR;
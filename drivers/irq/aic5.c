@@ -182,6 +182,21 @@ void aic_disable(uint32_t source)
 	aic->AIC_IDCR = AIC_IDCR_INTD;
 }
 
+void aic_trigger(uint32_t source)
+{
+	Aic* aic = _get_aic_instance(source);
+	uint32_t flags, ssr;
+
+	/* may be called from a handler that interrupted a thread in the middle
+	 * of another select/modify sequence, give it its source back */
+	flags = arch_irq_save();
+	ssr = aic->AIC_SSR;
+	aic->AIC_SSR = AIC_SSR_INTSEL(source);
+	aic->AIC_ISCR = AIC_ISCR_INTSET;
+	aic->AIC_SSR = ssr;
+	arch_irq_restore(flags);
+}
+
 uint32_t aic_get_current_interrupt_source(void)
 {
 	return AIC->AIC_ISR;
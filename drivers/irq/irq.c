@@ -37,11 +37,15 @@
 #include "irq/aic.h"
 #endif
 #include "irq/irq.h"
+#ifdef CONFIG_IRQ_TRACE
+#include "irq/irq_trace.h"
+#endif
 #if defined(CONFIG_HAVE_NVIC)
 #include "irq/nvic.h"
 #endif
 
 #include <assert.h>
+#include <string.h>
 
 /*------------------------------------------------------------------------------
  *         Local types
@@ -61,6 +65,10 @@ static struct handler_entry  handlers_pool[ID_PERIPH_COUNT * 2];
 static struct handler_entry* next_free_handler;
 static struct handler_entry* handlers[ID_PERIPH_COUNT];
 
+static volatile uint32_t nesting;
+static irq_clock_t stats_clock;
+static struct _irq_stats stats[ID_PERIPH_COUNT];
+
 /*------------------------------------------------------------------------------
  *         Local functions
  *------------------------------------------------------------------------------*/
@@ -101,6 +109,8 @@ static void _free_handler(struct handler_entry* entry)
 
 static void _default_irq_handler(void)
 {
+	irq_clock_t clock = stats_clock;
+	uint32_t entry_time = clock ? clock() : 0; /* earliest point in C */
 	uint32_t source;
 	struct handler_entry *entry;
 
@@ -118,11 +128,41 @@ static void _default_irq_handler(void)
 		while (1);
 	}
 
-	while (entry) {
-		if (entry->handler)
-			entry->handler(source, entry->user_arg);
-		entry = entry->next;
+	/* Handlers run with interrupts enabled at core level, the interrupt
+	 * controller only lets higher priority sources preempt them */
+	nesting++;
+	stats[source].count++;
+	if (nesting > 1)
+		stats[source].nested++;
+
+	if (clock) {
+		uint32_t start = clock();
+		uint32_t duration;
+
+		while (entry) {
+			if (entry->handler)
+				entry->handler(source, entry->user_arg);
+			entry = entry->next;
+		}
+
+		/* the duration includes the preemptions by higher priorities */
+		duration = clock() - start;
+		if (start - entry_time > stats[source].max_dispatch)
+			stats[source].max_dispatch = start - entry_time;
+		if (duration > stats[source].max_duration)
+			stats[source].max_duration = duration;
+#ifdef CONFIG_IRQ_TRACE
+		irq_trace_record(source, start - entry_time, duration);
+#endif
+	} else {
+		while (entry) {
+			if (entry->handler)
+				entry->handler(source, entry->user_arg);
+			entry = entry->next;
+		}
 	}
+
+	nesting--;
 }
 
 /*----------------------------------------------------------------------------
@@ -226,3 +266,36 @@ void irq_disable(uint32_t source)
 #error Unknown IRQ controller!
 #endif
 }
+
+void irq_trigger(uint32_t source)
+{
+#if defined(CONFIG_HAVE_AIC2) || defined(CONFIG_HAVE_AIC5)
+	aic_trigger(source);
+#elif defined(CONFIG_HAVE_NVIC)
+	nvic_trigger(source);
+#else
+#error Unknown IRQ controller!
+#endif
+}
+
+uint32_t irq_get_nesting(void)
+{
+	return nesting;
+}
+
+void irq_set_stats_clock(irq_clock_t clock)
+{
+	stats_clock = clock;
+}
+
+void irq_get_stats(uint32_t source, struct _irq_stats* irq_stats)
+{
+	assert(source < ID_PERIPH_COUNT);
+
+	*irq_stats = stats[source];
+}
+
+void irq_reset_stats(void)
+{
+	memset(stats, 0, sizeof(stats));
+}
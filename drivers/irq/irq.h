@@ -38,6 +38,17 @@
 
 typedef void (*irq_handler_t)(uint32_t source, void* user_arg);
 
+/** Free-running time source for the interrupt statistics, any unit */
+typedef uint32_t (*irq_clock_t)(void);
+
+/** Interrupt statistics, in irq_clock_t units */
+struct _irq_stats {
+	uint32_t count;         /**< number of interrupts */
+	uint32_t nested;        /**< number of times it preempted another one */
+	uint32_t max_dispatch;  /**< max time from dispatcher entry to handlers */
+	uint32_t max_duration;  /**< max time spent in the handlers */
+};
+
 enum _irq_mode {
 	IRQ_MODE_HIGH_LEVEL,
 	IRQ_MODE_LOW_LEVEL,
@@ -116,6 +127,48 @@ extern void irq_enable(uint32_t source);
  */
 extern void irq_disable(uint32_t source);
 
+/**
+ * \brief Set an interrupt source pending by software (ID_xxx).
+ *
+ * On AIC, the source must be configured as edge-triggered.
+ *
+ * \param source  Interrupt source to trigger
+ */
+extern void irq_trigger(uint32_t source);
+
+/**
+ * \brief Get the interrupt nesting level, 0 when not in interrupt context.
+ *
+ * Handlers run with interrupts enabled at core level: the interrupt
+ * controller only lets sources of a strictly higher priority preempt them
+ * (see irq_configure_priority()).
+ */
+extern uint32_t irq_get_nesting(void);
+
+/**
+ * \brief Set the time source used to measure the dispatch time and the
+ * handler duration. Without time source, only the counters are updated.
+ *
+ * The dispatch time runs from the entry of the C dispatcher to the first
+ * handler: reading the source from the interrupt controller and looking up
+ * its handlers. It does not include the time the source was pending nor
+ * the exception entry, which have no time stamp, so it is not the interrupt
+ * latency.
+ *
+ * \param clock  Time source, NULL to stop the measurements
+ */
+extern void irq_set_stats_clock(irq_clock_t clock);
+
+/**
+ * \brief Get the statistics of an interrupt source (ID_xxx).
+ */
+extern void irq_get_stats(uint32_t source, struct _irq_stats* stats);
+
+/**
+ * \brief Clear the statistics of all interrupt sources.
+ */
+extern void irq_reset_stats(void);
+
 #ifdef __cplusplus
 }
 #endif
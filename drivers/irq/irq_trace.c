@@ -0,0 +1,217 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "chip.h"
+#include "compiler.h"
+#include "cycles.h"
+#include "errno.h"
+
+#include "irq/irq.h"
+#include "irq/irq_trace.h"
+#include "peripherals/pmc.h"
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+static volatile bool _enabled;
+
+static uint32_t _dispatch[ID_PERIPH_COUNT][IRQ_TRACE_BUCKETS];
+static uint32_t _duration[ID_PERIPH_COUNT][IRQ_TRACE_BUCKETS];
+
+/* current critical section, interrupts are masked while it is updated */
+static bool _mask_active;
+static uint32_t _mask_start;
+static uint32_t _mask_pc;
+
+/* longest critical sections, sorted by decreasing duration */
+static struct _irq_trace_mask _masks[IRQ_TRACE_MASK_ENTRIES];
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static uint32_t _irq_trace_clock(void)
+{
+	return arch_cycles_read();
+}
+
+static uint32_t _irq_trace_bucket(uint32_t cycles)
+{
+	uint32_t bucket;
+
+	if (cycles < 32)
+		return 0;
+	bucket = 31 - CLZ(cycles) - 4;
+	return bucket < IRQ_TRACE_BUCKETS ? bucket : IRQ_TRACE_BUCKETS - 1;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+int irq_trace_start(void)
+{
+	if (!arch_cycles_available())
+		return -ENOTSUP;
+
+	_enabled = false;
+	memset(_dispatch, 0, sizeof(_dispatch));
+	memset(_duration, 0, sizeof(_duration));
+	memset(_masks, 0, sizeof(_masks));
+	_mask_active = false;
+	irq_reset_stats();
+
+	arch_cycles_enable();
+	irq_set_stats_clock(_irq_trace_clock);
+	_enabled = true;
+	return 0;
+}
+
+void irq_trace_stop(void)
+{
+	_enabled = false;
+	irq_set_stats_clock(NULL);
+}
+
+void irq_trace_record(uint32_t source, uint32_t dispatch, uint32_t duration)
+{
+	if (!_enabled || source >= ID_PERIPH_COUNT)
+		return;
+
+	_dispatch[source][_irq_trace_bucket(dispatch)]++;
+	_duration[source][_irq_trace_bucket(duration)]++;
+}
+
+void irq_trace_masked(uint32_t pc)
+{
+	if (!_enabled || _mask_active)
+		return;
+
+	_mask_active = true;
+	_mask_pc = pc;
+	_mask_start = arch_cycles_read();
+}
+
+void irq_trace_unmasked(void)
+{
+	uint32_t cycles;
+	int i, j;
+
+	if (!_mask_active)
+		return;
+
+	cycles = arch_cycles_read() - _mask_start;
+	_mask_active = false;
+
+	/* same site: keep its longest duration only */
+	for (i = 0; i < IRQ_TRACE_MASK_ENTRIES; i++) {
+		if (_masks[i].pc == _mask_pc) {
+			if (cycles <= _masks[i].cycles)
+				return;
+			break;
+		}
+	}
+	if (i == IRQ_TRACE_MASK_ENTRIES) {
+		i = IRQ_TRACE_MASK_ENTRIES - 1;
+		if (cycles <= _masks[i].cycles)
+			return;
+	}
+
+	/* insertion in the sorted list */
+	for (j = i; j > 0 && _masks[j - 1].cycles < cycles; j--)
+		_masks[j] = _masks[j - 1];
+	_masks[j].pc = _mask_pc;
+	_masks[j].cycles = cycles;
+}
+
+void irq_trace_get_histograms(uint32_t source, uint32_t* dispatch,
+		uint32_t* duration)
+{
+	if (source >= ID_PERIPH_COUNT)
+		return;
+
+	if (dispatch)
+		memcpy(dispatch, _dispatch[source], sizeof(_dispatch[source]));
+	if (duration)
+		memcpy(duration, _duration[source], sizeof(_duration[source]));
+}
+
+void irq_trace_get_masks(struct _irq_trace_mask* masks)
+{
+	memcpy(masks, _masks, sizeof(_masks));
+}
+
+void irq_trace_dump(void)
+{
+	struct _irq_trace_mask masks[IRQ_TRACE_MASK_ENTRIES];
+	uint32_t hist[IRQ_TRACE_BUCKETS];
+	struct _irq_stats stats;
+	uint32_t source;
+	int i;
+
+	printf("IRQT clock %u\r\n", (unsigned)pmc_get_processor_clock());
+
+	for (source = 0; source < ID_PERIPH_COUNT; source++) {
+		irq_get_stats(source, &stats);
+		if (!stats.count)
+			continue;
+		printf("IRQT src %u %u %u %u %u\r\n", (unsigned)source,
+		       (unsigned)stats.count, (unsigned)stats.nested,
+		       (unsigned)stats.max_dispatch, (unsigned)stats.max_duration);
+
+		irq_trace_get_histograms(source, hist, NULL);
+		printf("IRQT dsp %u", (unsigned)source);
+		for (i = 0; i < IRQ_TRACE_BUCKETS; i++)
+			printf(" %u", (unsigned)hist[i]);
+		printf("\r\n");
+
+		irq_trace_get_histograms(source, NULL, hist);
+		printf("IRQT dur %u", (unsigned)source);
+		for (i = 0; i < IRQ_TRACE_BUCKETS; i++)
+			printf(" %u", (unsigned)hist[i]);
+		printf("\r\n");
+	}
+
+	irq_trace_get_masks(masks);
+	for (i = 0; i < IRQ_TRACE_MASK_ENTRIES; i++)
+		if (masks[i].cycles)
+			printf("IRQT mask 0x%08x %u\r\n", (unsigned)masks[i].pc,
+			       (unsigned)masks[i].cycles);
+
+	printf("IRQT end\r\n");
+}
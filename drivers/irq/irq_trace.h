@@ -0,0 +1,122 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef _IRQ_TRACE_H_
+#define _IRQ_TRACE_H_
+
+#ifdef CONFIG_IRQ_TRACE
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Histogram buckets: [0, 32), then [2^(n+4), 2^(n+5)) cycles, the last
+ * bucket also counts everything above */
+#define IRQ_TRACE_BUCKETS 16
+
+/** Number of longest critical sections kept */
+#define IRQ_TRACE_MASK_ENTRIES 8
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+struct _irq_trace_mask {
+	uint32_t pc;       /**< where interrupts were masked */
+	uint32_t cycles;   /**< how long they stayed masked */
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/*
+ * Opt-in interrupt instrumentation (CONFIG_IRQ_TRACE=y), based on the core
+ * cycle counter (not available on ARM926):
+ * - per source log2 histograms of the dispatch time (see
+ *   irq_set_stats_clock(), not the interrupt latency) and handler duration,
+ *   fed by the IRQ dispatcher,
+ * - the longest sections with interrupts masked by arch_irq_disable() or
+ *   arch_irq_save(), with the address of the masking code. Sections that
+ *   sleep with interrupts masked (idle) are reported too.
+ *
+ * irq_trace_dump() prints everything in a line format read by
+ * scripts/irq_trace.py.
+ */
+
+/**
+ * \brief Clear the data and start tracing.
+ * \return 0 on success, -ENOTSUP without cycle counter
+ */
+extern int irq_trace_start(void);
+
+/**
+ * \brief Stop tracing, the data is kept.
+ */
+extern void irq_trace_stop(void);
+
+/**
+ * \brief Record one interrupt, called by the IRQ dispatcher.
+ * \param source    interrupt source
+ * \param dispatch  cycles from dispatcher entry to the handlers
+ * \param duration  cycles spent in the handlers
+ */
+extern void irq_trace_record(uint32_t source, uint32_t dispatch, uint32_t duration);
+
+/**
+ * \brief Copy the histograms of a source.
+ * \param source    interrupt source
+ * \param dispatch  IRQ_TRACE_BUCKETS counters, or NULL
+ * \param duration  IRQ_TRACE_BUCKETS counters, or NULL
+ */
+extern void irq_trace_get_histograms(uint32_t source, uint32_t* dispatch,
+		uint32_t* duration);
+
+/**
+ * \brief Copy the longest critical sections, longest first.
+ * \param masks  IRQ_TRACE_MASK_ENTRIES entries
+ */
+extern void irq_trace_get_masks(struct _irq_trace_mask* masks);
+
+/**
+ * \brief Print the statistics, histograms and critical sections on the
+ * console. Call it from the application console command handler (in thread
+ * context).
+ */
+extern void irq_trace_dump(void);
+
+#endif /* CONFIG_IRQ_TRACE */
+
+#endif /* _IRQ_TRACE_H_ */
@@ -0,0 +1,205 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stddef.h>
+
+#include "chip.h"
+#include "compiler.h"
+#include "irqflags.h"
+
+#include "irq/irq.h"
+#include "irq/irq_work.h"
+
+/*----------------------------------------------------------------------------
+ *        Local types
+ *----------------------------------------------------------------------------*/
+
+struct _irq_work_queue {
+	struct _irq_work* head;
+	struct _irq_work* tail;
+};
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+static struct _irq_work_queue _queues[IRQ_WORK_PRIORITIES];
+
+/** Bit n set when queue n is not empty */
+static volatile uint32_t _pending;
+
+/** Software interrupt source, ID_PERIPH_COUNT if none */
+static uint32_t _source = ID_PERIPH_COUNT;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static void _irq_work_handler(uint32_t source, void* user_arg)
+{
+	irq_work_run();
+}
+
+/* Remove the first item of the highest priority queue, interrupts masked */
+static struct _irq_work* _irq_work_pop(void)
+{
+	struct _irq_work_queue* queue;
+	struct _irq_work* work;
+	uint32_t priority;
+
+	if (!_pending)
+		return NULL;
+
+	priority = 31 - CLZ(_pending);
+	queue = &_queues[priority];
+	work = queue->head;
+	queue->head = work->next;
+	if (!queue->head) {
+		queue->tail = NULL;
+		_pending &= ~(1u << priority);
+	}
+	work->next = NULL;
+	work->queued = false;
+	return work;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+void irq_work_init(struct _irq_work* work, callback_method_t method,
+		void* arg, uint8_t priority)
+{
+	assert(priority < IRQ_WORK_PRIORITIES);
+
+	work->next = NULL;
+	work->priority = priority;
+	work->queued = false;
+	callback_set(&work->cb, method, arg);
+}
+
+void irq_work_configure(uint32_t source)
+{
+	assert(source < ID_PERIPH_COUNT);
+
+	_source = source;
+	irq_configure_mode(source, IRQ_MODE_POSITIVE_EDGE);
+	irq_configure_priority(source, 0);
+	irq_add_handler(source, _irq_work_handler, NULL);
+	irq_enable(source);
+
+	if (_pending)
+		irq_trigger(source);
+}
+
+bool irq_work_is_configured(void)
+{
+	return _source < ID_PERIPH_COUNT;
+}
+
+bool irq_work_queue(struct _irq_work* work)
+{
+	struct _irq_work_queue* queue = &_queues[work->priority];
+	uint32_t flags = arch_irq_save();
+
+	if (work->queued) {
+		arch_irq_restore(flags);
+		return false;
+	}
+
+	work->queued = true;
+	work->next = NULL;
+	if (queue->tail)
+		queue->tail->next = work;
+	else
+		queue->head = work;
+	queue->tail = work;
+	_pending |= 1u << work->priority;
+
+	arch_irq_restore(flags);
+
+	if (_source < ID_PERIPH_COUNT)
+		irq_trigger(_source);
+	return true;
+}
+
+void irq_work_cancel(struct _irq_work* work)
+{
+	struct _irq_work_queue* queue = &_queues[work->priority];
+	struct _irq_work* prev = NULL;
+	struct _irq_work* cur;
+	uint32_t flags = arch_irq_save();
+
+	if (work->queued) {
+		for (cur = queue->head; cur != work; cur = cur->next)
+			prev = cur;
+
+		if (prev)
+			prev->next = work->next;
+		else
+			queue->head = work->next;
+		if (queue->tail == work)
+			queue->tail = prev;
+		if (!queue->head)
+			_pending &= ~(1u << work->priority);
+		work->next = NULL;
+		work->queued = false;
+	}
+
+	arch_irq_restore(flags);
+}
+
+bool irq_work_pending(void)
+{
+	return _pending != 0;
+}
+
+uint32_t irq_work_run(void)
+{
+	struct _irq_work* work;
+	uint32_t count = 0;
+
+	for (;;) {
+		uint32_t flags = arch_irq_save();
+		work = _irq_work_pop();
+		arch_irq_restore(flags);
+
+		if (!work)
+			break;
+
+		callback_call(&work->cb, work);
+		count++;
+	}
+	return count;
+}
@@ -0,0 +1,119 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef _IRQ_WORK_H_
+#define _IRQ_WORK_H_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "callback.h"
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Number of work priorities, 0 is the lowest */
+#define IRQ_WORK_PRIORITIES 8
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+struct _irq_work {
+	struct _irq_work* next;
+	struct _callback cb;      /**< called with the work item as arg2 */
+	uint8_t priority;
+	volatile bool queued;
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/*
+ * Deferred work (bottom halves): an interrupt handler acknowledges its
+ * peripheral and queues a work item, the item callback does the rest of the
+ * processing with all interrupts enabled. Work items run in priority order,
+ * first in first out within a priority.
+ *
+ * Work runs from a dedicated software interrupt when irq_work_configure()
+ * was given a spare interrupt source, the source gets the lowest priority so
+ * every top half preempts it as long as their priority is above 0. Without
+ * it, the main loop calls irq_work_run().
+ */
+
+/**
+ * \brief Initialize a work item.
+ * \param work      work item
+ * \param method    function to call, with arg and the work item
+ * \param arg       user argument
+ * \param priority  0 (lowest) to IRQ_WORK_PRIORITIES - 1
+ */
+extern void irq_work_init(struct _irq_work* work, callback_method_t method,
+		void* arg, uint8_t priority);
+
+/**
+ * \brief Run deferred work from a software interrupt.
+ * \param source  unused interrupt source (ID_xxx) to trigger
+ */
+extern void irq_work_configure(uint32_t source);
+
+/**
+ * \brief Tell if irq_work_configure() gave a software interrupt source.
+ */
+extern bool irq_work_is_configured(void);
+
+/**
+ * \brief Queue a work item, safe from any context.
+ * \return false if the item was already queued
+ */
+extern bool irq_work_queue(struct _irq_work* work);
+
+/**
+ * \brief Remove a work item from its queue if it did not run yet.
+ */
+extern void irq_work_cancel(struct _irq_work* work);
+
+/**
+ * \brief Tell if work items are waiting.
+ */
+extern bool irq_work_pending(void);
+
+/**
+ * \brief Run the queued work items, including the ones queued meanwhile.
+ * \return the number of items run
+ */
+extern uint32_t irq_work_run(void);
+
+#endif /* _IRQ_WORK_H_ */
@@ -97,6 +97,13 @@ void nvic_disable(uint32_t source)
 	NVIC->NVIC_ICER[index] = bit;
 }
 
+void nvic_trigger(uint32_t source)
+{
+	uint32_t index = source >> 5;
+	uint32_t bit = 1 << (source & 0x1f);
+	NVIC->NVIC_ISPR[index] = bit;
+}
+
 uint32_t nvic_get_current_interrupt_source(void)
 {
 	uint32_t ipsr;
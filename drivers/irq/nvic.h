@@ -95,6 +95,13 @@ extern void nvic_enable(uint32_t source);
  */
 extern void nvic_disable(uint32_t source);
 
+/**
+ * \brief Set an interrupt source pending by software (ID_xxx).
+ *
+ * \param source  Interrupt source to trigger
+ */
+extern void nvic_trigger(uint32_t source);
+
 /**
  * \brief Get the current interrupt source number
  *
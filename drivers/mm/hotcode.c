@@ -0,0 +1,102 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include "chip.h"
+#include "compiler.h"
+
+#include "mm/hotcode.h"
+
+#ifdef CONFIG_HOTCODE
+#include "barriers.h"
+#include "mm/cache.h"
+#include "mm/l1cache.h"
+
+#include <string.h>
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+#ifdef CONFIG_HOTCODE
+#if defined(__ICCARM__)
+#pragma section = ".hotcode"
+#pragma section = ".hotcode_init"
+#define HOTCODE_START ((uint8_t*)__section_begin(".hotcode"))
+#define HOTCODE_END   ((uint8_t*)__section_end(".hotcode"))
+#define HOTCODE_LOAD  ((const uint8_t*)__section_begin(".hotcode_init"))
+#elif defined(__GNUC__)
+extern uint8_t _shotcode[];
+extern uint8_t _ehotcode[];
+extern const uint8_t _hotcode_lma[];
+#define HOTCODE_START _shotcode
+#define HOTCODE_END   _ehotcode
+#define HOTCODE_LOAD  _hotcode_lma
+#endif
+#endif /* CONFIG_HOTCODE */
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+uint32_t hotcode_size(void)
+{
+#ifdef CONFIG_HOTCODE
+	return (uint32_t)(HOTCODE_END - HOTCODE_START);
+#else
+	return 0;
+#endif
+}
+
+uint32_t hotcode_load(void)
+{
+#ifdef CONFIG_HOTCODE
+	uint32_t size = hotcode_size();
+
+	if (size == 0 || (const void*)HOTCODE_LOAD == (const void*)HOTCODE_START)
+		return 0;
+
+	memcpy(HOTCODE_START, HOTCODE_LOAD, size);
+
+	/* make the instructions visible to the instruction fetches */
+	cache_clean_region(HOTCODE_START, size);
+	dsb();
+#ifdef CONFIG_HAVE_L1CACHE
+	icache_invalidate();
+#endif
+	isb();
+	return size;
+#else
+	return 0;
+#endif
+}
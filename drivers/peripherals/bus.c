@@ -36,6 +36,9 @@
 #include "callback.h"
 #include "dma/dma.h"
 #include "errno.h"
+#include "irqflags.h"
+#include "irq/irq.h"
+#include "irq/irq_work.h"
 #include "peripherals/bus.h"
 #ifdef CONFIG_HAVE_BUS_SPI
 #include "spi/spid.h"
@@ -76,6 +79,21 @@ struct _bus_desc {
 		mutex_t lock;
 		mutex_t transaction;
 	} mutex;
+
+	struct {
+		struct _bus_request* head;
+		struct _bus_request* tail;
+		uint32_t count;
+		struct _bus_request* batch;  /* requests of the running transfer */
+		struct _buffer buffers[BUS_BATCH_BUFFERS];
+		struct _irq_work work;
+		volatile bool starting;
+		volatile bool restart;
+	} queue;
+
+	uint64_t start_us;
+	uint32_t xfer_bytes;
+	struct _bus_stats stats;
 };
 
 /*----------------------------------------------------------------------------
@@ -88,16 +106,228 @@ static struct _bus_desc _bus[BUS_COUNT];
  *         Local functions
  *----------------------------------------------------------------------------*/
 
+static void _bus_queue_start(uint8_t bus_id);
+
+static void _bus_account(uint8_t bus_id)
+{
+	struct _bus_desc* bus = &_bus[bus_id];
+
+	bus->stats.transfers++;
+	bus->stats.bytes += bus->xfer_bytes;
+	bus->stats.busy_us += timer_get_time_us() - bus->start_us;
+}
+
+static int _bus_start(uint8_t bus_id, uint16_t remote, struct _buffer* buf, uint16_t buffers, struct _callback* cb)
+{
+	struct _bus_desc* bus = &_bus[bus_id];
+	int err;
+	int i;
+
+	bus->xfer_bytes = 0;
+	for (i = 0; i < buffers; i++)
+		bus->xfer_bytes += buf[i].size;
+	bus->start_us = timer_get_time_us();
+
+	switch (bus->type) {
+#ifdef CONFIG_HAVE_SPI_BUS
+	case BUS_TYPE_SPI:
+		bus->iface.spid.chip_select = (uint8_t)remote;
+
+		err = spid_transfer(&bus->iface.spid, buf, buffers, cb);
+		break;
+#endif
+#ifdef CONFIG_HAVE_I2C_BUS
+	case BUS_TYPE_I2C:
+		bus->iface.twid.slave_addr = (uint8_t)remote;
+
+		err = twid_transfer(&bus->iface.twid, buf, buffers, cb);
+		break;
+#endif
+	default:
+		err = -EINVAL;
+		break;
+	}
+
+	return err;
+}
+
+static void _bus_queue_kick(uint8_t bus_id)
+{
+	/* twid_transfer() waits between buffers, never from an interrupt that
+	 * may be the TWI one */
+	if (_bus[bus_id].type == BUS_TYPE_I2C && irq_get_nesting() > 0)
+		irq_work_queue(&_bus[bus_id].queue.work);
+	else
+		_bus_queue_start(bus_id);
+}
+
+static void _bus_queue_complete(uint8_t bus_id, int status)
+{
+	struct _bus_desc* bus = &_bus[bus_id];
+	struct _bus_request* req = bus->queue.batch;
+	struct _bus_request* next;
+
+	bus->queue.batch = NULL;
+	mutex_unlock(&bus->mutex.lock);
+	mutex_unlock(&bus->mutex.transaction);
+
+	while (req) {
+		/* the callback may submit the request again */
+		next = req->next;
+		bus->stats.requests++;
+		if (status < 0)
+			bus->stats.errors++;
+		req->status = status;
+		callback_call(&req->cb, req);
+		req = next;
+	}
+
+	_bus_queue_kick(bus_id);
+}
+
+static int _bus_queue_callback(void* arg, void* arg2)
+{
+	uint8_t bus_id = (uint32_t)arg;
+	int err = (int)arg2;
+
+	_bus_account(bus_id);
+	/* drivers report a failed transfer (e.g. TWI NACK) as a negative arg2 */
+	_bus_queue_complete(bus_id, err < 0 ? err : 0);
+
+	return 0;
+}
+
+static int _bus_queue_work(void* arg, void* arg2)
+{
+	_bus_queue_start((uint32_t)arg);
+
+	return 0;
+}
+
+static bool _bus_can_merge(uint8_t bus_id, const struct _bus_request* prev,
+		const struct _bus_request* next)
+{
+	if (next->remote != prev->remote)
+		return false;
+
+	switch (_bus[bus_id].type) {
+#ifdef CONFIG_HAVE_SPI_BUS
+	case BUS_TYPE_SPI:
+		/* spid only looks at RELEASE_CS on the last buffer */
+		return (prev->buf[prev->buffers - 1].attr & BUS_SPI_BUF_ATTR_RELEASE_CS) == 0;
+#endif
+#ifdef CONFIG_HAVE_I2C_BUS
+	case BUS_TYPE_I2C:
+		return (next->buf[0].attr & BUS_I2C_BUF_ATTR_START) != 0;
+#endif
+	default:
+		return false;
+	}
+}
+
+/* Must be called with interrupts masked */
+static struct _bus_request* _bus_queue_take(uint8_t bus_id, uint16_t* buffers)
+{
+	struct _bus_desc* bus = &_bus[bus_id];
+	struct _bus_request* req = bus->queue.head;
+	struct _bus_request* last;
+	uint32_t count = 1;
+
+	if (!req || bus->queue.batch)
+		return NULL;
+	if (!mutex_try_lock(&bus->mutex.transaction))
+		return NULL;
+	if (!mutex_try_lock(&bus->mutex.lock)) {
+		mutex_unlock(&bus->mutex.transaction);
+		return NULL;
+	}
+
+	*buffers = req->buffers;
+	for (last = req; last->next; last = last->next) {
+		if (*buffers + last->next->buffers > BUS_BATCH_BUFFERS ||
+		    !_bus_can_merge(bus_id, last, last->next))
+			break;
+		*buffers += last->next->buffers;
+		count++;
+	}
+
+	bus->queue.head = last->next;
+	if (!bus->queue.head)
+		bus->queue.tail = NULL;
+	last->next = NULL;
+	bus->queue.count -= count;
+	bus->queue.batch = req;
+	bus->stats.merged += count - 1;
+
+	return req;
+}
+
+static void _bus_queue_start(uint8_t bus_id)
+{
+	struct _bus_desc* bus = &_bus[bus_id];
+	struct _bus_request* req;
+	struct _buffer* buf;
+	struct _callback cb;
+	uint16_t buffers;
+	uint32_t flags;
+	int err;
+
+	flags = arch_irq_save();
+	if (bus->queue.starting) {
+		/* a completion while starting, or a synchronous one (polling) */
+		bus->queue.restart = true;
+		arch_irq_restore(flags);
+		return;
+	}
+	bus->queue.starting = true;
+
+	do {
+		bus->queue.restart = false;
+		req = _bus_queue_take(bus_id, &buffers);
+		arch_irq_restore(flags);
+
+		if (req) {
+			buf = req->buf;
+			if (req->next) {
+				struct _bus_request* r;
+
+				buf = bus->queue.buffers;
+				for (r = req; r; r = r->next) {
+					memcpy(buf, r->buf, r->buffers * sizeof(*buf));
+					buf += r->buffers;
+				}
+				buf = bus->queue.buffers;
+			}
+
+			callback_set(&cb, _bus_queue_callback, (void*)(uint32_t)bus_id);
+			err = _bus_start(bus_id, req->remote, buf, buffers, &cb);
+			if (err < 0)
+				_bus_queue_complete(bus_id, err);
+		}
+
+		flags = arch_irq_save();
+	} while (bus->queue.restart);
+
+	bus->queue.starting = false;
+	arch_irq_restore(flags);
+}
+
 static int _bus_callback(void* arg, void* arg2)
 {
 	uint32_t bus_id = (uint32_t)arg;
+	int err = (int)arg2;
 
 	if (bus_id >= BUS_COUNT)
 		return -ENODEV;
 
+	_bus_account(bus_id);
+	_bus[bus_id].stats.requests++;
+	if (err < 0)
+		_bus[bus_id].stats.errors++;
 	mutex_unlock(&_bus[bus_id].mutex.lock);
 
-	return callback_call(&_bus[bus_id].callback, NULL);
+	/* forward the transfer status, NULL on success */
+	return callback_call(&_bus[bus_id].callback, (void*)(err < 0 ? err : 0));
 }
 
 static int _bus_fifo_enable(uint8_t bus_id)
@@ -303,6 +533,9 @@ int bus_configure(uint8_t bus_id, const struct _bus_iface* iface)
 	_bus[bus_id].transfer_mode = iface->transfer_mode;
 	_bus[bus_id].options = O_BLOCK;
 	_bus[bus_id].type = iface->type;
+	_bus[bus_id].stats.since_us = timer_get_time_us();
+	irq_work_init(&_bus[bus_id].queue.work, _bus_queue_work,
+	              (void*)(uint32_t)bus_id, IRQ_WORK_PRIORITIES - 1);
 
 	switch (_bus[bus_id].type) {
 #ifdef CONFIG_HAVE_SPI_BUS
@@ -431,26 +664,7 @@ int bus_transfer(uint8_t bus_id, uint16_t remote, struct _buffer* buf, uint16_t
 	callback_copy(&_bus[bus_id].callback, cb);
 
 	callback_set(&_cb, _bus_callback, (void*)(uint32_t)bus_id);
-	switch (_bus[bus_id].type) {
-#ifdef CONFIG_HAVE_SPI_BUS
-	case BUS_TYPE_SPI:
-		_bus[bus_id].iface.spid.chip_select = (uint8_t)remote;
-
-		err = spid_transfer(&_bus[bus_id].iface.spid, buf, buffers, &_cb);
-		break;
-#endif
-#ifdef CONFIG_HAVE_I2C_BUS
-	case BUS_TYPE_I2C:
-		_bus[bus_id].iface.twid.slave_addr = (uint8_t)remote;
-
-		err = twid_transfer(&_bus[bus_id].iface.twid, buf, buffers, &_cb);
-		break;
-#endif
-	default:
-		err = -EINVAL;
-		break;
-	}
-
+	err = _bus_start(bus_id, remote, buf, buffers, &_cb);
 	if (err < 0) {
 		mutex_unlock(&_bus[bus_id].mutex.lock);
 		return err;
@@ -480,6 +694,7 @@ int bus_stop_transaction(uint8_t bus_id)
 		return -ENODEV;
 
 	mutex_unlock(&_bus[bus_id].mutex.transaction);
+	_bus_queue_kick(bus_id);
 
 	return 0;
 }
@@ -546,3 +761,97 @@ int bus_suspend(uint8_t bus_id)
 
 	return err;
 }
+
+int bus_submit(uint8_t bus_id, struct _bus_request* req)
+{
+	struct _bus_desc* bus;
+	uint32_t flags;
+
+	if (bus_id >= BUS_COUNT)
+		return -ENODEV;
+	bus = &_bus[bus_id];
+
+	if (bus->type == BUS_TYPE_NONE)
+		return -ENODEV;
+	if (req->buf == NULL || req->buffers == 0)
+		return -EINVAL;
+	/* I2C completions start the next transfer from deferred work */
+	if (bus->type == BUS_TYPE_I2C && !irq_work_is_configured())
+		return -ENOTSUP;
+
+	req->next = NULL;
+	req->status = -EINPROGRESS;
+
+	flags = arch_irq_save();
+	if (bus->queue.tail)
+		bus->queue.tail->next = req;
+	else
+		bus->queue.head = req;
+	bus->queue.tail = req;
+	bus->queue.count++;
+	if (bus->queue.count > bus->stats.max_queued)
+		bus->stats.max_queued = bus->queue.count;
+	arch_irq_restore(flags);
+
+	_bus_queue_kick(bus_id);
+
+	return 0;
+}
+
+int bus_cancel(uint8_t bus_id, struct _bus_request* req)
+{
+	struct _bus_desc* bus;
+	struct _bus_request** pprev;
+	struct _bus_request* prev = NULL;
+	uint32_t flags;
+
+	if (bus_id >= BUS_COUNT)
+		return -ENODEV;
+	bus = &_bus[bus_id];
+
+	flags = arch_irq_save();
+	for (pprev = &bus->queue.head; *pprev; pprev = &(*pprev)->next) {
+		if (*pprev == req) {
+			*pprev = req->next;
+			if (bus->queue.tail == req)
+				bus->queue.tail = prev;
+			bus->queue.count--;
+			arch_irq_restore(flags);
+
+			req->next = NULL;
+			req->status = -ECANCELED;
+			return 0;
+		}
+		prev = *pprev;
+	}
+	arch_irq_restore(flags);
+
+	return -EBUSY;
+}
+
+int bus_get_stats(uint8_t bus_id, struct _bus_stats* stats)
+{
+	uint32_t flags;
+
+	if (bus_id >= BUS_COUNT)
+		return -ENODEV;
+
+	flags = arch_irq_save();
+	*stats = _bus[bus_id].stats;
+	arch_irq_restore(flags);
+
+	return 0;
+}
+
+void bus_reset_stats(uint8_t bus_id)
+{
+	uint32_t flags;
+
+	if (bus_id >= BUS_COUNT)
+		return;
+
+	flags = arch_irq_save();
+	memset(&_bus[bus_id].stats, 0, sizeof(_bus[bus_id].stats));
+	_bus[bus_id].stats.since_us = timer_get_time_us();
+	arch_irq_restore(flags);
+}
@@ -72,6 +72,9 @@ enum _bus_ioctl {
 	BUS_IOCTL_SET_TIMEOUT = 8,
 };
 
+/** Most buffers of queued requests merged into one transfer */
+#define BUS_BATCH_BUFFERS 8
+
 /*----------------------------------------------------------------------------
  *         Exported types
  *----------------------------------------------------------------------------*/
@@ -133,6 +136,26 @@ struct _bus_dev_cfg {
 	};
 };
 
+struct _bus_request {
+	struct _bus_request* next;
+	uint16_t remote;          /**< chip select or slave address */
+	struct _buffer* buf;
+	uint16_t buffers;
+	struct _callback cb;      /**< called with the request as arg2 when done */
+	volatile int status;      /**< -EINPROGRESS while queued, then result */
+};
+
+struct _bus_stats {
+	uint32_t requests;        /**< requests completed */
+	uint32_t transfers;       /**< transfers started on the controller */
+	uint32_t merged;          /**< requests merged into a previous transfer */
+	uint32_t errors;          /**< requests completed with an error */
+	uint32_t max_queued;      /**< deepest request queue */
+	uint64_t bytes;           /**< bytes transferred */
+	uint64_t busy_us;         /**< time with a transfer running */
+	uint64_t since_us;        /**< time of the last reset */
+};
+
 /*----------------------------------------------------------------------------
  *         Exported functions
  *----------------------------------------------------------------------------*/
@@ -205,7 +228,8 @@ void bus_wait_transaction(uint8_t bus_id);
  * \param remote     Address of the remote device
  * \param buf        List of buffer to transfer
  * \param buffers    Number of buffers to transfer
- * \param cb         Callback to call when transfer is over
+ * \param cb         Callback to call when transfer is over, with NULL or a
+ *                   negative error code (e.g. -ECONNABORTED for a NACK) as arg2
  * \return 0 on success, < 0 on error
  */
 int bus_transfer(uint8_t bus_id, uint16_t remote, struct _buffer* buf, uint16_t buffers, struct _callback* cb);
@@ -234,4 +258,57 @@ int bus_wait_transfer(uint8_t bus_id);
  */
 int bus_suspend(uint8_t bus_id);
 
+/*
+ * Request queue: clients submit transfers without waiting for the bus, the
+ * queue starts them one after the other as soon as the bus is free and no
+ * transaction is opened with bus_start_transaction().
+ *
+ * Consecutive requests for the same remote are merged into one controller
+ * transfer when they fit in BUS_BATCH_BUFFERS and the controller can chain
+ * them: SPI requests whose last buffer keeps the chip select asserted, I2C
+ * requests beginning with a (repeated) start.
+ *
+ * SPI transfers start back to back from the completion interrupt. The I2C
+ * driver waits between the buffers of a transfer, so after a completion
+ * the next I2C transfer starts from deferred work (see irq/irq_work.h):
+ * the application must call irq_work_configure() with a spare interrupt
+ * source before queueing I2C requests, bus_submit() fails otherwise.
+ */
+
+/**
+ * \brief Queue a request, its callback runs when it is done (from interrupt
+ * context).
+ *
+ * \param bus_id     bus id
+ * \param req        request, left untouched by the caller until completion
+ * \return 0 on success, -ENOTSUP for an I2C bus without deferred work
+ * interrupt source, < 0 on other errors
+ */
+int bus_submit(uint8_t bus_id, struct _bus_request* req);
+
+/**
+ * \brief Remove a request that did not start yet
+ *
+ * \param bus_id     bus id
+ * \param req        request
+ * \return 0 on success, -EBUSY if the request is running or done
+ */
+int bus_cancel(uint8_t bus_id, struct _bus_request* req);
+
+/**
+ * \brief Get the utilization counters of a bus
+ *
+ * \param bus_id     bus id
+ * \param stats      counters
+ * \return 0 on success, < 0 on error
+ */
+int bus_get_stats(uint8_t bus_id, struct _bus_stats* stats);
+
+/**
+ * \brief Clear the utilization counters of a bus
+ *
+ * \param bus_id     bus id
+ */
+void bus_reset_stats(uint8_t bus_id);
+
 #endif /* ! BUS_H */
@@ -0,0 +1,181 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <assert.h>
+#include <stddef.h>
+#include <string.h>
+
+#include "cpuidle.h"
+#include "power/idle.h"
+
+/*----------------------------------------------------------------------------
+ *        Local functions declarations
+ *----------------------------------------------------------------------------*/
+
+static uint32_t _idle_wfi(uint32_t expected);
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+/* Default figures per chip. The ULP latencies include the main oscillator or
+ * PLL restart and, for DDR variants, the self-refresh exit. */
+static struct _idle_state _states[IDLE_STATE_COUNT] = {
+	[IDLE_WFI] = {
+		.name = "wfi",
+		.exit_latency = 1,
+		.target_residency = 1,
+		.enter = _idle_wfi,
+	},
+#if defined(CONFIG_SOC_SAMA5D2) || defined(CONFIG_SOC_SAM9X60)
+	[IDLE_ULP0] = {
+		.name = "ulp0",
+		.exit_latency = 300,
+		.target_residency = 2000,
+	},
+	[IDLE_ULP1] = {
+		.name = "ulp1",
+		.exit_latency = 1000,
+		.target_residency = 10000,
+	},
+#elif defined(CONFIG_SOC_SAMA5D3) || defined(CONFIG_SOC_SAMA5D4) || \
+      defined(CONFIG_SOC_SAM9XX5)
+	[IDLE_ULP0] = {
+		.name = "ulp0",
+		.exit_latency = 500,
+		.target_residency = 3000,
+	},
+	[IDLE_ULP1] = {
+		.name = "ulp1",
+	},
+#elif defined(CONFIG_SOC_SAMV71)
+	[IDLE_ULP0] = {
+		.name = "sleep",
+		.exit_latency = 10,
+		.target_residency = 100,
+	},
+	[IDLE_ULP1] = {
+		.name = "wait",
+		.exit_latency = 100,
+		.target_residency = 5000,
+	},
+#else
+	[IDLE_ULP0] = {
+		.name = "ulp0",
+	},
+	[IDLE_ULP1] = {
+		.name = "ulp1",
+	},
+#endif
+};
+
+static struct _idle_stats _stats[IDLE_STATE_COUNT];
+
+static uint32_t _latency_limit = UINT32_MAX;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static uint32_t _idle_wfi(uint32_t expected)
+{
+	cpu_idle();
+	return 0;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+void idle_set_state(enum _idle_state_id id, const struct _idle_state* state)
+{
+	assert(id < IDLE_STATE_COUNT);
+
+	_states[id] = *state;
+}
+
+const struct _idle_state* idle_get_state(enum _idle_state_id id)
+{
+	assert(id < IDLE_STATE_COUNT);
+
+	return &_states[id];
+}
+
+void idle_set_latency_limit(uint32_t latency)
+{
+	_latency_limit = latency;
+}
+
+enum _idle_state_id idle_select(uint32_t expected)
+{
+	int id;
+
+	for (id = IDLE_STATE_COUNT - 1; id > IDLE_WFI; id--) {
+		const struct _idle_state* state = &_states[id];
+
+		if (state->enter &&
+		    state->exit_latency <= _latency_limit &&
+		    state->target_residency <= expected)
+			return (enum _idle_state_id)id;
+	}
+	return IDLE_WFI;
+}
+
+uint32_t idle_enter(uint32_t expected, enum _idle_state_id* id)
+{
+	enum _idle_state_id selected = idle_select(expected);
+
+	if (id)
+		*id = selected;
+	return _states[selected].enter(expected);
+}
+
+void idle_account(enum _idle_state_id id, uint32_t residency)
+{
+	assert(id < IDLE_STATE_COUNT);
+
+	_stats[id].count++;
+	_stats[id].residency += residency;
+}
+
+void idle_get_stats(enum _idle_state_id id, struct _idle_stats* stats)
+{
+	assert(id < IDLE_STATE_COUNT);
+
+	*stats = _stats[id];
+}
+
+void idle_reset_stats(void)
+{
+	memset(_stats, 0, sizeof(_stats));
+}
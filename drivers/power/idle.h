@@ -0,0 +1,135 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef _IDLE_H_
+#define _IDLE_H_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** Idle states, from the shallowest to the deepest */
+enum _idle_state_id {
+	IDLE_WFI,   /**< core clock gated, peripherals running */
+	IDLE_ULP0,  /**< MCK switched to a slow source */
+	IDLE_ULP1,  /**< clocks stopped, wake-up on fast startup events */
+	IDLE_STATE_COUNT,
+};
+
+/**
+ * Enter an idle state, called with interrupts masked. Returns the time in
+ * microseconds during which the system timer did not count, 0 if it kept
+ * running.
+ */
+typedef uint32_t (*idle_enter_t)(uint32_t expected);
+
+struct _idle_state {
+	const char* name;
+	uint32_t exit_latency;      /**< worst case wake-up time, in us */
+	uint32_t target_residency;  /**< shortest idle time saving energy, in us */
+	idle_enter_t enter;         /**< NULL if the state is not available */
+};
+
+struct _idle_stats {
+	uint32_t count;             /**< number of entries */
+	uint64_t residency;         /**< total time in the state, in us */
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/*
+ * Idle state selection: the deepest available state whose target residency
+ * fits in the expected idle time and whose exit latency is within the
+ * latency limit is chosen. The latency and residency figures of each chip
+ * are conservative defaults (PLL lock and DDR self-refresh exit included),
+ * boards can refine them with idle_set_state().
+ *
+ * Only WFI is available by default: entering ULP modes needs code running
+ * from SRAM and board specific wake-up sources, so the application provides
+ * the enter function (see examples/low_power_mode).
+ */
+
+/**
+ * \brief Override the description of an idle state.
+ * \param id     state to change
+ * \param state  new description, copied; a NULL enter function disables it
+ */
+extern void idle_set_state(enum _idle_state_id id, const struct _idle_state* state);
+
+/**
+ * \brief Get the description of an idle state.
+ */
+extern const struct _idle_state* idle_get_state(enum _idle_state_id id);
+
+/**
+ * \brief Set the maximum wake-up latency allowed, in us. Defaults to no limit.
+ */
+extern void idle_set_latency_limit(uint32_t latency);
+
+/**
+ * \brief Select the idle state for an expected idle time.
+ * \param expected  expected idle time in us, UINT32_MAX if unknown
+ */
+extern enum _idle_state_id idle_select(uint32_t expected);
+
+/**
+ * \brief Select and enter an idle state. Must be called with interrupts
+ * masked, the wake-up interrupt is serviced after they are unmasked.
+ * \param expected  expected idle time in us, UINT32_MAX if unknown
+ * \param id        if not NULL, set to the state entered
+ * \return the time during which the system timer was stopped, in us
+ */
+extern uint32_t idle_enter(uint32_t expected, enum _idle_state_id* id);
+
+/**
+ * \brief Record the time spent in an idle state.
+ * \param id         state entered
+ * \param residency  time spent, in us
+ */
+extern void idle_account(enum _idle_state_id id, uint32_t residency);
+
+/**
+ * \brief Get the residency statistics of an idle state.
+ */
+extern void idle_get_stats(enum _idle_state_id id, struct _idle_stats* stats);
+
+/**
+ * \brief Clear the residency statistics.
+ */
+extern void idle_reset_stats(void);
+
+#endif /* _IDLE_H_ */
@@ -51,12 +51,17 @@
 
 static struct _seriald console;
 
+static struct _seriald_tx console_tx;
+
 /*------------------------------------------------------------------------------
  *         Exported functions
  *------------------------------------------------------------------------------*/
 
 void console_configure(const struct _console_cfg* config)
 {
+	if (console.tx)
+		seriald_set_tx_buffer(&console, NULL, NULL, 0, SERIALD_TX_DROP);
+
 	if (config && config->addr && config->baudrate)
 	{
 		if (config->tx_pin.mask)
@@ -79,6 +84,27 @@ void console_put_string(const char* str)
 	seriald_put_string(&console, (const uint8_t*)str);
 }
 
+uint32_t console_put_buffer(const void* buffer, uint32_t len)
+{
+	return seriald_write(&console, (const uint8_t*)buffer, len);
+}
+
+int console_set_tx_buffer(uint8_t* buffer, uint32_t size, bool block)
+{
+	return seriald_set_tx_buffer(&console, &console_tx, buffer, size,
+			block ? SERIALD_TX_WAIT : SERIALD_TX_DROP);
+}
+
+uint32_t console_get_tx_dropped(void)
+{
+	return console.tx ? console.tx->dropped : 0;
+}
+
+void console_flush(void)
+{
+	seriald_flush(&console);
+}
+
 bool console_is_tx_empty(void)
 {
 	return seriald_is_tx_empty(&console);
@@ -68,7 +68,8 @@ extern void console_configure(const struct _console_cfg* config);
 /**
  * \brief Outputs a character on the CONSOLE.
  *
- * \note This function is synchronous (i.e. uses polling).
+ * \note This function is synchronous (i.e. uses polling) unless a TX buffer
+ * has been set with console_set_tx_buffer().
  * \param c  Character to send.
  */
 extern void console_put_char(char c);
@@ -76,11 +77,45 @@ extern void console_put_char(char c);
 /**
  * \brief Outputs a string on the CONSOLE.
  *
- * \note This function is synchronous (i.e. uses polling).
+ * \note This function is synchronous (i.e. uses polling) unless a TX buffer
+ * has been set with console_set_tx_buffer().
  * \param str  String to send.
  */
 extern void console_put_string(const char* str);
 
+/**
+ * \brief Outputs a buffer on the CONSOLE.
+ *
+ * \param buffer  Data to send.
+ * \param len     Number of bytes to send.
+ * \return the number of bytes queued or sent, 0 if the buffer was dropped.
+ */
+extern uint32_t console_put_buffer(const void* buffer, uint32_t len);
+
+/**
+ * \brief Make CONSOLE output non-blocking: data is copied to the given ring
+ * buffer and drained by DMA (or by TX interrupt if no DMA channel is
+ * available).
+ *
+ * \param buffer  Ring buffer, size must be a power of two. NULL reverts to
+ * polled output.
+ * \param size    Size of the buffer in bytes.
+ * \param block   When the buffer is full, wait for room (true) or drop the
+ * message (false). Callers with interrupts masked never wait.
+ * \return 0 on success, a negative error code otherwise.
+ */
+extern int console_set_tx_buffer(uint8_t* buffer, uint32_t size, bool block);
+
+/**
+ * \brief Number of bytes dropped because the TX buffer was full.
+ */
+extern uint32_t console_get_tx_dropped(void);
+
+/**
+ * \brief Wait until all buffered CONSOLE output has been sent.
+ */
+extern void console_flush(void);
+
 /**
  * \brief Check if any pending TX character has been sent
  */
@@ -32,13 +32,22 @@
 *----------------------------------------------------------------------------*/
 
 #include <assert.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <string.h>
 
 #include "board.h"
+#include "callback.h"
 #include "chip.h"
+#if defined(CONFIG_HAVE_XDMAC) || defined(CONFIG_HAVE_DMAC)
+#include "dma/dma.h"
+#define SERIALD_TX_DMA
+#endif
 #include "gpio/pio.h"
+#include "intmath.h"
 #include "irq/irq.h"
+#include "irqflags.h"
+#include "mm/cache.h"
 #ifdef CONFIG_HAVE_L1CACHE
 #include "mm/l1cache.h"
 #endif
@@ -74,6 +83,8 @@ typedef void (*disable_it_handler_t)(void*, uint32_t);
 struct _seriald_ops {
 	uint32_t             mode;
 	uint32_t             rx_int_mask;
+	uint32_t             tx_int_mask;
+	uint32_t             thr_offset;
 	init_handler_t       init;
 	put_char_handler_t   put_char;
 	tx_empty_handler_t   tx_empty;
@@ -91,6 +102,8 @@ struct _seriald_ops {
 static const struct _seriald_ops seriald_ops_usart = {
 	.mode = US_MR_CHMODE_NORMAL | US_MR_PAR_NO | US_MR_CHRL_8_BIT,
 	.rx_int_mask = US_IER_RXRDY,
+	.tx_int_mask = US_IER_TXEMPTY,
+	.thr_offset = offsetof(Usart, US_THR),
 	.init = (init_handler_t)usart_configure,
 	.put_char = (put_char_handler_t)usart_put_char,
 	.tx_empty = (tx_empty_handler_t)usart_is_tx_empty,
@@ -105,6 +118,8 @@ static const struct _seriald_ops seriald_ops_usart = {
 static const struct _seriald_ops seriald_ops_uart = {
 	.mode = UART_MR_CHMODE_NORMAL | UART_MR_PAR_NO,
 	.rx_int_mask = UART_IER_RXRDY,
+	.tx_int_mask = UART_IER_TXEMPTY,
+	.thr_offset = offsetof(Uart, UART_THR),
 	.init = (init_handler_t)uart_configure,
 	.put_char = (put_char_handler_t)uart_put_char,
 	.tx_empty = (tx_empty_handler_t)uart_is_tx_empty,
@@ -119,6 +134,8 @@ static const struct _seriald_ops seriald_ops_uart = {
 static const struct _seriald_ops seriald_ops_dbgu = {
 	.mode = DBGU_MR_CHMODE_NORM | DBGU_MR_PAR_NONE,
 	.rx_int_mask = DBGU_IER_RXRDY,
+	.tx_int_mask = DBGU_IER_TXEMPTY,
+	.thr_offset = offsetof(Dbgu, DBGU_THR),
 	.init = (init_handler_t)dbgu_configure,
 	.put_char = (put_char_handler_t)dbgu_put_char,
 	.tx_empty = (tx_empty_handler_t)dbgu_is_tx_empty,
@@ -133,11 +150,80 @@ static const struct _seriald_ops seriald_ops_dbgu = {
  *         Local functions
  *------------------------------------------------------------------------------*/
 
+static void _seriald_tx_start(const struct _seriald* serial);
+
+#ifdef SERIALD_TX_DMA
+static int _seriald_tx_dma_callback(void* arg, void* arg2)
+{
+	const struct _seriald* serial = (const struct _seriald*)arg;
+	struct _seriald_tx* tx = serial->tx;
+
+	dma_reset_channel(tx->dma);
+	tx->tail += tx->pending;
+	tx->pending = 0;
+	_seriald_tx_start(serial);
+	return 0;
+}
+#endif
+
+/* Start draining the TX buffer, called with interrupts masked or from the
+ * TX completion */
+static void _seriald_tx_start(const struct _seriald* serial)
+{
+	struct _seriald_tx* tx = serial->tx;
+	uint32_t index, len;
+
+	if (tx->pending || tx->head == tx->tail)
+		return;
+
+	index = tx->tail & (tx->size - 1);
+	len = min_u32(tx->head - tx->tail, tx->size - index);
+
+#ifdef SERIALD_TX_DMA
+	if (tx->dma) {
+		struct _dma_cfg cfg_dma = {
+			.data_width = DMA_DATA_WIDTH_BYTE,
+			.chunk_size = DMA_CHUNK_SIZE_1,
+			.incr_saddr = true,
+			.incr_daddr = false,
+			.loop = false,
+		};
+		struct _dma_transfer_cfg cfg = {
+			.saddr = &tx->buffer[index],
+			.daddr = (uint8_t*)serial->addr + serial->ops->thr_offset,
+			.len = len,
+		};
+		struct _callback cb;
+
+		tx->pending = len;
+		cache_clean_region(cfg.saddr, len);
+		dma_configure_transfer(tx->dma, &cfg_dma, &cfg, 1);
+		callback_set(&cb, _seriald_tx_dma_callback, (void*)serial);
+		dma_set_callback(tx->dma, &cb);
+		dma_start_transfer(tx->dma);
+		return;
+	}
+#endif
+
+	/* one character per TX empty interrupt */
+	tx->pending = 1;
+	serial->ops->put_char(serial->addr, tx->buffer[index]);
+	serial->ops->enable_it(serial->addr, serial->ops->tx_int_mask);
+}
+
 static void seriald_handler(uint32_t source, void* user_arg)
 {
 	const struct _seriald* serial = (struct _seriald*)user_arg;
+	struct _seriald_tx* tx = serial->tx;
 	uint8_t c;
 
+	if (tx && !tx->dma && tx->pending && serial->ops->tx_empty(serial->addr)) {
+		serial->ops->disable_it(serial->addr, serial->ops->tx_int_mask);
+		tx->tail += tx->pending;
+		tx->pending = 0;
+		_seriald_tx_start(serial);
+	}
+
 	if (!seriald_is_rx_ready(serial))
 		return;
 
@@ -200,12 +286,107 @@ int seriald_configure(struct _seriald* serial, void* addr, uint32_t baudrate)
 	return 0;
 }
 
+int seriald_set_tx_buffer(struct _seriald* serial, struct _seriald_tx* tx,
+		uint8_t* buffer, uint32_t size, enum _seriald_overflow overflow)
+{
+	if (!serial || !serial->id)
+		return -ENODEV;
+
+	if (serial->tx) {
+		seriald_flush(serial);
+#ifdef SERIALD_TX_DMA
+		if (serial->tx->dma)
+			dma_free_channel(serial->tx->dma);
+#endif
+		serial->tx = NULL;
+	}
+
+	if (!buffer)
+		return 0;
+	if (!tx || size < 2 || (size & (size - 1)))
+		return -EINVAL;
+
+	memset(tx, 0, sizeof(*tx));
+	tx->buffer = buffer;
+	tx->size = size;
+	tx->overflow = overflow;
+#ifdef SERIALD_TX_DMA
+	tx->dma = dma_allocate_channel(DMA_PERIPH_MEMORY, serial->id);
+#endif
+	if (!tx->dma) {
+		irq_add_handler(serial->id, seriald_handler, (void*)serial);
+		irq_enable(serial->id);
+	}
+	serial->tx = tx;
+	return 0;
+}
+
+uint32_t seriald_write(const struct _seriald* serial, const uint8_t* data, uint32_t len)
+{
+	struct _seriald_tx* tx;
+	uint32_t flags, index, n, level;
+
+	if (!serial || !serial->id)
+		return 0;
+
+	tx = serial->tx;
+	if (!tx) {
+		for (n = 0; n < len; n++)
+			serial->ops->put_char(serial->addr, data[n]);
+		return len;
+	}
+
+	if (len > tx->size) {
+		tx->dropped += len;
+		return 0;
+	}
+
+	flags = arch_irq_save();
+	while (tx->size - (tx->head - tx->tail) < len) {
+		/* waiting with interrupts masked would never end */
+		if (tx->overflow == SERIALD_TX_DROP || flags) {
+			tx->dropped += len;
+			arch_irq_restore(flags);
+			return 0;
+		}
+		arch_irq_restore(flags);
+		flags = arch_irq_save();
+	}
+
+	index = tx->head & (tx->size - 1);
+	n = min_u32(len, tx->size - index);
+	memcpy(&tx->buffer[index], data, n);
+	memcpy(tx->buffer, data + n, len - n);
+	tx->head += len;
+
+	level = tx->head - tx->tail;
+	if (level > tx->high_water)
+		tx->high_water = level;
+
+	_seriald_tx_start(serial);
+	arch_irq_restore(flags);
+	return len;
+}
+
+void seriald_flush(const struct _seriald* serial)
+{
+	if (!serial || !serial->id)
+		return;
+
+	if (serial->tx)
+		while (serial->tx->head != serial->tx->tail);
+	while (!serial->ops->tx_empty(serial->addr));
+}
+
 void seriald_put_char(const struct _seriald* serial, uint8_t c)
 {
 	if (!serial || !serial->id)
 		return;
 
-	serial->ops->put_char(serial->addr, c);
+	if (serial->tx)
+		seriald_write(serial, &c, 1);
+	else
+		serial->ops->put_char(serial->addr, c);
 }
 
 void seriald_put_string(const struct _seriald* serial, const uint8_t* str)
@@ -213,6 +394,11 @@ void seriald_put_string(const struct _seriald* serial, const uint8_t* str)
 	if (!serial || !serial->id)
 		return;
 
+	if (serial->tx) {
+		seriald_write(serial, str, strlen((const char*)str));
+		return;
+	}
+
 	while (*str)
 		serial->ops->put_char(serial->addr, *str++);
 }
@@ -267,6 +453,10 @@ void seriald_disable_rx_interrupt(const struct _seriald* serial)
 		return;
 
 	serial->ops->disable_it(serial->addr, serial->ops->rx_int_mask);
+
+	/* the handler also drains the TX buffer */
+	if (serial->tx && !serial->tx->dma)
+		return;
 	irq_disable(serial->id);
 	irq_remove_handler(serial->id, seriald_handler);
 }
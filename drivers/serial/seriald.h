@@ -47,6 +47,26 @@ typedef void (*seriald_rx_handler_t)(uint8_t received_char);
 
 /** Forward declaration of internal structure */
 struct _seriald_ops;
+struct _dma_channel;
+
+/** Behavior of a buffered write that does not fit in the TX buffer */
+enum _seriald_overflow {
+	SERIALD_TX_DROP,  /**< drop the whole write and count the bytes */
+	SERIALD_TX_WAIT,  /**< wait for room, drop if interrupts are masked */
+};
+
+/** TX buffer state, see seriald_set_tx_buffer() */
+struct _seriald_tx {
+	uint8_t* buffer;
+	uint32_t size;                  /* power of two */
+	enum _seriald_overflow overflow;
+	volatile uint32_t head;         /* free-running write index */
+	volatile uint32_t tail;         /* free-running read index */
+	volatile uint32_t pending;      /* bytes of the running DMA transfer */
+	struct _dma_channel* dma;       /* NULL: drained by TX interrupt */
+	uint32_t dropped;               /* bytes lost on overflow */
+	uint32_t high_water;            /* largest fill level */
+};
 
 /** Serial driver */
 struct _seriald {
@@ -54,6 +74,7 @@ struct _seriald {
 	void *addr; /* peripheral address */
 	seriald_rx_handler_t rx_handler; /* rx callback */
 	const struct _seriald_ops* ops; /* low-level operations */
+	struct _seriald_tx* tx; /* TX buffer, NULL when unbuffered */
 };
 
 /* ----------------------------------------------------------------------------
@@ -68,10 +89,42 @@ struct _seriald {
  */
 extern int seriald_configure(struct _seriald* seriald, void *addr, uint32_t baudrate);
 
+/**
+ * \brief Buffer the SERIAL output.
+ *
+ * The output functions then copy the data in the TX buffer and return; the
+ * buffer is drained by DMA when a channel is available for the peripheral,
+ * by the TX empty interrupt otherwise. Writers are serialized by masking
+ * the interrupts during the copy only, so the output functions can be used
+ * from interrupt handlers.
+ *
+ * \param tx        TX buffer state, must stay valid while buffered.
+ * \param buffer    Buffer, NULL to go back to synchronous output.
+ * \param size      Buffer size, a power of two.
+ * \param overflow  Behavior when a write does not fit.
+ * \return 0 on success, -EINVAL on invalid size.
+ */
+extern int seriald_set_tx_buffer(struct _seriald* seriald, struct _seriald_tx* tx,
+		uint8_t* buffer, uint32_t size, enum _seriald_overflow overflow);
+
+/**
+ * \brief Outputs a buffer on the SERIAL. When buffered, the data is queued
+ * as a whole or dropped as a whole.
+ *
+ * \return the number of bytes queued or sent.
+ */
+extern uint32_t seriald_write(const struct _seriald* seriald, const uint8_t* data, uint32_t len);
+
+/**
+ * \brief Wait until the TX buffer is drained and the last character is sent.
+ */
+extern void seriald_flush(const struct _seriald* seriald);
+
 /**
  * \brief Outputs a character on the SERIAL.
  *
- * \note This function is synchronous (i.e. uses polling).
+ * \note This function is synchronous (i.e. uses polling) unless a TX buffer
+ * is set.
  * \param c  Character to send.
  */
 extern void seriald_put_char(const struct _seriald* seriald, uint8_t c);
@@ -79,7 +132,8 @@ extern void seriald_put_char(const struct _seriald* seriald, uint8_t c);
 /**
  * \brief Outputs a string on the SERIAL.
  *
- * \note This function is synchronous (i.e. uses polling).
+ * \note This function is synchronous (i.e. uses polling) unless a TX buffer
+ * is set.
  * \param str  String to send.
  */
 extern void seriald_put_string(const struct _seriald* seriald, const uint8_t* str);
@@ -212,6 +212,13 @@ void usart_set_rx_timeout(Usart *usart, uint32_t baudrate, uint32_t timeout)
 	usart->US_RTOR = US_RTOR_TO(to);
 }
 
+void usart_set_rx_timeout_bits(Usart *usart, uint32_t bits)
+{
+	if (bits > US_RTOR_TO_Msk)
+		bits = US_RTOR_TO_Msk;
+	usart->US_RTOR = US_RTOR_TO(bits);
+}
+
 void usart_start_tx_break(Usart *usart)
 {
 	usart->US_CR = US_CR_STTBRK;
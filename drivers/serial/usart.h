@@ -194,6 +194,15 @@ extern void usart_reset_rx(Usart *usart);
  */
 extern void usart_set_rx_timeout(Usart *usart, uint32_t baudrate, uint32_t timeout);
 
+/**
+ * \brief Configure the receiver time-out in bit periods, e.g. to detect an
+ * idle line after a few characters at high bitrates.
+ *
+ * \param usart Pointer to a USART instance.
+ * \param bits Time-out in bit periods, 0 disables the time-out.
+ */
+extern void usart_set_rx_timeout_bits(Usart *usart, uint32_t bits);
+
 #ifdef US_CSR_CMP
 /**
  * \brief Configure the comparison register.
@@ -40,6 +40,7 @@
 #include "dma/dma.h"
 #include "io.h"
 #include "irq/irq.h"
+#include "irqflags.h"
 #include "mm/cache.h"
 #include "mutex.h"
 #ifdef CONFIG_HAVE_FLEXCOM
@@ -57,6 +58,8 @@
 #define USARTD_ATTRIBUTE_MASK     (0)
 #define USARTD_POLLING_THRESHOLD  16
 
+#define USARTD_RING_ERRORS        (US_CSR_OVRE | US_CSR_FRAME | US_CSR_PARE)
+
 static struct _usart_desc *_serial[USART_IFACE_COUNT];
 
 /*----------------------------------------------------------------------------
@@ -257,6 +260,115 @@ static uint32_t _usartd_pingpong_transfer(struct _usart_desc *desc, struct _buff
 	return 0;
 }
 
+/*
+ * Hand the bytes received up to pos to the ring callback, as one span or two
+ * when they wrap around the end of the ring.
+ */
+static void _usartd_ring_update(struct _usart_desc* desc, uint32_t pos, bool idle)
+{
+	struct _usartd_ring* ring = desc->ring;
+	struct _usartd_span spans[2];
+	uint32_t flags, start, len, i, count = 0;
+
+	flags = arch_irq_save();
+	if ((int32_t)(pos - ring->head) > 0)
+		ring->head = pos;
+	if (ring->head - ring->tail > ring->size) {
+		/* the DMA went over bytes not released yet */
+		ring->overflows += ring->head - ring->tail - ring->size;
+		ring->tail = ring->head - ring->size;
+	}
+	if ((int32_t)(ring->tail - ring->reported) > 0)
+		ring->reported = ring->tail;
+
+	start = ring->reported % ring->size;
+	len = ring->head - ring->reported;
+	ring->reported = ring->head;
+	if (start + len > ring->size) {
+		spans[count].data = ring->data + start;
+		spans[count++].size = ring->size - start;
+		len -= ring->size - start;
+		start = 0;
+	}
+	if (len > 0 || idle) {
+		spans[count].data = ring->data + start;
+		spans[count++].size = len;
+	}
+
+	/* keep the positions far from the uint32_t wrap, which would break
+	 * the ring index of sizes that are not a power of 2 */
+	if (ring->tail > (ring->size << 4)) {
+		ring->head -= ring->size << 4;
+		ring->tail -= ring->size << 4;
+		ring->reported -= ring->size << 4;
+		ring->dma -= ring->size << 4;
+	}
+	arch_irq_restore(flags);
+
+	for (i = 0; i < count; i++) {
+		spans[i].idle = idle && (i == count - 1);
+		if (spans[i].size > 0)
+			cache_invalidate_region((void*)spans[i].data, spans[i].size);
+		callback_call(&ring->callback, &spans[i]);
+	}
+}
+
+/* Position of the DMA in the ring */
+static uint32_t _usartd_ring_position(struct _usart_desc* desc)
+{
+	struct _usartd_ring* ring = desc->ring;
+	uint32_t segment = ring->size / USARTD_RING_SEGMENTS;
+	uint32_t len;
+
+	dma_fifo_flush(desc->dma.rx.channel);
+	len = dma_get_transferred_data_len(desc->dma.rx.channel, desc->dma.rx.cfg_dma.chunk_size, segment);
+
+	/* an item just completed, its callback is pending and will account
+	 * for it */
+	if (len >= segment)
+		len = 0;
+
+	return ring->dma + len;
+}
+
+static int _usartd_ring_dma_callback(void* arg, void* arg2)
+{
+	struct _usart_desc* desc = (struct _usart_desc*)arg;
+	uint32_t flags;
+	uint32_t pos;
+
+	flags = arch_irq_save();
+	desc->ring->dma += desc->ring->size / USARTD_RING_SEGMENTS;
+	pos = desc->ring->dma;
+	arch_irq_restore(flags);
+
+	_usartd_ring_update(desc, pos, false);
+
+	return 0;
+}
+
+static void _usartd_ring_handler(struct _usart_desc* desc, uint32_t status)
+{
+	struct _usartd_ring* ring = desc->ring;
+
+	if (status & USARTD_RING_ERRORS) {
+		if (status & US_CSR_OVRE)
+			ring->overruns++;
+		if (status & US_CSR_FRAME)
+			ring->frame_errors++;
+		if (status & US_CSR_PARE)
+			ring->parity_errors++;
+		usart_set_cr(desc->addr, US_CR_RSTSTA);
+	}
+
+	if (USART_STATUS_TIMEOUT(status)) {
+		/* wait for the next character before the next idle event */
+		usart_start_rx_timeout(desc->addr);
+		ring->idles++;
+		_usartd_ring_update(desc, _usartd_ring_position(desc), true);
+	}
+}
+
 static void _usartd_handler(uint32_t source, void* user_arg)
 {
 	int iface;
@@ -282,6 +394,14 @@ static void _usartd_handler(uint32_t source, void* user_arg)
 	status = usart_get_masked_status(addr);
 	desc->rx.has_timeout = false;
 
+	if (desc->ring) {
+		_usartd_ring_handler(desc, status);
+		status &= ~(US_CSR_TIMEOUT | US_CSR_RXRDY | USARTD_RING_ERRORS);
+		if (!status)
+			return;
+		_rx_stop = false;
+	}
+
 #ifdef US_CSR_CMP
 	if ((status & US_CSR_CMP) == US_CSR_CMP) {
 		if (desc->rx.buffer.attr & USARTD_BUF_ATTR_PINGPONG) {
@@ -367,6 +487,7 @@ void usartd_configure(uint8_t iface, struct _usart_desc* config)
 	assert(iface < USART_IFACE_COUNT);
 
 	_serial[iface] = config;
+	config->ring = NULL;
 
 #ifdef CONFIG_HAVE_FLEXCOM
 	Flexcom* flexcom = get_flexcom_addr_from_id(id);
@@ -611,6 +732,93 @@ uint32_t usartd_dma_pingpong_read(uint8_t iface, uint8_t* buf, uint32_t size, ui
 	return remain;
 }
 
+uint32_t usartd_ring_start(uint8_t iface, struct _usartd_ring* ring)
+{
+	assert(iface < USART_IFACE_COUNT);
+	struct _usart_desc *desc = _serial[iface];
+	struct _dma_transfer_cfg items[USARTD_RING_SEGMENTS];
+	struct _dma_cfg cfg_dma;
+	struct _callback _cb;
+	uint32_t segment = ring->size / USARTD_RING_SEGMENTS;
+	uint32_t i;
+
+	if (!ring->data || segment == 0 || (ring->size % USARTD_RING_SEGMENTS) ||
+	    segment > DMA_MAX_BT_SIZE)
+		return USARTD_ERROR;
+
+	if (!mutex_try_lock(&desc->rx.mutex))
+		return USARTD_ERROR_LOCK;
+
+	ring->head = 0;
+	ring->tail = 0;
+	ring->reported = 0;
+	ring->dma = 0;
+	ring->idles = 0;
+	ring->overflows = 0;
+	ring->overruns = 0;
+	ring->frame_errors = 0;
+	ring->parity_errors = 0;
+
+	desc->rx.buffer.size = 0;
+	desc->rx.buffer.attr = 0;
+	desc->ring = ring;
+
+	for (i = 0; i < USARTD_RING_SEGMENTS; i++) {
+		items[i].saddr = (void *)&desc->addr->US_RHR;
+		items[i].daddr = ring->data + i * segment;
+		items[i].len = segment;
+	}
+	cfg_dma = desc->dma.rx.cfg_dma;
+	cfg_dma.loop = true;
+	if (dma_configure_transfer(desc->dma.rx.channel, &cfg_dma, items, USARTD_RING_SEGMENTS) < 0) {
+		/* e.g. no free linked list item */
+		desc->ring = NULL;
+		mutex_unlock(&desc->rx.mutex);
+		return USARTD_ERROR;
+	}
+	callback_set(&_cb, _usartd_ring_dma_callback, (void*)desc);
+	dma_set_callback(desc->dma.rx.channel, &_cb);
+	cache_invalidate_region(ring->data, ring->size);
+
+	usart_set_rx_timeout_bits(desc->addr, ring->idle_bits ? ring->idle_bits : USARTD_RING_IDLE_BITS);
+	usart_get_status(desc->addr);
+	usart_set_cr(desc->addr, US_CR_RSTSTA);
+	usart_start_rx_timeout(desc->addr);
+	usart_enable_it(desc->addr, US_IER_TIMEOUT | US_IER_OVRE | US_IER_FRAME | US_IER_PARE);
+
+	dma_start_transfer(desc->dma.rx.channel);
+
+	return USARTD_SUCCESS;
+}
+
+void usartd_ring_stop(uint8_t iface)
+{
+	assert(iface < USART_IFACE_COUNT);
+	struct _usart_desc *desc = _serial[iface];
+
+	if (!desc->ring)
+		return;
+
+	usart_disable_it(desc->addr, US_IDR_TIMEOUT | US_IDR_OVRE | US_IDR_FRAME | US_IDR_PARE);
+	dma_stop_transfer(desc->dma.rx.channel);
+	_usartd_ring_update(desc, _usartd_ring_position(desc), false);
+	dma_reset_channel(desc->dma.rx.channel);
+
+	usart_set_rx_timeout(desc->addr, desc->baudrate, desc->timeout);
+	desc->ring = NULL;
+	mutex_unlock(&desc->rx.mutex);
+}
+
+void usartd_ring_release(struct _usartd_ring* ring, uint32_t count)
+{
+	uint32_t flags = arch_irq_save();
+
+	if (count > ring->head - ring->tail)
+		count = ring->head - ring->tail;
+	ring->tail += count;
+	arch_irq_restore(flags);
+}
+
 void usartd_finish_rx_transfer(uint8_t iface)
 {
 	assert(iface < USART_IFACE_COUNT);
@@ -54,6 +54,12 @@
 #define USARTD_ERROR_TIMEOUT   (5)
 #define USARTD_ERROR           (6)
 
+/** DMA items of a continuous reception ring */
+#define USARTD_RING_SEGMENTS   4
+
+/** Default idle line time-out of a continuous reception, in bit periods */
+#define USARTD_RING_IDLE_BITS  20
+
 /*----------------------------------------------------------------------------
  *        Type definitions
  *----------------------------------------------------------------------------*/
@@ -64,6 +70,34 @@ enum _usartd_buf_attr {
 	USARTD_BUF_ATTR_PINGPONG = 0x04, /* the buffer is splited into 2 and used as the ping/pong buffer */
 };
 
+/** Received bytes handed to the consumer of a continuous reception */
+struct _usartd_span {
+	const uint8_t* data;
+	uint32_t size;
+	bool idle;        /**< the line went idle after this span */
+};
+
+/** Continuous reception ring */
+struct _usartd_ring {
+	uint8_t* data;          /**< ring, cache aligned */
+	uint32_t size;          /**< multiple of USARTD_RING_SEGMENTS */
+	uint32_t idle_bits;     /**< idle time-out (0: USARTD_RING_IDLE_BITS) */
+	struct _callback callback; /**< called with a struct _usartd_span* */
+
+	/* positions in bytes since the start */
+	volatile uint32_t head;     /**< received */
+	volatile uint32_t tail;     /**< released by the consumer */
+	uint32_t reported;          /**< handed to the callback */
+	uint32_t dma;               /**< start of the current DMA item */
+
+	/* statistics */
+	uint32_t idles;
+	uint32_t overflows;     /**< bytes overwritten before release */
+	uint32_t overruns;
+	uint32_t frame_errors;
+	uint32_t parity_errors;
+};
+
 struct _usart_desc
 {
 	Usart*  addr;
@@ -123,6 +157,9 @@ struct _usart_desc
 		uint32_t buf_switch;
 		struct _dma_transfer_cfg cfg[2];
 	} dma_pingpong;
+
+	/* continuous reception, when started */
+	struct _usartd_ring* ring;
 };
 
 enum _usartd_trans_mode
@@ -140,6 +177,35 @@ enum _usartd_trans_mode
 extern void usartd_configure(uint8_t iface, struct _usart_desc* desc);
 extern uint32_t usartd_transfer(uint8_t iface, struct _buffer* buf, struct _callback* cb);
 extern uint32_t usartd_dma_pingpong_read(uint8_t iface, uint8_t* buf, uint32_t size, uint32_t* actural_read);
+
+/**
+ * \brief Start a continuous reception in \a ring with a circular DMA.
+ *
+ * The callback of the ring is called from interrupt context with the spans
+ * received in place in the ring, at the end of each DMA item and when the
+ * line goes idle for ring->idle_bits. The spans stay valid until released
+ * with usartd_ring_release(), bytes overwritten before being released are
+ * counted in ring->overflows.
+ *
+ * \param iface  USART interface
+ * \param ring  ring, its size divided by USARTD_RING_SEGMENTS is at most
+ * DMA_MAX_BT_SIZE
+ * \return USARTD_SUCCESS, USARTD_ERROR_LOCK if a reception is in progress,
+ * USARTD_ERROR for an invalid ring
+ */
+extern uint32_t usartd_ring_start(uint8_t iface, struct _usartd_ring* ring);
+
+/**
+ * \brief Stop the continuous reception, the bytes already received are
+ * handed to the callback.
+ */
+extern void usartd_ring_stop(uint8_t iface);
+
+/**
+ * \brief Give back the \a count oldest received bytes of the ring.
+ */
+extern void usartd_ring_release(struct _usartd_ring* ring, uint32_t count);
+
 extern void usartd_finish_rx_transfer(uint8_t iface);
 extern uint32_t usartd_rx_is_busy(const uint8_t iface);
 extern void usartd_wait_rx_transfer(const uint8_t iface);
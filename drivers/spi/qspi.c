@@ -411,8 +411,12 @@ static int qspi_exec(union spi_flash_priv* priv, const struct spi_flash_command
 	if (enable_data) {
 		ifr |= QSPI_IFR_DATAEN;
 
-		/* Special case for Continuous Read Mode. */
-		if (!cmd->tx_data && !cmd->rx_data)
+		/* Special case for Continuous Read Mode: the instruction is
+		 * only sent for the first access, the next ones start with
+		 * the address. This requires the mode bits that keep the
+		 * memory in continuous read, reads without them (e.g. 1-1-1
+		 * fast read) send the instruction on every access. */
+		if (!cmd->tx_data && !cmd->rx_data && cmd->num_mode_cycles)
 			ifr |= QSPI_IFR_CRM;
 	}
 
@@ -156,6 +156,14 @@ void spi_mode_master_enable(Spi *spi, bool master)
 		spi->SPI_MR = spi->SPI_MR & ~SPI_MR_MSTR;
 }
 
+void spi_set_loopback(Spi *spi, bool enable)
+{
+	if (enable)
+		spi->SPI_MR |= SPI_MR_LLB;
+	else
+		spi->SPI_MR &= ~SPI_MR_LLB;
+}
+
 void spi_select_cs(Spi * spi, uint8_t cs)
 {
 	uint32_t mr = spi->SPI_MR & ~SPI_MR_PCS_Msk;
@@ -125,6 +125,15 @@ extern void spi_configure_cs(Spi * spi, uint8_t cs, uint32_t bitrate,
  */
 extern void spi_mode_master_enable(Spi *spi, bool master);
 
+/**
+ * \brief Enable or disable the local loopback (MISO internally connected to
+ * MOSI), to exercise the master without a remote device
+ *
+ * \param spi  Pointer to an Spi instance.
+ * \param enable  Enable the loopback if true, disable it otherwise.
+ */
+extern void spi_set_loopback(Spi *spi, bool enable);
+
 /**
  * \brief Configures the current chip select bitrate
  *
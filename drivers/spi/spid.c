@@ -39,7 +39,9 @@
 #include "callback.h"
 #include "dma/dma.h"
 #include "errno.h"
+#include "intmath.h"
 #include "irq/irq.h"
+#include "irqflags.h"
 #include "mm/cache.h"
 #include "peripherals/bus.h"
 #ifdef CONFIG_HAVE_FLEXCOM
@@ -48,6 +50,7 @@
 #include "peripherals/pmc.h"
 #include "spi/spi.h"
 #include "spi/spid.h"
+#include "timer.h"
 #include "trace.h"
 
 /*----------------------------------------------------------------------------
@@ -56,6 +59,15 @@
 
 #define SPID_POLLING_THRESHOLD      16
 
+/** Size of the 0xff source and of the sink standing for the missing TX or RX
+ * data of a buffer in a DMA chain. The address mode is set per channel, not
+ * per item, so they are walked like data: a buffer up to this size takes a
+ * single item. */
+#define SPID_FILLER_SIZE            4096
+
+/** Most DMA items of a chained transfer, per direction */
+#define SPID_CHAIN_ITEMS            16
+
 /*----------------------------------------------------------------------------
  *        Local variables
  *----------------------------------------------------------------------------*/
@@ -63,6 +75,12 @@
 CACHE_ALIGNED
 static uint32_t _garbage = UINT32_MAX;
 
+CACHE_ALIGNED
+static uint8_t _filler[SPID_FILLER_SIZE];
+
+CACHE_ALIGNED
+static uint8_t _sink[SPID_FILLER_SIZE];
+
 /*----------------------------------------------------------------------------
  *        Local functions
  *----------------------------------------------------------------------------*/
@@ -113,9 +131,18 @@ static int _spid_dma_tx_callback(void* arg, void* arg2)
 	return 0;
 }
 
-static void _spid_transfer_current_buffer_dma(struct _spi_desc* desc)
+static void _spid_dma_allocate(struct _spi_desc* desc)
 {
 	uint32_t id = get_spi_id_from_addr(desc->addr);
+
+	if (!desc->xfer.dma.tx_channel)
+		desc->xfer.dma.tx_channel = dma_allocate_channel(DMA_PERIPH_MEMORY, id);
+	if (!desc->xfer.dma.rx_channel)
+		desc->xfer.dma.rx_channel = dma_allocate_channel(id, DMA_PERIPH_MEMORY);
+}
+
+static void _spid_transfer_current_buffer_dma(struct _spi_desc* desc)
+{
 	struct _callback _cb;
 	struct _dma_transfer_cfg rx_cfg = {
 		.saddr = (void*)&desc->addr->SPI_RDR,
@@ -153,10 +180,7 @@ static void _spid_transfer_current_buffer_dma(struct _spi_desc* desc)
 		rx_cfg_dma.incr_daddr = true;
 	}
 
-	if (!desc->xfer.dma.tx_channel)
-		desc->xfer.dma.tx_channel = dma_allocate_channel(DMA_PERIPH_MEMORY, id);
-	if (!desc->xfer.dma.rx_channel)
-		desc->xfer.dma.rx_channel = dma_allocate_channel(id, DMA_PERIPH_MEMORY);
+	_spid_dma_allocate(desc);
 
 	dma_reset_channel(desc->xfer.dma.tx_channel);
 	dma_configure_transfer(desc->xfer.dma.tx_channel, &tx_cfg_dma, &tx_cfg, 1);
@@ -172,6 +196,170 @@ static void _spid_transfer_current_buffer_dma(struct _spi_desc* desc)
 	dma_start_transfer(desc->xfer.dma.tx_channel);
 }
 
+/* Append the items moving len bytes between memory at addr and the data
+ * register reg, max bytes per item. The filler and the sink are reused from
+ * their start for each item. */
+static int _spid_chain_add(struct _dma_transfer_cfg* items, int count,
+		void* addr, uint32_t len, uint32_t max, bool to_periph, void* reg)
+{
+	bool repeat = (addr == _filler || addr == _sink);
+	uint32_t chunk;
+	uint32_t offset = 0;
+
+	while (offset < len) {
+		if (count == SPID_CHAIN_ITEMS)
+			return -ENOMEM;
+		chunk = min_u32(len - offset, max);
+		if (to_periph) {
+			items[count].saddr = (uint8_t*)addr + (repeat ? 0 : offset);
+			items[count].daddr = reg;
+		} else {
+			items[count].saddr = reg;
+			items[count].daddr = (uint8_t*)addr + (repeat ? 0 : offset);
+		}
+		items[count].len = chunk;
+		offset += chunk;
+		count++;
+	}
+
+	return count;
+}
+
+static int _spid_dma_chain_callback(void* arg, void* arg2)
+{
+	struct _spi_desc* desc = (struct _spi_desc*)arg;
+	struct _buffer* buf;
+
+	for (buf = desc->xfer.current; buf <= desc->xfer.last; buf++)
+		if (buf->attr & BUS_BUF_ATTR_RX)
+			cache_invalidate_region(buf->data, buf->size);
+
+	/* every byte was received so every byte was sent, the TX channel
+	 * interrupt may still be pending */
+	if (!dma_is_transfer_done(desc->xfer.dma.tx_channel))
+		dma_stop_transfer(desc->xfer.dma.tx_channel);
+	dma_reset_channel(desc->xfer.dma.tx_channel);
+	dma_reset_channel(desc->xfer.dma.rx_channel);
+
+	desc->xfer.current = desc->xfer.last;
+	_spid_transfer_next_buffer(desc);
+
+	return 0;
+}
+
+/* Transfer the whole buffer list with one linked list per direction, the chip
+ * select is held from the first to the last byte and there is a single
+ * interrupt at the end */
+static int _spid_transfer_chain_dma(struct _spi_desc* desc)
+{
+	struct _dma_transfer_cfg tx_items[SPID_CHAIN_ITEMS];
+	struct _dma_transfer_cfg rx_items[SPID_CHAIN_ITEMS];
+	struct _dma_cfg cfg_dma = {
+		.loop = false,
+		.data_width = DMA_DATA_WIDTH_BYTE,
+		.chunk_size = DMA_CHUNK_SIZE_1,
+	};
+	struct _callback _cb;
+	struct _buffer* buf;
+	int tx_count = 0, rx_count = 0;
+	uint32_t total = 0;
+
+	for (buf = desc->xfer.current; buf <= desc->xfer.last; buf++)
+		total += buf->size;
+	if (total < SPID_POLLING_THRESHOLD)
+		return -EINVAL;
+
+	for (buf = desc->xfer.current; buf <= desc->xfer.last; buf++) {
+		if (buf->attr & BUS_BUF_ATTR_TX)
+			tx_count = _spid_chain_add(tx_items, tx_count, buf->data, buf->size,
+			                           DMA_MAX_BT_SIZE, true, (void*)&desc->addr->SPI_TDR);
+		else
+			tx_count = _spid_chain_add(tx_items, tx_count, _filler, buf->size,
+			                           SPID_FILLER_SIZE, true, (void*)&desc->addr->SPI_TDR);
+		if (tx_count < 0)
+			return tx_count;
+
+		if (buf->attr & BUS_BUF_ATTR_RX)
+			rx_count = _spid_chain_add(rx_items, rx_count, buf->data, buf->size,
+			                           DMA_MAX_BT_SIZE, false, (void*)&desc->addr->SPI_RDR);
+		else
+			rx_count = _spid_chain_add(rx_items, rx_count, _sink, buf->size,
+			                           SPID_FILLER_SIZE, false, (void*)&desc->addr->SPI_RDR);
+		if (rx_count < 0)
+			return rx_count;
+	}
+
+	_spid_dma_allocate(desc);
+	if (!desc->xfer.dma.tx_channel || !desc->xfer.dma.rx_channel)
+		return -ENODEV;
+
+	for (buf = desc->xfer.current; buf <= desc->xfer.last; buf++)
+		if (buf->attr & BUS_BUF_ATTR_TX)
+			cache_clean_region(buf->data, buf->size);
+
+	dma_reset_channel(desc->xfer.dma.tx_channel);
+	cfg_dma.incr_saddr = true;
+	cfg_dma.incr_daddr = false;
+	if (dma_configure_transfer(desc->xfer.dma.tx_channel, &cfg_dma, tx_items, tx_count) < 0)
+		return -ENOMEM;
+	dma_set_callback(desc->xfer.dma.tx_channel, NULL);
+
+	dma_reset_channel(desc->xfer.dma.rx_channel);
+	cfg_dma.incr_saddr = false;
+	cfg_dma.incr_daddr = true;
+	if (dma_configure_transfer(desc->xfer.dma.rx_channel, &cfg_dma, rx_items, rx_count) < 0) {
+		dma_reset_channel(desc->xfer.dma.tx_channel);
+		return -ENOMEM;
+	}
+	callback_set(&_cb, _spid_dma_chain_callback, (void*)desc);
+	dma_set_callback(desc->xfer.dma.rx_channel, &_cb);
+
+	dma_start_transfer(desc->xfer.dma.rx_channel);
+	dma_start_transfer(desc->xfer.dma.tx_channel);
+
+	return 0;
+}
+
+static int _spid_dma_circular_callback(void* arg, void* arg2)
+{
+	struct _spi_desc* desc = (struct _spi_desc*)arg;
+	uint32_t half_size = desc->xfer.circular.size / 2;
+	uint8_t* half = desc->xfer.circular.rx + desc->xfer.circular.half * half_size;
+
+	desc->xfer.circular.half ^= 1;
+	cache_invalidate_region(half, half_size);
+
+	return callback_call(&desc->xfer.callback, half);
+}
+
+static int _spid_dma_stream_callback(void* arg, void* arg2)
+{
+	struct _spi_desc* desc = (struct _spi_desc*)arg;
+	struct _spid_stream* stream = desc->xfer.stream;
+	uint32_t index = stream->head % stream->frames;
+	uint8_t* frame = stream->ring + index * stream->frame_size;
+
+	stream->timestamps[index] = timer_get_tick();
+	if (spi_get_status(desc->addr) & SPI_SR_OVRES)
+		stream->overruns++;
+	cache_invalidate_region(frame, stream->frame_size);
+
+	stream->head++;
+	if (stream->head - stream->tail >= stream->frames) {
+		/* the DMA now fills the slot of the oldest frame, drop it so
+		 * that at most frames - 1 frames are held */
+		stream->overflows++;
+		stream->tail = stream->head - stream->frames + 1;
+	}
+
+	if (index == stream->frames / 2 - 1)
+		callback_call(&stream->half, stream->ring);
+	else if (index == stream->frames - 1)
+		callback_call(&stream->full, stream->ring + (stream->frames / 2) * stream->frame_size);
+
+	return 0;
+}
+
 static void _spid_handler(uint32_t source, void* user_arg)
 {
 	uint8_t data;
@@ -336,11 +524,219 @@ int spid_transfer(struct _spi_desc* desc,
 	desc->xfer.last = &buffers[buffer_count - 1];
 	callback_copy(&desc->xfer.callback, cb);
 
+	/* whole list in one DMA chain, else buffer by buffer (tiny transfers
+	 * polled, lists too long for the chain) */
+	if (desc->transfer_mode == BUS_TRANSFER_MODE_DMA) {
+		int err = _spid_transfer_chain_dma(desc);
+
+		if (err == 0)
+			return 0;
+		if (err != -EINVAL) {
+			desc->xfer.chain_fallbacks++;
+			trace_debug("spid: DMA chain not available (%d)\r\n", err);
+		}
+	}
+
 	_spid_transfer_current_buffer(desc);
 
 	return 0;
 }
 
+int spid_start_circular(struct _spi_desc* desc, const uint8_t* tx,
+		uint8_t* rx, uint32_t size, struct _callback* cb)
+{
+	struct _dma_transfer_cfg tx_items[SPID_CHAIN_ITEMS];
+	struct _dma_transfer_cfg rx_items[2];
+	struct _dma_cfg cfg_dma = {
+		.loop = true,
+		.data_width = DMA_DATA_WIDTH_BYTE,
+		.chunk_size = DMA_CHUNK_SIZE_1,
+	};
+	struct _callback _cb;
+	int tx_count;
+	int err;
+
+	if (rx == NULL || size < 2 || (size & 1) || size / 2 > DMA_MAX_BT_SIZE)
+		return -EINVAL;
+	if (desc->transfer_mode != BUS_TRANSFER_MODE_DMA)
+		return -ENOTSUP;
+
+	if (tx)
+		tx_count = _spid_chain_add(tx_items, 0, (void*)tx, size,
+		                           DMA_MAX_BT_SIZE, true, (void*)&desc->addr->SPI_TDR);
+	else
+		tx_count = _spid_chain_add(tx_items, 0, _filler, size,
+		                           SPID_FILLER_SIZE, true, (void*)&desc->addr->SPI_TDR);
+	if (tx_count < 0)
+		return -EINVAL;
+	_spid_chain_add(rx_items, 0, rx, size, size / 2, false, (void*)&desc->addr->SPI_RDR);
+
+	if (!mutex_try_lock(&desc->mutex))
+		return -EBUSY;
+
+	_spid_dma_allocate(desc);
+	if (!desc->xfer.dma.tx_channel || !desc->xfer.dma.rx_channel) {
+		mutex_unlock(&desc->mutex);
+		return -ENODEV;
+	}
+
+	if (tx)
+		cache_clean_region((void*)tx, size);
+
+	desc->xfer.current = NULL;
+	desc->xfer.circular.rx = rx;
+	desc->xfer.circular.size = size;
+	desc->xfer.circular.half = 0;
+	callback_copy(&desc->xfer.callback, cb);
+
+	dma_reset_channel(desc->xfer.dma.tx_channel);
+	cfg_dma.incr_saddr = true;
+	cfg_dma.incr_daddr = false;
+	err = dma_configure_transfer(desc->xfer.dma.tx_channel, &cfg_dma, tx_items, tx_count);
+	dma_set_callback(desc->xfer.dma.tx_channel, NULL);
+
+	dma_reset_channel(desc->xfer.dma.rx_channel);
+	cfg_dma.incr_saddr = false;
+	cfg_dma.incr_daddr = true;
+	if (err >= 0)
+		err = dma_configure_transfer(desc->xfer.dma.rx_channel, &cfg_dma, rx_items, 2);
+	if (err < 0) {
+		dma_reset_channel(desc->xfer.dma.tx_channel);
+		dma_reset_channel(desc->xfer.dma.rx_channel);
+		mutex_unlock(&desc->mutex);
+		return err;
+	}
+	callback_set(&_cb, _spid_dma_circular_callback, (void*)desc);
+	dma_set_callback(desc->xfer.dma.rx_channel, &_cb);
+
+	spi_select_cs(desc->addr, desc->chip_select);
+	dma_start_transfer(desc->xfer.dma.rx_channel);
+	dma_start_transfer(desc->xfer.dma.tx_channel);
+
+	return 0;
+}
+
+void spid_stop_circular(struct _spi_desc* desc)
+{
+	if (!desc->xfer.circular.rx)
+		return;
+
+	dma_stop_transfer(desc->xfer.dma.tx_channel);
+	dma_stop_transfer(desc->xfer.dma.rx_channel);
+	dma_reset_channel(desc->xfer.dma.tx_channel);
+	dma_reset_channel(desc->xfer.dma.rx_channel);
+
+	/* wait for the last character and drop what it brought */
+	while (!spi_is_tx_finished(desc->addr));
+	spi_read(desc->addr);
+	spi_release_cs(desc->addr);
+
+	desc->xfer.circular.rx = NULL;
+	mutex_unlock(&desc->mutex);
+}
+
+int spid_stream_start(struct _spi_desc* desc, struct _spid_stream* stream)
+{
+	struct _dma_transfer_cfg items[SPID_STREAM_MAX_FRAMES];
+	struct _dma_cfg cfg_dma = {
+		.incr_saddr = false,
+		.incr_daddr = true,
+		.loop = true,
+		.data_width = DMA_DATA_WIDTH_BYTE,
+		.chunk_size = DMA_CHUNK_SIZE_1,
+	};
+	struct _callback _cb;
+	uint32_t i;
+	int err;
+
+	if (stream->ring == NULL || stream->frame_size == 0 ||
+	    stream->frame_size > DMA_MAX_BT_SIZE || stream->frames < 2 ||
+	    (stream->frames & 1) || stream->frames > SPID_STREAM_MAX_FRAMES)
+		return -EINVAL;
+
+	for (i = 0; i < stream->frames; i++) {
+		items[i].saddr = (void*)&desc->addr->SPI_RDR;
+		items[i].daddr = stream->ring + i * stream->frame_size;
+		items[i].len = stream->frame_size;
+	}
+
+	if (!mutex_try_lock(&desc->mutex))
+		return -EBUSY;
+
+	_spid_dma_allocate(desc);
+	if (!desc->xfer.dma.rx_channel) {
+		mutex_unlock(&desc->mutex);
+		return -ENODEV;
+	}
+
+	stream->head = 0;
+	stream->tail = 0;
+	stream->overflows = 0;
+	stream->overruns = 0;
+	desc->xfer.current = NULL;
+	desc->xfer.stream = stream;
+
+	dma_reset_channel(desc->xfer.dma.rx_channel);
+	err = dma_configure_transfer(desc->xfer.dma.rx_channel, &cfg_dma, items, stream->frames);
+	if (err < 0) {
+		desc->xfer.stream = NULL;
+		mutex_unlock(&desc->mutex);
+		return err;
+	}
+	callback_set(&_cb, _spid_dma_stream_callback, (void*)desc);
+	dma_set_callback(desc->xfer.dma.rx_channel, &_cb);
+
+	/* drop stale data and status */
+	spi_read(desc->addr);
+	spi_get_status(desc->addr);
+
+	dma_start_transfer(desc->xfer.dma.rx_channel);
+
+	return 0;
+}
+
+void spid_stream_stop(struct _spi_desc* desc)
+{
+	if (!desc->xfer.stream)
+		return;
+
+	dma_stop_transfer(desc->xfer.dma.rx_channel);
+	dma_reset_channel(desc->xfer.dma.rx_channel);
+
+	desc->xfer.stream = NULL;
+	mutex_unlock(&desc->mutex);
+}
+
+int spid_stream_get_frame(struct _spid_stream* stream, uint8_t** frame,
+		uint64_t* tick)
+{
+	uint32_t flags = arch_irq_save();
+	uint32_t index;
+
+	if (stream->tail == stream->head) {
+		arch_irq_restore(flags);
+		return -EAGAIN;
+	}
+
+	index = stream->tail % stream->frames;
+	*frame = stream->ring + index * stream->frame_size;
+	if (tick)
+		*tick = stream->timestamps[index];
+	arch_irq_restore(flags);
+
+	return 0;
+}
+
+void spid_stream_release(struct _spid_stream* stream, uint32_t count)
+{
+	uint32_t flags = arch_irq_save();
+
+	if (count > stream->head - stream->tail)
+		count = stream->head - stream->tail;
+	stream->tail += count;
+	arch_irq_restore(flags);
+}
+
 bool spid_is_busy(struct _spi_desc* desc)
 {
 	return mutex_is_locked(&desc->mutex);
@@ -376,6 +772,9 @@ int spid_configure(struct _spi_desc* desc)
 	desc->xfer.dma.tx_channel = 0;
 	desc->xfer.dma.rx_channel = 0;
 
+	memset(_filler, 0xff, sizeof(_filler));
+	cache_clean_region(_filler, sizeof(_filler));
+
 	spi_enable(desc->addr);
 
 	return 0;
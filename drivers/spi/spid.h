@@ -42,6 +42,13 @@
 #include "io.h"
 #include "mutex.h"
 
+/*------------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Most frames in the ring of a slave stream (one DMA item per frame) */
+#define SPID_STREAM_MAX_FRAMES 32
+
 /*------------------------------------------------------------------------------
  *        Types
  *----------------------------------------------------------------------------*/
@@ -53,6 +60,21 @@ enum _spid_mode {
 	SPID_MODE_3 = 0x03, // POL=1, CPHA=1
 };
 
+struct _spid_stream {
+	uint8_t* ring;          /*< frames * frame_size bytes, cache aligned */
+	uint32_t frame_size;    /*< Bytes per frame */
+	uint16_t frames;        /*< Frames in the ring, even */
+	struct _callback half;  /*< First half received, arg2 is its first frame */
+	struct _callback full;  /*< Second half received, arg2 is its first frame */
+
+	/* following fields are updated by the driver */
+	uint64_t timestamps[SPID_STREAM_MAX_FRAMES]; /*< timer_get_tick() at the end of each frame */
+	volatile uint32_t head; /*< Frames received */
+	volatile uint32_t tail; /*< Frames released */
+	uint32_t overflows;     /*< Frames overwritten before their release */
+	uint32_t overruns;      /*< Frames during which the controller lost data */
+};
+
 struct _spi_desc {
 	Spi* addr;
 	uint8_t chip_select;
@@ -84,6 +106,16 @@ struct _spi_desc {
 			struct _dma_channel* rx_channel;
 			struct _dma_channel* tx_channel;
 		} dma;
+
+		struct {
+			uint8_t* rx;     /*< Circular receive buffer */
+			uint32_t size;   /*< Size of the buffer */
+			uint8_t half;    /*< Half being received */
+		} circular;
+
+		struct _spid_stream* stream; /*< Slave stream */
+
+		uint32_t chain_fallbacks; /*< DMA lists sent buffer by buffer for lack of chain items */
 	} xfer;
 };
 
@@ -97,6 +129,78 @@ extern int spid_transfer(struct _spi_desc* desc,
 		struct _buffer* buffers, int buffer_count,
 		struct _callback* cb);
 
+/**
+ * \brief Start a continuous full-duplex DMA transfer for devices sampled at a
+ * fixed rate (ADC, sensors in streaming mode).
+ *
+ * The chip select stays asserted until spid_stop_circular(). \a tx is sent
+ * over and over (0xff when NULL) while the received data fills \a rx as a
+ * ping-pong buffer: the callback gets the address of each half (size / 2
+ * bytes) as soon as it is complete, from the DMA interrupt. The sample rate
+ * is set by the bitrate and the delay between transfers of the chip select
+ * (see spid_configure_cs()).
+ *
+ * \param desc  SPI descriptor, in DMA transfer mode
+ * \param tx    data to send, size bytes, or NULL
+ * \param rx    receive buffer, cache aligned
+ * \param size  size of both buffers, even
+ * \param cb    called for each received half
+ * \return 0 on success, < 0 on error
+ */
+extern int spid_start_circular(struct _spi_desc* desc, const uint8_t* tx,
+		uint8_t* rx, uint32_t size, struct _callback* cb);
+
+/**
+ * \brief Stop a transfer started by spid_start_circular() and release the
+ * chip select.
+ */
+extern void spid_stop_circular(struct _spi_desc* desc);
+
+/**
+ * \brief Receive continuously in slave mode (see spid_configure_master()),
+ * for external masters streaming at a high rate.
+ *
+ * The received bytes fill the ring of \a stream, frame after frame, with a
+ * circular DMA. The end of each frame is timestamped with timer_get_tick()
+ * and the half and full callbacks are called from the DMA interrupt when
+ * each half of the ring is complete. Frames are framed by byte count, not by
+ * the chip select.
+ *
+ * The consumer reads the frames with spid_stream_get_frame() or from the
+ * callbacks, then gives them back with spid_stream_release(). The slot
+ * being filled is never readable, so at most frames - 1 frames are held:
+ * unreleased frames whose slot the DMA starts filling again are dropped
+ * and counted in overflows, frames during which the controller lost bytes
+ * (DMA too late) in overruns.
+ *
+ * \param desc    SPI descriptor, configured as slave
+ * \param stream  ring and callbacks, ring size at most DMA_MAX_BT_SIZE per
+ *                frame and SPID_STREAM_MAX_FRAMES frames
+ * \return 0 on success, < 0 on error
+ */
+extern int spid_stream_start(struct _spi_desc* desc, struct _spid_stream* stream);
+
+/**
+ * \brief Stop a stream started by spid_stream_start(), the frames received
+ * so far stay readable.
+ */
+extern void spid_stream_stop(struct _spi_desc* desc);
+
+/**
+ * \brief Get the oldest received frame that was not released.
+ * \param stream  slave stream
+ * \param frame   set to the frame data
+ * \param tick    set to the frame timestamp, may be NULL
+ * \return 0 on success, -EAGAIN if no frame is available
+ */
+extern int spid_stream_get_frame(struct _spid_stream* stream, uint8_t** frame,
+		uint64_t* tick);
+
+/**
+ * \brief Release the oldest frames once processed.
+ */
+extern void spid_stream_release(struct _spid_stream* stream, uint32_t count);
+
 extern bool spid_is_busy(struct _spi_desc* desc);
 
 extern void spid_wait_transfer(struct _spi_desc* desc);
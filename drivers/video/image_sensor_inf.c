@@ -37,6 +37,7 @@
 #include "chip.h"
 #include "errno.h"
 #include "i2c/twid.h"
+#include "intmath.h"
 #include "peripherals/bus.h"
 #include "timer.h"
 #include "trace.h"
@@ -178,6 +179,50 @@ static int sensor_twi_write_reg(uint8_t twi_mode, uint8_t bus, uint8_t addr,
 	return err;
 }
 
+/**
+ * \brief Write consecutive registers in one transfer, relying on the sensor
+ * register address auto-increment.
+ * \param bus  TWI bus
+ * \param addr Sensor TWI addr
+ * \param reg First register to be written
+ * \param data Values, in bus order
+ * \param size Size of the values, in bytes
+ * \return SENSOR_OK if no error; otherwise SENSOR_TWI_ERROR
+ */
+static int sensor_twi_write_burst(uint8_t twi_mode, uint8_t bus, uint8_t addr,
+				  uint16_t reg, const uint8_t *data, uint32_t size)
+{
+	int err;
+	uint8_t addr_buf[2];
+	struct _buffer buf[2] = {
+		{
+			.data = addr_buf,
+			/* .size */
+			.attr = BUS_I2C_BUF_ATTR_START | BUS_BUF_ATTR_TX,
+		},
+		{
+			.data = (uint8_t*)data,
+			.size = size,
+			.attr = BUS_BUF_ATTR_TX | BUS_I2C_BUF_ATTR_STOP,
+		},
+	};
+
+	if (twi_mode == SENSOR_TWI_REG_2BYTE_DATA_BYTE) {
+		buf[0].size = 2;
+		addr_buf[0] = (reg >> 8) & 0xff;
+		addr_buf[1] = reg & 0xff;
+	} else {
+		buf[0].size = 1;
+		addr_buf[0] = reg & 0xff;
+	}
+
+	bus_start_transaction(bus);
+	err = bus_transfer(bus, addr, buf, 2, NULL);
+	bus_stop_transaction(bus);
+
+	return err;
+}
+
 /**
  * \brief Read and check sensor product ID.
  * \param twi_bus  TWI bus
@@ -218,28 +263,58 @@ static uint32_t sensor_check_pid(uint8_t twi_bus, struct sensor_profile* sensor_
 /**
  * \brief  Initialize a list of registers.
  * The list of registers is terminated by the pair of values
+ * If the sensor supports auto-increment writes, registers at consecutive
+ * addresses are merged in burst writes.
  * \param twi_bus  TWI bus
  * \param sensor_profile   Sensor private profile
  * \param reglist Register list to be written
  * \return SENSOR_OK if no error; otherwise SENSOR_TWI_ERROR
  */
 static uint32_t sensor_twi_write_regs(uint8_t twi_bus,
-									  struct sensor_profile* sensor_profile,
+									  const struct sensor_profile* sensor_profile,
 									  const struct sensor_reg* reglist)
 {
 	int status;
 	const struct sensor_reg *next = reglist;
+	uint8_t burst_max = min_u32(sensor_profile->burst_max, SENSOR_MAX_BURST);
+	uint8_t vals[SENSOR_MAX_BURST];
+	uint16_t reg;
+	uint8_t count;
+
+	/* bursts are only used with 8-bit values */
+	if (sensor_profile->twi_inf_mode == SENSOR_TWI_REG_BYTE_DATA_2BYTE)
+		burst_max = 0;
 
 	while (!((next->reg == SENSOR_REG_TERM) && (next->val == SENSOR_VAL_TERM))) {
-		status = sensor_twi_write_reg(sensor_profile->twi_inf_mode,
-									  twi_bus,
-									  sensor_profile->addr,
-									  next->reg,
-									  (uint8_t *)(&next->val));
-		msleep(2);
+		if (next->reg == SENSOR_REG_DELAY) {
+			msleep(next->val);
+			next++;
+			continue;
+		}
+
+		if (burst_max > 1) {
+			reg = next->reg;
+			count = 0;
+			do {
+				vals[count++] = next->val & 0xff;
+				next++;
+			} while (count < burst_max && next->reg == reg + count &&
+				 !((next->reg == SENSOR_REG_TERM) && (next->val == SENSOR_VAL_TERM)));
+			status = sensor_twi_write_burst(sensor_profile->twi_inf_mode,
+											twi_bus,
+											sensor_profile->addr,
+											reg, vals, count);
+		} else {
+			status = sensor_twi_write_reg(sensor_profile->twi_inf_mode,
+										  twi_bus,
+										  sensor_profile->addr,
+										  next->reg,
+										  (uint8_t *)(&next->val));
+			msleep(2);
+			next++;
+		}
 		if (status < 0)
 			return SENSOR_TWI_ERROR;
-		next++;
 	}
 
 	return SENSOR_OK;
@@ -249,6 +324,61 @@ static uint32_t sensor_twi_write_regs(uint8_t twi_bus,
  *        Exported functions
  *----------------------------------------------------------------------------*/
 
+uint32_t sensor_write_regs(uint8_t twi_bus,
+						   const struct sensor_profile* sensor_profile,
+						   const struct sensor_reg* regs,
+						   uint8_t count)
+{
+	int err;
+	uint8_t i;
+	uint8_t addr_buf[SENSOR_MAX_BATCH_REGS][2];
+	struct _buffer buf[2 * SENSOR_MAX_BATCH_REGS];
+	uint8_t reg_size, val_size;
+
+	if (count == 0 || count > SENSOR_MAX_BATCH_REGS)
+		return SENSOR_TWI_ERROR;
+
+	switch (sensor_profile->twi_inf_mode) {
+	case SENSOR_TWI_REG_BYTE_DATA_BYTE:
+		reg_size = 1;
+		val_size = 1;
+		break;
+	case SENSOR_TWI_REG_2BYTE_DATA_BYTE:
+		reg_size = 2;
+		val_size = 1;
+		break;
+	case SENSOR_TWI_REG_BYTE_DATA_2BYTE:
+		reg_size = 1;
+		val_size = 2;
+		break;
+	default:
+		return SENSOR_TWI_ERROR;
+	}
+
+	/* one START/address/data/STOP message per register, all queued in the
+	 * same transfer */
+	for (i = 0; i < count; i++) {
+		if (reg_size == 2) {
+			addr_buf[i][0] = (regs[i].reg >> 8) & 0xff;
+			addr_buf[i][1] = regs[i].reg & 0xff;
+		} else {
+			addr_buf[i][0] = regs[i].reg & 0xff;
+		}
+		buf[2 * i].data = addr_buf[i];
+		buf[2 * i].size = reg_size;
+		buf[2 * i].attr = BUS_I2C_BUF_ATTR_START | BUS_BUF_ATTR_TX;
+		buf[2 * i + 1].data = (uint8_t*)&regs[i].val;
+		buf[2 * i + 1].size = val_size;
+		buf[2 * i + 1].attr = BUS_BUF_ATTR_TX | BUS_I2C_BUF_ATTR_STOP;
+	}
+
+	bus_start_transaction(twi_bus);
+	err = bus_transfer(twi_bus, sensor_profile->addr, buf, 2 * count, NULL);
+	bus_stop_transaction(twi_bus);
+
+	return err < 0 ? SENSOR_TWI_ERROR : SENSOR_OK;
+}
+
 uint32_t sensor_setup(uint8_t twi_bus, struct sensor_profile* sensor_profile,
 					  uint8_t resolution,
 					  uint8_t format)
@@ -269,10 +399,60 @@ uint32_t sensor_setup(uint8_t twi_bus, struct sensor_profile* sensor_profile,
 	if (found == 0)
 		return SENSOR_RESOLUTION_NOT_SUPPORTED;
 
+	if (sensor_profile->output_conf[i]->output_packed)
+		return sensor_write_packed(twi_bus, sensor_profile,
+								   sensor_profile->output_conf[i]->output_packed);
+
 	return sensor_twi_write_regs(twi_bus, sensor_profile,
 								 sensor_profile->output_conf[i]->output_setting);
 }
 
+uint32_t sensor_write_packed(uint8_t twi_bus,
+							 const struct sensor_profile* sensor_profile,
+							 const uint8_t* table)
+{
+	const uint8_t *p = table;
+	uint8_t mode = sensor_profile->twi_inf_mode;
+	uint8_t reg_size = mode == SENSOR_TWI_REG_2BYTE_DATA_BYTE ? 2 : 1;
+	uint8_t val_size = mode == SENSOR_TWI_REG_BYTE_DATA_2BYTE ? 2 : 1;
+	uint8_t burst_max = min_u32(sensor_profile->burst_max, SENSOR_MAX_BURST);
+	uint16_t reg = 0;
+	uint8_t header, count, i, n;
+	int status;
+
+	while ((header = *p++) != SENSOR_PACK_END) {
+		if (header == SENSOR_PACK_DELAY) {
+			msleep(*p++);
+			continue;
+		}
+
+		count = header & SENSOR_PACK_COUNT_MASK;
+		if (header & SENSOR_PACK_DELTA) {
+			reg += *p++;
+		} else {
+			reg = reg_size == 2 ? (p[0] << 8) | p[1] : p[0];
+			p += reg_size;
+		}
+
+		for (i = 0; i < count; i += n) {
+			n = burst_max > 1 ? min_u32(count - i, burst_max) : 1;
+			status = sensor_twi_write_burst(mode, twi_bus,
+											sensor_profile->addr,
+											reg + i, p + i * val_size,
+											n * val_size);
+			if (status < 0)
+				return SENSOR_TWI_ERROR;
+			if (burst_max <= 1)
+				msleep(2);
+		}
+
+		p += count * val_size;
+		reg += count;
+	}
+
+	return SENSOR_OK;
+}
+
 struct sensor_profile* sensor_detect(uint8_t twi_bus, bool detect_auto, uint8_t id)
 {
 	uint8_t i;
@@ -58,6 +58,33 @@
 /** terminating list entry for value in configuration file */
 #define SENSOR_VAL_TERM         0xFF
 
+/** register value in a {reg, val} list meaning "wait val milliseconds" */
+#define SENSOR_REG_DELAY        0xFFFF
+
+/** Maximum number of registers written by one sensor_write_regs() call */
+#define SENSOR_MAX_BATCH_REGS   8
+
+/** Maximum number of registers merged in one burst write */
+#define SENSOR_MAX_BURST        64
+
+/*
+ * Packed register tables (see scripts/sensor/pack_sensor_regs.py)
+ *
+ * A packed table is a sequence of runs of registers at consecutive
+ * addresses. Each run starts with a header byte:
+ * - 0x00: end of table
+ * - 0x80: delay, followed by one byte giving the delay in milliseconds
+ * - 0x01..0x7F: number of registers, followed by the address of the first
+ *   register (1 or 2 bytes, MSB first, depending on the TWI mode)
+ * - 0x81..0xFF: number of registers (bits 6:0), followed by one byte giving
+ *   the distance from the register following the previous run
+ * The header is followed by the register values, in bus order.
+ */
+#define SENSOR_PACK_END         0x00
+#define SENSOR_PACK_DELAY       0x80
+#define SENSOR_PACK_DELTA       0x80
+#define SENSOR_PACK_COUNT_MASK  0x7F
+
 /*----------------------------------------------------------------------------
  *        Types
  *----------------------------------------------------------------------------*/
@@ -125,6 +152,7 @@ struct sensor_output {
 	uint32_t output_width;                      /** output width */
 	uint32_t output_height;                     /** output height */
 	const struct sensor_reg* output_setting;    /** sensor registers setting */
+	const uint8_t* output_packed;               /** packed registers setting, used instead of output_setting if set */
 };
 
 /** define a structure for sensor profile */
@@ -139,6 +167,7 @@ struct sensor_profile {
 	uint16_t pid_low;             /** product ID low byte */
 	uint16_t version_mask;        /** version mask */
 	const struct sensor_output* output_conf[SENSOR_SUPPORTED_OUTPUTS]; /** sensor settings */
+	uint8_t burst_max;            /** max registers per auto-increment write, 0 if not supported */
 };
 
 /*----------------------------------------------------------------------------
@@ -178,6 +207,40 @@ extern uint32_t sensor_setup(uint8_t twi_bus,
 							 uint8_t resolution,
 							 uint8_t format);
 
+/**
+ * \brief Write a packed register table.
+ *
+ * Each run of the table is sent as one bus transfer straight from the table
+ * (split in bursts of burst_max registers), or register by register if the
+ * sensor does not support auto-increment writes.
+ *
+ * \param twi_bus TWI bus
+ * \param sensor pointer to a sensor profile instance.
+ * \param table packed table
+ * \return SENSOR_OK if no error; otherwise return SENSOR_XXX_ERROR
+ */
+extern uint32_t sensor_write_packed(uint8_t twi_bus,
+									const struct sensor_profile* sensor,
+									const uint8_t* table);
+
+/**
+ * \brief Write a set of registers in a single bus transaction.
+ *
+ * Meant for run-time updates (exposure, gain...) that must reach the sensor
+ * together: the bus is locked once and all the register writes are queued in
+ * one transfer, without the settling delay used when loading a profile.
+ *
+ * \param twi_bus TWI bus
+ * \param sensor pointer to a sensor profile instance.
+ * \param regs registers to write
+ * \param count number of registers (up to SENSOR_MAX_BATCH_REGS)
+ * \return SENSOR_OK if no error; otherwise return SENSOR_XXX_ERROR
+ */
+extern uint32_t sensor_write_regs(uint8_t twi_bus,
+								  const struct sensor_profile* sensor,
+								  const struct sensor_reg* regs,
+								  uint8_t count);
+
 /**
  * \brief Retrieves sensor output bit width and size for giving resolution and format.
  * \param sensor pointer to a sensor profile instance.
@@ -707,3 +707,12 @@ void isc_dma_address(uint8_t channel, uint32_t address, uint32_t stride)
 	ISC->ISC_SUB0[channel].ISC_DAD = address;
 	ISC->ISC_SUB0[channel].ISC_DST = stride;
 }
+
+/**
+ * \brief Get the transfer address loaded from the current DMA descriptor.
+ * \param channel Channel number.
+ */
+uint32_t isc_dma_get_address(uint8_t channel)
+{
+	return ISC->ISC_SUB0[channel].ISC_DAD;
+}
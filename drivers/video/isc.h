@@ -292,6 +292,7 @@ extern void isc_dma_configure_input_mode(uint32_t mode);
 extern void isc_dma_configure_desc_entry(uint32_t desc_entry);
 extern void isc_dma_enable(uint32_t ctrl);
 extern void isc_dma_address(uint8_t channel, uint32_t address, uint32_t stride);
+extern uint32_t isc_dma_get_address(uint8_t channel);
 
 #endif /* CONFIG_HAVE_ISC */
 
@@ -27,6 +27,11 @@
  * ----------------------------------------------------------------------------
  */
 
+#include <stdlib.h>
+#include <string.h>
+
+#include "errno.h"
+#include "intmath.h"
 #include "irq/irq.h"
 
 #include "mm/cache.h"
@@ -35,6 +40,7 @@
 #include "video/isc.h"
 #include "video/iscd.h"
 
+#include "timer.h"
 #include "trace.h"
 
 /*----------------------------------------------------------------------------
@@ -63,7 +69,10 @@ static int _dma_histo_callback(void *arg, void* arg2)
 
 	cache_invalidate_region((uint32_t*)iscd->pipe.histo_buf,
 			HIST_ENTRIES * sizeof(uint32_t));
-	awb.dma.dma_histo_done = true;
+	awb.entry = 0;
+	awb.count[awb.op_mode] = 0;
+	awb.pixels[awb.op_mode] = 0;
+	awb.state = AWB_COUNT_UP;
 
 	return 0;
 }
@@ -157,15 +166,93 @@ static void _awb_update(void)
 }
 
 /**
- * \brief Count up 4 channel R/G/Gr/Gb histogram data.
+ * \brief Count up part of the histogram of the current Bayer component.
+ * \return true once the whole histogram has been counted
  */
-static void _awb_count_up(uint32_t* buf)
+static bool _awb_count_up(uint32_t* buf)
 {
 	uint32_t i;
+	uint32_t end = min_u32(awb.entry + ISCD_HISTO_STEP, HIST_ENTRIES);
+	uint32_t count = awb.count[awb.op_mode];
+	uint32_t pixels = awb.pixels[awb.op_mode];
 
-	awb.count[awb.op_mode] = 0;
-	for (i = 0; i < HIST_ENTRIES; i++)
-		awb.count[awb.op_mode] += (*buf++) * i;
+	for (i = awb.entry; i < end; i++) {
+		count += buf[i] * i;
+		pixels += buf[i];
+	}
+	awb.count[awb.op_mode] = count;
+	awb.pixels[awb.op_mode] = pixels;
+	awb.entry = end;
+
+	if (end < HIST_ENTRIES)
+		return false;
+
+	awb.mean[awb.op_mode] = pixels ? count / pixels : 0;
+	return true;
+}
+
+/**
+ * \brief Compute a new exposure from the mean green level and pass it to the
+ * application.
+ */
+static void _ae_update(struct _iscd_desc* desc)
+{
+	uint32_t pixels, mean, target, exposure;
+	int32_t delta;
+
+	if (!desc->ae.enable || !desc->ae.set_exposure || !desc->ae.target)
+		return;
+
+	pixels = awb.pixels[HISTOGRAM_GR] + awb.pixels[HISTOGRAM_GB];
+	if (!pixels)
+		return;
+	mean = (awb.count[HISTOGRAM_GR] + awb.count[HISTOGRAM_GB]) / pixels;
+	if (!mean)
+		mean = 1;
+
+	/* dead band of 1/16th of the target to avoid hunting */
+	target = desc->ae.target;
+	delta = (int32_t)mean - (int32_t)target;
+	if ((uint32_t)abs(delta) < target / 16)
+		return;
+
+	/* move half-way to the exposure giving the target level */
+	exposure = ((uint64_t)desc->ae.exposure * target) / mean;
+	exposure = (desc->ae.exposure + exposure) / 2;
+	exposure = max_u32(desc->ae.min, min_u32(desc->ae.max, exposure));
+	if (exposure == desc->ae.exposure)
+		return;
+
+	desc->ae.exposure = exposure;
+	desc->ae.set_exposure(exposure);
+}
+
+/**
+ * \brief Record the metadata of the frame just written by the DMA.
+ */
+static void _iscd_frame_done(struct _iscd_desc* desc)
+{
+	uint32_t seq = desc->ring.head;
+	struct _iscd_frame_info* info = &desc->ring.frames[seq % desc->cfg.multi_bufs];
+	uint32_t offset;
+	uint8_t index;
+
+	/* buffer of the descriptor the DMA just finished, a missed interrupt
+	 * does not shift the index */
+	offset = isc_dma_get_address(0) - desc->dma.address0;
+	if (desc->dma.size && offset / desc->dma.size < desc->cfg.multi_bufs)
+		index = offset / desc->dma.size;
+	else
+		index = desc->pipe.frame_idx;
+
+	info->index = index;
+	info->sequence = seq;
+	info->timestamp = timer_get_tick();
+	info->exposure = desc->ae.exposure;
+	memcpy(info->histo_mean, awb.mean, sizeof(info->histo_mean));
+	info->histo_sequence = awb.histo_sequence;
+
+	desc->ring.head = seq + 1;
 }
 
 /**
@@ -185,8 +272,15 @@ static void _isc_handler(uint32_t source, void* arg)
 		if (iscd->dma.callback)
 			iscd->dma.callback(iscd->pipe.frame_idx);
 	}
-	if ((status & ISC_INTSR_HISDONE) == ISC_INTSR_HISDONE)
-		awb.dma.dma_histo_ready = true;
+	if ((status & ISC_INTSR_DDONE) == ISC_INTSR_DDONE)
+		_iscd_frame_done(iscd);
+	if ((status & ISC_INTSR_HISDONE) == ISC_INTSR_HISDONE) {
+		/* fetch the histogram right away, the CPU only counts it */
+		if (awb.state == AWB_WAIT_HIS_READY && iscd->pipe.histo_buf) {
+			awb.state = AWB_WAIT_DMA_READY;
+			_iscd_dma_read_histogram((uint32_t)iscd->pipe.histo_buf);
+		}
+	}
 }
 
 /**
@@ -273,7 +367,7 @@ static uint8_t _iscd_configure_dma(struct _iscd_desc* desc)
  *        Public functions
  *----------------------------------------------------------------------------*/
 
-uint8_t iscd_pipe_start(struct _iscd_desc* desc)
+int iscd_pipe_start(struct _iscd_desc* desc)
 {
 	uint32_t i;
 	uint32_t* gg;
@@ -281,6 +375,10 @@ uint8_t iscd_pipe_start(struct _iscd_desc* desc)
 	uint32_t* bg;
 	struct _callback _cb;
 
+	if (desc->cfg.multi_bufs == 0 ||
+	    desc->cfg.multi_bufs > ISCD_MAX_DMA_DESC)
+		return -EINVAL;
+
 	irq_disable(ID_ISC);
 	isc_software_reset();
 
@@ -412,11 +510,17 @@ uint8_t iscd_pipe_start(struct _iscd_desc* desc)
 
 	awb.state = AWB_INIT;
 	awb.op_mode = 0;
+	awb.desc = desc;
+	awb.histo_sequence = 0;
+	memset(awb.mean, 0, sizeof(awb.mean));
 	desc->pipe.frame_idx = 0;
+	desc->ring.head = 0;
+	desc->ring.tail = 0;
+	desc->ring.dropped = 0;
 
 	isc_update_profile();
 	irq_add_handler(ID_ISC, _isc_handler, desc);
-	isc_enable_interrupt(ISC_INTEN_VD | ISC_INTEN_HISDONE);
+	isc_enable_interrupt(ISC_INTEN_VD | ISC_INTEN_DDONE | ISC_INTEN_HISDONE);
 	isc_interrupt_status();
 
 	irq_enable(ID_ISC);
@@ -425,32 +529,50 @@ uint8_t iscd_pipe_start(struct _iscd_desc* desc)
 	return ISCD_OK;
 }
 
-/**
- * \brief Image tuning for AWB, this is a reference algrothm only.
- */
-void iscd_auto_white_balance_ref_algo(uint32_t* histo_buf)
+int iscd_get_frame(struct _iscd_desc* desc, struct _iscd_frame_info* info)
+{
+	uint32_t head, depth;
+
+	if (desc->cfg.multi_bufs == 0 ||
+	    desc->cfg.multi_bufs > ISCD_MAX_DMA_DESC)
+		return -EINVAL;
+
+	depth = desc->cfg.multi_bufs > 1 ? desc->cfg.multi_bufs - 1 : 1;
+
+	irq_disable(ID_ISC);
+	head = desc->ring.head;
+	if (head == desc->ring.tail) {
+		irq_enable(ID_ISC);
+		return -EAGAIN;
+	}
+	if (head - desc->ring.tail > depth) {
+		desc->ring.dropped += head - desc->ring.tail - depth;
+		desc->ring.tail = head - depth;
+	}
+	*info = desc->ring.frames[desc->ring.tail % desc->cfg.multi_bufs];
+	desc->ring.tail++;
+	irq_enable(ID_ISC);
+
+	return 0;
+}
+
+void iscd_auto_adjust(struct _iscd_desc* desc)
 {
 	switch (awb.state) {
 	case AWB_INIT:
 		isc_histogram_configure(awb.op_mode, ISC_HIS_CFG_BAYSEL_BGBG, 1);
 		isc_update_profile();
-		awb.dma.dma_histo_ready = false;
-		awb.dma.dma_histo_done = false;
-		isc_update_histogram_table();
 		awb.state = AWB_WAIT_HIS_READY;
+		isc_update_histogram_table();
 		break;
 	case AWB_WAIT_HIS_READY:
-		if (!awb.dma.dma_histo_ready)
-			break;
-		awb.dma.dma_histo_ready = false;
-		_iscd_dma_read_histogram((uint32_t)histo_buf);
-		awb.state = AWB_WAIT_DMA_READY;
-		break;
 	case AWB_WAIT_DMA_READY:
-		if (!awb.dma.dma_histo_done)
+		/* histogram computed by the ISC then read by DMA, both
+		 * completions are handled in interrupt context */
+		break;
+	case AWB_COUNT_UP:
+		if (!_awb_count_up(desc->pipe.histo_buf))
 			break;
-		awb.dma.dma_histo_done = false;
-		_awb_count_up(histo_buf);
 		awb.op_mode++;
 		if (awb.op_mode < BAYER_COUNT)
 			awb.state = AWB_INIT;
@@ -459,8 +581,16 @@ void iscd_auto_white_balance_ref_algo(uint32_t* histo_buf)
 		break;
 	case AWB_WAIT_ISC_PERFORMED:
 		_awb_update();
+		_ae_update(desc);
+		awb.histo_sequence = desc->ring.head;
 		awb.op_mode = 0;
 		awb.state = AWB_INIT;
 		break;
 	}
 }
+
+void iscd_auto_white_balance_ref_algo(uint32_t* histo_buf)
+{
+	if (awb.desc)
+		iscd_auto_adjust(awb.desc);
+}
@@ -59,6 +59,9 @@
 
 #define HIST_ENTRIES (512)
 
+/* Number of histogram entries accumulated by one iscd_auto_adjust() call */
+#define ISCD_HISTO_STEP (64)
+
 #define ISCD_OK           (0)
 #define ISCD_ERROR_LOCK   (1)
 #define ISCD_ERROR_CONFIG (2)
@@ -69,6 +72,8 @@
 
 typedef void (*iscd_callback_t)(uint8_t frame_idx);
 
+typedef void (*iscd_exposure_cb_t)(uint32_t exposure);
+
 enum _iscd_layout {
 	ISCD_LAYOUT_PACKED8 = 0,
 	ISCD_LAYOUT_PACKED16,
@@ -106,9 +111,20 @@ enum _iscd_awb_state {
 	AWB_INIT = 0,
 	AWB_WAIT_HIS_READY,
 	AWB_WAIT_DMA_READY,
+	AWB_COUNT_UP,
 	AWB_WAIT_ISC_PERFORMED,
 };
 
+/** Metadata of a captured frame */
+struct _iscd_frame_info {
+	uint8_t index;           /**< Index of the frame buffer in the ring */
+	uint32_t sequence;       /**< Frame counter since iscd_pipe_start() */
+	uint32_t timestamp;      /**< Tick (ms) at the end of the frame */
+	uint32_t exposure;       /**< Sensor exposure when the frame was captured */
+	uint32_t histo_mean[BAYER_COUNT]; /**< Mean level of each Bayer component */
+	uint32_t histo_sequence; /**< Frame on which the histogram was completed */
+};
+
 struct _iscd_desc {
 	/* structure to define ISCD parameter */
 	struct {
@@ -147,26 +163,81 @@ struct _iscd_desc {
 		uint32_t size;
 		iscd_callback_t callback;
 	} dma;
+	struct {
+		bool enable;
+		uint16_t target;         /* target mean green level (0..HIST_ENTRIES-1) */
+		uint32_t exposure;       /* current exposure, in sensor units */
+		uint32_t min;
+		uint32_t max;
+		iscd_exposure_cb_t set_exposure;
+	} ae;
+	struct {
+		struct _iscd_frame_info frames[ISCD_MAX_DMA_DESC];
+		volatile uint32_t head;  /* number of frames completed */
+		uint32_t tail;           /* number of frames consumed */
+		uint32_t dropped;        /* frames overwritten before being consumed */
+	} ring;
 };
 
 struct _iscd_awb {
 	struct {
 		struct _dma_channel* dma_histo_channel;
-		bool dma_histo_ready;
-		bool dma_histo_done;
 	} dma;
+	struct _iscd_desc* desc;
 	uint32_t backup[BAYER_COUNT];
 	uint32_t count[BAYER_COUNT];
+	uint32_t pixels[BAYER_COUNT];
+	uint32_t mean[BAYER_COUNT];
+	uint32_t histo_sequence;
 	uint32_t op_mode;
-	enum _iscd_awb_state state;
+	uint32_t entry;
+	volatile enum _iscd_awb_state state;
 };
 
 /*------------------------------------------------------------------------------
  *        Functions
  *----------------------------------------------------------------------------*/
 
-extern uint8_t iscd_pipe_start(struct _iscd_desc* desc);
+/**
+ * \brief Configure the ISC pipeline and start the capture.
+ * \param desc  ISC driver descriptor
+ * \return ISCD_OK on success, -EINVAL if desc->cfg.multi_bufs is 0 or greater
+ * than ISCD_MAX_DMA_DESC, ISCD_ERROR_CONFIG if the configuration fails
+ */
+extern int iscd_pipe_start(struct _iscd_desc* desc);
+
+/**
+ * \brief Get the oldest captured frame not consumed yet.
+ *
+ * The ISC DMA keeps cycling through the frame buffers, so a frame stays valid
+ * for (multi_bufs - 1) frame periods after it has been captured. Frames
+ * older than that are skipped and counted in desc->ring.dropped.
+ *
+ * \param desc  ISC driver descriptor
+ * \param info  Returns the frame metadata
+ * \return 0 on success, -EAGAIN if no new frame is available, -EINVAL if
+ * desc->cfg.multi_bufs is invalid
+ */
+extern int iscd_get_frame(struct _iscd_desc* desc, struct _iscd_frame_info* info);
+
+/**
+ * \brief Run one step of the AWB/AE control loop.
+ *
+ * The histogram of each Bayer component is computed by the ISC on successive
+ * frames and read by DMA from the interrupt handler. Each call processes at
+ * most ISCD_HISTO_STEP histogram entries and never waits, so it can be called
+ * from the main loop at any rate. Once the four components are measured, the
+ * white balance gains are updated and, if desc->ae.enable is set, a new
+ * exposure is passed to desc->ae.set_exposure().
+ *
+ * \param desc  ISC driver descriptor
+ */
+extern void iscd_auto_adjust(struct _iscd_desc* desc);
 
+/**
+ * \brief Image tuning for AWB, this is a reference algrothm only.
+ * Kept for compatibility, equivalent to iscd_auto_adjust().
+ */
 extern void iscd_auto_white_balance_ref_algo(uint32_t* histo_buf);
 
 #endif /* ISCD_H_ */
@@ -5273,5 +5273,6 @@ const struct sensor_profile ov5640_profile =
 		&ov5640_output_af,
 		0,
 		0
-	}
+	},
+	SENSOR_MAX_BURST,                /* max registers per burst write */
 };
@@ -92,11 +92,13 @@
 #include "chip.h"
 #include "trace.h"
 #include "compiler.h"
+#include "errno.h"
 
 #include "mm/cache.h"
 #include "irq/irq.h"
 #include "peripherals/pmc.h"
 #include "crypto/icm.h"
+#include "crypto/icm_monitor.h"
 #include "serial/console.h"
 
 #include <assert.h>
@@ -115,6 +117,9 @@
 #define HASH_REGION1_OFFSET 8
 
 #define MSG_LEN_WORDS   16
+
+/** Slices of the monitor bus error check, one per ICM slot */
+#define MONITOR_SLICES  ICM_MONITOR_SLOTS
 /*----------------------------------------------------------------------------
  *        Local variables
  *----------------------------------------------------------------------------*/
@@ -170,6 +175,14 @@ const uint32_t hash_sha256[] =
 
 static volatile uint32_t region_hash_comp, region_mismatch;
 
+/* Monitored memory, main list and hash area of the bus error check */
+CACHE_ALIGNED static uint8_t monitor_data[MONITOR_SLICES * ICM_MONITOR_BLOCK_SIZE];
+ALIGNED(64) static struct _icm_region_desc monitor_list[ICM_MONITOR_SLOTS];
+ALIGNED(128) static uint32_t monitor_hash[8 * ICM_MONITOR_SLOTS];
+static struct _icm_monitor monitor;
+static struct _icm_monitor_event monitor_event;
+static uint8_t monitor_events;
+
 /*----------------------------------------------------------------------------
  *        Local functions
  *----------------------------------------------------------------------------*/
@@ -207,6 +220,52 @@ static void check_hash(uint8_t region)
 		printf("Hash correct (see Datasheet 52.5.3.1 Message Digest Example \n\r");
 }
 
+static int _monitor_callback(void* arg, void* arg2)
+{
+	monitor_event = *(struct _icm_monitor_event*)arg2;
+	monitor_events++;
+	return 0;
+}
+
+/**
+ * \brief Feed the monitor scheduler with a pass that ends on a bus error in
+ * slot 1 (no ICM access). Slot 0 must get its reference digest, slot 1 must
+ * be reported and the slices of slots 1 to 3, which the ICM did not hash,
+ * must be scheduled again.
+ */
+static void check_monitor_bus_error(void)
+{
+	struct _callback cb;
+	uint8_t i, count;
+	bool ok;
+
+	printf("Check monitor bus error on a middle slot...\n\r");
+	callback_set(&cb, _monitor_callback, NULL);
+	icm_monitor_init(&monitor, ICM_MONITOR_BLOCK_SIZE, &cb);
+	icm_monitor_add_region(&monitor, monitor_data, sizeof(monitor_data),
+			ICM_MONITOR_SHA256);
+
+	count = icm_monitor_build_pass(&monitor, monitor_list, monitor_hash);
+
+	/* the ICM wrote the digest of slot 0, then stopped on slot 1 */
+	for (i = 0; i < 8; i++)
+		monitor_hash[i] = hash_sha256[i];
+	monitor_events = 0;
+	monitor.pass_count = count;
+	icm_monitor_complete_pass(&monitor, monitor_hash, 0, 1 << 1);
+
+	ok = count == MONITOR_SLICES &&
+	     monitor.slices[0].state == ICM_MONITOR_SLICE_VALID &&
+	     !memcmp(monitor.slices[0].digest, hash_sha256, sizeof(hash_sha256)) &&
+	     monitor.dirty == MONITOR_SLICES - 1 &&
+	     monitor.stats.bus_errors == 1 &&
+	     monitor_events == 1 && monitor_event.status == -EIO &&
+	     monitor_event.addr == (uint32_t)&monitor_data[ICM_MONITOR_BLOCK_SIZE];
+	for (i = 1; i < MONITOR_SLICES; i++)
+		ok = ok && monitor.slices[i].state == ICM_MONITOR_SLICE_DIRTY;
+	printf("%s\n\r", ok ? "Bus error handled" : "Bus error NOT handled");
+}
+
 int main( void )
 {
 	uint8_t i;
@@ -214,6 +273,8 @@ int main( void )
 	/* Output example information */
 	console_example_info("ICM Example");
 
+	check_monitor_bus_error();
+
 	/* Enable ICM peripheral clock */
 	pmc_configure_peripheral(ID_ICM, NULL, true);
 
@@ -366,7 +366,7 @@ restart_sensor:
 			}
 		}
 		if (awb)
-			iscd_auto_white_balance_ref_algo(iscd.pipe.histo_buf);
+			iscd_auto_adjust(&iscd);
 	}
 
 }
@@ -0,0 +1,257 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \page qspi_xip_bench QSPI XIP Read Latency Benchmark
+ *
+ * \section Purpose
+ *
+ * This example measures the cost of executing or reading from the QSPI
+ * memory mapping: the latency of a cache line miss and the sequential
+ * throughput, with a 1-1-1 fast read, with the quad read in continuous read
+ * mode used by qspi_xip(), and with the same quad read through the AESB
+ * on-the-fly decryption.
+ *
+ * \section Description
+ *
+ * Each cache miss of code executed in place costs a full QSPI transfer
+ * (instruction, address, mode and dummy cycles, then one cache line) plus,
+ * with AESB, the decryption of the line. The numbers give the budget to
+ * decide which functions to move to DDR or SRAM with HOTCODE (see
+ * drivers/mm/hotcode.h and scripts/hotcode.py).
+ *
+ * The latency is measured over random cache line misses in the first
+ * megabyte of the memory, the loop overhead being measured on SRAM and
+ * subtracted (it still includes the SRAM or DDR line fill). The flash content is not modified.
+ *
+ * \section Usage
+ *
+ * -# Build the program and download it to the evaluation board (sram or
+ *    ddram variant, the benchmark code must not run from QSPI).
+ * -# On the computer, open and configure a terminal application
+ *    (e.g. HyperTerminal on Microsoft Windows) with these settings:
+ *   - 115200 bauds
+ *   - 8 bits of data
+ *   - No parity
+ *   - 1 stop bit
+ *   - No flow control
+ * -# Start the application, the results are printed for each read mode.
+ *
+ * \section References
+ * - qspi_xip_bench/main.c
+ * - qspi.c
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "board.h"
+#include "board_spi.h"
+#include "chip.h"
+#include "compiler.h"
+#ifdef CONFIG_HAVE_AESB
+#include "crypto/aesb.h"
+#endif
+#ifdef CONFIG_HAVE_QSPI_DMA
+#include "dma/dma.h"
+#endif
+#include "mm/cache.h"
+#include "nvm/spi-nor/spi-flash.h"
+#include "peripherals/pmc.h"
+#include "serial/console.h"
+#include "spi/qspi.h"
+#include "timer.h"
+#include "trace.h"
+
+/*----------------------------------------------------------------------------
+ *        Constants
+ *----------------------------------------------------------------------------*/
+
+#define BOARD_SPI_FLASH_QSPI0 0
+
+/** Memory window of the random accesses */
+#define BENCH_WINDOW (1024 * 1024)
+
+/** Number of random cache line misses */
+#define BENCH_MISSES 65536
+
+/** Bytes read for the sequential throughput */
+#define BENCH_SEQ_SIZE (512 * 1024)
+
+/*----------------------------------------------------------------------------
+ *        Local types
+ *----------------------------------------------------------------------------*/
+
+struct _read_params {
+	enum spi_flash_protocol proto;
+	uint8_t inst;
+	uint8_t num_mode_cycles;
+	uint8_t num_wait_states;
+};
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+CACHE_ALIGNED static uint8_t copy_buffer[4096];
+
+CACHE_ALIGNED static uint8_t baseline_window[32 * 1024];
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static uint64_t random_misses(const uint8_t* mem, uint32_t window)
+{
+	uint32_t i, offset, seed = 0x1234567;
+	uint32_t sum = 0;
+	uint64_t start;
+
+	start = timer_get_tick();
+	for (i = 0; i < BENCH_MISSES; i++) {
+		seed = seed * 1103515245 + 12345;
+		offset = ((seed >> 8) % (window / L1_CACHE_BYTES)) * L1_CACHE_BYTES;
+		cache_invalidate_region((void*)(mem + offset), L1_CACHE_BYTES);
+		sum += *(volatile const uint32_t*)(mem + offset);
+	}
+	(void)sum;
+	return timer_get_interval(start, timer_get_tick());
+}
+
+static uint64_t sequential_read(const uint8_t* mem)
+{
+	uint32_t offset;
+	uint64_t start;
+
+	start = timer_get_tick();
+	for (offset = 0; offset < BENCH_SEQ_SIZE; offset += sizeof(copy_buffer)) {
+		cache_invalidate_region((void*)(mem + offset), sizeof(copy_buffer));
+		memcpy(copy_buffer, mem + offset, sizeof(copy_buffer));
+	}
+	return timer_get_interval(start, timer_get_tick());
+}
+
+static void run_bench(const char* name, const uint8_t* mem, uint64_t baseline)
+{
+	uint64_t miss_ms, seq_ms;
+
+	miss_ms = random_misses(mem, BENCH_WINDOW);
+	seq_ms = sequential_read(mem);
+	if (miss_ms > baseline)
+		miss_ms -= baseline;
+	else
+		miss_ms = 0;
+
+	printf("%-28s %6u ns/miss %7u KB/s\r\n", name,
+		(unsigned)((miss_ms * 1000000) / BENCH_MISSES),
+		seq_ms ? (unsigned)((BENCH_SEQ_SIZE / 1024) * 1000 / seq_ms) : 0);
+}
+
+static void get_read_params(struct spi_flash* flash, struct _read_params* params)
+{
+	params->proto = flash->read_proto;
+	params->inst = flash->read_inst;
+	params->num_mode_cycles = flash->num_mode_cycles;
+	params->num_wait_states = flash->num_wait_states;
+}
+
+static void set_read_params(struct spi_flash* flash, const struct _read_params* params)
+{
+	flash->read_proto = params->proto;
+	flash->read_inst = params->inst;
+	flash->num_mode_cycles = params->num_mode_cycles;
+	flash->num_wait_states = params->num_wait_states;
+}
+
+/*----------------------------------------------------------------------------
+ *        Global functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ *  \brief QSPI_XIP_BENCH Application entry point.
+ *
+ *  \return Unused (ANSI-C compatibility).
+ */
+int main(void)
+{
+	struct spi_flash* flash = board_get_spi_flash(BOARD_SPI_FLASH_QSPI0);
+	struct _read_params quad, single;
+	uint8_t* mem;
+	uint64_t baseline;
+
+	/* Output example information */
+	console_example_info("QSPI XIP Benchmark");
+
+	printf("%u random misses in %u KB, %u KB sequential\r\n",
+		BENCH_MISSES, BENCH_WINDOW / 1024, BENCH_SEQ_SIZE / 1024);
+
+	/* loop overhead, measured on internal memory */
+	baseline = random_misses(baseline_window, sizeof(baseline_window));
+
+	get_read_params(flash, &quad);
+
+	/* 1-1-1 fast read, instruction sent on every access */
+	single.proto = SFLASH_PROTO_1_1_1;
+	single.inst = flash->addr_len == 4 ? SFLASH_INST_FAST_READ_4B : SFLASH_INST_FAST_READ;
+	single.num_mode_cycles = 0;
+	single.num_wait_states = 8;
+	set_read_params(flash, &single);
+	if (spi_flash_read(flash, 0, NULL, 0) < 0)
+		trace_fatal("Cannot enter memory mode\r\n");
+	mem = (uint8_t*)flash->priv.qspi.mem;
+	run_bench("1-1-1 fast read", mem, baseline);
+
+	/* quad read in continuous read mode, as used for XIP */
+	set_read_params(flash, &quad);
+	if (qspi_xip(flash, (void**)&mem) < 0)
+		trace_fatal("Cannot enter XIP mode\r\n");
+	run_bench(quad.num_mode_cycles ? "quad read, continuous" : "quad read", mem, baseline);
+
+#ifdef CONFIG_HAVE_AESB
+	/* same read through the AESB, the data is garbage unless the flash
+	 * was programmed encrypted but the timing is the same */
+	pmc_configure_peripheral(ID_AESB, NULL, true);
+	aesb_swrst();
+	aesb_configure(AESB_MR_AAHB | AESB_MR_DUALBUFF_ACTIVE | AESB_MR_PROCDLY(0) |
+	               AESB_MR_SMOD_AUTO_START | AESB_MR_OPMOD_CTR | AESB_MR_CKEY_PASSWD);
+	spi_flash_use_aesb(flash, true);
+	if (spi_flash_read(flash, 0, NULL, 0) < 0)
+		trace_fatal("Cannot enter memory mode\r\n");
+	run_bench("quad read, continuous, AESB", (uint8_t*)flash->priv.qspi.mem_aesb, baseline);
+	spi_flash_use_aesb(flash, false);
+#endif
+
+	printf("Done.\r\n");
+	while (1);
+}
@@ -0,0 +1,295 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \page spi_dma_bench SPI DMA Chaining Benchmark
+ *
+ * \section Purpose
+ *
+ * This example measures the SPI master throughput for transfers split in
+ * several buffers, with the chip select held for the whole list: buffer by
+ * buffer (one spid_transfer() per buffer) and as one list, which spid
+ * transfers with a single DMA linked list per direction. It also runs the
+ * continuous circular mode used for devices sampled at a fixed rate.
+ *
+ * \section Description
+ *
+ * The SPI controller is put in local loopback (MOSI internally connected to
+ * MISO), so the results do not depend on a remote device and can be
+ * reproduced on any board: every byte sent is received back and checked.
+ * Buffers with TX and RX data are transferred in place and must come back
+ * unchanged, buffers with RX data only must receive the 0xff sent for them.
+ *
+ * The same amount of data is transferred for each buffer size, the gap
+ * between the wire rate and the measured throughput is the per-buffer
+ * overhead (interrupt, DMA reconfiguration, polling of small buffers).
+ *
+ * \section Usage
+ *
+ * -# Build the program and download it to the evaluation board.
+ * -# On the computer, open and configure a terminal application
+ *    (e.g. HyperTerminal on Microsoft Windows) with these settings:
+ *   - 115200 bauds
+ *   - 8 bits of data
+ *   - No parity
+ *   - 1 stop bit
+ *   - No flow control
+ * -# Start the application, the results are printed for each buffer size.
+ *
+ * \section References
+ * - spi_dma_bench/main.c
+ * - spid.c
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "board.h"
+#include "callback.h"
+#include "chip.h"
+#include "compiler.h"
+#include "mm/cache.h"
+#include "peripherals/bus.h"
+#include "serial/console.h"
+#include "spi/spi.h"
+#include "spi/spid.h"
+#include "timer.h"
+#include "trace.h"
+
+/*----------------------------------------------------------------------------
+ *        Constants
+ *----------------------------------------------------------------------------*/
+
+/** SPI bitrate in kHz */
+#define BENCH_BITRATE 20000
+
+/** Bytes transferred for each measure */
+#define BENCH_SIZE (256 * 1024)
+
+/** Buffers per spid_transfer() call */
+#define BENCH_BUFFERS 8
+
+/** Circular mode: receive buffer size and duration */
+#define BENCH_CIRCULAR_SIZE 1024
+#define BENCH_CIRCULAR_MS 1000
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+CACHE_ALIGNED static uint8_t data_buffer[BENCH_BUFFERS * 4096];
+
+CACHE_ALIGNED static uint8_t circular_buffer[BENCH_CIRCULAR_SIZE];
+
+static struct _buffer buffers[BENCH_BUFFERS];
+
+static struct _spi_desc spi_dev = {
+	.addr = BOARD_SPI_BUS0,
+	.chip_select = 0,
+	.transfer_mode = BUS_TRANSFER_MODE_DMA,
+};
+
+static volatile uint32_t circular_halves;
+
+static volatile uint32_t circular_errors;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/* Buffers of size bytes, every other one without TX data */
+static void fill_buffers(uint32_t size, uint32_t seed)
+{
+	uint32_t i, j;
+
+	for (i = 0; i < BENCH_BUFFERS; i++) {
+		buffers[i].data = &data_buffer[i * size];
+		buffers[i].size = size;
+		buffers[i].attr = (i & 1) ? BUS_BUF_ATTR_RX : BUS_BUF_ATTR_TX | BUS_BUF_ATTR_RX;
+		for (j = 0; j < size; j++)
+			buffers[i].data[j] = (uint8_t)(seed + i * 31 + j);
+	}
+	buffers[BENCH_BUFFERS - 1].attr |= BUS_SPI_BUF_ATTR_RELEASE_CS;
+}
+
+static bool check_buffers(uint32_t size, uint32_t seed)
+{
+	uint32_t i, j;
+	uint8_t expected;
+
+	for (i = 0; i < BENCH_BUFFERS; i++) {
+		for (j = 0; j < size; j++) {
+			expected = (i & 1) ? 0xff : (uint8_t)(seed + i * 31 + j);
+			if (buffers[i].data[j] != expected)
+				return false;
+		}
+	}
+	return true;
+}
+
+/* Transfer BENCH_SIZE bytes in buffers of size bytes, return the time in ms
+ * or 0 on data error */
+static uint64_t run_bench(uint32_t size, bool chained)
+{
+	uint32_t done, i, seed = 0;
+	uint32_t errors = 0;
+	uint64_t start, elapsed = 0;
+
+	for (done = 0; done < BENCH_SIZE; done += BENCH_BUFFERS * size) {
+		fill_buffers(size, seed);
+
+		start = timer_get_tick();
+		if (chained) {
+			spid_transfer(&spi_dev, buffers, BENCH_BUFFERS, NULL);
+			spid_wait_transfer(&spi_dev);
+		} else {
+			for (i = 0; i < BENCH_BUFFERS; i++) {
+				spid_transfer(&spi_dev, &buffers[i], 1, NULL);
+				spid_wait_transfer(&spi_dev);
+			}
+		}
+		elapsed += timer_get_interval(start, timer_get_tick());
+
+		if (!check_buffers(size, seed))
+			errors++;
+		seed++;
+	}
+
+	return errors ? 0 : (elapsed ? elapsed : 1);
+}
+
+static void print_result(const char* name, uint32_t size, uint64_t ms, uint32_t fallbacks)
+{
+	if (ms == 0)
+		printf("%-12s %5u B  data error\r\n", name, (unsigned)size);
+	else
+		printf("%-12s %5u B  %6u KB/s  %u fallbacks\r\n", name, (unsigned)size,
+		       (unsigned)((BENCH_SIZE / 1024) * 1000 / ms), (unsigned)fallbacks);
+}
+
+static int circular_callback(void* arg, void* arg2)
+{
+	const uint8_t* half = (const uint8_t*)arg2;
+	uint32_t i;
+
+	for (i = 0; i < BENCH_CIRCULAR_SIZE / 2; i++)
+		if (half[i] != 0xff)
+			circular_errors++;
+	circular_halves++;
+
+	return 0;
+}
+
+static void run_circular(void)
+{
+	struct _callback cb;
+	uint64_t start, elapsed;
+	uint32_t halves;
+
+	circular_halves = 0;
+	circular_errors = 0;
+	memset(circular_buffer, 0, sizeof(circular_buffer));
+
+	callback_set(&cb, circular_callback, NULL);
+	start = timer_get_tick();
+	if (spid_start_circular(&spi_dev, NULL, circular_buffer,
+	                        sizeof(circular_buffer), &cb) < 0) {
+		printf("circular     cannot start\r\n");
+		return;
+	}
+	timer_sleep(BENCH_CIRCULAR_MS);
+	spid_stop_circular(&spi_dev);
+	halves = circular_halves;
+	elapsed = timer_get_interval(start, timer_get_tick());
+
+	printf("circular     %5u B  %6u KB/s, %u halves, %u errors\r\n",
+	       BENCH_CIRCULAR_SIZE / 2,
+	       (unsigned)((uint64_t)halves * (BENCH_CIRCULAR_SIZE / 2) / elapsed),
+	       (unsigned)halves, (unsigned)circular_errors);
+}
+
+/*----------------------------------------------------------------------------
+ *        Global functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ *  \brief SPI_DMA_BENCH Application entry point.
+ *
+ *  \return Unused (ANSI-C compatibility).
+ */
+int main(void)
+{
+	static const uint32_t sizes[] = { 4096, 512, 64, 16, 4 };
+	static const struct {
+		const char* name;
+		enum _bus_transfer_mode mode;
+		bool chained;
+	} runs[] = {
+		{ "polling", BUS_TRANSFER_MODE_POLLING, true },
+		{ "async", BUS_TRANSFER_MODE_ASYNC, true },
+		{ "dma/buffer", BUS_TRANSFER_MODE_DMA, false },
+		{ "dma/chain", BUS_TRANSFER_MODE_DMA, true },
+	};
+	uint32_t r, s, fallbacks;
+	uint64_t ms;
+
+	/* Output example information */
+	console_example_info("SPI DMA Benchmark");
+
+	spid_configure(&spi_dev);
+	spid_configure_master(&spi_dev, true);
+	spid_configure_cs(&spi_dev, spi_dev.chip_select, BENCH_BITRATE, 0, 0, SPID_MODE_0);
+	spi_set_loopback(spi_dev.addr, true);
+
+	printf("%u KB per measure, %u buffers per transfer, wire rate %u KB/s\r\n",
+	       BENCH_SIZE / 1024, BENCH_BUFFERS, BENCH_BITRATE / 8);
+
+	for (r = 0; r < ARRAY_SIZE(runs); r++) {
+		spi_dev.transfer_mode = runs[r].mode;
+		for (s = 0; s < ARRAY_SIZE(sizes); s++) {
+			/* lists the driver could not chain went buffer by buffer */
+			fallbacks = spi_dev.xfer.chain_fallbacks;
+			ms = run_bench(sizes[s], runs[r].chained);
+			print_result(runs[r].name, sizes[s], ms,
+			             spi_dev.xfer.chain_fallbacks - fallbacks);
+		}
+	}
+
+	spi_dev.transfer_mode = BUS_TRANSFER_MODE_DMA;
+	run_circular();
+
+	spi_set_loopback(spi_dev.addr, false);
+	printf("Done.\r\n");
+	while (1);
+}
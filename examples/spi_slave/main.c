@@ -100,6 +100,9 @@
  * <ol>
  * <li>Configure SPI as master, setup SPI clock.
  * </ol>
+ * <li> 'r' will start SPI streaming test: the slave receives continuously
+ * in a ring of frames (spid_stream_start()) while the master sends a long
+ * burst, the frames are checked and released from the half/full callbacks.
  * <li>Setup SPI clock for slave.
  * </ul>
  *
@@ -147,6 +150,8 @@
 
 #include "board.h"
 #include "chip.h"
+#include "callback.h"
+#include "timer.h"
 #include "trace.h"
 #include "compiler.h"
 
@@ -168,6 +173,11 @@
 
 #define DMA_TRANS_SIZE 256
 
+/** slave stream: frame size, frames in the ring and burst sent by master */
+#define STREAM_FRAME_SIZE 64
+#define STREAM_FRAMES 16
+#define STREAM_BURST_SIZE (16 * 1024)
+
 #if defined(CONFIG_BOARD_SAMA5D2_XPLAINED)
 	#include "config_sama5d2-xplained.h"
 #elif defined(CONFIG_BOARD_SAMA5D27_SOM1_EK)
@@ -204,6 +214,22 @@ CACHE_ALIGNED static uint8_t spi_buffer_master_tx[DMA_TRANS_SIZE];
 /** data buffer for SPI slave's transfer */
 CACHE_ALIGNED static uint8_t spi_buffer_slave_rx[DMA_TRANS_SIZE];
 
+/** ring of the slave stream */
+CACHE_ALIGNED static uint8_t spi_stream_ring[STREAM_FRAMES * STREAM_FRAME_SIZE];
+
+/** burst sent by the master to the slave stream */
+CACHE_ALIGNED static uint8_t spi_stream_burst[STREAM_BURST_SIZE];
+
+static struct _spid_stream spi_stream;
+
+/** next byte expected by the stream check, and mismatches */
+static uint8_t stream_expected;
+static volatile uint32_t stream_errors;
+
+/** timestamp of the first frame, its ring slot is reused afterwards */
+static uint64_t stream_first_tick;
+static volatile bool stream_first_seen;
+
 /** Pio pins for SPI slave */
 static const struct _pin pins_spi_slave[] = SPI_SLAVE_PINS;
 
@@ -239,6 +265,7 @@ static void _display_menu(void)
 	printf("\r\nMenu :\r\n");
 	printf("------\r\n");
 	printf("  s: Perform SPI transfer start\r\n");
+	printf("  r: Perform SPI streaming test\r\n");
 	printf("  h: Display menu \r\n\r\n");
 }
 
@@ -296,6 +323,81 @@ static void _spi_transfer(void)
 	printf("Received data matched.\r\n");
 }
 
+static int _spi_stream_callback(void* arg, void* arg2)
+{
+	const uint8_t* half = (const uint8_t*)arg2;
+	uint8_t* frame;
+	uint32_t i;
+
+	if (!stream_first_seen &&
+	    spid_stream_get_frame(&spi_stream, &frame, &stream_first_tick) == 0)
+		stream_first_seen = true;
+
+	/* check and release the half of the ring just received */
+	for (i = 0; i < (STREAM_FRAMES / 2) * STREAM_FRAME_SIZE; i++)
+		if (half[i] != stream_expected++)
+			stream_errors++;
+	spid_stream_release(&spi_stream, STREAM_FRAMES / 2);
+
+	return 0;
+}
+
+/**
+ * \brief Stream a long burst from SPI master to SPI slave.
+ */
+static void _spi_stream(void)
+{
+	int err;
+	uint32_t i;
+	uint64_t first, last;
+	struct _buffer master_buf = {
+		.data = spi_stream_burst,
+		.size = STREAM_BURST_SIZE,
+		.attr = BUS_BUF_ATTR_TX | BUS_SPI_BUF_ATTR_RELEASE_CS,
+	};
+
+	for (i = 0; i < STREAM_BURST_SIZE; i++)
+		spi_stream_burst[i] = (uint8_t)i;
+	stream_expected = 0;
+	stream_errors = 0;
+	stream_first_seen = false;
+
+	spi_stream.ring = spi_stream_ring;
+	spi_stream.frame_size = STREAM_FRAME_SIZE;
+	spi_stream.frames = STREAM_FRAMES;
+	callback_set(&spi_stream.half, _spi_stream_callback, NULL);
+	callback_set(&spi_stream.full, _spi_stream_callback, NULL);
+
+	printf("Slave streaming...\r\n");
+	err = spid_stream_start(&spi_slave_dev, &spi_stream);
+	if (err < 0) {
+		trace_error("SPI: SLAVE: stream start failed.\r\n");
+		return;
+	}
+
+	printf("Master sending %u bytes...\r\n", STREAM_BURST_SIZE);
+	bus_start_transaction(spi_master_dev.bus);
+	bus_transfer(spi_master_dev.bus, spi_master_dev.spi_dev.chip_select, &master_buf, 1, NULL);
+	bus_stop_transaction(spi_master_dev.bus);
+
+	spid_stream_stop(&spi_slave_dev);
+
+	if (!stream_first_seen) {
+		trace_error("SPI: no frame received!\r\n");
+		return;
+	}
+	first = stream_first_tick;
+	last = spi_stream.timestamps[(spi_stream.head - 1) % STREAM_FRAMES];
+	printf("%u frames in %u ms, %u overflows, %u overruns, %u bad bytes\r\n",
+	       (unsigned)spi_stream.head, (unsigned)timer_get_interval(first, last),
+	       (unsigned)spi_stream.overflows, (unsigned)spi_stream.overruns,
+	       (unsigned)stream_errors);
+	if (spi_stream.head == STREAM_BURST_SIZE / STREAM_FRAME_SIZE && !stream_errors)
+		printf("Stream received.\r\n");
+	else
+		trace_error("SPI: stream incomplete or corrupted!\r\n");
+}
+
 /*----------------------------------------------------------------------------
  *        Global functions
  *----------------------------------------------------------------------------*/
@@ -333,6 +435,10 @@ int main(void)
 		case 's':
 			_spi_transfer();
 			break;
+		case 'R':
+		case 'r':
+			_spi_stream();
+			break;
 		default:
 			break;
 		}
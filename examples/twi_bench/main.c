@@ -0,0 +1,215 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \page twi_bench TWI Transaction Rate Benchmark
+ *
+ * \section Purpose
+ *
+ * This example measures how many small register reads per second the TWI
+ * master can do in each transfer mode. A register read is the usual write of
+ * the register address followed by a read after a repeated START, the
+ * access pattern of most I2C sensors, PMICs and EEPROMs.
+ *
+ * \section Description
+ *
+ * The reads target the AT24 EEPROM of the board, at its offset 0, for
+ * several data sizes. Each mode runs for one second and every read is
+ * compared with a reference read in polling mode.
+ *
+ * On devices with the TWI alternative command mode (SAMA5D2, SAM9X60), the
+ * DMA mode sends each register read as a single command: the register
+ * address goes out as internal address, and the repeated START, the NACK of
+ * the last byte and the STOP are generated by the TWI. The other devices use
+ * the byte by byte sequence driven by the CPU, and the difference between
+ * the two is the gain of the fast path.
+ *
+ * \section Usage
+ *
+ * -# Build the program and download it to the evaluation board.
+ * -# On the computer, open and configure a terminal application
+ *    (e.g. HyperTerminal on Microsoft Windows) with these settings:
+ *   - 115200 bauds
+ *   - 8 bits of data
+ *   - No parity
+ *   - 1 stop bit
+ *   - No flow control
+ * -# Start the application, the results are printed for each data size.
+ *
+ * \section References
+ * - twi_bench/main.c
+ * - twid.c
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "board.h"
+#include "chip.h"
+#include "compiler.h"
+#include "mm/cache.h"
+#include "peripherals/bus.h"
+#include "serial/console.h"
+#include "timer.h"
+#include "trace.h"
+
+/*----------------------------------------------------------------------------
+ *        Constants
+ *----------------------------------------------------------------------------*/
+
+/** Duration of each measure in ms */
+#define BENCH_MS 1000
+
+/** Largest register read */
+#define BENCH_MAX_SIZE 64
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+CACHE_ALIGNED static uint8_t reg_buffer[L1_CACHE_BYTES];
+
+CACHE_ALIGNED static uint8_t data_buffer[BENCH_MAX_SIZE];
+
+static uint8_t reference[BENCH_MAX_SIZE];
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/* Read size bytes at register reg, as a device driver does */
+static int read_register(uint8_t reg, uint8_t* data, uint32_t size)
+{
+	int err;
+	struct _buffer buf[2] = {
+		{
+			.data = reg_buffer,
+			.size = 1,
+			.attr = BUS_I2C_BUF_ATTR_START | BUS_BUF_ATTR_TX,
+		},
+		{
+			.data = data,
+			.size = size,
+			.attr = BUS_I2C_BUF_ATTR_START | BUS_BUF_ATTR_RX | BUS_I2C_BUF_ATTR_STOP,
+		},
+	};
+
+	reg_buffer[0] = reg;
+
+	bus_start_transaction(BOARD_AT24_TWI_BUS);
+	err = bus_transfer(BOARD_AT24_TWI_BUS, BOARD_AT24_ADDR, buf, 2, NULL);
+	if (err == 0)
+		err = bus_wait_transfer(BOARD_AT24_TWI_BUS);
+	bus_stop_transaction(BOARD_AT24_TWI_BUS);
+
+	return err;
+}
+
+static void set_mode(enum _bus_transfer_mode mode, bool fifo)
+{
+	bus_ioctl(BOARD_AT24_TWI_BUS, BUS_IOCTL_SET_TRANSFER_MODE, &mode);
+#ifdef CONFIG_HAVE_TWI_FIFO
+	bus_ioctl(BOARD_AT24_TWI_BUS, fifo ? BUS_IOCTL_ENABLE_FIFO : BUS_IOCTL_DISABLE_FIFO, NULL);
+#endif
+}
+
+static void run_bench(const char* name, uint32_t size)
+{
+	uint32_t count = 0, errors = 0;
+	uint64_t start, elapsed;
+
+	start = timer_get_tick();
+	do {
+		memset(data_buffer, 0, size);
+		if (read_register(0, data_buffer, size) < 0 ||
+		    memcmp(data_buffer, reference, size))
+			errors++;
+		count++;
+		elapsed = timer_get_interval(start, timer_get_tick());
+	} while (elapsed < BENCH_MS);
+
+	printf("%-10s %3u B  %6u transactions/s  %u errors\r\n", name, (unsigned)size,
+	       (unsigned)((uint64_t)count * 1000 / elapsed), (unsigned)errors);
+}
+
+/*----------------------------------------------------------------------------
+ *        Global functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ *  \brief TWI_BENCH Application entry point.
+ *
+ *  \return Unused (ANSI-C compatibility).
+ */
+int main(void)
+{
+	static const uint32_t sizes[] = { 1, 2, 4, 16, 64 };
+	static const struct {
+		const char* name;
+		enum _bus_transfer_mode mode;
+		bool fifo;
+	} runs[] = {
+		{ "polling", BUS_TRANSFER_MODE_POLLING, false },
+		{ "async", BUS_TRANSFER_MODE_ASYNC, false },
+		{ "dma", BUS_TRANSFER_MODE_DMA, false },
+#ifdef CONFIG_HAVE_TWI_FIFO
+		{ "async/fifo", BUS_TRANSFER_MODE_ASYNC, true },
+		{ "dma/fifo", BUS_TRANSFER_MODE_DMA, true },
+#endif
+	};
+	uint32_t r, s;
+
+	/* Output example information */
+	console_example_info("TWI Benchmark");
+
+#ifdef CONFIG_HAVE_TWI_ALTERNATE_CMD
+	printf("Alternative command fast path available in DMA mode\r\n");
+#endif
+
+	set_mode(BUS_TRANSFER_MODE_POLLING, false);
+	if (read_register(0, reference, BENCH_MAX_SIZE) < 0) {
+		printf("No answer from the AT24 at address 0x%02x\r\n", BOARD_AT24_ADDR);
+		while (1);
+	}
+
+	for (r = 0; r < ARRAY_SIZE(runs); r++) {
+		set_mode(runs[r].mode, runs[r].fifo);
+		for (s = 0; s < ARRAY_SIZE(sizes); s++)
+			run_bench(runs[r].name, sizes[s]);
+	}
+
+	set_mode(BUS_TRANSFER_MODE_POLLING, false);
+	printf("Done.\r\n");
+	while (1);
+}
@@ -0,0 +1,256 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/**
+ * \page usart_dma_ring USART Continuous DMA Reception Benchmark
+ *
+ * \section Purpose
+ *
+ * This example measures the continuous USART reception of usartd_ring_start():
+ * a circular DMA fills a ring without interruption and the received bytes
+ * are handed in place to a callback at the end of each DMA item and when
+ * the line goes idle (receiver time-out).
+ *
+ * \section Description
+ *
+ * The USART is put in local loopback (transmitter output connected to the
+ * receiver input), so no wiring nor remote device is needed. Messages with
+ * a running byte counter are sent by DMA, with a pause between bursts, and
+ * the callback checks that every byte comes in order before releasing it.
+ * The test runs at several bitrates up to 3 Mbit/s, with and without the
+ * USART FIFO when available, and prints the throughput together with the
+ * idle, overflow and error counters of the ring.
+ *
+ * \section Usage
+ *
+ * -# Build the program and download it to the evaluation board.
+ * -# On the computer, open and configure a terminal application
+ *    (e.g. HyperTerminal on Microsoft Windows) with these settings:
+ *   - 115200 bauds
+ *   - 8 bits of data
+ *   - No parity
+ *   - 1 stop bit
+ *   - No flow control
+ * -# Start the application, the results are printed for each bitrate.
+ *
+ * \section References
+ * - usart_dma_ring/main.c
+ * - usartd.c
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "board.h"
+#include "callback.h"
+#include "chip.h"
+#include "compiler.h"
+#include "mm/cache.h"
+#include "serial/console.h"
+#include "serial/usart.h"
+#include "serial/usartd.h"
+#include "timer.h"
+#include "trace.h"
+
+/*----------------------------------------------------------------------------
+ *        Constants
+ *----------------------------------------------------------------------------*/
+
+#if defined(CONFIG_BOARD_SAMA5D2_PTC_EK)
+#define USART_ADDR FLEXUSART4
+
+#elif defined(CONFIG_BOARD_SAMA5D2_XPLAINED)
+#define USART_ADDR FLEXUSART0
+
+#elif defined(CONFIG_BOARD_SAMA5D27_SOM1_EK)
+#define USART_ADDR FLEXUSART3
+
+#elif defined(CONFIG_BOARD_SAMA5D4_XPLAINED)
+#define USART_ADDR USART4
+
+#elif defined(CONFIG_BOARD_SAMA5D4_EK)
+#define USART_ADDR USART4
+
+#elif defined(CONFIG_BOARD_SAMA5D3_XPLAINED)
+#define USART_ADDR USART3
+
+#elif defined(CONFIG_BOARD_SAMA5D3_EK)
+#define USART_ADDR USART1
+
+#elif defined(CONFIG_BOARD_SAM9X60_EK)
+#define USART_ADDR FLEXUSART2
+
+#else
+#error Unsupported SoC!
+#endif
+
+/** Bytes sent for each measure */
+#define BENCH_SIZE (64 * 1024)
+
+/** Bytes sent in one burst, then the line stays idle */
+#define BENCH_BURST 1000
+
+/** Size of the reception ring */
+#define BENCH_RING_SIZE 4096
+
+/*----------------------------------------------------------------------------
+ *        Local variables
+ *----------------------------------------------------------------------------*/
+
+CACHE_ALIGNED static uint8_t tx_buffer[BENCH_BURST];
+
+CACHE_ALIGNED static uint8_t ring_buffer[BENCH_RING_SIZE];
+
+static struct _usartd_ring ring = {
+	.data = ring_buffer,
+	.size = sizeof(ring_buffer),
+};
+
+static struct _usart_desc usart_desc = {
+	.addr           = USART_ADDR,
+	.baudrate       = 115200,
+	.mode           = US_MR_CHMODE_LOCAL_LOOPBACK | US_MR_PAR_NO | US_MR_CHRL_8_BIT,
+	.transfer_mode  = USARTD_MODE_DMA,
+	.timeout        = 0,
+};
+
+static volatile uint32_t received;
+
+static volatile uint32_t spans;
+
+static volatile uint32_t errors;
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+/* Check the running counter in place, then give the bytes back */
+static int ring_callback(void* arg, void* arg2)
+{
+	const struct _usartd_span* span = (const struct _usartd_span*)arg2;
+	uint32_t i;
+
+	for (i = 0; i < span->size; i++)
+		if (span->data[i] != (uint8_t)(received + i))
+			errors++;
+	received += span->size;
+	spans++;
+
+	usartd_ring_release(&ring, span->size);
+
+	return 0;
+}
+
+static void run_bench(uint32_t baudrate, bool fifo)
+{
+	struct _buffer buf = {
+		.data = tx_buffer,
+		.size = BENCH_BURST,
+		.attr = USARTD_BUF_ATTR_WRITE,
+	};
+	uint32_t sent, i;
+	uint64_t start, elapsed;
+
+	usart_set_async_baudrate(usart_desc.addr, baudrate);
+#ifdef CONFIG_HAVE_USART_FIFO
+	usart_desc.use_fifo = fifo;
+	if (fifo)
+		usart_fifo_enable(usart_desc.addr);
+	else
+		usart_fifo_disable(usart_desc.addr);
+#endif
+
+	received = 0;
+	spans = 0;
+	errors = 0;
+	callback_set(&ring.callback, ring_callback, NULL);
+	if (usartd_ring_start(0, &ring) != USARTD_SUCCESS) {
+		printf("%7u  cannot start the reception\r\n", (unsigned)baudrate);
+		return;
+	}
+
+	start = timer_get_tick();
+	for (sent = 0; sent < BENCH_SIZE; sent += BENCH_BURST) {
+		for (i = 0; i < BENCH_BURST; i++)
+			tx_buffer[i] = (uint8_t)(sent + i);
+		usartd_transfer(0, &buf, NULL);
+		usartd_wait_tx_transfer(0);
+		/* let the line go idle before the next burst */
+		timer_sleep(1);
+	}
+	while (received < sent && timer_get_interval(start, timer_get_tick()) < 10000);
+	elapsed = timer_get_interval(start, timer_get_tick());
+	usartd_ring_stop(0);
+
+	printf("%7u %-4s %6u B/s  %5u spans  %4u idles  %u overflows  %u overruns  %u errors  %u lost\r\n",
+	       (unsigned)baudrate, fifo ? "fifo" : "",
+	       (unsigned)((uint64_t)received * 1000 / elapsed),
+	       (unsigned)spans, (unsigned)ring.idles,
+	       (unsigned)ring.overflows, (unsigned)ring.overruns,
+	       (unsigned)errors, (unsigned)(sent - received));
+}
+
+/*----------------------------------------------------------------------------
+ *        Global functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ *  \brief USART_DMA_RING Application entry point.
+ *
+ *  \return Unused (ANSI-C compatibility).
+ */
+int main(void)
+{
+	/* ascending, usart_set_async_baudrate() does not clear US_MR_OVER */
+	static const uint32_t baudrates[] = { 115200, 1000000, 3000000 };
+	uint32_t b;
+
+	/* Output example information */
+	console_example_info("USART DMA Ring Benchmark");
+
+	usartd_configure(0, &usart_desc);
+
+	printf("%u KB per measure, bursts of %u bytes, ring of %u bytes\r\n",
+	       BENCH_SIZE / 1024, BENCH_BURST, BENCH_RING_SIZE);
+
+	for (b = 0; b < ARRAY_SIZE(baudrates); b++) {
+		run_bench(baudrates[b], false);
+#ifdef CONFIG_HAVE_USART_FIFO
+		run_bench(baudrates[b], true);
+#endif
+	}
+
+	printf("Done.\r\n");
+	while (1);
+}
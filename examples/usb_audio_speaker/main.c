@@ -53,6 +53,13 @@
  *  amplifier. At the same time, the audio stream received is also sent
  *  back to host from EK for recording.
  *
+ *  The streaming endpoint is asynchronous: an explicit feedback endpoint
+ *  reports the rate at which the audio device consumes samples, derived from
+ *  the number of buffers waiting to be played, so that the host follows the
+ *  audio device clock. The remaining drift, and hosts that ignore the
+ *  feedback, are handled by an asynchronous sample-rate converter placed
+ *  between the USB buffers and the audio device.
+ *
  *  \section Usage
  *
  *  -# Build the program and download it inside the evaluation board. Please
@@ -111,6 +118,7 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "asrc.h"
 #include "audio/audio_device.h"
 #include "board.h"
 #include "chip.h"
@@ -155,8 +163,19 @@
 /**  Number of available audio buffers. */
 #define BUFFERS (32)
 
-/**  Size of one buffer in bytes. */
-#define BUFFER_SIZE ROUND_UP_MULT(AUDDSpeakerDriver_BYTESPERFRAME, L1_CACHE_BYTES)
+/**  Size of the USB receive buffer in bytes. */
+#define BUFFER_SIZE ROUND_UP_MULT(AUDDSpeakerDriver_MAXBYTESPERFRAME, L1_CACHE_BYTES)
+
+/**  Maximum number of audio frames (one sample per channel) in one USB
+     frame. */
+#define USB_FRAMES (AUDDSpeakerDriver_MAXBYTESPERFRAME / AUDDSpeakerDriver_BYTESPERSUBFRAME)
+
+/**  Maximum number of audio frames output by the converter for one USB
+     frame, the ratio correction never exceeds one frame per packet. */
+#define PLAY_FRAMES (USB_FRAMES + 2)
+
+/**  Size of one playback buffer in bytes. */
+#define PLAY_BUFFER_SIZE ROUND_UP_MULT(PLAY_FRAMES * AUDDSpeakerDriver_BYTESPERSUBFRAME, L1_CACHE_BYTES)
 
 /**  Delay (in number of buffers) before starting the DAC transmission
      after data has been received. */
@@ -173,8 +192,11 @@ extern const USBDDriverDescriptors audd_speaker_driver_descriptors;
  *         Internal variables
  *----------------------------------------------------------------------------*/
 
-/**  Data buffers for receiving audio frames from the USB host. */
-CACHE_ALIGNED static uint8_t _buffer[BUFFERS][BUFFER_SIZE];
+/**  Data buffer for receiving audio frames from the USB host. */
+CACHE_ALIGNED static uint8_t _usb_buffer[BUFFER_SIZE];
+
+/**  Data buffers holding rate-converted audio frames to play. */
+CACHE_ALIGNED static uint8_t _buffer[BUFFERS][PLAY_BUFFER_SIZE];
 
 /**  Number of samples stored in each data buffer. */
 static uint32_t _samples[BUFFERS];
@@ -188,8 +210,10 @@ static struct _audio_ctx {
 		uint16_t tx;
 		uint32_t count;
 	} circ;
+	struct _asrc asrc;
 	uint8_t volume;
 	bool playing;
+	volatile bool feedback;  /* a feedback transfer is queued */
 } _audio_ctx = {
 	.samples = _samples,
 	.threshold = BUFFER_THRESHOLD,
@@ -249,7 +273,14 @@ static void _usb_frame_recv_callback(void* arg, uint8_t status, uint32_t transfe
 			_audio_ctx.circ.count--;
 		}
 
-		_audio_ctx.samples[_audio_ctx.circ.rx] = transferred;
+		/* Convert the received frames to the audio device clock */
+		asrc_track_fill(&_audio_ctx.asrc, _audio_ctx.circ.count,
+				_audio_ctx.threshold);
+		_audio_ctx.samples[_audio_ctx.circ.rx] =
+			asrc_process(&_audio_ctx.asrc, (const int16_t*)_usb_buffer,
+				     transferred / AUDDSpeakerDriver_BYTESPERSUBFRAME, NULL,
+				     (int16_t*)_buffer[_audio_ctx.circ.rx], PLAY_FRAMES)
+			* AUDDSpeakerDriver_BYTESPERSUBFRAME;
 		_audio_ctx.circ.rx = (_audio_ctx.circ.rx + 1) % BUFFERS;
 		_audio_ctx.circ.count++;
 
@@ -279,11 +310,32 @@ static void _usb_frame_recv_callback(void* arg, uint8_t status, uint32_t transfe
 	}
 
 	/* Receive next packet */
-	audd_speaker_driver_read(_buffer[_audio_ctx.circ.rx],
-				 AUDDSpeakerDriver_BYTESPERFRAME,
+	audd_speaker_driver_read(_usb_buffer,
+				 AUDDSpeakerDriver_MAXBYTESPERFRAME,
 				 _usb_frame_recv_callback, desc);
 }
 
+/**
+ *  Invoked when the host has read the feedback value, queues the next one.
+ */
+static void _usb_feedback_callback(void* arg, uint8_t status, uint32_t transferred, uint32_t remaining)
+{
+	uint32_t feedback;
+
+	/* Stream closed, restarted when the host selects it again */
+	if (status == USBD_STATUS_CANCELED || status == USBD_STATUS_RESET) {
+		_audio_ctx.feedback = false;
+		return;
+	}
+
+	/* Ask for more samples when the buffers drain, and the other way */
+	feedback = audd_stream_compute_feedback(AUDDSpeakerDriver_SAMPLERATE,
+						_audio_ctx.circ.count,
+						_audio_ctx.threshold);
+	_audio_ctx.feedback = audd_speaker_driver_write_feedback(feedback,
+			_usb_feedback_callback, arg) == USBD_STATUS_SUCCESS;
+}
+
 static void console_handler(uint8_t key)
 {
 	switch (key) {
@@ -430,6 +482,12 @@ void audd_speaker_driver_stream_setting_changed(uint8_t new_setting)
 		_audio_ctx.circ.count = 0;
 		_audio_ctx.circ.tx = 0;
 		_audio_ctx.circ.rx = 0;
+		asrc_reset(&_audio_ctx.asrc);
+
+		/* Setting 0 canceled the feedback transfer, report the rate
+		 * again */
+		if (!_audio_ctx.feedback)
+			_usb_feedback_callback(NULL, USBD_STATUS_SUCCESS, 0, 0);
 	}
 }
 
@@ -446,9 +504,6 @@ int main(void)
 {
 	bool usb_conn = false;
 
-	int32_t jitter = 0, _jitter_curr;
-	int8_t clock_adjust = 0;
-
 	console_set_rx_handler(console_handler);
 	console_enable_rx_interrupt();
 
@@ -464,6 +519,10 @@ int main(void)
 	/* Configure audio play volume */
 	audio_set_volume(&audio_device, _audio_ctx.volume);
 
+	/* Both sides run at the same nominal rate, only the drift is corrected */
+	asrc_init(&_audio_ctx.asrc, AUDDSpeakerDriver_NUMCHANNELS,
+		  AUDDSpeakerDriver_SAMPLERATE, audio_device.sample_rate);
+
 #ifdef PINS_PUSHBUTTONS
 	configure_buttons();
 #endif
@@ -487,28 +546,15 @@ int main(void)
 			continue;
 		}
 
-		_jitter_curr = (_audio_ctx.circ.count - _audio_ctx.threshold);
-
-		if (jitter != _jitter_curr) {
-			jitter = _jitter_curr;
-			if (jitter > 0 && clock_adjust != 1) {
-				/* USB too fast or SSC too slow: faster clock */
-				clock_adjust = 1;
-				audio_sync_adjust(&audio_device, clock_adjust);
-			}
-			if (jitter < 0 && clock_adjust != -1) {
-				/* USB too slow or SSC too fast: slower clock */
-				clock_adjust = -1;
-				audio_sync_adjust(&audio_device, clock_adjust);
-			}
-		}
-
 		if (!usb_conn) {
 			trace_info("USB connected\r\n");
 			/* Start Reading the incoming audio stream */
-			audd_speaker_driver_read(_buffer[_audio_ctx.circ.rx],
-					AUDDSpeakerDriver_BYTESPERFRAME,
+			audd_speaker_driver_read(_usb_buffer,
+					AUDDSpeakerDriver_MAXBYTESPERFRAME,
 					_usb_frame_recv_callback, &audio_device);
+			/* Start reporting the playback rate */
+			if (!_audio_ctx.feedback)
+				_usb_feedback_callback(NULL, USBD_STATUS_SUCCESS, 0, 0);
 
 			usb_conn = true;
 		}
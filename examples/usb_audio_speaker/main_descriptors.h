@@ -75,6 +75,10 @@
 /** Number of bytes in one USB frame. */
 #define AUDDSpeakerDriver_BYTESPERFRAME     (AUDDSpeakerDriver_SAMPLESPERFRAME * \
 		AUDDSpeakerDriver_BYTESPERSAMPLE)
+/** Maximum number of bytes in one USB frame, the host sends one more
+ *  subframe when the feedback asks for a higher rate. */
+#define AUDDSpeakerDriver_MAXBYTESPERFRAME  (AUDDSpeakerDriver_BYTESPERFRAME + \
+		AUDDSpeakerDriver_BYTESPERSUBFRAME)
 /**     @}*/
 
 /** \addtogroup usbd_audio_id USB Device Audio Speaker Codes
@@ -97,6 +101,8 @@
  *      @{
  * This page lists the definitions for USB Audio Speaker Device Driver.
  * - \ref AUDDSpeakerDriverDescriptors_DATAOUT
+ * - \ref AUDDSpeakerDriverDescriptors_FEEDBACK
+ * - \ref AUDDSpeakerDriverDescriptors_FEEDBACK_REFRESH
  * - \ref AUDDSpeakerDriverDescriptors_FS_INTERVAL
  * - \ref AUDDSpeakerDriverDescriptors_HS_INTERVAL
  *
@@ -105,12 +111,51 @@
  */
 /** Data out endpoint number. */
 #define AUDDSpeakerDriverDescriptors_DATAOUT            0x02
+/** Explicit feedback endpoint number. */
+#define AUDDSpeakerDriverDescriptors_FEEDBACK           0x03
+/** Feedback refresh period 2^x ms */
+#define AUDDSpeakerDriverDescriptors_FEEDBACK_REFRESH   0x03
 /** Endpoint polling interval 2^(x-1) * 125us */
 #define AUDDSpeakerDriverDescriptors_HS_INTERVAL        0x04
 /** Endpoint polling interval 2^(x-1) * ms */
 #define AUDDSpeakerDriverDescriptors_FS_INTERVAL        0x01
 /**     @}*/
 
+/*----------------------------------------------------------------------------
+ *         Types
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \typedef AUDDSpeakerAsyncConfigurationDescriptors
+ * \brief Configuration descriptors of the speaker with an asynchronous
+ *        streaming endpoint and its explicit feedback endpoint.
+ */
+typedef PACKED_STRUCT _AUDDSpeakerAsyncConfigurationDescriptors {
+
+	/** Standard configuration. */
+	USBConfigurationDescriptor configuration;
+	/** Audio control interface. */
+	USBInterfaceDescriptor control;
+	/** Descriptors for the audio control interface. */
+	AUDDSpeakerDriverAudioControlDescriptors controlDescriptors;
+	/* - AUDIO OUT */
+	/** Streaming out interface descriptor (with no endpoint, required). */
+	USBInterfaceDescriptor streamingOutNoIsochronous;
+	/** Streaming out interface descriptor. */
+	USBInterfaceDescriptor streamingOut;
+	/** Audio class descriptor for the streaming out interface. */
+	AUDStreamingInterfaceDescriptor streamingOutClass;
+	/** Stream format descriptor. */
+	AUDFormatTypeOneDescriptor1 streamingOutFormatType;
+	/** Streaming out endpoint descriptor. */
+	AUDEndpointDescriptor streamingOutEndpoint;
+	/** Audio class descriptor for the streaming out endpoint. */
+	AUDDataEndpointDescriptor streamingOutDataEndpoint;
+	/** Explicit feedback endpoint descriptor. */
+	AUDEndpointDescriptor streamingOutFeedbackEndpoint;
+
+} AUDDSpeakerAsyncConfigurationDescriptors;
+
 /**@}*/
 
 #endif /* USBD_DRIVER_DESCRIPTORS_H */
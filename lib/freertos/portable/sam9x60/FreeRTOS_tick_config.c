@@ -34,6 +34,8 @@
 #include "irq/aic.h"
 #include "gpio/pio.h"
 #include "peripherals/pit.h"
+#include "peripherals/pmc.h"
+#include "power/idle.h"
 #include "board.h"
 
 /*
@@ -59,6 +61,129 @@ static void System_Handler( void )
 }
 /*-----------------------------------------------------------*/
 
+#if configUSE_TICKLESS_IDLE == 1
+
+/*
+ * Tickless idle.  The PIT period is stretched to cover the expected idle time
+ * (up to the 20-bit PIV range), the core enters the idle state selected by
+ * power/idle.h and, on wake-up, the kernel tick count is stepped by the
+ * number of complete ticks that elapsed.  When the core wakes up in the
+ * middle of a tick, the period is set to end on the next tick boundary and
+ * the tick interrupt restores the normal period.
+ */
+
+/* PIT counts per tick, maximum number of ticks covered by one PIT period and
+PIT counter frequency. */
+static uint32_t ulTickPIV;
+static uint32_t ulMaxSuppressedTicks;
+static uint32_t ulPITClock;
+
+/* Set when the current period was extended to realign on a tick boundary. */
+static volatile uint32_t ulRestorePIV;
+
+static void prvTicklessTickHandler( void )
+{
+	/* The period that just ended was the one realigning the tick, the
+	counter restarted from 0. */
+	if( ( ulRestorePIV != 0 ) && ( ( PIT->PIT_PIIR & PIT_PIIR_CPIV_Msk ) < ulTickPIV ) )
+	{
+		pit_set_piv( ulTickPIV - 1 );
+		ulRestorePIV = 0;
+	}
+
+	FreeRTOS_Tick_Handler();
+}
+/*-----------------------------------------------------------*/
+
+void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime )
+{
+uint32_t ulPIIR, ulStartCPIV, ulCPIV, ulElapsedCounts, ulCompleteTicks;
+uint32_t ulExpectedUs, ulStoppedUs = 0;
+enum _idle_state_id eState = IDLE_WFI;
+
+	if( xExpectedIdleTime > ulMaxSuppressedTicks )
+	{
+		xExpectedIdleTime = ulMaxSuppressedTicks;
+	}
+
+	/* Interrupts stay masked while sleeping, a pending interrupt still ends
+	the WFI and is serviced once they are enabled again. */
+	portDISABLE_INTERRUPTS();
+
+	ulPIIR = PIT->PIT_PIIR;
+	if( ( eTaskConfirmSleepModeStatus() == eAbortSleep ) ||
+		( ( ulPIIR & PIT_PIIR_PICNT_Msk ) != 0 ) || ( ulRestorePIV != 0 ) )
+	{
+		/* A task became ready, a tick is pending or the previous tickless
+		period is still being realigned. */
+		portENABLE_INTERRUPTS();
+		return;
+	}
+
+	/* The counter keeps running: the stretched period ends
+	xExpectedIdleTime ticks after the start of the current one. */
+	ulStartCPIV = ulPIIR & PIT_PIIR_CPIV_Msk;
+	pit_set_piv( ( xExpectedIdleTime * ulTickPIV ) - 1 );
+
+	ulExpectedUs = ( uint32_t )( ( ( uint64_t )( ( xExpectedIdleTime * ulTickPIV ) - ulStartCPIV ) * 16000000ULL ) / ulPITClock );
+
+	configPRE_SLEEP_PROCESSING( xExpectedIdleTime );
+	if( xExpectedIdleTime > 0 )
+	{
+		ulStoppedUs = idle_enter( ulExpectedUs, &eState );
+	}
+	configPOST_SLEEP_PROCESSING( xExpectedIdleTime );
+
+	ulPIIR = PIT->PIT_PIIR;
+	ulCPIV = ulPIIR & PIT_PIIR_CPIV_Msk;
+	if( ( ulPIIR & PIT_PIIR_PICNT_Msk ) != 0 )
+	{
+		/* The stretched period completed, its interrupt is pending and
+		accounts for the last tick. */
+		ulCompleteTicks = xExpectedIdleTime - 1;
+		ulElapsedCounts = ( xExpectedIdleTime * ulTickPIV ) - ulStartCPIV + ulCPIV;
+	}
+	else
+	{
+		/* Woken up early by another interrupt. */
+		ulCompleteTicks = ulCPIV / ulTickPIV;
+		ulElapsedCounts = ulCPIV - ulStartCPIV;
+	}
+
+	/* Time during which the PIT did not count (deep idle states). */
+	if( ulStoppedUs != 0 )
+	{
+		ulCompleteTicks += ( uint32_t )( ( ( uint64_t )ulStoppedUs * configTICK_RATE_HZ ) / 1000000ULL );
+		if( ulCompleteTicks > xExpectedIdleTime - 1 )
+		{
+			ulCompleteTicks = xExpectedIdleTime - 1;
+		}
+	}
+
+	/* End the current period on the next tick boundary. */
+	if( ulCPIV < ulTickPIV )
+	{
+		pit_set_piv( ulTickPIV - 1 );
+	}
+	else
+	{
+		pit_set_piv( ( ( ( ulCPIV / ulTickPIV ) + 1 ) * ulTickPIV ) - 1 );
+		ulRestorePIV = 1;
+	}
+
+	if( ulCompleteTicks > 0 )
+	{
+		vTaskStepTick( ulCompleteTicks );
+	}
+
+	idle_account( eState, ( uint32_t )( ( ( uint64_t )ulElapsedCounts * 16000000ULL ) / ulPITClock ) + ulStoppedUs );
+
+	portENABLE_INTERRUPTS();
+}
+/*-----------------------------------------------------------*/
+
+#endif /* configUSE_TICKLESS_IDLE == 1 */
+
 /*
  * The application must provide a function that configures a peripheral to
  * create the FreeRTOS tick interrupt, then define configSETUP_TICK_INTERRUPT()
@@ -78,7 +203,14 @@ void vConfigureTickInterrupt( void )
 	installed in place of FreeRTOS_Tick_Handler() if other system handlers are
 	required.  The tick must be given the lowest priority (0 in the SAMA5 AIC) */
 	aic_configure_mode( ID_PIT, IRQ_MODE_POSITIVE_EDGE );
+#if configUSE_TICKLESS_IDLE == 1
+	ulTickPIV = ( pit_get_mode() & PIT_MR_PIV_Msk ) + 1;
+	ulMaxSuppressedTicks = ( ( PIT_MR_PIV_Msk >> PIT_MR_PIV_Pos ) + 1 ) / ulTickPIV;
+	ulPITClock = pmc_get_peripheral_clock( ID_PIT );
+	aic_set_source_vector( ID_PIT, prvTicklessTickHandler );
+#else
 	aic_set_source_vector( ID_PIT, FreeRTOS_Tick_Handler );
+#endif
 
 	/* See commend directly above IRQ_ConfigureIT( ID_PIT, 0, System_Handler ); */
 	aic_enable( ID_PIT );
@@ -159,6 +159,12 @@
 	handler for whichever peripheral is used to generate the RTOS tick. */
 	void FreeRTOS_Tick_Handler( void );
 
+	/* Tickless idle, see FreeRTOS_tick_config.c. */
+	#if configUSE_TICKLESS_IDLE == 1
+		void vPortSuppressTicksAndSleep( TickType_t xExpectedIdleTime );
+		#define portSUPPRESS_TICKS_AND_SLEEP( xExpectedIdleTime ) vPortSuppressTicksAndSleep( xExpectedIdleTime )
+	#endif
+
 	/* Any task that uses the floating point unit MUST call vPortTaskUsesFPU()
 	before any floating point instructions are executed. */
 	void vPortTaskUsesFPU( void );
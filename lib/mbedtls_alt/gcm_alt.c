@@ -0,0 +1,184 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "mbedtls/gcm.h"
+
+#include "errno.h"
+#include "mbedtls_alt.h"
+
+#ifdef MBEDTLS_GCM_ALT
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static int _error(int err)
+{
+	switch (err) {
+	case 0:
+		return 0;
+	case -EBADMSG:
+		return MBEDTLS_ERR_GCM_AUTH_FAILED;
+	case -EINVAL:
+		return MBEDTLS_ERR_GCM_BAD_INPUT;
+	default:
+		return MBEDTLS_ERR_GCM_HW_ACCEL_FAILED;
+	}
+}
+
+/* Use the engine for long, word aligned operations. When the switch is
+ * not possible (no engine, middle of a block), the current path is kept. */
+static void _select(mbedtls_gcm_context* ctx, size_t len,
+		    const unsigned char* in, const unsigned char* out)
+{
+	bool engine = len >= MBEDTLS_ALT_GCM_ENGINE_MIN &&
+		(((uintptr_t)in | (uintptr_t)out) & 3) == 0;
+
+	aes_session_use_engine(&ctx->session, engine);
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+void mbedtls_gcm_init(mbedtls_gcm_context* ctx)
+{
+	memset(ctx, 0, sizeof(*ctx));
+}
+
+int mbedtls_gcm_setkey(mbedtls_gcm_context* ctx, mbedtls_cipher_id_t cipher,
+		       const unsigned char* key, unsigned int keybits)
+{
+	int err;
+
+	if (cipher != MBEDTLS_CIPHER_ID_AES)
+		return MBEDTLS_ERR_GCM_BAD_INPUT;
+
+	aes_session_free(&ctx->session);
+	err = aes_session_init(&ctx->session, mbedtls_alt_get_aesd(),
+			AES_SESSION_GCM, true, key, keybits / 8);
+	if (err == -ENOTSUP || err == -ENODEV)
+		err = aes_session_init(&ctx->session, NULL, AES_SESSION_GCM,
+				true, key, keybits / 8);
+	return err < 0 ? MBEDTLS_ERR_GCM_BAD_INPUT : 0;
+}
+
+int mbedtls_gcm_starts(mbedtls_gcm_context* ctx, int mode,
+		       const unsigned char* iv, size_t iv_len,
+		       const unsigned char* add, size_t add_len)
+{
+	int err;
+
+	if (iv_len == 0 || iv_len > UINT8_MAX || add_len > UINT32_MAX)
+		return MBEDTLS_ERR_GCM_BAD_INPUT;
+
+	aes_session_set_direction(&ctx->session, mode == MBEDTLS_GCM_ENCRYPT);
+	_select(ctx, add_len, add, add);
+	err = aes_session_start(&ctx->session, iv, iv_len);
+	if (err == 0 && add_len)
+		err = aes_session_update_aad(&ctx->session, add, add_len);
+	return _error(err);
+}
+
+int mbedtls_gcm_update(mbedtls_gcm_context* ctx, size_t length,
+		       const unsigned char* input, unsigned char* output)
+{
+	if (length > UINT32_MAX)
+		return MBEDTLS_ERR_GCM_BAD_INPUT;
+	if (length == 0)
+		return 0;
+
+	_select(ctx, length, input, output);
+	return _error(aes_session_update(&ctx->session, input, output, length));
+}
+
+int mbedtls_gcm_finish(mbedtls_gcm_context* ctx, unsigned char* tag,
+		       size_t tag_len)
+{
+	if (tag_len < 4 || tag_len > 16)
+		return MBEDTLS_ERR_GCM_BAD_INPUT;
+	return _error(aes_session_finish_tag(&ctx->session, tag, tag_len));
+}
+
+int mbedtls_gcm_crypt_and_tag(mbedtls_gcm_context* ctx, int mode,
+			      size_t length, const unsigned char* iv,
+			      size_t iv_len, const unsigned char* add,
+			      size_t add_len, const unsigned char* input,
+			      unsigned char* output, size_t tag_len,
+			      unsigned char* tag)
+{
+	int err;
+
+	err = mbedtls_gcm_starts(ctx, mode, iv, iv_len, add, add_len);
+	if (err == 0)
+		err = mbedtls_gcm_update(ctx, length, input, output);
+	if (err == 0)
+		err = mbedtls_gcm_finish(ctx, tag, tag_len);
+	return err;
+}
+
+int mbedtls_gcm_auth_decrypt(mbedtls_gcm_context* ctx, size_t length,
+			     const unsigned char* iv, size_t iv_len,
+			     const unsigned char* add, size_t add_len,
+			     const unsigned char* tag, size_t tag_len,
+			     const unsigned char* input, unsigned char* output)
+{
+	unsigned char check[16];
+	unsigned char diff = 0;
+	size_t i;
+	int err;
+
+	err = mbedtls_gcm_crypt_and_tag(ctx, MBEDTLS_GCM_DECRYPT, length, iv,
+			iv_len, add, add_len, input, output, tag_len, check);
+	if (err)
+		return err;
+
+	for (i = 0; i < tag_len; i++)
+		diff |= tag[i] ^ check[i];
+	if (diff) {
+		memset(output, 0, length);
+		return MBEDTLS_ERR_GCM_AUTH_FAILED;
+	}
+	return 0;
+}
+
+void mbedtls_gcm_free(mbedtls_gcm_context* ctx)
+{
+	aes_session_free(&ctx->session);
+}
+
+#endif /* MBEDTLS_GCM_ALT */
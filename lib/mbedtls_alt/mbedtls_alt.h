@@ -0,0 +1,85 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef _MBEDTLS_ALT_H_
+#define _MBEDTLS_ALT_H_
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/*
+ * Hardware acceleration of mbedTLS on top of the AES, SHA and TRNG
+ * drivers. The mbedTLS configuration selects the alternative
+ * implementations provided here:
+ *
+ *   #define MBEDTLS_GCM_ALT
+ *   #define MBEDTLS_SHA256_ALT
+ *   #define MBEDTLS_SHA512_ALT
+ *   #define MBEDTLS_ENTROPY_HARDWARE_ALT
+ *
+ * with lib/mbedtls_alt in the include path. Each operation goes to the
+ * engine or to the software implementation depending on its length: the
+ * engine setup (key load, state restore, DMA descriptors) costs more than
+ * hashing or ciphering a few blocks in software.
+ */
+
+/** Minimum GCM update length (bytes) processed by the AES engine */
+#ifndef MBEDTLS_ALT_GCM_ENGINE_MIN
+#define MBEDTLS_ALT_GCM_ENGINE_MIN 256
+#endif
+
+/** Minimum SHA update length (bytes) processed by the SHA engine */
+#ifndef MBEDTLS_ALT_SHA_ENGINE_MIN
+#define MBEDTLS_ALT_SHA_ENGINE_MIN 512
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+struct _aesd_desc;
+struct _shad_desc;
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Give the engines used by the mbedTLS contexts created afterwards.
+ * \param aesd  Initialized AES driver, or NULL for software GCM.
+ * \param shad  Initialized SHA driver, or NULL for software SHA.
+ */
+extern void mbedtls_alt_init(struct _aesd_desc *aesd, struct _shad_desc *shad);
+
+extern struct _aesd_desc *mbedtls_alt_get_aesd(void);
+
+extern struct _shad_desc *mbedtls_alt_get_shad(void);
+
+#endif /* _MBEDTLS_ALT_H_ */
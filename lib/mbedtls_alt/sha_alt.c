@@ -0,0 +1,250 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "mbedtls/sha256.h"
+#include "mbedtls/sha512.h"
+
+#include "mbedtls_alt.h"
+
+#if defined(MBEDTLS_SHA256_ALT) || defined(MBEDTLS_SHA512_ALT)
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static int _starts(struct _sha_session* session, enum _shad_algo algo)
+{
+	int err;
+
+	sha_session_free(session);
+	err = sha_session_init(session, mbedtls_alt_get_shad(), algo);
+	if (err == 0)
+		err = sha_session_start(session);
+	return err;
+}
+
+/* Use the engine for long, word aligned updates. The engine may refuse to
+ * take over a message (no state restore), software goes on then. */
+static int _update(struct _sha_session* session, const unsigned char* input,
+		   size_t ilen)
+{
+	bool engine = ilen >= MBEDTLS_ALT_SHA_ENGINE_MIN &&
+		((uintptr_t)input & 3) == 0;
+	int err;
+
+	sha_session_use_engine(session, engine);
+	while (ilen) {
+		uint32_t len = ilen > UINT32_MAX ? UINT32_MAX : (uint32_t)ilen;
+
+		err = sha_session_update(session, input, len);
+		if (err < 0)
+			return err;
+		input += len;
+		ilen -= len;
+	}
+	return 0;
+}
+
+static void _clone(struct _sha_session* dst, const struct _sha_session* src)
+{
+	/* the saved state is always up to date, the copy restores it when
+	 * it uses the engine */
+	sha_session_free(dst);
+	memcpy(dst, src, sizeof(*dst));
+}
+
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+#ifdef MBEDTLS_SHA256_ALT
+
+void mbedtls_sha256_init(mbedtls_sha256_context* ctx)
+{
+	memset(ctx, 0, sizeof(*ctx));
+}
+
+void mbedtls_sha256_free(mbedtls_sha256_context* ctx)
+{
+	if (ctx)
+		sha_session_free(&ctx->session);
+}
+
+void mbedtls_sha256_clone(mbedtls_sha256_context* dst,
+			  const mbedtls_sha256_context* src)
+{
+	_clone(&dst->session, &src->session);
+}
+
+int mbedtls_sha256_starts_ret(mbedtls_sha256_context* ctx, int is224)
+{
+	if (_starts(&ctx->session, is224 ? ALGO_SHA_224 : ALGO_SHA_256) < 0)
+		return MBEDTLS_ERR_SHA256_HW_ACCEL_FAILED;
+	return 0;
+}
+
+int mbedtls_sha256_update_ret(mbedtls_sha256_context* ctx,
+			      const unsigned char* input, size_t ilen)
+{
+	if (_update(&ctx->session, input, ilen) < 0)
+		return MBEDTLS_ERR_SHA256_HW_ACCEL_FAILED;
+	return 0;
+}
+
+int mbedtls_sha256_finish_ret(mbedtls_sha256_context* ctx,
+			      unsigned char output[32])
+{
+	if (sha_session_finish(&ctx->session, output) < 0)
+		return MBEDTLS_ERR_SHA256_HW_ACCEL_FAILED;
+	return 0;
+}
+
+int mbedtls_internal_sha256_process(mbedtls_sha256_context* ctx,
+				    const unsigned char data[64])
+{
+	/* one raw block, the message length must not change */
+	if (sha_session_compress(&ctx->session, data) < 0)
+		return MBEDTLS_ERR_SHA256_HW_ACCEL_FAILED;
+	return 0;
+}
+
+#if !defined(MBEDTLS_DEPRECATED_REMOVED)
+void mbedtls_sha256_starts(mbedtls_sha256_context* ctx, int is224)
+{
+	mbedtls_sha256_starts_ret(ctx, is224);
+}
+
+void mbedtls_sha256_update(mbedtls_sha256_context* ctx,
+			   const unsigned char* input, size_t ilen)
+{
+	mbedtls_sha256_update_ret(ctx, input, ilen);
+}
+
+void mbedtls_sha256_finish(mbedtls_sha256_context* ctx,
+			   unsigned char output[32])
+{
+	mbedtls_sha256_finish_ret(ctx, output);
+}
+
+void mbedtls_sha256_process(mbedtls_sha256_context* ctx,
+			    const unsigned char data[64])
+{
+	mbedtls_internal_sha256_process(ctx, data);
+}
+#endif
+
+#endif /* MBEDTLS_SHA256_ALT */
+
+#ifdef MBEDTLS_SHA512_ALT
+
+void mbedtls_sha512_init(mbedtls_sha512_context* ctx)
+{
+	memset(ctx, 0, sizeof(*ctx));
+}
+
+void mbedtls_sha512_free(mbedtls_sha512_context* ctx)
+{
+	if (ctx)
+		sha_session_free(&ctx->session);
+}
+
+void mbedtls_sha512_clone(mbedtls_sha512_context* dst,
+			  const mbedtls_sha512_context* src)
+{
+	_clone(&dst->session, &src->session);
+}
+
+int mbedtls_sha512_starts_ret(mbedtls_sha512_context* ctx, int is384)
+{
+	if (_starts(&ctx->session, is384 ? ALGO_SHA_384 : ALGO_SHA_512) < 0)
+		return MBEDTLS_ERR_SHA512_HW_ACCEL_FAILED;
+	return 0;
+}
+
+int mbedtls_sha512_update_ret(mbedtls_sha512_context* ctx,
+			      const unsigned char* input, size_t ilen)
+{
+	if (_update(&ctx->session, input, ilen) < 0)
+		return MBEDTLS_ERR_SHA512_HW_ACCEL_FAILED;
+	return 0;
+}
+
+int mbedtls_sha512_finish_ret(mbedtls_sha512_context* ctx,
+			      unsigned char output[64])
+{
+	if (sha_session_finish(&ctx->session, output) < 0)
+		return MBEDTLS_ERR_SHA512_HW_ACCEL_FAILED;
+	return 0;
+}
+
+int mbedtls_internal_sha512_process(mbedtls_sha512_context* ctx,
+				    const unsigned char data[128])
+{
+	/* one raw block, the message length must not change */
+	if (sha_session_compress(&ctx->session, data) < 0)
+		return MBEDTLS_ERR_SHA512_HW_ACCEL_FAILED;
+	return 0;
+}
+
+#if !defined(MBEDTLS_DEPRECATED_REMOVED)
+void mbedtls_sha512_starts(mbedtls_sha512_context* ctx, int is384)
+{
+	mbedtls_sha512_starts_ret(ctx, is384);
+}
+
+void mbedtls_sha512_update(mbedtls_sha512_context* ctx,
+			   const unsigned char* input, size_t ilen)
+{
+	mbedtls_sha512_update_ret(ctx, input, ilen);
+}
+
+void mbedtls_sha512_finish(mbedtls_sha512_context* ctx,
+			   unsigned char output[64])
+{
+	mbedtls_sha512_finish_ret(ctx, output);
+}
+
+void mbedtls_sha512_process(mbedtls_sha512_context* ctx,
+			    const unsigned char data[128])
+{
+	mbedtls_internal_sha512_process(ctx, data);
+}
+#endif
+
+#endif /* MBEDTLS_SHA512_ALT */
@@ -34,6 +34,19 @@
  *----------------------------------------------------------------------------*/
 
 #include "board.h"
+#include "compiler.h"
+#include "errno.h"
+#include "intmath.h"
+#include "pixel.h"
+#include "trace.h"
+
+#include "picture/bmp.h"
+
+#ifdef CONFIG_HAVE_LCDC
+#include "display/lcdc.h"
+#include "mm/cache.h"
+#endif
+
 #include <string.h>
 
 /*----------------------------------------------------------------------------
@@ -43,6 +56,16 @@
 /// BMP offset for header
 #define  IMAGE_OFFSET       0x100
 
+/// Size of the file header and of the BITMAPINFOHEADER
+#define  BMP_FILE_HEADER_SIZE   14
+#define  BMP_CORE_HEADER_SIZE   12
+#define  BMP_HEADERS_SIZE       (BMP_FILE_HEADER_SIZE + BITMAPINFOHEADER)
+
+/// RLE escape codes
+#define  BMP_RLE_EOL        0
+#define  BMP_RLE_EOF        1
+#define  BMP_RLE_DELTA      2
+
 /*----------------------------------------------------------------------------
  *        Internal types
  *----------------------------------------------------------------------------*/
@@ -58,6 +81,313 @@ typedef struct _BMPPaletteEntry {
 	uint8_t filler;
 } BMPPaletteEntry;
 
+#ifdef CONFIG_LIB_FATFS
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static inline uint16_t
+_le16(const uint8_t * p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+static inline uint32_t
+_le32(const uint8_t * p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+/**
+ * \brief Read exactly size bytes from the file.
+ */
+static int
+_bmp_read(struct _bmp_stream *bmp, void *buffer, uint32_t size)
+{
+	UINT read;
+
+	if (f_read(bmp->file, buffer, size, &read) != FR_OK || read != size)
+		return -EIO;
+	return 0;
+}
+
+/**
+ * \brief Get the next byte of RLE data, refilling the strip buffer as needed.
+ */
+static int
+_bmp_rle_byte(struct _bmp_stream *bmp, uint8_t * byte)
+{
+	if (bmp->strip_pos == bmp->strip_len) {
+		UINT read;
+
+		if (f_read(bmp->file, bmp->strip, bmp->strip_size, &read) != FR_OK
+		    || read == 0)
+			return -EIO;
+		bmp->strip_len = read;
+		bmp->strip_pos = 0;
+	}
+	*byte = bmp->strip[bmp->strip_pos++];
+	return 0;
+}
+
+/**
+ * \brief Convert RGB555 pixels to RGB565 in place, two pixels per word.
+ */
+static void
+_bmp_rgb555_to_rgb565(uint16_t * pixels, uint32_t count)
+{
+	uint32_t *p32;
+
+	if (count && (((uint32_t) pixels) & 3)) {
+		uint16_t p = *pixels;
+		*pixels++ = ((p & 0x7FE0) << 1) | ((p >> 4) & 0x20) | (p & 0x1F);
+		count--;
+	}
+	p32 = (uint32_t *) pixels;
+	for (; count >= 2; count -= 2) {
+		uint32_t w = *p32;
+		*p32++ = ((w & 0x7FE07FE0) << 1) | ((w >> 4) & 0x00200020)
+		    | (w & 0x001F001F);
+	}
+	if (count) {
+		uint16_t p = *(uint16_t *) p32;
+		*(uint16_t *) p32 = ((p & 0x7FE0) << 1) | ((p >> 4) & 0x20)
+		    | (p & 0x1F);
+	}
+}
+
+/**
+ * \brief Write palette entry index at x in a destination row.
+ */
+static inline void
+_bmp_put_index(const struct _bmp_stream *bmp, uint8_t * row, uint32_t x,
+	       uint8_t bpp, uint8_t index)
+{
+	uint32_t color = bmp->palette[index];
+
+	switch (bpp) {
+	case 16:
+		((uint16_t *) row)[x] = bmp->lut16[index];
+		break;
+	case 24:
+		row += 3 * x;
+		row[0] = color & 0xFF;
+		row[1] = (color >> 8) & 0xFF;
+		row[2] = (color >> 16) & 0xFF;
+		break;
+	case 32:
+		((uint32_t *) row)[x] = color;
+		break;
+	}
+}
+
+/**
+ * \brief Convert a stored row of a palettized image.
+ */
+static void
+_bmp_convert_indexed(const struct _bmp_stream *bmp, uint8_t * dst,
+		     const uint8_t * src, uint32_t count, uint8_t bpp)
+{
+	uint32_t x;
+
+	switch (bmp->bits) {
+	case 8:
+		if (bpp == 16) {
+			uint16_t *d = (uint16_t *) dst;
+			for (x = 0; x + 4 <= count; x += 4) {
+				d[x] = bmp->lut16[src[x]];
+				d[x + 1] = bmp->lut16[src[x + 1]];
+				d[x + 2] = bmp->lut16[src[x + 2]];
+				d[x + 3] = bmp->lut16[src[x + 3]];
+			}
+			for (; x < count; x++)
+				d[x] = bmp->lut16[src[x]];
+		} else if (bpp == 32) {
+			uint32_t *d = (uint32_t *) dst;
+			for (x = 0; x < count; x++)
+				d[x] = bmp->palette[src[x]];
+		} else {
+			for (x = 0; x < count; x++)
+				_bmp_put_index(bmp, dst, x, bpp, src[x]);
+		}
+		break;
+	case 4:
+		for (x = 0; x < count; x++)
+			_bmp_put_index(bmp, dst, x, bpp,
+				       (x & 1) ? src[x >> 1] & 0xF : src[x >> 1] >> 4);
+		break;
+	case 1:
+		for (x = 0; x < count; x++)
+			_bmp_put_index(bmp, dst, x, bpp,
+				       (src[x >> 3] >> (7 - (x & 7))) & 1);
+		break;
+	}
+}
+
+/**
+ * \brief Convert a stored row into the destination format.
+ */
+static void
+_bmp_convert_row(struct _bmp_stream *bmp, uint8_t * dst, uint8_t * src,
+		 uint32_t count, uint8_t bpp)
+{
+	uint32_t x;
+
+	switch (bmp->bits) {
+	case 16:
+		if (bmp->rgb555)
+			_bmp_rgb555_to_rgb565((uint16_t *) src, count);
+		pixel_convert(dst, bpp, src, 16, count);
+		break;
+	case 24:
+		pixel_convert(dst, bpp, src, 24, count);
+		break;
+	case 32:
+		if (bmp->opaque && bpp == 32) {
+			uint32_t *d = (uint32_t *) dst;
+			const uint32_t *s = (const uint32_t *)src;
+			for (x = 0; x < count; x++)
+				d[x] = s[x] | 0xFF000000;
+		} else {
+			pixel_convert(dst, bpp, src, 32, count);
+		}
+		break;
+	default:
+		_bmp_convert_indexed(bmp, dst, src, count, bpp);
+		break;
+	}
+}
+
+/**
+ * \brief Decode uncompressed pixel data, strip by strip.
+ */
+static int
+_bmp_decode_rows(struct _bmp_stream *bmp, uint8_t * buffer, uint32_t pitch,
+		 uint32_t width, uint32_t height, uint8_t bpp)
+{
+	uint32_t rows_per_strip = bmp->strip_size / bmp->row_size;
+	uint32_t first = 0, stored, rows, i, y;
+	int err;
+
+	if (rows_per_strip == 0)
+		return -ENOMEM;
+
+	/* bottom-up images start with rows below the destination */
+	if (!bmp->top_down && bmp->height > height)
+		first = bmp->height - height;
+	if (f_lseek(bmp->file, bmp->data_offset + first * bmp->row_size)
+	    != FR_OK)
+		return -EIO;
+
+	for (stored = first; stored < bmp->height && (bmp->top_down ?
+	     stored < height : true); stored += rows) {
+		rows = min_u32(rows_per_strip, bmp->height - stored);
+		if (bmp->top_down)
+			rows = min_u32(rows, height - stored);
+		err = _bmp_read(bmp, bmp->strip, rows * bmp->row_size);
+		if (err < 0)
+			return err;
+
+		for (i = 0; i < rows; i++) {
+			y = bmp->top_down ? stored + i
+			    : bmp->height - 1 - (stored + i);
+			_bmp_convert_row(bmp, buffer + y * pitch,
+					 bmp->strip + i * bmp->row_size,
+					 width, bpp);
+		}
+	}
+	return 0;
+}
+
+/**
+ * \brief Decode RLE8 or RLE4 pixel data. Pixels skipped by delta or end of
+ * line codes are left untouched.
+ */
+static int
+_bmp_decode_rle(struct _bmp_stream *bmp, uint8_t * buffer, uint32_t pitch,
+		uint32_t width, uint32_t height, uint8_t bpp)
+{
+	bool rle4 = bmp->compression == BMP_BI_RLE4;
+	uint32_t x = 0, y = 0, n, i, cnt;
+	uint8_t count, code, value = 0;
+	uint8_t *row;
+	int err;
+
+	if (f_lseek(bmp->file, bmp->data_offset) != FR_OK)
+		return -EIO;
+	bmp->strip_len = 0;
+	bmp->strip_pos = 0;
+
+	while (y < bmp->height) {
+		/* rows are stored bottom-up, row is NULL when out of the
+		 * destination */
+		n = bmp->height - 1 - y;
+		row = n < height ? buffer + n * pitch : NULL;
+
+		if ((err = _bmp_rle_byte(bmp, &count)) < 0)
+			return err;
+		if ((err = _bmp_rle_byte(bmp, &code)) < 0)
+			return err;
+
+		if (count) {
+			/* encoded run */
+			cnt = (x < width) ? min_u32(count, width - x) : 0;
+			if (row && cnt) {
+				if (!rle4 || (code >> 4) == (code & 0xF))
+					pixel_fill(row + x * (bpp / 8),
+						   bmp->palette[rle4 ? code & 0xF : code],
+						   cnt, bpp);
+				else
+					for (i = 0; i < cnt; i++)
+						_bmp_put_index(bmp, row, x + i, bpp,
+							       (i & 1) ? code & 0xF : code >> 4);
+			}
+			x += count;
+			continue;
+		}
+
+		switch (code) {
+		case BMP_RLE_EOL:
+			x = 0;
+			y++;
+			break;
+		case BMP_RLE_EOF:
+			return 0;
+		case BMP_RLE_DELTA:
+			if ((err = _bmp_rle_byte(bmp, &count)) < 0)
+				return err;
+			if ((err = _bmp_rle_byte(bmp, &value)) < 0)
+				return err;
+			x += count;
+			y += value;
+			break;
+		default:
+			/* absolute run of code pixels, padded to 16 bits */
+			n = rle4 ? (code + 1) / 2 : code;
+			for (i = 0; i < code; i++) {
+				if (!rle4 || !(i & 1)) {
+					if ((err = _bmp_rle_byte(bmp, &value)) < 0)
+						return err;
+				}
+				if (row && x + i < width)
+					_bmp_put_index(bmp, row, x + i, bpp,
+						       !rle4 ? value :
+						       (i & 1) ? value & 0xF : value >> 4);
+			}
+			if (n & 1) {
+				if ((err = _bmp_rle_byte(bmp, &value)) < 0)
+					return err;
+			}
+			x += code;
+			break;
+		}
+	}
+	return 0;
+}
+
+#endif /* CONFIG_LIB_FATFS */
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -314,20 +644,260 @@ void
 RGB565toBGR555(uint8_t * fileSource, uint8_t * fileDestination, uint32_t width,
 	       uint32_t height, uint8_t bpp)
 {
-	uint32_t i;
-	uint32_t j;
-	uint32_t row;
-
-	for (i = 0; i < height * (bpp / 8); i++) {
-		row = (i * width * (bpp / 8));
-
-		for (j = 0; j <= width * (bpp / 8); j += 2) {
-			fileDestination[row + j] =
-			    ((fileSource[row + j + 1] >> 3) & 0x1F)
-			    | (fileSource[row + j] & 0xE0);
-			fileDestination[row + j + 1] =
-			    (fileSource[row + j + 1] & 0x03)
-			    | ((fileSource[row + j] & 0x1F) << 2);
+	uint32_t count = width * height;
+	uint32_t w;
+
+	if (bpp != 16)
+		return;
+
+	/* two pixels per word when both buffers are word aligned */
+	if (!(((uint32_t)fileSource | (uint32_t)fileDestination) & 3)) {
+		const uint32_t *src = (const uint32_t *)fileSource;
+		uint32_t *dst = (uint32_t *)fileDestination;
+
+		for (; count >= 2; count -= 2) {
+			w = *src++;
+			*dst++ = ((w >> 11) & 0x001F001F) | (w & 0x03E003E0)
+			    | ((w & 0x001F001F) << 10);
+		}
+		fileSource = (uint8_t *)src;
+		fileDestination = (uint8_t *)dst;
+	}
+
+	for (; count; count--) {
+		w = fileSource[0] | (fileSource[1] << 8);
+		w = ((w >> 11) & 0x1F) | (w & 0x03E0) | ((w & 0x1F) << 10);
+		fileDestination[0] = w & 0xFF;
+		fileDestination[1] = w >> 8;
+		fileSource += 2;
+		fileDestination += 2;
+	}
+}
+
+#ifdef CONFIG_LIB_FATFS
+
+/**
+ * \brief Open a BMP file for streaming decode: parse the headers and load
+ * the palette.
+ *
+ * Supported formats are 1, 4 and 8 bpp palettized (uncompressed, RLE4 or
+ * RLE8), RGB555/RGB565 16 bpp, 24 bpp and 32 bpp, stored bottom-up or
+ * top-down.
+ *
+ * \param bmp  Decoder state.
+ * \param file  File opened for reading.
+ * \param strip  Strip buffer, word aligned. It must hold at least one
+ * stored row (width * bpp / 8 rounded up to 4 bytes), a few rows make the
+ * file system reads more efficient.
+ * \param strip_size  Size of the strip buffer in bytes.
+ * \return 0 on success, -EIO on read error, -EINVAL if the file is not a
+ * BMP, its width is invalid or one row does not fit in the strip buffer,
+ * -ENOTSUP if the format is not supported.
+ */
+int
+bmp_stream_open(struct _bmp_stream *bmp, FIL * file, void *strip,
+		uint32_t strip_size)
+{
+	uint8_t header[BMP_HEADERS_SIZE + 16];
+	uint32_t header_size, masks_offset, i;
+	uint8_t entry_size, *entry;
+	int32_t height;
+	int err;
+
+	memset(bmp, 0, sizeof(*bmp));
+	bmp->file = file;
+	bmp->strip = (uint8_t *) strip;
+	bmp->strip_size = strip_size;
+
+	if (f_lseek(file, 0) != FR_OK)
+		return -EIO;
+	err = _bmp_read(bmp, header, BMP_FILE_HEADER_SIZE + 4);
+	if (err < 0)
+		return err;
+	if (_le16(header) != BMP_TYPE)
+		return -EINVAL;
+	bmp->data_offset = _le32(&header[10]);
+	header_size = _le32(&header[14]);
+
+	if (header_size == BMP_CORE_HEADER_SIZE) {
+		/* OS/2 1.x header */
+		err = _bmp_read(bmp, &header[18], BMP_CORE_HEADER_SIZE - 4);
+		if (err < 0)
+			return err;
+		bmp->width = _le16(&header[18]);
+		height = _le16(&header[20]);
+		bmp->bits = _le16(&header[24]);
+		bmp->compression = BMP_BI_RGB;
+		entry_size = 3;
+	} else if (header_size >= BITMAPINFOHEADER) {
+		err = _bmp_read(bmp, &header[18], BITMAPINFOHEADER - 4);
+		if (err < 0)
+			return err;
+		bmp->width = _le32(&header[18]);
+		height = (int32_t) _le32(&header[22]);
+		bmp->bits = _le16(&header[28]);
+		bmp->compression = _le32(&header[30]);
+		bmp->num_colors = _le32(&header[46]);
+		entry_size = 4;
+
+		/* RGB masks follow the 40-byte header, or are part of the
+		 * V4/V5 headers at the same offset with the alpha mask */
+		if (bmp->compression == BMP_BI_BITFIELDS) {
+			err = _bmp_read(bmp, &header[BMP_HEADERS_SIZE],
+					header_size >= 56 ? 16 : 12);
+			if (err < 0)
+				return err;
+		}
+	} else {
+		return -ENOTSUP;
+	}
+
+	bmp->top_down = height < 0;
+	bmp->height = height < 0 ? -height : height;
+
+	switch (bmp->bits) {
+	case 1:
+	case 4:
+	case 8:
+		if ((bmp->compression == BMP_BI_RLE8 && bmp->bits != 8)
+		    || (bmp->compression == BMP_BI_RLE4 && bmp->bits != 4)
+		    || bmp->compression == BMP_BI_BITFIELDS)
+			return -ENOTSUP;
+		if (bmp->compression != BMP_BI_RGB && bmp->top_down)
+			return -ENOTSUP;
+		if (bmp->num_colors == 0 || bmp->num_colors > (1u << bmp->bits))
+			bmp->num_colors = 1u << bmp->bits;
+		break;
+	case 16:
+		bmp->rgb555 = true;
+		if (bmp->compression == BMP_BI_BITFIELDS) {
+			masks_offset = BMP_HEADERS_SIZE;
+			if (_le32(&header[masks_offset]) == 0xF800
+			    && _le32(&header[masks_offset + 4]) == 0x07E0
+			    && _le32(&header[masks_offset + 8]) == 0x001F)
+				bmp->rgb555 = false;
+			else if (_le32(&header[masks_offset]) != 0x7C00
+				 || _le32(&header[masks_offset + 4]) != 0x03E0
+				 || _le32(&header[masks_offset + 8]) != 0x001F)
+				return -ENOTSUP;
+		} else if (bmp->compression != BMP_BI_RGB) {
+			return -ENOTSUP;
+		}
+		bmp->num_colors = 0;
+		break;
+	case 24:
+	case 32:
+		if (bmp->compression == BMP_BI_BITFIELDS) {
+			masks_offset = BMP_HEADERS_SIZE;
+			if (bmp->bits != 32
+			    || _le32(&header[masks_offset]) != 0x00FF0000
+			    || _le32(&header[masks_offset + 4]) != 0x0000FF00
+			    || _le32(&header[masks_offset + 8]) != 0x000000FF)
+				return -ENOTSUP;
+		} else if (bmp->compression != BMP_BI_RGB) {
+			return -ENOTSUP;
+		}
+		/* the alpha byte is only meaningful with an alpha mask */
+		bmp->opaque = !(bmp->compression == BMP_BI_BITFIELDS
+				&& header_size >= 56
+				&& _le32(&header[BMP_HEADERS_SIZE + 12]) == 0xFF000000);
+		bmp->num_colors = 0;
+		break;
+	default:
+		return -ENOTSUP;
+	}
+
+	/* the decoder reads whole rows through the strip buffer */
+	if (bmp->width == 0 || bmp->width > (UINT32_MAX - 7) / bmp->bits)
+		return -EINVAL;
+	bmp->row_size = ROUND_UP_MULT((bmp->width * bmp->bits + 7) / 8, 4);
+	if (bmp->row_size > strip_size)
+		return -EINVAL;
+
+	if (bmp->num_colors) {
+		/* the palette follows the info header, read it through the
+		 * strip buffer if it is large enough */
+		uint32_t size = bmp->num_colors * entry_size;
+		uint8_t *palette = (size <= strip_size) ? bmp->strip
+		    : (uint8_t *) bmp->palette;
+
+		if (f_lseek(file, BMP_FILE_HEADER_SIZE + header_size) != FR_OK)
+			return -EIO;
+		err = _bmp_read(bmp, palette, size);
+		if (err < 0)
+			return err;
+
+		/* convert from the end, the palette may be loaded in place */
+		for (i = bmp->num_colors; i > 0; i--) {
+			entry = &palette[(i - 1) * entry_size];
+			bmp->palette[i - 1] = 0xFF000000 | (entry[2] << 16)
+			    | (entry[1] << 8) | entry[0];
+			bmp->lut16[i - 1] = PIXEL_ARGB_TO_RGB565(bmp->palette[i - 1]);
 		}
 	}
+
+	return 0;
 }
+
+/**
+ * \brief Decode a BMP file opened with bmp_stream_open() into a buffer.
+ *
+ * The image is converted to the buffer format row by row as it is read,
+ * its top left corner is placed at the start of the buffer and it is
+ * clipped to the buffer size.
+ *
+ * \param bmp  Decoder state.
+ * \param buffer  Destination buffer.
+ * \param pitch  Bytes between two rows of the destination buffer.
+ * \param width  Destination width in pixels.
+ * \param height  Destination height in pixels.
+ * \param bpp  Destination bits per pixel: 16 (RGB565), 24 (packed RGB888)
+ * or 32 (ARGB8888).
+ * \return 0 on success, -EINVAL on invalid parameter, -ENOMEM if the strip
+ * buffer cannot hold a row, -EIO on read error or truncated file.
+ */
+int
+bmp_stream_decode(struct _bmp_stream *bmp, void *buffer, uint32_t pitch,
+		  uint16_t width, uint16_t height, uint8_t bpp)
+{
+	if (!bmp->file || (bpp != 16 && bpp != 24 && bpp != 32))
+		return -EINVAL;
+
+	width = min_u32(width, bmp->width);
+	height = min_u32(height, bmp->height);
+
+	if (bmp->compression == BMP_BI_RLE4 || bmp->compression == BMP_BI_RLE8)
+		return _bmp_decode_rle(bmp, (uint8_t *) buffer, pitch, width,
+				       height, bpp);
+	else
+		return _bmp_decode_rows(bmp, (uint8_t *) buffer, pitch, width,
+					height, bpp);
+}
+
+#ifdef CONFIG_HAVE_LCDC
+/**
+ * \brief Decode a BMP file opened with bmp_stream_open() into the current
+ * LCDC canvas (see lcdc_get_canvas()), and clean the canvas from the data
+ * cache.
+ * \return 0 on success, -ENODEV if there is no canvas, or an error from
+ * bmp_stream_decode().
+ */
+int
+bmp_stream_decode_canvas(struct _bmp_stream *bmp)
+{
+	struct _lcdc_layer *canvas = lcdc_get_canvas();
+	uint32_t pitch;
+	int err;
+
+	if (!canvas || !canvas->buffer)
+		return -ENODEV;
+
+	pitch = ROUND_UP_MULT(canvas->width * (canvas->bpp / 8), 4);
+	err = bmp_stream_decode(bmp, canvas->buffer, pitch, canvas->width,
+				canvas->height, canvas->bpp);
+	cache_clean_region(canvas->buffer, pitch * canvas->height);
+	return err;
+}
+#endif /* CONFIG_HAVE_LCDC */
+
+#endif /* CONFIG_LIB_FATFS */
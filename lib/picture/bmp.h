@@ -34,17 +34,31 @@
  *  Utility for BMP
  *
  */
-#include <chip.h>
 
 #ifndef BMP_H
 #define BMP_H
 
+#include <chip.h>
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef CONFIG_LIB_FATFS
+#include "fatfs/src/ff.h"
+#endif
+
 /**  BMP magic number ('BM'). */
 #define BMP_TYPE       0x4D42
 
 /**  headerSize must be set to 40 */
 #define BITMAPINFOHEADER   40
 
+/** Compression methods */
+#define BMP_BI_RGB         0
+#define BMP_BI_RLE8        1
+#define BMP_BI_RLE4        2
+#define BMP_BI_BITFIELDS   3
+
 /*------------------------------------------------------------------------------
  *         Exported types
  *------------------------------------------------------------------------------*/
@@ -202,6 +216,40 @@ typedef PACKED_STRUCT _BMPHeader {
 
 } BMPHeader;
 
+#ifdef CONFIG_LIB_FATFS
+
+/**
+ * Streaming BMP decoder.
+ *
+ * The file is read in strips through a buffer given by the application,
+ * only the header and the palette are kept in this structure (about
+ * 1.6 KB), so the peak RAM use is sizeof(struct _bmp_stream) plus the strip
+ * buffer whatever the image size.
+ */
+struct _bmp_stream {
+	FIL      *file;
+	uint32_t  width;        /**< Image width in pixels */
+	uint32_t  height;       /**< Image height in pixels */
+	uint32_t  data_offset;  /**< Offset of the pixel data in the file */
+	uint32_t  row_size;     /**< Stored row size, in bytes */
+	uint32_t  compression;  /**< BMP_BI_xxx */
+	uint16_t  bits;         /**< Bits per pixel of the file */
+	uint16_t  num_colors;   /**< Palette entries */
+	bool      top_down;     /**< Rows stored from the top */
+	bool      rgb555;       /**< 16 bpp stored as X1R5G5B5 */
+	bool      opaque;       /**< 32 bpp without alpha channel */
+
+	uint8_t  *strip;        /**< Strip buffer */
+	uint32_t  strip_size;   /**< Strip buffer size */
+	uint32_t  strip_len;    /**< RLE: bytes in the strip */
+	uint32_t  strip_pos;    /**< RLE: next byte in the strip */
+
+	uint32_t  palette[256]; /**< Palette, 0xAARRGGBB */
+	uint16_t  lut16[256];   /**< Palette, RGB565 */
+};
+
+#endif /* CONFIG_LIB_FATFS */
+
 /*------------------------------------------------------------------------------
  *         Exported functions
  *------------------------------------------------------------------------------*/
@@ -225,4 +273,19 @@ void RGB565toBGR555(uint8_t * fileSource,
 			   uint8_t * fileDestination,
 			   uint32_t width, uint32_t height, uint8_t bpp);
 
+#ifdef CONFIG_LIB_FATFS
+
+extern int bmp_stream_open(struct _bmp_stream *bmp, FIL *file,
+			   void *strip, uint32_t strip_size);
+
+extern int bmp_stream_decode(struct _bmp_stream *bmp, void *buffer,
+			     uint32_t pitch, uint16_t width, uint16_t height,
+			     uint8_t bpp);
+
+#ifdef CONFIG_HAVE_LCDC
+extern int bmp_stream_decode_canvas(struct _bmp_stream *bmp);
+#endif
+
+#endif /* CONFIG_LIB_FATFS */
+
 #endif				//#ifndef BMP_H
@@ -357,8 +357,8 @@ enum usb_device_feature {
 #define USBEndpointDescriptor_Synchronous_ISOCHRONOUS           (3<<2)
 
 /**  Usage Type for Isochronous endpoint type. */
-#define USBEndpointDescriptor_Feedback_ISOCHRONOUS              (1<<2)
-#define USBEndpointDescriptor_Explicit_Feedback_ISOCHRONOUS     (2<<2)
+#define USBEndpointDescriptor_Feedback_ISOCHRONOUS              (1<<4)
+#define USBEndpointDescriptor_Explicit_Feedback_ISOCHRONOUS     (2<<4)
 /**         @}*/
 
 /** \addtogroup usb_ep_size USB Endpoint maximum sizes
@@ -220,4 +220,23 @@ uint8_t audd_speaker_driver_read(void *buffer, uint32_t length,
 			buffer, length, callback, argument);
 }
 
+/**
+ * Sends the explicit feedback value of the asynchronous speaker stream to
+ * the USB host. When the host has read the value, an optional callback
+ * function is invoked.
+ * \param feedback Feedback value, see audd_stream_compute_feedback().
+ * \param callback Optional callback function.
+ * \param argument Optional argument to the callback function.
+ * \return USBD_STATUS_SUCCESS if the transfer is started successfully;
+ *         otherwise an error code.
+ */
+uint8_t audd_speaker_driver_write_feedback(uint32_t feedback,
+		usbd_xfer_cb_t callback, void *argument)
+{
+	AUDDSpeakerDriver *p_audd = &audd_speaker_driver;
+	AUDDSpeakerPhone *p_audf  = &p_audd->fun;
+	return audd_stream_write_feedback(p_audf->pSpeaker, feedback,
+			callback, argument);
+}
+
 /**@}*/
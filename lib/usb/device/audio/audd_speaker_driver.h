@@ -237,6 +237,10 @@ extern uint8_t audd_speaker_driver_read(void *buffer,
 									  usbd_xfer_cb_t callback,
 									  void *argument);
 
+extern uint8_t audd_speaker_driver_write_feedback(uint32_t feedback,
+									  usbd_xfer_cb_t callback,
+									  void *argument);
+
 extern void audd_speaker_driver_mute_changed(uint8_t channel,uint8_t muted);
 
 extern void audd_speaker_driver_stream_setting_changed(uint8_t newSetting);
@@ -49,6 +49,22 @@
 #include "usb/device/audio/audd_speaker_phone.h"
 #include "usb/device/usbd_hal.h"
 
+/*------------------------------------------------------------------------------
+ *         Definitions
+ *------------------------------------------------------------------------------*/
+
+/** Get the usage type (bits 5..4) of an isochronous endpoint */
+#define AUDD_EP_USAGE(attributes)   (((attributes) >> 4) & 0x3)
+
+/** Usage type of an explicit feedback endpoint */
+#define AUDD_EP_USAGE_FEEDBACK      1
+
+/** Get the synchronization type (bits 3..2) of an isochronous endpoint */
+#define AUDD_EP_SYNC(attributes)    (((attributes) >> 2) & 0x3)
+
+/** Synchronization type of an asynchronous endpoint */
+#define AUDD_EP_SYNC_ASYNC          1
+
 /*------------------------------------------------------------------------------
  *         Types
  *------------------------------------------------------------------------------*/
@@ -60,6 +76,9 @@ typedef struct _AUDDParseData {
 
 	/** Pointer to found interface descriptor */
 	USBInterfaceDescriptor * p_if_desc;
+
+	/** Asynchronous speaker endpoint found, its feedback endpoint not yet */
+	uint8_t b_wait_feedback;
 } AUDDParseData;
 
 /** Transfer callback extention */
@@ -126,6 +145,9 @@ static uint32_t audd_speaker_phone_parse(USBGenericDescriptor *desc,
 		else if (p_arg->p_if_desc) {
 			return USBRC_PARTIAL_DONE;
 		}
+		/* The feedback endpoint belongs to the same interface as the
+		 * data endpoint, stop waiting for it */
+		p_arg->b_wait_feedback = 0;
 	}
 
 	if (p_arg->p_if_desc) {
@@ -134,7 +156,13 @@ static uint32_t audd_speaker_phone_parse(USBGenericDescriptor *desc,
 		/* Find Streaming Interface & Endpoints */
 		if (desc->bDescriptorType == USBGenericDescriptor_ENDPOINT
 			&& (pEp->bmAttributes & 0x3) == USBEndpointDescriptor_ISOCHRONOUS) {
-			if (pEp->bEndpointAddress & 0x80 && p_mic) {
+			if (AUDD_EP_USAGE(pEp->bmAttributes) == AUDD_EP_USAGE_FEEDBACK) {
+				/* Explicit feedback of the asynchronous speaker stream */
+				if (p_speaker)
+					p_speaker->bEndpointFeedback = pEp->bEndpointAddress & 0x7F;
+				p_arg->b_wait_feedback = 0;
+			}
+			else if (pEp->bEndpointAddress & 0x80 && p_mic) {
 				p_mic->bEndpointIn = pEp->bEndpointAddress & 0x7F;
 				p_mic->bAsInterface = p_arg->p_if_desc->bInterfaceNumber;
 				/* Fixed FU */
@@ -145,6 +173,10 @@ static uint32_t audd_speaker_phone_parse(USBGenericDescriptor *desc,
 				p_speaker->bAsInterface = p_arg->p_if_desc->bInterfaceNumber;
 				/* Fixed FU */
 				p_speaker->bFeatureUnitOut = AUDD_ID_SpeakerFU;
+				/* The feedback endpoint may follow the data endpoint */
+				if (AUDD_EP_SYNC(pEp->bmAttributes) == AUDD_EP_SYNC_ASYNC
+						&& p_speaker->bEndpointFeedback == 0)
+					p_arg->b_wait_feedback = 1;
 			}
 		}
 	}
@@ -153,7 +185,8 @@ static uint32_t audd_speaker_phone_parse(USBGenericDescriptor *desc,
 		if (p_speaker->bAcInterface != 0xFF &&
 				p_speaker->bAsInterface != 0xFF &&
 				p_speaker->bFeatureUnitOut != 0xFF &&
-				p_speaker->bEndpointOut != 0) {
+				p_speaker->bEndpointOut != 0 &&
+				!p_arg->b_wait_feedback) {
 			bSpeakerDone = 1;
 		}
 	} else {
@@ -337,10 +370,12 @@ void audd_stream_initialize(AUDDStream *p_auds,
 	p_auds->bAsInterface    = 0xFF;
 	p_auds->bEndpointOut    = 0;
 	p_auds->bEndpointIn     = 0;
+	p_auds->bEndpointFeedback = 0;
 
 	p_auds->bNumChannels   = num_channels;
 	p_auds->bmMute         = 0;
 	p_auds->pwVolumes      = channel_volumes;
+	p_auds->dwFeedback     = 0;
 
 	p_auds->fCallback = callback;
 	p_auds->pArg      = callback_arg;
@@ -488,6 +523,68 @@ uint32_t audd_stream_write(AUDDStream *p_auds, void* buffer, uint16_t length)
 	return usbd_hal_write(p_auds->bEndpointIn, buffer, length);
 }
 
+/**
+ * Compute the explicit feedback value of an asynchronous OUT stream.
+ * The nominal number of samples per (micro)frame is corrected according to
+ * the fill level of the buffer between the USB and the audio device: a
+ * buffer filling up asks the host to send less samples, and the other way
+ * round.
+ * \param sample_rate  Nominal sample rate of the stream in Hz.
+ * \param fill         Current fill level of the playback buffer.
+ * \param target       Fill level to converge to, same unit as \a fill.
+ * \return Feedback value in samples per (micro)frame, 16.16 format.
+ */
+uint32_t audd_stream_compute_feedback(uint32_t sample_rate,
+		int32_t fill, int32_t target)
+{
+	uint32_t frames_per_sec = usbd_is_high_speed() ? 8000 : 1000;
+	uint32_t nominal = (uint32_t)(((uint64_t)sample_rate << 16)
+			/ frames_per_sec);
+	int32_t max_adjust = nominal >> AUDD_FEEDBACK_MAX_SHIFT;
+	int32_t adjust = (target - fill) * (int32_t)(nominal >> AUDD_FEEDBACK_GAIN_SHIFT);
+
+	if (adjust > max_adjust)
+		adjust = max_adjust;
+	else if (adjust < -max_adjust)
+		adjust = -max_adjust;
+
+	return nominal + adjust;
+}
+
+/**
+ * Send a feedback value on the explicit feedback endpoint.
+ * The value is encoded in 10.14 format on 3 bytes at full speed, and in
+ * 16.16 format on 4 bytes at high speed. It is kept in the AUDDStream
+ * instance until the transfer completes.
+ * \param p_auds    Pointer to AUDDStream instance.
+ * \param feedback  Feedback value, as returned by
+ *                  audd_stream_compute_feedback().
+ * \param callback  Optional callback function invoked when the host has read
+ *                  the value, typically used to queue the next one.
+ * \param p_arg     Optional callback argument.
+ * \return USBD_STATUS_SUCCESS if the transfer is started successfully;
+ *         otherwise an error code.
+ */
+uint32_t audd_stream_write_feedback(AUDDStream *p_auds, uint32_t feedback,
+		usbd_xfer_cb_t callback, void *p_arg)
+{
+	uint32_t length;
+
+	if (p_auds->bEndpointFeedback == 0)
+		return USBRC_STATE_ERR;
+
+	if (usbd_is_high_speed()) {
+		p_auds->dwFeedback = feedback;
+		length = 4;
+	} else {
+		p_auds->dwFeedback = feedback >> 2;
+		length = 3;
+	}
+
+	return usbd_write(p_auds->bEndpointFeedback, &p_auds->dwFeedback,
+			length, callback, p_arg);
+}
+
 /**
  * Close the stream. All pending transfers are canceled.
  * \param stream Pointer to AUDDStream instance.
@@ -506,6 +603,11 @@ uint32_t audd_stream_close(AUDDStream *stream)
 		bm_eps |= 1 << stream->bEndpointOut;
 	}
 
+	/* Close feedback endpoint */
+	if (stream->bEndpointFeedback) {
+		bm_eps |= 1 << stream->bEndpointFeedback;
+	}
+
 	usbd_hal_reset_endpoints(bm_eps, USBRC_CANCELED, 1);
 
 	return USBRC_SUCCESS;
@@ -536,10 +638,12 @@ void audd_speaker_phone_initializeStream(AUDDStream *p_auds,
 	p_auds->bAsInterface    = 0xFF;
 	p_auds->bEndpointOut    = 0;
 	p_auds->bEndpointIn     = 0;
+	p_auds->bEndpointFeedback = 0;
 
 	p_auds->bNumChannels   = numChannels;
 	p_auds->bmMute         = 0;
 	p_auds->pwVolumes      = channel_volumes;
+	p_auds->dwFeedback     = 0;
 
 	p_auds->fCallback = callback;
 	p_auds->pArg      = p_arg;
@@ -572,6 +676,7 @@ const USBGenericDescriptor *audd_speaker_phone_parse_interfaces(AUDDSpeakerPhone
 
 	data.p_audf = p_audf;
 	data.p_if_desc = 0;
+	data.b_wait_feedback = 0;
 
 	return usb_generic_descriptor_parse(p_descriptors, length,
 			(USBDescriptorParseFunction)audd_speaker_phone_parse,
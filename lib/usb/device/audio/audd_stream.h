@@ -63,6 +63,13 @@
 #define AUDD_EC_VolumeChanged       2
 /**     @}*/
 
+/** Shift of the nominal feedback value giving the correction applied per
+ *  unit of fill level error (about 244 ppm) */
+#define AUDD_FEEDBACK_GAIN_SHIFT    12
+/** Shift of the nominal feedback value giving the maximum correction
+ *  (about 1.5%) */
+#define AUDD_FEEDBACK_MAX_SHIFT     6
+
 /*------------------------------------------------------------------------------
  *         Types
  *------------------------------------------------------------------------------*/
@@ -90,12 +97,16 @@ typedef struct _AUDDStream {
 	uint8_t     bEndpointOut;
 	/** Streaming IN  endpoint address */
 	uint8_t     bEndpointIn;
+	/** Explicit feedback IN endpoint address (asynchronous OUT stream) */
+	uint8_t     bEndpointFeedback;
 	/** Number of channels (<=8) */
 	uint8_t     bNumChannels;
 	/** Mute control bits  (8b) */
 	uint8_t     bmMute;
 	/** Volume control data */
 	uint16_t   *pwVolumes;
+	/** Feedback value being sent to the host */
+	uint32_t    dwFeedback;
 
 	/** Audio Streaming Events Callback */
 	AUDDStreamEventCallback fCallback;
@@ -143,6 +154,15 @@ extern uint32_t audd_stream_write(
 	AUDDStream * pAuds,
 	void * pBuffer,uint16_t wLength);
 
+extern uint32_t audd_stream_compute_feedback(
+	uint32_t sampleRate,
+	int32_t fill, int32_t target);
+
+extern uint32_t audd_stream_write_feedback(
+	AUDDStream * pAuds,
+	uint32_t feedback,
+	usbd_xfer_cb_t fCallback, void * pArg);
+
 extern uint32_t audd_stream_close(AUDDStream * pStream);
 
 #endif /* _AUDD_STREAM_H_ */
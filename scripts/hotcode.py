@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+# ----------------------------------------------------------------------------
+#         SAM Software Package License
+# ----------------------------------------------------------------------------
+# Copyright (c) 2019, Atmel Corporation
+#
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# - Redistributions of source code must retain the above copyright notice,
+# this list of conditions and the disclaimer below.
+#
+# Atmel's name may not be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+# IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+# DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+# INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+# OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+# LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+# EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+# ----------------------------------------------------------------------------
+
+"""Rank the functions of a program by PC samples to choose the HOTCODE
+functions (see drivers/mm/hotcode.h).
+
+Usage: hotcode.py [--nm NM] [--budget BYTES] ELF SAMPLES
+
+SAMPLES is a text file with one sampled program counter per line, in
+hexadecimal, as produced by the PC sampling of a debug probe or by a
+periodic interrupt logging its return address. Only the samples in the
+QSPI execution window are counted by default.
+
+The functions are listed by decreasing number of samples with their size,
+until the cumulated size reaches the budget (the room left in DDR or SRAM
+for the copy). Mark the listed functions with HOTCODE and rebuild with
+CONFIG_HOTCODE=y.
+"""
+
+import argparse
+import bisect
+import subprocess
+import sys
+
+# SAMA5D2 QSPI0/QSPI1 (plain and AESB mappings), SAM9X60 QSPI
+QSPI_WINDOWS = ((0xD0000000, 0xE0000000), (0x90000000, 0xA0000000),
+                (0x70000000, 0x80000000))
+
+
+def read_symbols(nm, elf):
+    out = subprocess.run([nm, "-S", "-n", "-C", "--defined-only", elf],
+                         check=True, stdout=subprocess.PIPE,
+                         universal_newlines=True).stdout
+    symbols = []
+    for line in out.splitlines():
+        fields = line.split(None, 3)
+        if len(fields) != 4 or fields[2] not in "tTwW":
+            continue
+        addr = int(fields[0], 16) & ~1
+        size = int(fields[1], 16)
+        if size:
+            symbols.append((addr, size, fields[3]))
+    return symbols
+
+
+def read_samples(path, all_pcs):
+    samples = []
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if not line or line.startswith("#"):
+                continue
+            pc = int(line.split()[0], 16)
+            if all_pcs or any(lo <= pc < hi for lo, hi in QSPI_WINDOWS):
+                samples.append(pc)
+    return samples
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--nm", default="arm-none-eabi-nm")
+    parser.add_argument("--budget", type=int, default=16384,
+                        help="bytes available for the copied functions")
+    parser.add_argument("--all", action="store_true",
+                        help="count samples outside the QSPI window too")
+    parser.add_argument("elf")
+    parser.add_argument("samples")
+    args = parser.parse_args()
+
+    symbols = read_symbols(args.nm, args.elf)
+    starts = [s[0] for s in symbols]
+    samples = read_samples(args.samples, args.all)
+    if not samples:
+        sys.exit("no sample in the QSPI window")
+
+    hits = {}
+    unknown = 0
+    for pc in samples:
+        i = bisect.bisect_right(starts, pc) - 1
+        if i >= 0 and pc < symbols[i][0] + symbols[i][1]:
+            hits[i] = hits.get(i, 0) + 1
+        else:
+            unknown += 1
+
+    total = len(samples)
+    used = 0
+    covered = 0
+    print("%8s %6s %7s  %s" % ("samples", "%", "size", "function"))
+    for i, count in sorted(hits.items(), key=lambda h: -h[1]):
+        size = symbols[i][1]
+        if used + size > args.budget:
+            continue
+        used += size
+        covered += count
+        print("%8d %6.2f %7d  %s" % (count, 100.0 * count / total, size,
+                                      symbols[i][2]))
+    print("%d of %d samples (%.1f%%) in %d bytes, %d outside known functions"
+          % (covered, total, 100.0 * covered / total, used, unknown),
+          file=sys.stderr)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,154 @@
+#!/usr/bin/env python3
+# ----------------------------------------------------------------------------
+#         SAM Software Package License
+# ----------------------------------------------------------------------------
+# Copyright (c) 2019, Atmel Corporation
+#
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# - Redistributions of source code must retain the above copyright notice,
+# this list of conditions and the disclaimer below.
+#
+# Atmel's name may not be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+# IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+# DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+# INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+# OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+# LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+# EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+# ----------------------------------------------------------------------------
+
+"""Show the interrupt dispatch/duration histograms and the longest critical
+sections printed by irq_trace_dump() (see drivers/irq/irq_trace.h).
+
+Usage: irq_trace.py [--nm NM] [--elf ELF] [LOG]
+
+LOG is a console capture (standard input by default), the lines not
+starting with "IRQT" are ignored and the last dump is used. Cycle counts
+are converted to microseconds with the processor clock of the dump. With
+--elf, the critical section addresses are resolved to function names.
+"""
+
+import argparse
+import bisect
+import subprocess
+import sys
+
+BUCKETS = 16
+BAR = 40
+
+
+def read_symbols(nm, elf):
+    out = subprocess.run([nm, "-S", "-n", "-C", "--defined-only", elf],
+                         check=True, stdout=subprocess.PIPE,
+                         universal_newlines=True).stdout
+    symbols = []
+    for line in out.splitlines():
+        fields = line.split(None, 3)
+        if len(fields) != 4 or fields[2] not in "tTwW":
+            continue
+        addr = int(fields[0], 16) & ~1
+        size = int(fields[1], 16)
+        if size:
+            symbols.append((addr, size, fields[3]))
+    return symbols
+
+
+def read_dump(f):
+    dump = None
+    for line in f:
+        fields = line.split()
+        if not fields or fields[0] != "IRQT":
+            continue
+        kind, values = fields[1], fields[2:]
+        if kind == "clock":
+            dump = {"clock": int(values[0]), "sources": {}, "masks": []}
+        elif dump is None:
+            continue
+        elif kind == "src":
+            src = dump["sources"].setdefault(int(values[0]), {})
+            src["count"], src["nested"], src["max_dsp"], src["max_dur"] = \
+                [int(v) for v in values[1:5]]
+        elif kind in ("dsp", "dur"):
+            src = dump["sources"].setdefault(int(values[0]), {})
+            src[kind] = [int(v) for v in values[1:1 + BUCKETS]]
+        elif kind == "mask":
+            dump["masks"].append((int(values[0], 16), int(values[1])))
+    return dump
+
+
+def bucket_label(i, clock):
+    lo = 0 if i == 0 else 1 << (i + 4)
+    if i == BUCKETS - 1:
+        return ">= %s" % us(lo, clock)
+    return "<  %s" % us(1 << (i + 5), clock)
+
+
+def us(cycles, clock):
+    return "%.2fus" % (cycles * 1e6 / clock) if clock else "%dcy" % cycles
+
+
+def print_histogram(title, hist, clock):
+    total = sum(hist)
+    if not total:
+        return
+    print("  %s" % title)
+    peak = max(hist)
+    last = max(i for i, n in enumerate(hist) if n)
+    first = min(i for i, n in enumerate(hist) if n)
+    for i in range(first, last + 1):
+        bar = "#" * ((hist[i] * BAR + peak - 1) // peak)
+        print("    %-12s %8d %6.2f%% %s" % (bucket_label(i, clock), hist[i],
+                                          100.0 * hist[i] / total, bar))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--nm", default="arm-none-eabi-nm")
+    parser.add_argument("--elf", help="program to resolve the addresses")
+    parser.add_argument("log", nargs="?")
+    args = parser.parse_args()
+
+    if args.log:
+        with open(args.log) as f:
+            dump = read_dump(f)
+    else:
+        dump = read_dump(sys.stdin)
+    if not dump:
+        sys.exit("no irq trace dump found")
+
+    clock = dump["clock"]
+    for source in sorted(dump["sources"]):
+        src = dump["sources"][source]
+        print("source %d: %d interrupts, %d nested, max dispatch %s, "
+              "max duration %s" % (source, src.get("count", 0),
+                                   src.get("nested", 0),
+                                   us(src.get("max_dsp", 0), clock),
+                                   us(src.get("max_dur", 0), clock)))
+        print_histogram("dispatch", src.get("dsp", [0] * BUCKETS), clock)
+        print_histogram("duration", src.get("dur", [0] * BUCKETS), clock)
+
+    if not dump["masks"]:
+        return
+    symbols = read_symbols(args.nm, args.elf) if args.elf else []
+    starts = [s[0] for s in symbols]
+    print("longest critical sections:")
+    for pc, cycles in dump["masks"]:
+        name = ""
+        i = bisect.bisect_right(starts, pc) - 1
+        if i >= 0 and pc < symbols[i][0] + symbols[i][1]:
+            name = "%s+0x%x" % (symbols[i][2], pc - symbols[i][0])
+        print("  0x%08x %10s  %s" % (pc, us(cycles, clock), name))
+
+
+if __name__ == "__main__":
+    main()
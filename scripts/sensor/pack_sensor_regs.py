@@ -0,0 +1,150 @@
+#!/usr/bin/env python3
+# ----------------------------------------------------------------------------
+#         SAM Software Package License
+# ----------------------------------------------------------------------------
+# Copyright (c) 2019, Atmel Corporation
+#
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# - Redistributions of source code must retain the above copyright notice,
+# this list of conditions and the disclaimer below.
+#
+# Atmel's name may not be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+# IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+# DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+# INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+# OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+# LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+# EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+# ----------------------------------------------------------------------------
+
+"""Convert the {reg, val} tables of a sensor configuration file to the packed
+format read by sensor_write_packed() (see drivers/video/image_sensor_inf.h).
+
+Usage: pack_sensor_regs.py [--reg-bytes N] [--val-bytes N] [--burst N] FILE
+
+The packed arrays are written to stdout, one per sensor_reg table found in
+FILE, named <table>_packed. A summary of the number of bus transactions and
+of the table sizes before and after packing is written to stderr.
+"""
+
+import argparse
+import re
+import sys
+
+REG_TERM = 0xFF
+VAL_TERM = 0xFF
+REG_DELAY = 0xFFFF
+
+PACK_END = 0x00
+PACK_DELAY = 0x80
+PACK_DELTA = 0x80
+PACK_MAX_COUNT = 0x7F
+
+TABLE_RE = re.compile(
+    r"static\s+const\s+struct\s+sensor_reg\s+(\w+)\s*\[\s*\]\s*=\s*\{(.*?)\};",
+    re.S)
+ENTRY_RE = re.compile(r"\{\s*(0[xX][0-9a-fA-F]+|\d+)\s*,\s*(0[xX][0-9a-fA-F]+|\d+)\s*\}")
+
+
+def parse_tables(text):
+    for match in TABLE_RE.finditer(text):
+        body = re.sub(r"/\*.*?\*/|//[^\n]*", "", match.group(2), flags=re.S)
+        entries = []
+        for reg, val in ENTRY_RE.findall(body):
+            reg, val = int(reg, 0), int(val, 0)
+            if reg == REG_TERM and val == VAL_TERM:
+                break
+            entries.append((reg, val))
+        yield match.group(1), entries
+
+
+def split_runs(entries):
+    """Group entries in runs of consecutive registers, keeping delays."""
+    runs = []
+    for reg, val in entries:
+        if reg == REG_DELAY:
+            runs.append(("delay", val))
+            continue
+        if runs and runs[-1][0] == "run":
+            first, values = runs[-1][1], runs[-1][2]
+            if reg == first + len(values) and len(values) < PACK_MAX_COUNT:
+                values.append(val)
+                continue
+        runs.append(("run", reg, [val]))
+    return runs
+
+
+def pack(runs, reg_bytes, val_bytes):
+    out = []
+    next_reg = None
+    for run in runs:
+        if run[0] == "delay":
+            delay = run[1]
+            while delay > 0:
+                out += [PACK_DELAY, min(delay, 255)]
+                delay -= 255
+            continue
+        _, reg, values = run
+        delta = reg - next_reg if next_reg is not None else -1
+        if 0 <= delta <= 0xFF:
+            out += [PACK_DELTA | len(values), delta]
+        else:
+            out.append(len(values))
+            out += [(reg >> (8 * i)) & 0xFF for i in reversed(range(reg_bytes))]
+        for val in values:
+            # values are sent in memory order, as sensor_twi_write_reg() does
+            out += [(val >> (8 * i)) & 0xFF for i in range(val_bytes)]
+        next_reg = reg + len(values)
+    out.append(PACK_END)
+    return out
+
+
+def count_transactions(runs, burst):
+    count = 0
+    for run in runs:
+        if run[0] == "run":
+            size = len(run[2])
+            count += (size + burst - 1) // burst if burst > 1 else size
+    return count
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--reg-bytes", type=int, default=2, choices=(1, 2))
+    parser.add_argument("--val-bytes", type=int, default=1, choices=(1, 2))
+    parser.add_argument("--burst", type=int, default=64,
+                        help="registers per burst write on the target (SENSOR_MAX_BURST)")
+    parser.add_argument("file")
+    args = parser.parse_args()
+
+    with open(args.file) as f:
+        text = f.read()
+
+    entry_size = 4  # sizeof(struct sensor_reg)
+    for name, entries in parse_tables(text):
+        writes = sum(1 for reg, _ in entries if reg != REG_DELAY)
+        runs = split_runs(entries)
+        data = pack(runs, args.reg_bytes, args.val_bytes)
+
+        print("static const uint8_t %s_packed[] = {" % name)
+        for i in range(0, len(data), 12):
+            print("\t" + " ".join("0x%02x," % b for b in data[i:i + 12]))
+        print("};\n")
+
+        sys.stderr.write("%-24s %5d writes -> %5d transactions, %6d -> %5d bytes\n" % (
+            name, writes, count_transactions(runs, args.burst),
+            (len(entries) + 1) * entry_size, len(data)))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,178 @@
+#!/usr/bin/env python3
+# ----------------------------------------------------------------------------
+#         SAM Software Package License
+# ----------------------------------------------------------------------------
+# Copyright (c) 2019, Atmel Corporation
+#
+# All rights reserved.
+#
+# Redistribution and use in source and binary forms, with or without
+# modification, are permitted provided that the following conditions are met:
+#
+# - Redistributions of source code must retain the above copyright notice,
+# this list of conditions and the disclaimer below.
+#
+# Atmel's name may not be used to endorse or promote products derived from
+# this software without specific prior written permission.
+#
+# DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+# IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+# MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+# DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+# INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+# LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+# OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+# LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+# NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+# EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+# ----------------------------------------------------------------------------
+
+"""Decode the binary traces emitted by a program built with
+CONFIG_TRACE_BINARY=y (see utils/trace.h).
+
+Usage: trace_decode.py ELF [LOG]
+
+LOG is the raw console capture (stdin by default). Text output is passed
+through unchanged; each binary frame is expanded using the format string
+found at the recorded address in the ELF file.
+
+Frame layout: 0xFF 0xA5 LEN PAYLOAD[LEN] SUM, where SUM is the 8-bit sum
+of the payload. The payload holds the format string address (32-bit),
+the millisecond tick (32-bit) and the arguments: 32-bit integers, 64-bit
+for "ll"/"j" integers and floating point, length-prefixed strings.
+"""
+
+import re
+import struct
+import sys
+
+SYNC = b"\xff\xa5"
+
+CONV = re.compile(r"%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d+))?([hlLjzt]*)([diouxXcpeEfFgGaAsn%])")
+
+
+class Elf32:
+    """Minimal ELF32 little-endian reader returning strings by address"""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = f.read()
+        if self.data[:4] != b"\x7fELF" or self.data[4] != 1:
+            raise ValueError("%s: not an ELF32 file" % path)
+        shoff, = struct.unpack_from("<I", self.data, 0x20)
+        shentsize, shnum = struct.unpack_from("<HH", self.data, 0x2e)
+        self.sections = []
+        for i in range(shnum):
+            (_, stype, _, addr, off, size) = struct.unpack_from(
+                "<IIIIII", self.data, shoff + i * shentsize)
+            # SHT_PROGBITS only, NOBITS sections have no file content
+            if stype == 1 and addr:
+                self.sections.append((addr, off, size))
+
+    def string(self, addr):
+        for (base, off, size) in self.sections:
+            if base <= addr < base + size:
+                start = off + addr - base
+                end = self.data.index(b"\0", start)
+                return self.data[start:end].decode("latin-1")
+        return None
+
+
+def _format(fmt, args):
+    """Expand fmt with the payload args, returns the text"""
+    out = []
+    pos = 0
+    for m in CONV.finditer(fmt):
+        out.append(fmt[pos:m.start()])
+        pos = m.end()
+        flags, width, prec, length, conv = m.groups()
+        if conv == "%":
+            out.append("%")
+            continue
+        if width == "*":
+            width = str(_take(args, "<i"))
+        if prec == "*":
+            prec = str(_take(args, "<i"))
+        spec = "%" + flags + (width or "") + ("." + prec if prec else "")
+        if conv == "n":
+            continue
+        if conv == "s":
+            n = _take(args, "<B")
+            text = bytes(args[:n]).decode("latin-1")
+            del args[:n]
+            out.append((spec + "s") % text)
+        elif conv in "eEfFgGaA":
+            val = _take(args, "<d")
+            out.append((spec + ("e" if conv in "aA" else conv)) % val)
+        else:
+            wide = length.count("l") + length.count("L") > 1 or "j" in length
+            signed = conv in "di"
+            val = _take(args, ("<q" if signed else "<Q") if wide
+                        else ("<i" if signed else "<I"))
+            if conv == "c":
+                out.append((spec + "c") % chr(val & 0xff))
+            elif conv == "p":
+                out.append("0x%08x" % val)
+            else:
+                out.append((spec + conv.replace("u", "d")) % val)
+    out.append(fmt[pos:])
+    return "".join(out)
+
+
+def _take(args, fmt):
+    size = struct.calcsize(fmt)
+    if len(args) < size:
+        raise IndexError("truncated")
+    val, = struct.unpack(fmt, bytes(args[:size]))
+    del args[:size]
+    return val
+
+
+def decode(elf, data, write):
+    pos = 0
+    while pos < len(data):
+        idx = data.find(SYNC, pos)
+        if idx < 0 or idx + 3 > len(data):
+            write(data[pos:].decode("latin-1"))
+            return
+        write(data[pos:idx].decode("latin-1"))
+        length = data[idx + 2]
+        end = idx + 3 + length
+        payload = data[idx + 3:end]
+        if end >= len(data) or length < 8 or (sum(payload) & 0xff) != data[end]:
+            # not a valid frame, emit the sync byte as text and resync
+            write(data[idx:idx + 1].decode("latin-1"))
+            pos = idx + 1
+            continue
+        addr, tick = struct.unpack_from("<II", payload)
+        fmt = elf.string(addr)
+        if fmt is None:
+            write("[%10u] <unknown format 0x%08x>\n" % (tick, addr))
+        else:
+            args = bytearray(payload[8:])
+            try:
+                text = _format(fmt, args)
+            except (IndexError, ValueError, TypeError):
+                text = fmt + " <truncated>"
+                if not text.endswith("\n"):
+                    text += "\n"
+            write("[%10u] %s" % (tick, text))
+        pos = end + 1
+
+
+def main(argv):
+    if len(argv) not in (2, 3):
+        sys.stderr.write(__doc__)
+        return 1
+    elf = Elf32(argv[1])
+    if len(argv) == 3:
+        with open(argv[2], "rb") as f:
+            data = f.read()
+    else:
+        data = sys.stdin.buffer.read()
+    decode(elf, data, sys.stdout.write)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,97 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef _AES_SOFT_H_
+#define _AES_SOFT_H_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/** Expanded AES encryption key */
+struct _aes_soft_key {
+	uint32_t rk[60];   /**< Round keys */
+	uint8_t  rounds;   /**< 10, 12 or 14 */
+};
+
+/** GHASH multiplication table (4-bit, 256 bytes) */
+struct _aes_soft_ghash {
+	uint64_t hl[16];
+	uint64_t hh[16];
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/*
+ * Software AES forward cipher and GHASH, as needed by the CTR and GCM
+ * modes. They are used when no AES peripheral is available and run on the
+ * host, so that the hardware results can be checked against them.
+ */
+
+/**
+ * \brief Expand an AES key for encryption.
+ * \param ctx      Expanded key.
+ * \param key      Key.
+ * \param key_len  Key length in bytes: 16, 24 or 32.
+ * \return 0 on success, -EINVAL on invalid key length.
+ */
+extern int aes_soft_set_key(struct _aes_soft_key *ctx, const uint8_t *key,
+		uint8_t key_len);
+
+/**
+ * \brief Encrypt one 16-byte block.
+ */
+extern void aes_soft_encrypt(const struct _aes_soft_key *ctx,
+		const uint8_t *in, uint8_t *out);
+
+/**
+ * \brief Compute the GHASH table for the hash subkey H = E(K, 0^128).
+ */
+extern void aes_soft_ghash_init(struct _aes_soft_ghash *ghash,
+		const uint8_t *h);
+
+/**
+ * \brief Absorb 16-byte blocks in a GHASH state: state = (state ^ X) * H.
+ * \param ghash   GHASH table.
+ * \param state   GHASH state, 16 bytes.
+ * \param data    Blocks.
+ * \param blocks  Number of blocks.
+ */
+extern void aes_soft_ghash(const struct _aes_soft_ghash *ghash,
+		uint8_t *state, const uint8_t *data, uint32_t blocks);
+
+#endif /* _AES_SOFT_H_ */
@@ -0,0 +1,278 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/** \file
+ *
+ * Fixed-point polyphase asynchronous sample-rate converter.
+ *
+ * Each output frame is computed by a 16-tap windowed-sinc filter whose
+ * branch is picked from the fractional position of the output frame between
+ * two input frames. The outputs of the two nearest branches are linearly
+ * interpolated, giving an effective resolution well below 1/32 sample.
+ *
+ * The step between two output frames is a Q8.24 number, which gives a ratio
+ * resolution of about 0.06 ppm; it is slowly corrected by a PI controller
+ * driven by the fill level of the buffer that follows the converter.
+ *
+ * This module only depends on the C library so it can also be built and
+ * profiled on a host.
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <string.h>
+
+#include "asrc.h"
+#include "errno.h"
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Number of polyphase branches */
+#define ASRC_PHASES (1 << ASRC_PHASE_BITS)
+
+/** Position/step value for one input frame */
+#define ASRC_ONE (1u << ASRC_FRAC_BITS)
+
+/** Proportional gain of the fill level controller, as a shift of the
+ * nominal step (about 61 ppm per unit of fill error) */
+#define ASRC_KP_SHIFT 14
+
+/** Integral gain of the fill level controller, as a shift of the nominal
+ * step (about 1 ppm per unit of accumulated fill error) */
+#define ASRC_KI_SHIFT 20
+
+/** Anti-windup limit of the integral term */
+#define ASRC_INTEGRAL_MAX 1024
+
+/** Maximum correction, as a shift of the nominal step (about 2000 ppm) */
+#define ASRC_MAX_ADJUST_SHIFT 9
+
+/*----------------------------------------------------------------------------
+ *        Local constants
+ *----------------------------------------------------------------------------*/
+
+/**
+ * Polyphase filter bank, Q15.
+ * Kaiser-windowed sinc (beta = 7), cut-off at 0.45 fs, each branch
+ * normalized to unity DC gain. Branch p delays the signal by p/32 sample;
+ * the extra last branch is used for interpolation only.
+ */
+static const int16_t _asrc_coefs[ASRC_PHASES + 1][ASRC_TAPS] = {
+	{ 48, -192, 511, -1047, 1755, -2496, 3063, 29486, 3063, -2496, 1755, -1047, 511, -192, 48, -5 },
+	{ 49, -191, 496, -990, 1603, -2135, 2145, 29446, 4021, -2852, 1900, -1097, 523, -192, 47, -4 },
+	{ 49, -187, 478, -928, 1443, -1773, 1270, 29327, 5015, -3200, 2034, -1139, 530, -190, 45, -4 },
+	{ 48, -183, 456, -861, 1278, -1412, 440, 29129, 6042, -3538, 2157, -1174, 533, -186, 43, -4 },
+	{ 47, -177, 432, -790, 1110, -1056, -341, 28853, 7097, -3862, 2268, -1201, 532, -180, 39, -3 },
+	{ 46, -170, 405, -716, 940, -706, -1073, 28501, 8178, -4169, 2363, -1219, 526, -173, 36, -2 },
+	{ 44, -162, 376, -639, 768, -365, -1752, 28074, 9278, -4455, 2443, -1226, 514, -163, 31, -1 },
+	{ 42, -152, 346, -560, 598, -36, -2378, 27575, 10395, -4718, 2506, -1224, 498, -150, 26, 0 },
+	{ 40, -143, 314, -480, 429, 280, -2949, 27006, 11523, -4954, 2550, -1211, 477, -136, 20, 1 },
+	{ 38, -132, 281, -400, 264, 581, -3464, 26370, 12657, -5160, 2575, -1188, 450, -119, 13, 3 },
+	{ 35, -121, 248, -320, 104, 864, -3924, 25670, 13792, -5333, 2579, -1153, 418, -101, 5, 4 },
+	{ 32, -110, 214, -241, -51, 1129, -4328, 24910, 14923, -5471, 2562, -1107, 381, -80, -3, 6 },
+	{ 30, -98, 181, -163, -199, 1374, -4676, 24093, 16045, -5569, 2523, -1049, 338, -57, -12, 8 },
+	{ 27, -87, 147, -88, -339, 1597, -4968, 23223, 17154, -5626, 2461, -980, 290, -33, -21, 11 },
+	{ 24, -75, 115, -16, -471, 1799, -5206, 22305, 18243, -5639, 2375, -900, 238, -6, -31, 13 },
+	{ 21, -64, 83, 54, -594, 1978, -5391, 21344, 19307, -5605, 2266, -809, 181, 22, -41, 16 },
+	{ 18, -52, 52, 119, -706, 2134, -5523, 20343, 20343, -5523, 2134, -706, 119, 52, -52, 18 },
+	{ 16, -41, 22, 181, -809, 2266, -5605, 19307, 21344, -5391, 1978, -594, 54, 83, -64, 21 },
+	{ 13, -31, -6, 238, -900, 2375, -5639, 18243, 22305, -5206, 1799, -471, -16, 115, -75, 24 },
+	{ 11, -21, -33, 290, -980, 2461, -5626, 17154, 23223, -4968, 1597, -339, -88, 147, -87, 27 },
+	{ 8, -12, -57, 338, -1049, 2523, -5569, 16045, 24093, -4676, 1374, -199, -163, 181, -98, 30 },
+	{ 6, -3, -80, 381, -1107, 2562, -5471, 14923, 24910, -4328, 1129, -51, -241, 214, -110, 32 },
+	{ 4, 5, -101, 418, -1153, 2579, -5333, 13792, 25670, -3924, 864, 104, -320, 248, -121, 35 },
+	{ 3, 13, -119, 450, -1188, 2575, -5160, 12657, 26370, -3464, 581, 264, -400, 281, -132, 38 },
+	{ 1, 20, -136, 477, -1211, 2550, -4954, 11523, 27006, -2949, 280, 429, -480, 314, -143, 40 },
+	{ 0, 26, -150, 498, -1224, 2506, -4718, 10395, 27575, -2378, -36, 598, -560, 346, -152, 42 },
+	{ -1, 31, -163, 514, -1226, 2443, -4455, 9278, 28074, -1752, -365, 768, -639, 376, -162, 44 },
+	{ -2, 36, -173, 526, -1219, 2363, -4169, 8178, 28501, -1073, -706, 940, -716, 405, -170, 46 },
+	{ -3, 39, -180, 532, -1201, 2268, -3862, 7097, 28853, -341, -1056, 1110, -790, 432, -177, 47 },
+	{ -4, 43, -186, 533, -1174, 2157, -3538, 6042, 29129, 440, -1412, 1278, -861, 456, -183, 48 },
+	{ -4, 45, -190, 530, -1139, 2034, -3200, 5015, 29327, 1270, -1773, 1443, -928, 478, -187, 49 },
+	{ -4, 47, -192, 523, -1097, 1900, -2852, 4021, 29446, 2145, -2135, 1603, -990, 496, -191, 49 },
+	{ -5, 48, -192, 511, -1047, 1755, -2496, 3063, 29486, 3063, -2496, 1755, -1047, 511, -192, 48 },
+};
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static inline int16_t _saturate_s16(int32_t value)
+{
+	if (value > INT16_MAX)
+		return INT16_MAX;
+	if (value < INT16_MIN)
+		return INT16_MIN;
+	return (int16_t)value;
+}
+
+/**
+ * \brief Push one interleaved input frame into the per-channel histories.
+ */
+static void _asrc_push(struct _asrc *asrc, const int16_t *frame)
+{
+	uint8_t ch;
+
+	for (ch = 0; ch < asrc->channels; ch++) {
+		asrc->history[ch][asrc->head] = frame[ch];
+		asrc->history[ch][asrc->head + ASRC_TAPS] = frame[ch];
+	}
+	asrc->head = (asrc->head + 1) % ASRC_TAPS;
+}
+
+/**
+ * \brief Compute one output sample.
+ * \param x   Oldest of the ASRC_TAPS input samples
+ * \param h0  Filter branch just before the output position
+ * \param h1  Filter branch just after the output position
+ * \param mu  Position between the two branches (Q16)
+ */
+static int16_t _asrc_filter(const int16_t *x, const int16_t *h0,
+		const int16_t *h1, uint32_t mu)
+{
+	int32_t acc0 = 0, acc1 = 0;
+	int i;
+
+	/* The absolute sum of each branch is below 2.0 so 32-bit
+	 * accumulators cannot overflow */
+	for (i = 0; i < ASRC_TAPS; i++) {
+		acc0 += h0[i] * x[i];
+		acc1 += h1[i] * x[i];
+	}
+	acc0 >>= 15;
+	acc1 >>= 15;
+	acc0 += (int32_t)(((int64_t)(acc1 - acc0) * mu) >> 16);
+
+	return _saturate_s16(acc0);
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+int asrc_init(struct _asrc *asrc, uint8_t channels,
+		uint32_t in_rate, uint32_t out_rate)
+{
+	uint64_t step;
+
+	if (channels == 0 || channels > ASRC_MAX_CHANNELS)
+		return -EINVAL;
+	if (in_rate == 0 || out_rate == 0)
+		return -EINVAL;
+
+	/* Ratios above 2 would need a lower cut-off frequency */
+	step = ((uint64_t)in_rate << ASRC_FRAC_BITS) / out_rate;
+	if (step == 0 || step > 2 * ASRC_ONE)
+		return -EINVAL;
+
+	asrc->channels = channels;
+	asrc->nominal = (uint32_t)step;
+	asrc_reset(asrc);
+
+	return 0;
+}
+
+void asrc_reset(struct _asrc *asrc)
+{
+	memset(asrc->history, 0, sizeof(asrc->history));
+	asrc->head = 0;
+	asrc->pos = 0;
+	asrc->step = asrc->nominal;
+	asrc->integral = 0;
+}
+
+void asrc_track_fill(struct _asrc *asrc, int32_t fill, int32_t target)
+{
+	int32_t error = fill - target;
+	int32_t max_adjust = asrc->nominal >> ASRC_MAX_ADJUST_SHIFT;
+	int32_t adjust;
+
+	asrc->integral += error;
+	if (asrc->integral > ASRC_INTEGRAL_MAX)
+		asrc->integral = ASRC_INTEGRAL_MAX;
+	else if (asrc->integral < -ASRC_INTEGRAL_MAX)
+		asrc->integral = -ASRC_INTEGRAL_MAX;
+
+	adjust = error * (int32_t)(asrc->nominal >> ASRC_KP_SHIFT)
+	       + asrc->integral * (int32_t)(asrc->nominal >> ASRC_KI_SHIFT);
+	if (adjust > max_adjust)
+		adjust = max_adjust;
+	else if (adjust < -max_adjust)
+		adjust = -max_adjust;
+
+	asrc->step = asrc->nominal + adjust;
+}
+
+int32_t asrc_get_ppm(const struct _asrc *asrc)
+{
+	int64_t delta = (int64_t)asrc->step - (int64_t)asrc->nominal;
+
+	return (int32_t)((delta * 1000000) / asrc->nominal);
+}
+
+uint32_t asrc_process(struct _asrc *asrc,
+		const int16_t *in, uint32_t in_frames, uint32_t *consumed,
+		int16_t *out, uint32_t out_frames)
+{
+	uint32_t n_in = 0, n_out = 0;
+	uint32_t phase, mu;
+	uint8_t ch;
+
+	while (n_out < out_frames) {
+		/* Feed the input frames preceding the output position */
+		while (asrc->pos >= ASRC_ONE) {
+			if (n_in == in_frames)
+				goto exit;
+			_asrc_push(asrc, in);
+			in += asrc->channels;
+			n_in++;
+			asrc->pos -= ASRC_ONE;
+		}
+
+		phase = asrc->pos >> (ASRC_FRAC_BITS - ASRC_PHASE_BITS);
+		mu = (asrc->pos >> (ASRC_FRAC_BITS - ASRC_PHASE_BITS - 16)) & 0xffff;
+
+		for (ch = 0; ch < asrc->channels; ch++)
+			*out++ = _asrc_filter(&asrc->history[ch][asrc->head],
+					_asrc_coefs[phase], _asrc_coefs[phase + 1], mu);
+
+		n_out++;
+		asrc->pos += asrc->step;
+	}
+
+exit:
+	if (consumed)
+		*consumed = n_in;
+	return n_out;
+}
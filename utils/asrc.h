@@ -0,0 +1,145 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef _ASRC_H_
+#define _ASRC_H_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Maximum number of interleaved channels handled by one converter */
+#define ASRC_MAX_CHANNELS 8
+
+/** Number of filter taps per polyphase branch */
+#define ASRC_TAPS 16
+
+/** Number of polyphase branches (log2) */
+#define ASRC_PHASE_BITS 5
+
+/** Number of fractional bits of the resampling step and position */
+#define ASRC_FRAC_BITS 24
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/**
+ * Asynchronous sample-rate converter state.
+ *
+ * The converter works on interleaved signed 16-bit PCM frames. It is meant
+ * to absorb the drift between two nominally identical clocks (USB SOF and
+ * codec clock for example), so the conversion ratio is expected to stay
+ * close to the ratio of the nominal rates.
+ */
+struct _asrc {
+	/** Number of interleaved channels */
+	uint8_t channels;
+	/** Write index in the history buffers */
+	uint8_t head;
+	/** Nominal step, input frames per output frame (Q8.24) */
+	uint32_t nominal;
+	/** Current step, nominal step plus drift correction (Q8.24) */
+	uint32_t step;
+	/** Position of the next output frame relative to the history (Q8.24) */
+	uint32_t pos;
+	/** Integral term of the fill level controller */
+	int32_t integral;
+	/** Input history, duplicated to avoid wrapping in the filter loop */
+	int16_t history[ASRC_MAX_CHANNELS][2 * ASRC_TAPS];
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initialize a converter for the given nominal rates.
+ * \param asrc      Pointer to the converter state
+ * \param channels  Number of interleaved channels (1..ASRC_MAX_CHANNELS)
+ * \param in_rate   Nominal input sample rate in Hz
+ * \param out_rate  Nominal output sample rate in Hz
+ * \return 0 on success, -EINVAL if a parameter is out of range
+ */
+extern int asrc_init(struct _asrc *asrc, uint8_t channels,
+		uint32_t in_rate, uint32_t out_rate);
+
+/**
+ * \brief Clear the history and the drift correction, keeping the rates.
+ * \param asrc  Pointer to the converter state
+ */
+extern void asrc_reset(struct _asrc *asrc);
+
+/**
+ * \brief Update the conversion ratio from the fill level of the buffer that
+ * sits after (playback) the converter.
+ *
+ * Call once per received packet. A fill level above the target means the
+ * producer is faster than the consumer, the converter then consumes more
+ * input frames per output frame, and the other way round.
+ *
+ * \param asrc    Pointer to the converter state
+ * \param fill    Current fill level, in frames or in packets
+ * \param target  Fill level to converge to, same unit as \a fill
+ */
+extern void asrc_track_fill(struct _asrc *asrc, int32_t fill, int32_t target);
+
+/**
+ * \brief Get the current drift correction.
+ * \param asrc  Pointer to the converter state
+ * \return Deviation of the current ratio from the nominal one, in ppm
+ */
+extern int32_t asrc_get_ppm(const struct _asrc *asrc);
+
+/**
+ * \brief Convert a block of interleaved frames.
+ *
+ * Conversion stops when either all input frames have been consumed or the
+ * output buffer is full. Input frames that were not consumed must be passed
+ * again on the next call.
+ *
+ * \param asrc        Pointer to the converter state
+ * \param in          Input frames
+ * \param in_frames   Number of input frames
+ * \param consumed    Returns the number of input frames consumed (optional)
+ * \param out         Output frames
+ * \param out_frames  Capacity of the output buffer, in frames
+ * \return Number of output frames written
+ */
+extern uint32_t asrc_process(struct _asrc *asrc,
+		const int16_t *in, uint32_t in_frames, uint32_t *consumed,
+		int16_t *out, uint32_t out_frames);
+
+#endif /* _ASRC_H_ */
@@ -113,4 +113,10 @@
 	#define RAMDATA
 #endif
 
+#ifdef CONFIG_HOTCODE
+	#define HOTCODE SECTION(".hotcode")
+#else
+	#define HOTCODE
+#endif
+
 #endif /* _COMPILER_H_ */
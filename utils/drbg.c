@@ -0,0 +1,181 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <string.h>
+
+#include "drbg.h"
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+#define ROTL32(x, n) (((x) << (n)) | ((x) >> (32 - (n))))
+
+#define QUARTER_ROUND(a, b, c, d) do { \
+		a += b; d ^= a; d = ROTL32(d, 16); \
+		c += d; b ^= c; b = ROTL32(b, 12); \
+		a += b; d ^= a; d = ROTL32(d, 8); \
+		c += d; b ^= c; b = ROTL32(b, 7); \
+	} while (0)
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static void _store_le32(uint8_t* p, uint32_t v)
+{
+	p[0] = (uint8_t)v;
+	p[1] = (uint8_t)(v >> 8);
+	p[2] = (uint8_t)(v >> 16);
+	p[3] = (uint8_t)(v >> 24);
+}
+
+static uint32_t _load_le32(const uint8_t* p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* One ChaCha20 block (RFC 8439 2.3) with a 64-bit counter and zero nonce */
+static void _chacha20_block(const uint32_t* key, uint64_t counter, uint8_t* out)
+{
+	uint32_t in[16], x[16];
+	int i;
+
+	in[0] = 0x61707865;
+	in[1] = 0x3320646e;
+	in[2] = 0x79622d32;
+	in[3] = 0x6b206574;
+	for (i = 0; i < 8; i++)
+		in[4 + i] = key[i];
+	in[12] = (uint32_t)counter;
+	in[13] = (uint32_t)(counter >> 32);
+	in[14] = 0;
+	in[15] = 0;
+
+	memcpy(x, in, sizeof(x));
+	for (i = 0; i < 10; i++) {
+		QUARTER_ROUND(x[0], x[4], x[8], x[12]);
+		QUARTER_ROUND(x[1], x[5], x[9], x[13]);
+		QUARTER_ROUND(x[2], x[6], x[10], x[14]);
+		QUARTER_ROUND(x[3], x[7], x[11], x[15]);
+		QUARTER_ROUND(x[0], x[5], x[10], x[15]);
+		QUARTER_ROUND(x[1], x[6], x[11], x[12]);
+		QUARTER_ROUND(x[2], x[7], x[8], x[13]);
+		QUARTER_ROUND(x[3], x[4], x[9], x[14]);
+	}
+	for (i = 0; i < 16; i++)
+		_store_le32(&out[4 * i], x[i] + in[i]);
+
+	memset(x, 0, sizeof(x));
+	memset(in, 0, sizeof(in));
+}
+
+static void _drbg_refill(struct _drbg* drbg)
+{
+	int i;
+
+	for (i = 0; i < DRBG_BUFFER_SIZE; i += 64)
+		_chacha20_block(drbg->key, drbg->counter++, &drbg->buffer[i]);
+
+	/* fast key erasure: the first bytes become the next key */
+	for (i = 0; i < 8; i++)
+		drbg->key[i] = _load_le32(&drbg->buffer[4 * i]);
+	memset(drbg->buffer, 0, DRBG_SEED_SIZE);
+	drbg->available = DRBG_BUFFER_SIZE - DRBG_SEED_SIZE;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+void drbg_init(struct _drbg* drbg, const void* seed, uint32_t len)
+{
+	memset(drbg, 0, sizeof(*drbg));
+	drbg_reseed(drbg, seed, len);
+}
+
+void drbg_reseed(struct _drbg* drbg, const void* seed, uint32_t len)
+{
+	const uint8_t* in = (const uint8_t*)seed;
+	uint32_t i;
+
+	/* fold the seed in the key, rekeying between chunks so that every
+	 * seed byte goes through the cipher */
+	do {
+		for (i = 0; i < DRBG_SEED_SIZE && i < len; i++)
+			drbg->key[i / 4] ^= (uint32_t)in[i] << (8 * (i % 4));
+		in += i;
+		len -= i;
+		_drbg_refill(drbg);
+	} while (len);
+}
+
+void drbg_generate(struct _drbg* drbg, void* out, uint32_t len)
+{
+	uint8_t* dst = (uint8_t*)out;
+	uint8_t* src;
+	uint32_t n;
+
+	while (len) {
+		if (drbg->available == 0) {
+			/* large requests: generate blocks in place, the key
+			 * is still erased by the refill that follows */
+			while (len >= DRBG_BUFFER_SIZE) {
+				for (n = 0; n < DRBG_BUFFER_SIZE; n += 64)
+					_chacha20_block(drbg->key, drbg->counter++, &dst[n]);
+				dst += DRBG_BUFFER_SIZE;
+				len -= DRBG_BUFFER_SIZE;
+			}
+			_drbg_refill(drbg);
+			if (!len)
+				break;
+		}
+
+		n = len < drbg->available ? len : drbg->available;
+		src = &drbg->buffer[DRBG_BUFFER_SIZE - drbg->available];
+		memcpy(dst, src, n);
+		memset(src, 0, n);
+		drbg->available -= n;
+		dst += n;
+		len -= n;
+	}
+}
+
+void drbg_wipe(struct _drbg* drbg)
+{
+	volatile uint8_t* p = (volatile uint8_t*)drbg;
+	uint32_t i;
+
+	for (i = 0; i < sizeof(*drbg); i++)
+		p[i] = 0;
+}
@@ -0,0 +1,98 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef _DRBG_H_
+#define _DRBG_H_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Size of the DRBG key, also the recommended seed size */
+#define DRBG_SEED_SIZE 32
+
+/** Output buffered per refill, in bytes (four ChaCha20 blocks) */
+#define DRBG_BUFFER_SIZE 256
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+struct _drbg {
+	uint32_t key[8];
+	uint64_t counter;
+	uint8_t buffer[DRBG_BUFFER_SIZE];
+	uint16_t available;
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/*
+ * ChaCha20 based deterministic random bit generator with fast key erasure:
+ * each refill generates four blocks, the first 32 bytes replace the key and
+ * the rest is handed out, and output bytes are cleared from the buffer as
+ * they are consumed. A compromise of the state does not reveal previous
+ * output.
+ */
+
+/**
+ * \brief Initialize a generator from a seed.
+ * \param drbg  generator to initialize
+ * \param seed  seed material, DRBG_SEED_SIZE bytes of full entropy or more
+ * \param len   seed length in bytes
+ */
+extern void drbg_init(struct _drbg* drbg, const void* seed, uint32_t len);
+
+/**
+ * \brief Mix more seed material in a generator.
+ */
+extern void drbg_reseed(struct _drbg* drbg, const void* seed, uint32_t len);
+
+/**
+ * \brief Generate random bytes.
+ * \param drbg  generator
+ * \param out   destination buffer
+ * \param len   number of bytes
+ */
+extern void drbg_generate(struct _drbg* drbg, void* out, uint32_t len);
+
+/**
+ * \brief Clear the generator state.
+ */
+extern void drbg_wipe(struct _drbg* drbg);
+
+#endif /* _DRBG_H_ */
@@ -0,0 +1,313 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <string.h>
+
+#include "dsp.h"
+#include "errno.h"
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+#if DSP_CIC_ORDER != 4
+#error "dsp_cic_process() is written for a 4th order CIC"
+#endif
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static inline uint32_t _pack_q15x2(int16_t lo, int16_t hi)
+{
+	return (uint16_t)lo | ((uint32_t)(uint16_t)hi << 16);
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+int dsp_fir_init(struct _dsp_fir *fir, const int16_t *coeffs,
+		uint16_t num_taps, int16_t *state)
+{
+	if (!coeffs || !state || num_taps == 0 || num_taps > INT16_MAX)
+		return -EINVAL;
+
+	fir->coeffs = coeffs;
+	fir->state = state;
+	fir->num_taps = num_taps;
+	fir->index = 0;
+	memset(state, 0, 2 * num_taps * sizeof(*state));
+	return 0;
+}
+
+void dsp_fir_process(struct _dsp_fir *fir, const int16_t *in,
+		int16_t *out, uint32_t count)
+{
+	const int16_t *c = fir->coeffs;
+	uint32_t taps = fir->num_taps;
+	uint32_t index = fir->index;
+	uint32_t i, k;
+
+	for (i = 0; i < count; i++) {
+		const int16_t *w;
+		int32_t acc = 0;
+
+		/* the delay line runs backwards so that w[0] is the newest
+		 * sample and the window is read in the coefficients order */
+		if (index == 0)
+			index = taps;
+		index--;
+		fir->state[index] = fir->state[index + taps] = in[i];
+		w = &fir->state[index];
+
+		k = 0;
+#if defined(DSP_HAVE_ARM_SIMD32)
+		for (; k + 1 < taps; k += 2)
+			acc = dsp_smlad(dsp_read_q15x2(&c[k]),
+					dsp_read_q15x2(&w[k]), acc);
+#endif
+		for (; k < taps; k++)
+			acc = dsp_smlabb(c[k], w[k], acc);
+
+		out[i] = dsp_sat16((acc + (1 << 14)) >> 15);
+	}
+
+	fir->index = index;
+}
+
+int dsp_biquad_init(struct _dsp_biquad *bq, const int16_t *coeffs,
+		uint8_t stages, int16_t *state)
+{
+	if (!coeffs || !state || stages == 0)
+		return -EINVAL;
+
+	bq->coeffs = coeffs;
+	bq->state = state;
+	bq->stages = stages;
+	memset(state, 0, 4 * stages * sizeof(*state));
+	return 0;
+}
+
+void dsp_biquad_process(struct _dsp_biquad *bq, const int16_t *in,
+		int16_t *out, uint32_t count)
+{
+	const int16_t *c = bq->coeffs;
+	int16_t *s = bq->state;
+	uint8_t stage;
+	uint32_t i;
+
+	/* process the whole block one stage at a time, the state of a stage
+	 * then stays in registers */
+	for (stage = 0; stage < bq->stages; stage++) {
+		int16_t x1 = s[0], x2 = s[1], y1 = s[2], y2 = s[3];
+		const int16_t *src = stage == 0 ? in : out;
+
+		for (i = 0; i < count; i++) {
+			int16_t x = src[i];
+			int32_t acc;
+			int16_t y;
+
+#if defined(DSP_HAVE_ARM_SIMD32)
+			acc = dsp_smlad(dsp_read_q15x2(&c[0]),
+					_pack_q15x2(x, x1), 0);
+			acc = dsp_smlad(dsp_read_q15x2(&c[2]),
+					_pack_q15x2(x2, y1), acc);
+			acc = dsp_smlabb(c[4], y2, acc);
+#else
+			acc = dsp_smlabb(c[0], x, 0);
+			acc = dsp_smlabb(c[1], x1, acc);
+			acc = dsp_smlabb(c[2], x2, acc);
+			acc = dsp_smlabb(c[3], y1, acc);
+			acc = dsp_smlabb(c[4], y2, acc);
+#endif
+			y = dsp_sat16((acc + (1 << 13)) >> 14);
+
+			x2 = x1;
+			x1 = x;
+			y2 = y1;
+			y1 = y;
+			out[i] = y;
+		}
+
+		s[0] = x1;
+		s[1] = x2;
+		s[2] = y1;
+		s[3] = y2;
+		s += 4;
+		c += 5;
+	}
+}
+
+void dsp_gain_q15(const int16_t *in, int16_t *out, uint32_t count,
+		int32_t gain)
+{
+	uint32_t i;
+
+	for (i = 0; i < count; i++)
+		out[i] = dsp_sat16(dsp_smulwb(gain, in[i]));
+}
+
+void dsp_gain_q31(const int32_t *in, int32_t *out, uint32_t count,
+		int32_t gain)
+{
+	uint32_t i;
+
+	for (i = 0; i < count; i++) {
+		int64_t v = ((int64_t)in[i] * gain) >> 16;
+		if (v > INT32_MAX)
+			v = INT32_MAX;
+		else if (v < INT32_MIN)
+			v = INT32_MIN;
+		out[i] = (int32_t)v;
+	}
+}
+
+void dsp_mix_q15(const int16_t *a, const int16_t *b, int16_t *out,
+		uint32_t count)
+{
+	uint32_t i = 0;
+
+#if defined(DSP_HAVE_ARM_SIMD32)
+	for (; i + 1 < count; i += 2) {
+		uint32_t v = dsp_qadd16(dsp_read_q15x2(&a[i]),
+				dsp_read_q15x2(&b[i]));
+		memcpy(&out[i], &v, sizeof(v));
+	}
+#endif
+	for (; i < count; i++)
+		out[i] = dsp_sat16((int32_t)a[i] + b[i]);
+}
+
+void dsp_mix_stereo_to_mono_q15(const int16_t *in, int16_t *out,
+		uint32_t frames)
+{
+	uint32_t i;
+
+	for (i = 0; i < frames; i++)
+		out[i] = ((int32_t)in[2 * i] + in[2 * i + 1]) >> 1;
+}
+
+void dsp_deinterleave_q15(const int16_t *in, uint8_t channels,
+		uint8_t channel, int16_t *out, uint32_t frames)
+{
+	uint32_t i;
+
+	in += channel;
+	for (i = 0; i < frames; i++, in += channels)
+		out[i] = *in;
+}
+
+void dsp_interleave_q15(const int16_t *in, int16_t *out,
+		uint8_t channels, uint8_t channel, uint32_t frames)
+{
+	uint32_t i;
+
+	out += channel;
+	for (i = 0; i < frames; i++, out += channels)
+		*out = in[i];
+}
+
+int dsp_cic_init(struct _dsp_cic *cic, uint16_t ratio)
+{
+	uint8_t bits;
+
+	switch (ratio) {
+	case 16:
+		bits = 4;
+		break;
+	case 32:
+		bits = 5;
+		break;
+	case 64:
+		bits = 6;
+		break;
+	case 128:
+		bits = 7;
+		break;
+	default:
+		return -EINVAL;
+	}
+
+	memset(cic, 0, sizeof(*cic));
+	cic->ratio = ratio;
+	/* the CIC gain is ratio^order */
+	cic->shift = DSP_CIC_ORDER * bits - 15;
+	return 0;
+}
+
+uint32_t dsp_cic_process(struct _dsp_cic *cic, const uint8_t *in,
+		uint32_t size, int16_t *out)
+{
+	uint32_t i0 = cic->integ[0];
+	uint32_t i1 = cic->integ[1];
+	uint32_t i2 = cic->integ[2];
+	uint32_t i3 = cic->integ[3];
+	uint32_t phase = cic->phase;
+	uint32_t count = 0;
+	uint32_t i;
+	int bit;
+
+	/* integrators and combs rely on modulo 2^32 arithmetic, the output
+	 * range (ratio^order) fits in 32 bits so wrap-arounds cancel out */
+	for (i = 0; i < size; i++) {
+		uint8_t b = in[i];
+		for (bit = 7; bit >= 0; bit--) {
+			i0 += ((b >> bit) & 1) ? 1 : UINT32_MAX;
+			i1 += i0;
+			i2 += i1;
+			i3 += i2;
+
+			if (++phase == cic->ratio) {
+				uint32_t v = i3;
+				uint8_t s;
+
+				phase = 0;
+				for (s = 0; s < DSP_CIC_ORDER; s++) {
+					uint32_t t = v;
+					v -= cic->comb[s];
+					cic->comb[s] = t;
+				}
+				out[count++] = dsp_sat16((int32_t)v >> cic->shift);
+			}
+		}
+	}
+
+	cic->integ[0] = i0;
+	cic->integ[1] = i1;
+	cic->integ[2] = i2;
+	cic->integ[3] = i3;
+	cic->phase = phase;
+	return count;
+}
@@ -0,0 +1,369 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef _DSP_H_
+#define _DSP_H_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <string.h>
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/* Select the instruction set used by the kernels. Defining
+ * CONFIG_DSP_REFERENCE forces the portable C path, which is the reference
+ * the optimized paths are checked against. */
+#if !defined(CONFIG_DSP_REFERENCE) && defined(__GNUC__) && defined(__arm__)
+  #if defined(__ARM_FEATURE_DSP)
+    /* ARMv5TE and later: SMLAxy, SMULWy, QADD, QSUB */
+    #define DSP_HAVE_ARM_DSP
+  #endif
+  #if defined(__ARM_FEATURE_SIMD32)
+    /* ARMv6 and later, ARMv7E-M: SMLAD, QADD16, SHADD16, SSAT */
+    #define DSP_HAVE_ARM_SIMD32
+  #endif
+#endif
+
+/** Unity gain for dsp_gain_q15() and dsp_gain_q31() (Q16.16) */
+#define DSP_GAIN_UNITY (1 << 16)
+
+/** Order of the CIC filter used by the PDM decimator */
+#define DSP_CIC_ORDER 4
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/**
+ * FIR filter state.
+ *
+ * The delay line is stored twice so that the filter loop always reads a
+ * contiguous window, it must hold 2 * num_taps samples.
+ */
+struct _dsp_fir {
+	/** Coefficients, Q15 */
+	const int16_t *coeffs;
+	/** Delay line, 2 * num_taps samples */
+	int16_t *state;
+	/** Number of taps */
+	uint16_t num_taps;
+	/** Position of the newest sample in the delay line */
+	uint16_t index;
+};
+
+/**
+ * Cascade of second order sections (direct form I).
+ *
+ * Each stage uses 5 coefficients in Q2.14 format: b0, b1, b2, -a1, -a2 (the
+ * feedback coefficients are stored negated so that all terms accumulate),
+ * and 4 state samples: x[n-1], x[n-2], y[n-1], y[n-2].
+ */
+struct _dsp_biquad {
+	/** Coefficients, 5 per stage, Q2.14 */
+	const int16_t *coeffs;
+	/** State, 4 per stage */
+	int16_t *state;
+	/** Number of stages */
+	uint8_t stages;
+};
+
+/**
+ * PDM to PCM decimator: CIC filter of order DSP_CIC_ORDER.
+ *
+ * The CIC has a sinc^N response, its passband droop can be compensated by
+ * running the output through a short FIR filter.
+ */
+struct _dsp_cic {
+	/** Integrator stages (modulo 2^32 arithmetic) */
+	uint32_t integ[DSP_CIC_ORDER];
+	/** Comb stages delay elements */
+	uint32_t comb[DSP_CIC_ORDER];
+	/** Decimation ratio, in PDM bits per PCM sample */
+	uint16_t ratio;
+	/** Number of PDM bits accumulated toward the next output sample */
+	uint16_t phase;
+	/** Right shift bringing the CIC output to Q15 */
+	uint8_t shift;
+};
+
+/*----------------------------------------------------------------------------
+ *        Inline functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Saturate a 32-bit value to the signed 16-bit range.
+ */
+static inline int16_t dsp_sat16(int32_t x)
+{
+#if defined(DSP_HAVE_ARM_SIMD32)
+	int32_t r;
+	asm("ssat %0, #16, %1" : "=r"(r) : "r"(x));
+	return (int16_t)r;
+#else
+	if (x > INT16_MAX)
+		return INT16_MAX;
+	if (x < INT16_MIN)
+		return INT16_MIN;
+	return (int16_t)x;
+#endif
+}
+
+/**
+ * \brief Saturating 32-bit addition.
+ */
+static inline int32_t dsp_qadd(int32_t a, int32_t b)
+{
+#if defined(DSP_HAVE_ARM_DSP)
+	int32_t r;
+	asm("qadd %0, %1, %2" : "=r"(r) : "r"(a), "r"(b));
+	return r;
+#else
+	int64_t r = (int64_t)a + b;
+	if (r > INT32_MAX)
+		return INT32_MAX;
+	if (r < INT32_MIN)
+		return INT32_MIN;
+	return (int32_t)r;
+#endif
+}
+
+/**
+ * \brief Multiply-accumulate of the low halfwords: acc + a[15:0] * b[15:0].
+ */
+static inline int32_t dsp_smlabb(int32_t a, int32_t b, int32_t acc)
+{
+#if defined(DSP_HAVE_ARM_DSP)
+	int32_t r;
+	asm("smlabb %0, %1, %2, %3" : "=r"(r) : "r"(a), "r"(b), "r"(acc));
+	return r;
+#else
+	return acc + (int32_t)(int16_t)a * (int16_t)b;
+#endif
+}
+
+/**
+ * \brief Multiply a 32-bit value by the low halfword, keeping the top 32
+ * bits of the 48-bit product: (a * b[15:0]) >> 16.
+ */
+static inline int32_t dsp_smulwb(int32_t a, int32_t b)
+{
+#if defined(DSP_HAVE_ARM_DSP)
+	int32_t r;
+	asm("smulwb %0, %1, %2" : "=r"(r) : "r"(a), "r"(b));
+	return r;
+#else
+	return (int32_t)(((int64_t)a * (int16_t)b) >> 16);
+#endif
+}
+
+/**
+ * \brief Saturating dual 16-bit addition.
+ */
+static inline uint32_t dsp_qadd16(uint32_t a, uint32_t b)
+{
+#if defined(DSP_HAVE_ARM_SIMD32)
+	uint32_t r;
+	asm("qadd16 %0, %1, %2" : "=r"(r) : "r"(a), "r"(b));
+	return r;
+#else
+	uint16_t lo = dsp_sat16((int16_t)a + (int16_t)b);
+	uint16_t hi = dsp_sat16((int16_t)(a >> 16) + (int16_t)(b >> 16));
+	return lo | ((uint32_t)hi << 16);
+#endif
+}
+
+/**
+ * \brief Dual multiply-accumulate:
+ * acc + a[15:0] * b[15:0] + a[31:16] * b[31:16].
+ */
+static inline int32_t dsp_smlad(uint32_t a, uint32_t b, int32_t acc)
+{
+#if defined(DSP_HAVE_ARM_SIMD32)
+	int32_t r;
+	asm("smlad %0, %1, %2, %3" : "=r"(r) : "r"(a), "r"(b), "r"(acc));
+	return r;
+#else
+	return acc + (int32_t)(int16_t)a * (int16_t)b
+	           + (int32_t)(int16_t)(a >> 16) * (int16_t)(b >> 16);
+#endif
+}
+
+/**
+ * \brief Read two consecutive 16-bit samples as one 32-bit word. The
+ * pointer does not need to be word aligned.
+ */
+static inline uint32_t dsp_read_q15x2(const int16_t *p)
+{
+	uint32_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Initialize a FIR filter and clear its delay line.
+ *
+ * The accumulator keeps one guard bit: the sum of the absolute values of
+ * the coefficients must stay below 2.0.
+ *
+ * \param fir       Pointer to the filter state
+ * \param coeffs    Coefficients, Q15, h[0] first
+ * \param num_taps  Number of taps (at least 1)
+ * \param state     Delay line buffer of 2 * num_taps samples
+ * \return 0 on success, -EINVAL if a parameter is invalid
+ */
+extern int dsp_fir_init(struct _dsp_fir *fir, const int16_t *coeffs,
+		uint16_t num_taps, int16_t *state);
+
+/**
+ * \brief Filter a block of samples. \a in and \a out may be the same buffer.
+ * \param fir    Pointer to the filter state
+ * \param in     Input samples
+ * \param out    Output samples
+ * \param count  Number of samples
+ */
+extern void dsp_fir_process(struct _dsp_fir *fir, const int16_t *in,
+		int16_t *out, uint32_t count);
+
+/**
+ * \brief Initialize a biquad cascade and clear its state.
+ * \param bq      Pointer to the cascade
+ * \param coeffs  Coefficients, 5 per stage (see struct _dsp_biquad)
+ * \param stages  Number of stages (at least 1)
+ * \param state   State buffer of 4 * stages samples
+ * \return 0 on success, -EINVAL if a parameter is invalid
+ */
+extern int dsp_biquad_init(struct _dsp_biquad *bq, const int16_t *coeffs,
+		uint8_t stages, int16_t *state);
+
+/**
+ * \brief Filter a block of samples. \a in and \a out may be the same buffer.
+ * \param bq     Pointer to the cascade
+ * \param in     Input samples
+ * \param out    Output samples
+ * \param count  Number of samples
+ */
+extern void dsp_biquad_process(struct _dsp_biquad *bq, const int16_t *in,
+		int16_t *out, uint32_t count);
+
+/**
+ * \brief Apply a gain to 16-bit samples, with saturation.
+ * \param in     Input samples
+ * \param out    Output samples, may be the same buffer as \a in
+ * \param count  Number of samples
+ * \param gain   Gain in Q16.16 (DSP_GAIN_UNITY is 0 dB)
+ */
+extern void dsp_gain_q15(const int16_t *in, int16_t *out, uint32_t count,
+		int32_t gain);
+
+/**
+ * \brief Apply a gain to 32-bit samples, with saturation.
+ * \param in     Input samples
+ * \param out    Output samples, may be the same buffer as \a in
+ * \param count  Number of samples
+ * \param gain   Gain in Q16.16 (DSP_GAIN_UNITY is 0 dB)
+ */
+extern void dsp_gain_q31(const int32_t *in, int32_t *out, uint32_t count,
+		int32_t gain);
+
+/**
+ * \brief Mix two blocks of 16-bit samples with saturation:
+ * out = a + b. Works on interleaved data with any number of channels.
+ * \param a      First input
+ * \param b      Second input
+ * \param out    Output, may be the same buffer as \a a or \a b
+ * \param count  Number of samples (not frames)
+ */
+extern void dsp_mix_q15(const int16_t *a, const int16_t *b, int16_t *out,
+		uint32_t count);
+
+/**
+ * \brief Down-mix interleaved stereo frames to mono: out = (L + R) / 2.
+ * \param in      Interleaved stereo frames
+ * \param out     Mono samples, may be the same buffer as \a in
+ * \param frames  Number of frames
+ */
+extern void dsp_mix_stereo_to_mono_q15(const int16_t *in, int16_t *out,
+		uint32_t frames);
+
+/**
+ * \brief Extract one channel of an interleaved block.
+ * \param in        Interleaved frames
+ * \param channels  Number of interleaved channels
+ * \param channel   Index of the channel to extract
+ * \param out       Output samples
+ * \param frames    Number of frames
+ */
+extern void dsp_deinterleave_q15(const int16_t *in, uint8_t channels,
+		uint8_t channel, int16_t *out, uint32_t frames);
+
+/**
+ * \brief Store a block of samples into one channel of an interleaved block.
+ * \param in        Input samples
+ * \param out       Interleaved frames
+ * \param channels  Number of interleaved channels
+ * \param channel   Index of the channel to write
+ * \param frames    Number of frames
+ */
+extern void dsp_interleave_q15(const int16_t *in, int16_t *out,
+		uint8_t channels, uint8_t channel, uint32_t frames);
+
+/**
+ * \brief Initialize a PDM to PCM decimator.
+ * \param cic    Pointer to the decimator state
+ * \param ratio  Decimation ratio: 16, 32, 64 or 128 PDM bits per sample
+ * \return 0 on success, -EINVAL if the ratio is not supported
+ */
+extern int dsp_cic_init(struct _dsp_cic *cic, uint16_t ratio);
+
+/**
+ * \brief Convert a block of PDM data to PCM samples.
+ *
+ * PDM bits are read MSB first, a set bit stands for +1 and a cleared bit
+ * for -1. The decimator keeps its phase across calls, so \a size does not
+ * need to be a multiple of the ratio.
+ *
+ * \param cic   Pointer to the decimator state
+ * \param in    PDM data
+ * \param size  Size of the PDM data, in bytes
+ * \param out   Output samples, Q15, room for (size * 8) / ratio + 1 samples
+ * \return Number of output samples written
+ */
+extern uint32_t dsp_cic_process(struct _dsp_cic *cic, const uint8_t *in,
+		uint32_t size, int16_t *out);
+
+#endif /* _DSP_H_ */
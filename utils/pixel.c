@@ -0,0 +1,414 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+#include <string.h>
+
+#include "pixel.h"
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+#define IS_WORD_ALIGNED(p) ((((uintptr_t)(p)) & 3) == 0)
+
+/* RGB565 pixel spread over 32 bits, with 5 free bits above each field, so
+ * that the three components can be scaled with a single multiplication */
+#define RGB565_SPREAD_MASK 0x07E0F81Fu
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static inline uint16_t _rgb888_to_rgb565(uint32_t b, uint32_t g, uint32_t r)
+{
+	return (uint16_t)(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3));
+}
+
+static inline uint32_t _rgb565_to_argb8888(uint16_t p)
+{
+	uint32_t r = (p >> 11) & 0x1F;
+	uint32_t g = (p >> 5) & 0x3F;
+	uint32_t b = p & 0x1F;
+
+	r = (r << 3) | (r >> 2);
+	g = (g << 2) | (g >> 4);
+	b = (b << 3) | (b >> 2);
+	return 0xFF000000u | (r << 16) | (g << 8) | b;
+}
+
+static inline uint32_t _spread_rgb565(uint16_t p)
+{
+	return ((uint32_t)p | ((uint32_t)p << 16)) & RGB565_SPREAD_MASK;
+}
+
+static inline uint16_t _blend_rgb565(uint16_t d, uint32_t s)
+{
+	uint32_t a = s >> 24;
+	uint32_t dd, ss;
+
+	if (a == 0xFF)
+		return PIXEL_ARGB_TO_RGB565(s);
+	if (a == 0)
+		return d;
+
+	/* 5-bit alpha on the spread representation: one multiply blends
+	 * the three components */
+	a = (a + 4) >> 3;
+	ss = _spread_rgb565(PIXEL_ARGB_TO_RGB565(s));
+	dd = _spread_rgb565(d);
+	dd = ((((ss - dd) * a) >> 5) + dd) & RGB565_SPREAD_MASK;
+	return (uint16_t)((dd >> 16) | dd);
+}
+
+static inline uint32_t _blend_argb8888(uint32_t d, uint32_t s)
+{
+	uint32_t a = s >> 24;
+	uint32_t na, rb, g, da;
+
+	if (a == 0xFF)
+		return s;
+	if (a == 0)
+		return d;
+
+	/* map 0..255 to 0..256 so that the shifts below are exact at the
+	 * ends, red and blue are blended together */
+	a += a >> 7;
+	na = 256 - a;
+	rb = (((s & 0x00FF00FF) * a + (d & 0x00FF00FF) * na) >> 8) & 0x00FF00FF;
+	g = (((s & 0x0000FF00) * a + (d & 0x0000FF00) * na) >> 8) & 0x0000FF00;
+	da = a + (((d >> 24) * na) >> 8);
+	return (da << 24) | rb | g;
+}
+
+static inline uint32_t _load_rgb888(const uint8_t *p)
+{
+	return 0xFF000000u | ((uint32_t)p[2] << 16) | ((uint32_t)p[1] << 8) | p[0];
+}
+
+static inline void _store_rgb888(uint8_t *p, uint32_t c)
+{
+	p[0] = c & 0xFF;
+	p[1] = (c >> 8) & 0xFF;
+	p[2] = (c >> 16) & 0xFF;
+}
+
+static void _fill16(uint16_t *dst, uint16_t color, uint32_t count)
+{
+	uint32_t pattern = color | ((uint32_t)color << 16);
+	uint32_t *dst32;
+
+	if (count && !IS_WORD_ALIGNED(dst)) {
+		*dst++ = color;
+		count--;
+	}
+	dst32 = (uint32_t *)dst;
+	for (; count >= 8; count -= 8) {
+		dst32[0] = pattern;
+		dst32[1] = pattern;
+		dst32[2] = pattern;
+		dst32[3] = pattern;
+		dst32 += 4;
+	}
+	for (; count >= 2; count -= 2)
+		*dst32++ = pattern;
+	if (count)
+		*(uint16_t *)dst32 = color;
+}
+
+static void _fill24(uint8_t *dst, uint32_t color, uint32_t count)
+{
+	uint32_t b = color & 0xFF;
+	uint32_t g = (color >> 8) & 0xFF;
+	uint32_t r = (color >> 16) & 0xFF;
+	uint32_t w0, w1, w2;
+	uint32_t *dst32;
+
+	/* at most 3 pixels until the row is word aligned */
+	while (count && !IS_WORD_ALIGNED(dst)) {
+		_store_rgb888(dst, color);
+		dst += 3;
+		count--;
+	}
+
+	/* 4 pixels in 3 words: BGRB GRBG RBGR */
+	w0 = b | (g << 8) | (r << 16) | (b << 24);
+	w1 = g | (r << 8) | (b << 16) | (g << 24);
+	w2 = r | (b << 8) | (g << 16) | (r << 24);
+	dst32 = (uint32_t *)dst;
+	for (; count >= 4; count -= 4) {
+		dst32[0] = w0;
+		dst32[1] = w1;
+		dst32[2] = w2;
+		dst32 += 3;
+	}
+
+	dst = (uint8_t *)dst32;
+	for (; count; count--) {
+		_store_rgb888(dst, color);
+		dst += 3;
+	}
+}
+
+static void _fill32(uint32_t *dst, uint32_t color, uint32_t count)
+{
+	for (; count >= 4; count -= 4) {
+		dst[0] = color;
+		dst[1] = color;
+		dst[2] = color;
+		dst[3] = color;
+		dst += 4;
+	}
+	for (; count; count--)
+		*dst++ = color;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+void pixel_fill(void *dst, uint32_t color, uint32_t count, uint8_t bpp)
+{
+	switch (bpp) {
+	case 16:
+		_fill16((uint16_t *)dst, PIXEL_ARGB_TO_RGB565(color), count);
+		break;
+	case 24:
+		_fill24((uint8_t *)dst, color, count);
+		break;
+	case 32:
+		_fill32((uint32_t *)dst, color, count);
+		break;
+	}
+}
+
+void pixel_rgb888_to_rgb565(uint16_t *dst, const uint8_t *src, uint32_t count)
+{
+	/* Word path: 4 pixels are read as 3 words and written as 2 words.
+	 * Source and destination only get aligned together when their
+	 * offsets match, otherwise the byte path handles the whole row. */
+	while (count && !(IS_WORD_ALIGNED(src) && IS_WORD_ALIGNED(dst))) {
+		*dst++ = _rgb888_to_rgb565(src[0], src[1], src[2]);
+		src += 3;
+		count--;
+		if (IS_WORD_ALIGNED(src) && !IS_WORD_ALIGNED(dst))
+			break;
+	}
+
+	if (IS_WORD_ALIGNED(src) && IS_WORD_ALIGNED(dst)) {
+		const uint32_t *src32 = (const uint32_t *)src;
+		uint32_t *dst32 = (uint32_t *)dst;
+
+		for (; count >= 4; count -= 4) {
+			uint32_t w0 = src32[0], w1 = src32[1], w2 = src32[2];
+			uint32_t p0 = _rgb888_to_rgb565(w0 & 0xFF, (w0 >> 8) & 0xFF, (w0 >> 16) & 0xFF);
+			uint32_t p1 = _rgb888_to_rgb565(w0 >> 24, w1 & 0xFF, (w1 >> 8) & 0xFF);
+			uint32_t p2 = _rgb888_to_rgb565((w1 >> 16) & 0xFF, w1 >> 24, w2 & 0xFF);
+			uint32_t p3 = _rgb888_to_rgb565((w2 >> 8) & 0xFF, (w2 >> 16) & 0xFF, w2 >> 24);
+
+			dst32[0] = p0 | (p1 << 16);
+			dst32[1] = p2 | (p3 << 16);
+			src32 += 3;
+			dst32 += 2;
+		}
+		src = (const uint8_t *)src32;
+		dst = (uint16_t *)dst32;
+	}
+
+	for (; count; count--) {
+		*dst++ = _rgb888_to_rgb565(src[0], src[1], src[2]);
+		src += 3;
+	}
+}
+
+void pixel_argb8888_to_rgb565(uint16_t *dst, const uint32_t *src,
+		uint32_t count)
+{
+	uint32_t *dst32;
+
+	if (count && !IS_WORD_ALIGNED(dst)) {
+		*dst++ = PIXEL_ARGB_TO_RGB565(*src);
+		src++;
+		count--;
+	}
+	dst32 = (uint32_t *)dst;
+	for (; count >= 2; count -= 2) {
+		*dst32++ = PIXEL_ARGB_TO_RGB565(src[0]) |
+			((uint32_t)PIXEL_ARGB_TO_RGB565(src[1]) << 16);
+		src += 2;
+	}
+	if (count)
+		*(uint16_t *)dst32 = PIXEL_ARGB_TO_RGB565(*src);
+}
+
+void pixel_rgb565_to_argb8888(uint32_t *dst, const uint16_t *src,
+		uint32_t count)
+{
+	if (count && !IS_WORD_ALIGNED(src)) {
+		*dst++ = _rgb565_to_argb8888(*src++);
+		count--;
+	}
+	for (; count >= 2; count -= 2) {
+		uint32_t w = *(const uint32_t *)src;
+
+		dst[0] = _rgb565_to_argb8888(w & 0xFFFF);
+		dst[1] = _rgb565_to_argb8888(w >> 16);
+		src += 2;
+		dst += 2;
+	}
+	if (count)
+		*dst = _rgb565_to_argb8888(*src);
+}
+
+void pixel_rgb888_to_argb8888(uint32_t *dst, const uint8_t *src,
+		uint32_t count)
+{
+	while (count && !IS_WORD_ALIGNED(src)) {
+		*dst++ = _load_rgb888(src);
+		src += 3;
+		count--;
+	}
+	for (; count >= 4; count -= 4) {
+		const uint32_t *src32 = (const uint32_t *)src;
+		uint32_t w0 = src32[0], w1 = src32[1], w2 = src32[2];
+
+		dst[0] = 0xFF000000u | (w0 & 0xFFFFFF);
+		dst[1] = 0xFF000000u | (w0 >> 24) | ((w1 & 0xFFFF) << 8);
+		dst[2] = 0xFF000000u | (w1 >> 16) | ((w2 & 0xFF) << 16);
+		dst[3] = 0xFF000000u | (w2 >> 8);
+		src += 12;
+		dst += 4;
+	}
+	for (; count; count--) {
+		*dst++ = _load_rgb888(src);
+		src += 3;
+	}
+}
+
+void pixel_argb8888_to_rgb888(uint8_t *dst, const uint32_t *src,
+		uint32_t count)
+{
+	while (count && !IS_WORD_ALIGNED(dst)) {
+		_store_rgb888(dst, *src++);
+		dst += 3;
+		count--;
+	}
+	for (; count >= 4; count -= 4) {
+		uint32_t *dst32 = (uint32_t *)dst;
+
+		dst32[0] = (src[0] & 0xFFFFFF) | (src[1] << 24);
+		dst32[1] = ((src[1] >> 8) & 0xFFFF) | (src[2] << 16);
+		dst32[2] = ((src[2] >> 16) & 0xFF) | (src[3] << 8);
+		src += 4;
+		dst += 12;
+	}
+	for (; count; count--) {
+		_store_rgb888(dst, *src++);
+		dst += 3;
+	}
+}
+
+void pixel_convert(void *dst, uint8_t dst_bpp, const void *src,
+		uint8_t src_bpp, uint32_t count)
+{
+	uint8_t *d = (uint8_t *)dst;
+	const uint8_t *s = (const uint8_t *)src;
+
+	if (dst_bpp == src_bpp) {
+		memcpy(dst, src, count * (dst_bpp / 8));
+		return;
+	}
+
+	switch ((src_bpp << 8) | dst_bpp) {
+	case (24 << 8) | 16:
+		pixel_rgb888_to_rgb565((uint16_t *)dst, s, count);
+		break;
+	case (32 << 8) | 16:
+		pixel_argb8888_to_rgb565((uint16_t *)dst, (const uint32_t *)src, count);
+		break;
+	case (16 << 8) | 32:
+		pixel_rgb565_to_argb8888((uint32_t *)dst, (const uint16_t *)src, count);
+		break;
+	case (24 << 8) | 32:
+		pixel_rgb888_to_argb8888((uint32_t *)dst, s, count);
+		break;
+	case (32 << 8) | 24:
+		pixel_argb8888_to_rgb888(d, (const uint32_t *)src, count);
+		break;
+	case (16 << 8) | 24:
+		for (; count; count--) {
+			_store_rgb888(d, _rgb565_to_argb8888(*(const uint16_t *)s));
+			s += 2;
+			d += 3;
+		}
+		break;
+	}
+}
+
+void pixel_blend_argb8888_rgb565(uint16_t *dst, const uint32_t *src,
+		uint32_t count)
+{
+	for (; count; count--) {
+		*dst = _blend_rgb565(*dst, *src++);
+		dst++;
+	}
+}
+
+void pixel_blend_argb8888(uint32_t *dst, const uint32_t *src, uint32_t count)
+{
+	for (; count; count--) {
+		*dst = _blend_argb8888(*dst, *src++);
+		dst++;
+	}
+}
+
+void pixel_blend(void *dst, uint8_t dst_bpp, const uint32_t *src,
+		uint32_t count)
+{
+	uint8_t *d = (uint8_t *)dst;
+
+	switch (dst_bpp) {
+	case 16:
+		pixel_blend_argb8888_rgb565((uint16_t *)dst, src, count);
+		break;
+	case 24:
+		for (; count; count--) {
+			_store_rgb888(d, _blend_argb8888(_load_rgb888(d), *src++));
+			d += 3;
+		}
+		break;
+	case 32:
+		pixel_blend_argb8888((uint32_t *)dst, src, count);
+		break;
+	}
+}
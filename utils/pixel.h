@@ -0,0 +1,132 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef _PIXEL_H_
+#define _PIXEL_H_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Convert a 0xAARRGGBB color to RGB565 */
+#define PIXEL_ARGB_TO_RGB565(c) \
+	((uint16_t)((((c) >> 8) & 0xF800) | (((c) >> 5) & 0x07E0) | \
+	            (((c) >> 3) & 0x001F)))
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/*
+ * Row kernels for the pixel formats used by the LCDC layers:
+ *  - 16 bpp: RGB565, one uint16_t per pixel
+ *  - 24 bpp: packed RGB888, bytes B, G, R
+ *  - 32 bpp: ARGB8888, one uint32_t 0xAARRGGBB per pixel
+ *
+ * Colors are always given as 0xAARRGGBB. The kernels handle any alignment
+ * but work on 32-bit words once the destination is word aligned. They do
+ * not depend on the hardware and build on the host.
+ */
+
+/**
+ * \brief Fill a row of pixels with a color.
+ * \param dst    Destination row.
+ * \param color  Color, 0xAARRGGBB.
+ * \param count  Number of pixels.
+ * \param bpp    Bits per pixel (16, 24 or 32).
+ */
+extern void pixel_fill(void *dst, uint32_t color, uint32_t count, uint8_t bpp);
+
+/**
+ * \brief Convert a row of RGB888 pixels to RGB565.
+ */
+extern void pixel_rgb888_to_rgb565(uint16_t *dst, const uint8_t *src,
+		uint32_t count);
+
+/**
+ * \brief Convert a row of ARGB8888 pixels to RGB565, alpha is dropped.
+ */
+extern void pixel_argb8888_to_rgb565(uint16_t *dst, const uint32_t *src,
+		uint32_t count);
+
+/**
+ * \brief Convert a row of RGB565 pixels to ARGB8888 with opaque alpha.
+ */
+extern void pixel_rgb565_to_argb8888(uint32_t *dst, const uint16_t *src,
+		uint32_t count);
+
+/**
+ * \brief Convert a row of RGB888 pixels to ARGB8888 with opaque alpha.
+ */
+extern void pixel_rgb888_to_argb8888(uint32_t *dst, const uint8_t *src,
+		uint32_t count);
+
+/**
+ * \brief Convert a row of ARGB8888 pixels to RGB888, alpha is dropped.
+ */
+extern void pixel_argb8888_to_rgb888(uint8_t *dst, const uint32_t *src,
+		uint32_t count);
+
+/**
+ * \brief Convert a row of pixels between any two supported formats.
+ * \param dst      Destination row.
+ * \param dst_bpp  Destination bits per pixel.
+ * \param src      Source row.
+ * \param src_bpp  Source bits per pixel.
+ * \param count    Number of pixels.
+ */
+extern void pixel_convert(void *dst, uint8_t dst_bpp, const void *src,
+		uint8_t src_bpp, uint32_t count);
+
+/**
+ * \brief Blend a row of ARGB8888 pixels over a RGB565 row (source over).
+ */
+extern void pixel_blend_argb8888_rgb565(uint16_t *dst, const uint32_t *src,
+		uint32_t count);
+
+/**
+ * \brief Blend a row of ARGB8888 pixels over an ARGB8888 row (source over,
+ * the destination alpha is kept).
+ */
+extern void pixel_blend_argb8888(uint32_t *dst, const uint32_t *src,
+		uint32_t count);
+
+/**
+ * \brief Blend a row of ARGB8888 pixels over a row of any supported format.
+ */
+extern void pixel_blend(void *dst, uint8_t dst_bpp, const uint32_t *src,
+		uint32_t count);
+
+#endif /* _PIXEL_H_ */
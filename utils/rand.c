@@ -35,14 +35,56 @@
 
 #include "board.h"
 
+#include "drbg.h"
+#include "errno.h"
 #include "rand.h"
 
+#include <stdbool.h>
+#include <string.h>
+
+/*------------------------------------------------------------------------------
+ *         Definitions
+ *------------------------------------------------------------------------------*/
+
+/** Bytes generated between two reseeds from the entropy source */
+#define RAND_RESEED_INTERVAL (1024 * 1024)
+
 /*------------------------------------------------------------------------------
  *         Global Variables
  *------------------------------------------------------------------------------*/
 
 static uint32_t _rand_next = 1;
 
+static struct {
+	struct _drbg drbg;
+	rand_entropy_t source;
+	uint32_t generated;
+	bool seeded;
+} _rand_csprng;
+
+/*------------------------------------------------------------------------------
+ *         Local Functions
+ *------------------------------------------------------------------------------*/
+
+static int _rand_reseed(void)
+{
+	uint8_t seed[DRBG_SEED_SIZE];
+	int err;
+
+	err = _rand_csprng.source(seed, sizeof(seed));
+	if (err < 0)
+		return err;
+
+	if (_rand_csprng.seeded)
+		drbg_reseed(&_rand_csprng.drbg, seed, sizeof(seed));
+	else
+		drbg_init(&_rand_csprng.drbg, seed, sizeof(seed));
+	memset(seed, 0, sizeof(seed));
+	_rand_csprng.seeded = true;
+	_rand_csprng.generated = 0;
+	return 0;
+}
+
 /*------------------------------------------------------------------------------
  *         Exported Functions
  *------------------------------------------------------------------------------*/
@@ -66,3 +108,46 @@ uint32_t rand(void)
 
 	return (uint32_t)(_rand_next / 131072) % 65536;
 }
+
+void rand_set_entropy_source(rand_entropy_t source)
+{
+	_rand_csprng.source = source;
+	_rand_csprng.generated = RAND_RESEED_INTERVAL;
+}
+
+void rand_add_entropy(const void* data, uint32_t len)
+{
+	if (_rand_csprng.seeded) {
+		drbg_reseed(&_rand_csprng.drbg, data, len);
+	} else {
+		drbg_init(&_rand_csprng.drbg, data, len);
+		_rand_csprng.seeded = true;
+	}
+}
+
+int rand_bytes(void* buffer, uint32_t len)
+{
+	int err;
+
+	if (_rand_csprng.source &&
+	    _rand_csprng.generated >= RAND_RESEED_INTERVAL) {
+		err = _rand_reseed();
+		/* keep going on the current state if the source fails */
+		if (err < 0 && !_rand_csprng.seeded)
+			return err;
+	}
+	if (!_rand_csprng.seeded)
+		return -ENODEV;
+
+	drbg_generate(&_rand_csprng.drbg, buffer, len);
+	_rand_csprng.generated += len;
+	return 0;
+}
+
+uint32_t rand_u32(void)
+{
+	uint32_t value = 0;
+
+	rand_bytes(&value, sizeof(value));
+	return value;
+}
@@ -44,6 +44,13 @@
 
 #include <stdint.h>
 
+/*------------------------------------------------------------------------------
+ *         Types
+ *------------------------------------------------------------------------------*/
+
+/** Entropy source: fill len bytes, return a negative error code on failure */
+typedef int (*rand_entropy_t)(void* buffer, uint32_t len);
+
 /*------------------------------------------------------------------------------
  *         Global Functions
  *------------------------------------------------------------------------------*/
@@ -52,4 +59,35 @@ extern void srand(uint32_t seed);
 
 extern uint32_t rand(void);
 
+/*
+ * Cryptographically secure generator: a ChaCha20 DRBG (see drbg.h) seeded
+ * and periodically reseeded from an entropy source, typically
+ * trng_pool_read(). These functions are not reentrant and must not be
+ * called from interrupt handlers.
+ */
+
+/**
+ * \brief Set the entropy source. The generator reseeds from it on the next
+ * request and then every 1MB of output.
+ */
+extern void rand_set_entropy_source(rand_entropy_t source);
+
+/**
+ * \brief Mix caller-provided seed material in the generator.
+ */
+extern void rand_add_entropy(const void* data, uint32_t len);
+
+/**
+ * \brief Fill a buffer with cryptographically secure random bytes.
+ * \return 0 on success, -ENODEV if the generator was never seeded, or the
+ * entropy source error code
+ */
+extern int rand_bytes(void* buffer, uint32_t len);
+
+/**
+ * \brief Get a cryptographically secure random 32-bit value (0 if the
+ * generator is not seeded).
+ */
+extern uint32_t rand_u32(void);
+
 #endif /* #ifndef _RAND_H */
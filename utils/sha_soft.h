@@ -0,0 +1,95 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef _SHA_SOFT_H_
+#define _SHA_SOFT_H_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdint.h>
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Largest state size in bytes (SHA-384/SHA-512) */
+#define SHA_SOFT_STATE_MAX 64
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+enum _sha_soft_algo {
+	SHA_SOFT_SHA1,
+	SHA_SOFT_SHA224,
+	SHA_SOFT_SHA256,
+	SHA_SOFT_SHA384,
+	SHA_SOFT_SHA512,
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/*
+ * Software SHA-1/SHA-2 compression functions. The state is kept as the
+ * big-endian bytes of the hash words, which is the layout of the SHA
+ * peripheral output registers, so that a state can move between the
+ * peripheral and the software implementation. The digest is the first
+ * bytes of the state after the padding blocks.
+ */
+
+/**
+ * \brief Get the block size of an algorithm (64 or 128 bytes).
+ */
+extern uint8_t sha_soft_block_size(enum _sha_soft_algo algo);
+
+/**
+ * \brief Get the state size of an algorithm (20, 32 or 64 bytes).
+ */
+extern uint8_t sha_soft_state_size(enum _sha_soft_algo algo);
+
+/**
+ * \brief Set the initial hash value of an algorithm.
+ */
+extern void sha_soft_init(enum _sha_soft_algo algo, uint8_t *state);
+
+/**
+ * \brief Process complete blocks.
+ * \param algo    Algorithm.
+ * \param state   State, updated.
+ * \param data    Blocks, no alignment constraint.
+ * \param blocks  Number of blocks.
+ */
+extern void sha_soft_blocks(enum _sha_soft_algo algo, uint8_t *state,
+		const uint8_t *data, uint32_t blocks);
+
+#endif /* _SHA_SOFT_H_ */
@@ -132,13 +132,8 @@ int _read(int file, char *ptr, int len)
 extern int _write(int file, char *ptr, int len);
 int _write(int file, char *ptr, int len)
 {
-	int i;
-
-	for (i = 0; i < len; i++, ptr++) {
-		console_put_char(*ptr);
-	}
-
-	return i;
+	console_put_buffer(ptr, len);
+	return len;
 }
 
 extern int _close(int file);
@@ -36,6 +36,7 @@
 #include "irq/irq.h"
 #include "peripherals/pmc.h"
 #include "peripherals/tc.h"
+#include "power/idle.h"
 #include "timer.h"
 
 /*----------------------------------------------------------------------------
@@ -47,6 +48,11 @@ struct _timer {
 	uint8_t channel;
 	uint32_t channel_freq;
 	volatile uint32_t upper;
+	uint64_t offset;
+	volatile bool events_pending;
+	bool deferred;
+	bool in_irq;
+	bool running;
 };
 
 /*----------------------------------------------------------------------------
@@ -56,6 +62,9 @@ struct _timer {
 /** System timer */
 static struct _timer _timer;
 
+/** Timer events, in ticks */
+static struct _timer_wheel _wheel;
+
 /*----------------------------------------------------------------------------
  *         Local Functions
  *----------------------------------------------------------------------------*/
@@ -65,6 +74,15 @@ static void timer_update_upper_tick_counter(void)
 	uint32_t status = tc_get_status(_timer.tc, _timer.channel);
 	if ((status & TC_SR_COVFS) == TC_SR_COVFS)
 		_timer.upper++;
+#ifndef CONFIG_TIMER_POLLING
+	/* Reading the status outside of the handler clears a compare match
+	 * before its interrupt is taken, set the compare again a few counts
+	 * ahead so the interrupt is raised anyway */
+	if ((status & TC_SR_CPCS) == TC_SR_CPCS && !_timer.in_irq) {
+		uint32_t rc = tc_get_cv(_timer.tc, _timer.channel) + 2;
+		tc_set_ra_rb_rc(_timer.tc, _timer.channel, NULL, NULL, &rc);
+	}
+#endif
 }
 
 static uint32_t timer_get_upper_tick_counter(void)
@@ -73,18 +91,6 @@ static uint32_t timer_get_upper_tick_counter(void)
 	return _timer.upper;
 }
 
-#ifndef CONFIG_TIMER_POLLING
-
-/**
- *  \brief Handler for timer interrupt.
- */
-static void timer_irq_handler(uint32_t source, void* user_arg)
-{
-	timer_update_upper_tick_counter();
-}
-
-#endif /* !CONFIG_TIMER_POLLING */
-
 static uint64_t _timer_get_tick(void)
 {
 	uint32_t upper, lower;
@@ -97,6 +103,75 @@ static uint64_t _timer_get_tick(void)
 	return (((uint64_t)upper) << TC_CHANNEL_SIZE) | lower;
 }
 
+/**
+ * \brief Program the RC compare for the next event processing.
+ * \return true if that processing is already due
+ */
+static bool _timer_arm_compare(void)
+{
+	uint64_t next = timer_wheel_next_tick(&_wheel);
+	uint64_t target;
+
+	if (next == UINT64_MAX) {
+#ifndef CONFIG_TIMER_POLLING
+		tc_disable_it(_timer.tc, _timer.channel, TC_IDR_CPCS);
+#endif
+		return false;
+	}
+
+	/* first counter value for which timer_get_tick() returns next */
+	target = (next * _timer.channel_freq + 999) / 1000;
+	target = target > _timer.offset ? target - _timer.offset : 0;
+
+#ifndef CONFIG_TIMER_POLLING
+	/* the compare only covers the current counter period, later targets
+	 * are armed again from the overflow interrupt */
+	if ((target >> TC_CHANNEL_SIZE) == timer_get_upper_tick_counter()) {
+		uint32_t rc = (uint32_t)target;
+		tc_set_ra_rb_rc(_timer.tc, _timer.channel, NULL, NULL, &rc);
+		tc_enable_it(_timer.tc, _timer.channel, TC_IER_CPCS);
+	} else {
+		tc_disable_it(_timer.tc, _timer.channel, TC_IDR_CPCS);
+	}
+#endif
+
+	return _timer_get_tick() >= target;
+}
+
+static uint32_t _timer_run_events(void)
+{
+	uint32_t count = 0;
+	uint32_t flags = arch_irq_save();
+
+	_timer.events_pending = false;
+	_timer.running = true;
+	do {
+		count += timer_wheel_advance(&_wheel, timer_get_tick());
+	} while (_timer_arm_compare());
+	_timer.running = false;
+
+	arch_irq_restore(flags);
+	return count;
+}
+
+#ifndef CONFIG_TIMER_POLLING
+
+/**
+ *  \brief Handler for timer interrupt.
+ */
+static void timer_irq_handler(uint32_t source, void* user_arg)
+{
+	_timer.in_irq = true;
+	timer_update_upper_tick_counter();
+	if (_timer.deferred)
+		_timer.events_pending = true;
+	else
+		_timer_run_events();
+	_timer.in_irq = false;
+}
+
+#endif /* !CONFIG_TIMER_POLLING */
+
 /*----------------------------------------------------------------------------
  *         Exported Functions
  *----------------------------------------------------------------------------*/
@@ -120,6 +195,7 @@ void timer_configure(Tc* tc, uint8_t channel, uint32_t clock_source)
 	tc_enable_it(tc, channel, TC_IER_COVFS);
 #endif
 	tc_start(tc, channel);
+	timer_wheel_init(&_wheel, timer_get_tick());
 }
 
 uint64_t timer_get_interval(uint64_t start, uint64_t end)
@@ -154,7 +230,105 @@ void timer_sleep(uint64_t count)
 
 uint64_t timer_get_tick(void)
 {
-	return (_timer_get_tick() * 1000) / _timer.channel_freq;
+	return ((_timer_get_tick() + _timer.offset) * 1000) / _timer.channel_freq;
+}
+
+uint64_t timer_get_time_us(void)
+{
+	return ((_timer_get_tick() + _timer.offset) * 1000000) / _timer.channel_freq;
+}
+
+void timer_compensate(uint32_t us)
+{
+	_timer.offset += ((uint64_t)us * _timer.channel_freq) / 1000000;
+}
+
+void timer_idle(void)
+{
+	uint32_t flags = arch_irq_save();
+	uint64_t start, next;
+	uint32_t expected, stopped;
+	enum _idle_state_id id;
+
+	if (_timer.events_pending) {
+		arch_irq_restore(flags);
+		return;
+	}
+
+	start = timer_get_time_us();
+	next = timer_get_next_event();
+	if (next == UINT64_MAX)
+		expected = UINT32_MAX;
+	else if (next * 1000 <= start)
+		expected = 0;
+	else if (next * 1000 - start < UINT32_MAX)
+		expected = next * 1000 - start;
+	else
+		expected = UINT32_MAX;
+
+	stopped = idle_enter(expected, &id);
+	if (stopped)
+		timer_compensate(stopped);
+	idle_account(id, timer_get_time_us() - start);
+
+	arch_irq_restore(flags);
+}
+
+void timer_add_event(struct _timer_event* event, uint64_t count)
+{
+	timer_add_event_at(event, timer_get_tick() + count);
+}
+
+void timer_add_event_at(struct _timer_event* event, uint64_t tick)
+{
+	uint32_t flags = arch_irq_save();
+
+	timer_wheel_add(&_wheel, event, tick);
+	/* already due: run it now unless events are being processed (the
+	 * processing loop catches it) or deferred */
+	if (_timer_arm_compare() && !_timer.running) {
+		if (_timer.deferred)
+			_timer.events_pending = true;
+		else
+			_timer_run_events();
+	}
+
+	arch_irq_restore(flags);
+}
+
+void timer_cancel_event(struct _timer_event* event)
+{
+	uint32_t flags = arch_irq_save();
+
+	timer_wheel_cancel(&_wheel, event);
+	_timer_arm_compare();
+
+	arch_irq_restore(flags);
+}
+
+void timer_set_deferred_events(bool deferred)
+{
+	_timer.deferred = deferred;
+}
+
+uint32_t timer_process_events(void)
+{
+#ifndef CONFIG_TIMER_POLLING
+	if (!_timer.events_pending &&
+	    timer_get_tick() < timer_get_next_event())
+		return 0;
+#endif
+	return _timer_run_events();
+}
+
+bool timer_events_pending(void)
+{
+	return _timer.events_pending;
+}
+
+uint64_t timer_get_next_event(void)
+{
+	return timer_wheel_next_tick(&_wheel);
 }
 
 void sleep(uint32_t count)
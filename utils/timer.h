@@ -34,9 +34,11 @@
  *         Headers
  *----------------------------------------------------------------------------*/
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #include "board.h"
+#include "timer_wheel.h"
 
 /*----------------------------------------------------------------------------
  *         Type definitions
@@ -105,6 +107,77 @@ extern uint64_t timer_get_interval(uint64_t start, uint64_t end);
  */
 extern uint64_t timer_get_tick(void);
 
+/**
+ * \brief Returns the time since the timer was configured, in microseconds
+ */
+extern uint64_t timer_get_time_us(void);
+
+/**
+ * \brief Account for time during which the TC did not count (deep idle
+ * states clocked from a stopped source).
+ *
+ * \param us  Time to add, in microseconds
+ */
+extern void timer_compensate(uint32_t us);
+
+/**
+ * \brief Tickless idle: sleep until the next timer event or any interrupt.
+ *
+ * The idle state is chosen from the time left before the next timer event
+ * (see power/idle.h) and the residency is recorded in the idle statistics.
+ * Call it from the main loop instead of cpu_idle().
+ */
+extern void timer_idle(void);
+
+/**
+ * \brief Schedule a timer event count ticks from now.
+ *
+ * The event must have been initialized with timer_event_init(). Its callback
+ * runs from the TC interrupt, or from timer_process_events() if deferred
+ * processing is selected or CONFIG_TIMER_POLLING is defined. Callbacks run
+ * with interrupts masked and may add or cancel events. A pending event is
+ * rescheduled.
+ */
+extern void timer_add_event(struct _timer_event* event, uint64_t count);
+
+/**
+ * \brief Schedule a timer event at an absolute tick (see timer_get_tick()).
+ */
+extern void timer_add_event_at(struct _timer_event* event, uint64_t tick);
+
+/**
+ * \brief Cancel a timer event, does nothing if it is not pending.
+ */
+extern void timer_cancel_event(struct _timer_event* event);
+
+/**
+ * \brief Select the context of the timer event callbacks.
+ *
+ * \param deferred  false to run the callbacks from the TC interrupt (default),
+ * true to only flag them from the interrupt and run them when the
+ * application calls timer_process_events().
+ */
+extern void timer_set_deferred_events(bool deferred);
+
+/**
+ * \brief Run the callbacks of the expired timer events and program the TC
+ * compare for the next one.
+ *
+ * \return the number of callbacks run
+ */
+extern uint32_t timer_process_events(void);
+
+/**
+ * \brief Tell if timer_process_events() has work to do (deferred mode).
+ */
+extern bool timer_events_pending(void);
+
+/**
+ * \brief Returns the tick of the next timer event processing, UINT64_MAX if
+ * no event is pending. The CPU may idle until this tick.
+ */
+extern uint64_t timer_get_next_event(void);
+
 /**
  *  \brief Wait for at least count seconds.
  */
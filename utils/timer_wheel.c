@@ -0,0 +1,246 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "compiler.h"
+#include "timer_wheel.h"
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static inline uint32_t _shift(uint32_t level)
+{
+	return level * TIMER_WHEEL_BITS;
+}
+
+/* index of the lowest bit set, mask must not be 0 */
+static inline uint32_t _lowest_bit(uint32_t mask)
+{
+	return 31 - CLZ(mask & -mask);
+}
+
+static void _unlink(struct _timer_wheel* wheel, struct _timer_event* event)
+{
+	*event->pprev = event->next;
+	if (event->next)
+		event->next->pprev = event->pprev;
+	event->next = NULL;
+	event->pprev = NULL;
+	if (!wheel->slots[event->level][event->slot])
+		wheel->bitmap[event->level] &= ~(1u << event->slot);
+}
+
+/*
+ * Put an event in the wheel, base is the next tick to be processed.
+ * The level is the first one where expiry and base agree on all the bits
+ * resolved by the upper levels, so the event slot is reached at or before
+ * the expiry.
+ */
+static void _place(struct _timer_wheel* wheel, struct _timer_event* event,
+		uint64_t base)
+{
+	uint64_t when = event->expires < base ? base : event->expires;
+	uint64_t diff = when ^ base;
+	uint32_t level, slot;
+	struct _timer_event** head;
+
+	for (level = 0; level < TIMER_WHEEL_LEVELS; level++)
+		if ((diff >> _shift(level + 1)) == 0)
+			break;
+
+	if (level == TIMER_WHEEL_LEVELS) {
+		/* the last level wraps: the slot is fine as long as the expiry
+		 * is less than one turn away, otherwise park the event in the
+		 * last slot to be reached and place it again from there */
+		level = TIMER_WHEEL_LEVELS - 1;
+		if ((when >> _shift(level)) - (base >> _shift(level)) >= TIMER_WHEEL_SLOTS)
+			when = ((base >> _shift(level)) - 1) << _shift(level);
+	}
+	slot = (when >> _shift(level)) & (TIMER_WHEEL_SLOTS - 1);
+
+	head = &wheel->slots[level][slot];
+	event->level = level;
+	event->slot = slot;
+	event->next = *head;
+	if (event->next)
+		event->next->pprev = &event->next;
+	event->pprev = head;
+	*head = event;
+	wheel->bitmap[level] |= 1u << slot;
+}
+
+/* Move the events of a slot to the lower levels */
+static void _cascade(struct _timer_wheel* wheel, uint32_t level, uint64_t tick)
+{
+	uint32_t slot = (tick >> _shift(level)) & (TIMER_WHEEL_SLOTS - 1);
+	struct _timer_event* event = wheel->slots[level][slot];
+
+	wheel->slots[level][slot] = NULL;
+	wheel->bitmap[level] &= ~(1u << slot);
+
+	while (event) {
+		struct _timer_event* next = event->next;
+		_place(wheel, event, tick);
+		event = next;
+	}
+}
+
+static uint32_t _expire(struct _timer_wheel* wheel, uint64_t tick)
+{
+	uint32_t slot = tick & (TIMER_WHEEL_SLOTS - 1);
+	struct _timer_event* head = wheel->slots[0][slot];
+	struct _timer_event* event;
+	uint32_t count = 0;
+
+	/* detach the list: callbacks may re-add events or cancel the ones
+	 * still in it */
+	wheel->slots[0][slot] = NULL;
+	wheel->bitmap[0] &= ~(1u << slot);
+	if (head)
+		head->pprev = &head;
+
+	while ((event = head) != NULL) {
+		_unlink(wheel, event);
+		wheel->count--;
+		callback_call(&event->cb, event);
+		count++;
+	}
+	return count;
+}
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+void timer_wheel_init(struct _timer_wheel* wheel, uint64_t now)
+{
+	uint32_t level, slot;
+
+	wheel->now = now;
+	wheel->count = 0;
+	for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+		wheel->bitmap[level] = 0;
+		for (slot = 0; slot < TIMER_WHEEL_SLOTS; slot++)
+			wheel->slots[level][slot] = NULL;
+	}
+}
+
+void timer_event_init(struct _timer_event* event,
+		callback_method_t method, void* arg)
+{
+	event->next = NULL;
+	event->pprev = NULL;
+	event->expires = 0;
+	callback_set(&event->cb, method, arg);
+}
+
+void timer_wheel_add(struct _timer_wheel* wheel,
+		struct _timer_event* event, uint64_t expires)
+{
+	if (timer_event_is_pending(event))
+		_unlink(wheel, event);
+	else
+		wheel->count++;
+
+	event->expires = expires;
+	_place(wheel, event, wheel->now + 1);
+}
+
+void timer_wheel_cancel(struct _timer_wheel* wheel,
+		struct _timer_event* event)
+{
+	if (!timer_event_is_pending(event))
+		return;
+
+	_unlink(wheel, event);
+	wheel->count--;
+}
+
+uint64_t timer_wheel_next_tick(const struct _timer_wheel* wheel)
+{
+	uint64_t next = UINT64_MAX;
+	uint32_t level;
+
+	if (!wheel->count)
+		return next;
+
+	for (level = 0; level < TIMER_WHEEL_LEVELS; level++) {
+		uint32_t bitmap = wheel->bitmap[level];
+		uint32_t cur, after;
+		uint64_t tick;
+
+		if (!bitmap)
+			continue;
+
+		/* slots after the current one belong to the current turn of
+		 * the level, the others to the next turn */
+		cur = (wheel->now >> _shift(level)) & (TIMER_WHEEL_SLOTS - 1);
+		after = cur < TIMER_WHEEL_SLOTS - 1 ? bitmap & (~0u << (cur + 1)) : 0;
+		tick = (wheel->now >> _shift(level + 1)) << _shift(level + 1);
+		if (after) {
+			tick += (uint64_t)_lowest_bit(after) << _shift(level);
+		} else {
+			tick += 1ull << _shift(level + 1);
+			tick += (uint64_t)_lowest_bit(bitmap) << _shift(level);
+		}
+		if (tick < next)
+			next = tick;
+	}
+	return next;
+}
+
+uint32_t timer_wheel_advance(struct _timer_wheel* wheel, uint64_t now)
+{
+	uint32_t count = 0;
+
+	while (wheel->now < now) {
+		uint64_t tick = timer_wheel_next_tick(wheel);
+		int level;
+
+		if (tick > now) {
+			wheel->now = now;
+			break;
+		}
+
+		/* events added by callbacks are relative to the next tick */
+		wheel->now = tick;
+		for (level = TIMER_WHEEL_LEVELS - 1; level > 0; level--)
+			if ((tick & ((1ull << _shift(level)) - 1)) == 0)
+				_cascade(wheel, level, tick);
+		count += _expire(wheel, tick);
+	}
+	return count;
+}
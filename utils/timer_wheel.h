@@ -0,0 +1,149 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef _TIMER_WHEEL_H_
+#define _TIMER_WHEEL_H_
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "callback.h"
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Number of bits of expiry time resolved by each level */
+#define TIMER_WHEEL_BITS 5
+
+/** Number of slots per level */
+#define TIMER_WHEEL_SLOTS (1u << TIMER_WHEEL_BITS)
+
+/** Number of levels, the wheel covers 2^25 ticks (more than 9 hours in ms),
+ * events further away are parked in the last level and re-inserted */
+#define TIMER_WHEEL_LEVELS 5
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+struct _timer_event {
+	struct _timer_event* next;
+	struct _timer_event** pprev;  /**< NULL when the event is not pending */
+	uint64_t expires;             /**< absolute expiry tick */
+	struct _callback cb;          /**< called with the event as arg2 */
+	uint8_t level;
+	uint8_t slot;
+};
+
+struct _timer_wheel {
+	uint64_t now;                 /**< last processed tick */
+	uint32_t count;               /**< number of pending events */
+	uint32_t bitmap[TIMER_WHEEL_LEVELS];
+	struct _timer_event* slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/*
+ * Hierarchical timing wheel: level n slots are 2^(5n) ticks wide. Adding and
+ * cancelling an event are O(1); an event is moved down at most once per level
+ * before it expires. The wheel has no notion of time source, the owner calls
+ * timer_wheel_advance() with the current tick (see utils/timer.c) and may skip
+ * ahead to timer_wheel_next_tick() when idle.
+ *
+ * The functions are not reentrant, callers serialize accesses (by masking the
+ * interrupt that advances the wheel). Callbacks may add or cancel events.
+ */
+
+/**
+ * \brief Initialize an empty wheel.
+ * \param wheel  wheel to initialize
+ * \param now    current tick
+ */
+extern void timer_wheel_init(struct _timer_wheel* wheel, uint64_t now);
+
+/**
+ * \brief Initialize an event before its first use.
+ * \param event   event to initialize
+ * \param method  function called on expiry, with arg and the event
+ * \param arg     user argument
+ */
+extern void timer_event_init(struct _timer_event* event,
+		callback_method_t method, void* arg);
+
+/**
+ * \brief Tell if an event is pending in a wheel.
+ */
+static inline bool timer_event_is_pending(const struct _timer_event* event)
+{
+	return event->pprev != NULL;
+}
+
+/**
+ * \brief Schedule an event at an absolute tick. A pending event is
+ * rescheduled. Events already expired are run on the next processed tick.
+ * \param wheel    wheel
+ * \param event    initialized event
+ * \param expires  absolute expiry tick
+ */
+extern void timer_wheel_add(struct _timer_wheel* wheel,
+		struct _timer_event* event, uint64_t expires);
+
+/**
+ * \brief Cancel a pending event, does nothing if it is not pending.
+ */
+extern void timer_wheel_cancel(struct _timer_wheel* wheel,
+		struct _timer_event* event);
+
+/**
+ * \brief Process all ticks up to now and run the callbacks of expired events.
+ * Ticks with nothing to do are skipped, so the cost does not depend on the
+ * time elapsed since the previous call.
+ * \param wheel  wheel
+ * \param now    current tick
+ * \return the number of callbacks run
+ */
+extern uint32_t timer_wheel_advance(struct _timer_wheel* wheel, uint64_t now);
+
+/**
+ * \brief Get the next tick at which timer_wheel_advance() has work to do.
+ * This is a lower bound of the next expiry: it may be a tick where events
+ * are only moved to a finer level.
+ * \return the tick, UINT64_MAX if no event is pending
+ */
+extern uint64_t timer_wheel_next_tick(const struct _timer_wheel* wheel);
+
+#endif /* _TIMER_WHEEL_H_ */
@@ -38,9 +38,158 @@
 #include "serial/console.h"
 #include "gpio/pio.h"
 
+#ifdef CONFIG_TRACE_BINARY
+#include <stdarg.h>
+#include <string.h>
+
+#include "timer.h"
+#endif
+
+/*------------------------------------------------------------------------------
+ *         Local definitions
+ *------------------------------------------------------------------------------*/
+
+#ifdef CONFIG_TRACE_BINARY
+
+/** Binary trace frame: sync bytes, payload length, payload, checksum */
+#define TRACE_SYNC0 0xFFu
+#define TRACE_SYNC1 0xA5u
+
+#define TRACE_MAX_PAYLOAD 128
+
+/** Maximum number of characters copied for a %s argument */
+#define TRACE_MAX_STRING 32
+
+#endif
+
 /*------------------------------------------------------------------------------
  *         Internal variables
  *------------------------------------------------------------------------------*/
 
 /** Current trace level */
 uint32_t trace_level = TRACE_LEVEL;
+
+/*------------------------------------------------------------------------------
+ *         Local functions
+ *------------------------------------------------------------------------------*/
+
+#ifdef CONFIG_TRACE_BINARY
+
+static bool _trace_put(uint8_t* payload, uint32_t* len, const void* data, uint32_t size)
+{
+	if (*len + size > TRACE_MAX_PAYLOAD)
+		return false;
+	memcpy(&payload[*len], data, size);
+	*len += size;
+	return true;
+}
+
+#endif
+
+/*------------------------------------------------------------------------------
+ *         Exported functions
+ *------------------------------------------------------------------------------*/
+
+#ifdef CONFIG_TRACE_BINARY
+
+void trace_binary(const char* fmt, ...)
+{
+	uint8_t frame[3 + TRACE_MAX_PAYLOAD + 1];
+	uint8_t* payload = &frame[3];
+	uint32_t len = 0;
+	uint32_t value, i;
+	uint8_t sum;
+	const char* p;
+	va_list ap;
+
+	/* little-endian target: the format address and tick are stored as-is */
+	value = (uint32_t)fmt;
+	_trace_put(payload, &len, &value, 4);
+	value = (uint32_t)timer_get_tick();
+	_trace_put(payload, &len, &value, 4);
+
+	/* walk the format string to know the size of each argument */
+	va_start(ap, fmt);
+	for (p = fmt; *p; p++) {
+		int lng = 0;
+		bool ok = true;
+
+		if (*p != '%')
+			continue;
+		p++;
+		if (*p == '%')
+			continue;
+
+		/* flags, width and precision */
+		while (*p && strchr("-+ #0123456789.*", *p)) {
+			if (*p == '*') {
+				value = va_arg(ap, int);
+				ok = _trace_put(payload, &len, &value, 4);
+			}
+			p++;
+		}
+
+		/* length modifiers */
+		while (*p && strchr("hlLjzt", *p)) {
+			if (*p == 'j')
+				lng = 2;
+			else if (*p == 'l' || *p == 'L')
+				lng++;
+			p++;
+		}
+
+		switch (*p) {
+		case 'd': case 'i': case 'u': case 'o':
+		case 'x': case 'X': case 'c': case 'p':
+			if (lng > 1) {
+				uint64_t v64 = va_arg(ap, uint64_t);
+				ok = _trace_put(payload, &len, &v64, 8);
+			} else {
+				value = va_arg(ap, uint32_t);
+				ok = _trace_put(payload, &len, &value, 4);
+			}
+			break;
+		case 'e': case 'E': case 'f': case 'F':
+		case 'g': case 'G': case 'a': case 'A':
+		{
+			double d = va_arg(ap, double);
+			ok = _trace_put(payload, &len, &d, 8);
+			break;
+		}
+		case 's':
+		{
+			const char* str = va_arg(ap, const char*);
+			uint8_t slen = 0;
+
+			if (!str)
+				str = "(null)";
+			while (slen < TRACE_MAX_STRING && str[slen])
+				slen++;
+			ok = _trace_put(payload, &len, &slen, 1) &&
+			     _trace_put(payload, &len, str, slen);
+			break;
+		}
+		case 'n':
+			(void)va_arg(ap, int*);
+			break;
+		default:
+			break;
+		}
+
+		/* truncated frames are still decodable up to the last argument */
+		if (!ok || !*p)
+			break;
+	}
+	va_end(ap);
+
+	frame[0] = TRACE_SYNC0;
+	frame[1] = TRACE_SYNC1;
+	frame[2] = len;
+	for (sum = 0, i = 0; i < len; i++)
+		sum += payload[i];
+	payload[len] = sum;
+
+	console_put_buffer(frame, len + 4);
+}
+
+#endif
@@ -57,6 +57,13 @@
  *     but which indicates there is a problem with the code.
  *  -# trace_fatal (1): Indicates a major error which prevents the program from going
  *     any further. Program will stop after the fatal trace message is displayed.
+ *
+ *  \par Binary traces
+ *  When built with CONFIG_TRACE_BINARY, trace_error(), trace_warning(),
+ *  trace_info() and trace_debug() do not format their message on target.
+ *  They emit a frame holding the address of the format string, a timestamp
+ *  and the raw arguments; scripts/trace_decode.py rebuilds the text from the
+ *  ELF file. Fatal traces and the "_wp" variants are always sent as text.
  */
 
 #ifndef _TRACE_H_
@@ -67,6 +74,7 @@
  * ----------------------------------------------------------------------------*/
 
 #include "compiler.h"
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdint.h>
 
@@ -93,6 +101,17 @@
 /** Trace level is modifable at runtime */
 extern uint32_t trace_level;
 
+#ifdef CONFIG_TRACE_BINARY
+/**
+ *  Outputs a binary trace frame for the given format string and arguments.
+ *  The format string must be a literal kept in the ELF file.
+ */
+extern void trace_binary(const char* fmt, ...);
+#define _trace_out(...) trace_binary(__VA_ARGS__)
+#else
+#define _trace_out(...) printf(__VA_ARGS__)
+#endif
+
 /* ------------------------------------------------------------------------------
  *         Exported functions
  * ----------------------------------------------------------------------------*/
@@ -117,7 +136,7 @@ extern uint32_t trace_level;
 
 #if (TRACE_LEVEL >= 2)
 #define trace_error(...) \
-	do { if (trace_level >= TRACE_LEVEL_ERROR) printf("-E- " __VA_ARGS__); } while (0)
+	do { if (trace_level >= TRACE_LEVEL_ERROR) _trace_out("-E- " __VA_ARGS__); } while (0)
 #define trace_error_wp(...) \
 	do { if (trace_level >= TRACE_LEVEL_ERROR) printf(__VA_ARGS__); } while (0)
 #else
@@ -127,7 +146,7 @@ extern uint32_t trace_level;
 
 #if (TRACE_LEVEL >= 3)
 #define trace_warning(...) \
-	do { if (trace_level >= TRACE_LEVEL_WARNING) printf("-W- " __VA_ARGS__); } while (0)
+	do { if (trace_level >= TRACE_LEVEL_WARNING) _trace_out("-W- " __VA_ARGS__); } while (0)
 #define trace_warning_wp(...) \
 	do { if (trace_level >= TRACE_LEVEL_WARNING) printf(__VA_ARGS__); } while (0)
 #else
@@ -137,7 +156,7 @@ extern uint32_t trace_level;
 
 #if (TRACE_LEVEL >= 4)
 #define trace_info(...) \
-	do { if (trace_level >= TRACE_LEVEL_INFO) printf("-I- " __VA_ARGS__); } while (0)
+	do { if (trace_level >= TRACE_LEVEL_INFO) _trace_out("-I- " __VA_ARGS__); } while (0)
 #define trace_info_wp(...) \
 	do { if (trace_level >= TRACE_LEVEL_INFO) printf(__VA_ARGS__); } while (0)
 #else
@@ -147,7 +166,7 @@ extern uint32_t trace_level;
 
 #if (TRACE_LEVEL >= 5)
 #define trace_debug(...) \
-	do { if (trace_level >= TRACE_LEVEL_DEBUG) printf("-D- " __FILE__ ":" STRINGIFY(__LINE__) " " __VA_ARGS__); } while (0)
+	do { if (trace_level >= TRACE_LEVEL_DEBUG) _trace_out("-D- " __FILE__ ":" STRINGIFY(__LINE__) " " __VA_ARGS__); } while (0)
 #define trace_debug_wp(...) \
 	do { if (trace_level >= TRACE_LEVEL_DEBUG) printf(__VA_ARGS__); } while (0)
 #else
@@ -34,7 +34,9 @@
  *----------------------------------------------------------------------------*/
 
 #include <stdio.h>
+#include <string.h>
 
+#include "errno.h"
 #include "wav.h"
 
 /*----------------------------------------------------------------------------
@@ -50,6 +52,40 @@
 /** WAV letters "fmt "*/
 #define WAV_SUBCHUNKID    0x20746D66
 
+/** Tail of the KSDATAFORMAT_SUBTYPE GUIDs, following the format code */
+static const uint8_t _wav_guid_tail[14] = {
+	0x00, 0x00, 0x00, 0x00, 0x10, 0x00, 0x80, 0x00,
+	0x00, 0xAA, 0x00, 0x38, 0x9B, 0x71,
+};
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static uint16_t _get_le16(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+static uint32_t _get_le32(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void _put_le16(uint8_t *p, uint16_t v)
+{
+	p[0] = v & 0xff;
+	p[1] = v >> 8;
+}
+
+static void _put_le32(uint8_t *p, uint32_t v)
+{
+	p[0] = v & 0xff;
+	p[1] = (v >> 8) & 0xff;
+	p[2] = (v >> 16) & 0xff;
+	p[3] = v >> 24;
+}
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -105,3 +141,66 @@ void wav_display_info(const struct _wav_header *header)
 	printf("  - Subchunk2 Size  = %u\n\r",
 			(unsigned int)header->subchunk2_size);
 }
+
+int wav_parse_format(const uint8_t *data, uint32_t size,
+		struct _wav_format *format)
+{
+	if (size < WAV_FMT_SIZE)
+		return -EINVAL;
+
+	format->audio_format = _get_le16(&data[0]);
+	format->num_channels = _get_le16(&data[2]);
+	format->sample_rate = _get_le32(&data[4]);
+	format->byte_rate = _get_le32(&data[8]);
+	format->block_align = _get_le16(&data[12]);
+	format->bits_per_sample = _get_le16(&data[14]);
+	format->valid_bits = format->bits_per_sample;
+	format->channel_mask = 0;
+
+	if (format->audio_format == WAV_FORMAT_EXTENSIBLE) {
+		/* cbSize, wValidBitsPerSample, dwChannelMask, SubFormat */
+		if (size < WAV_FMT_EXTENSIBLE_SIZE || _get_le16(&data[16]) < 22)
+			return -EINVAL;
+		format->valid_bits = _get_le16(&data[18]);
+		format->channel_mask = _get_le32(&data[20]);
+		format->audio_format = _get_le16(&data[24]);
+	}
+
+	if (format->num_channels == 0 || format->block_align == 0)
+		return -EINVAL;
+	if (format->valid_bits == 0
+	    || format->valid_bits > format->bits_per_sample)
+		format->valid_bits = format->bits_per_sample;
+
+	return 0;
+}
+
+uint32_t wav_build_format(const struct _wav_format *format, uint8_t *data)
+{
+	uint16_t block_align = format->num_channels *
+		((format->bits_per_sample + 7) / 8);
+	uint16_t valid_bits = format->valid_bits ?
+		format->valid_bits : format->bits_per_sample;
+	bool extensible = format->num_channels > 2
+		|| format->bits_per_sample > 16
+		|| valid_bits != format->bits_per_sample
+		|| format->channel_mask != 0;
+
+	_put_le16(&data[0], extensible ?
+			WAV_FORMAT_EXTENSIBLE : format->audio_format);
+	_put_le16(&data[2], format->num_channels);
+	_put_le32(&data[4], format->sample_rate);
+	_put_le32(&data[8], format->sample_rate * block_align);
+	_put_le16(&data[12], block_align);
+	_put_le16(&data[14], format->bits_per_sample);
+
+	if (!extensible)
+		return WAV_FMT_SIZE;
+
+	_put_le16(&data[16], WAV_FMT_EXTENSIBLE_SIZE - 18);
+	_put_le16(&data[18], valid_bits);
+	_put_le32(&data[20], format->channel_mask);
+	_put_le16(&data[24], format->audio_format);
+	memcpy(&data[26], _wav_guid_tail, sizeof(_wav_guid_tail));
+	return WAV_FMT_EXTENSIBLE_SIZE;
+}
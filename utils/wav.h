@@ -37,6 +37,23 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+/** Build a RIFF chunk identifier from its four characters */
+#define WAV_FOURCC(a, b, c, d) ((uint32_t)(a) | ((uint32_t)(b) << 8) | \
+		((uint32_t)(c) << 16) | ((uint32_t)(d) << 24))
+
+/** Format codes, found in the "fmt " chunk or in the extensible sub-format */
+#define WAV_FORMAT_PCM          0x0001
+#define WAV_FORMAT_IEEE_FLOAT   0x0003
+#define WAV_FORMAT_EXTENSIBLE   0xFFFE
+
+/** Size of a "fmt " chunk payload, basic and extensible layouts */
+#define WAV_FMT_SIZE            16
+#define WAV_FMT_EXTENSIBLE_SIZE 40
+
 /*----------------------------------------------------------------------------
  *        Types
  *----------------------------------------------------------------------------*/
@@ -71,6 +88,26 @@ struct _wav_header {
 	uint32_t subchunk2_size;
 };
 
+/** Audio format, as described by a "fmt " chunk of any layout. */
+struct _wav_format {
+	/** Format code, the sub-format for extensible files */
+	uint16_t audio_format;
+	/** Number of interleaved channels */
+	uint16_t num_channels;
+	/** Frames per second */
+	uint32_t sample_rate;
+	/** Bytes per second */
+	uint32_t byte_rate;
+	/** Bytes per frame */
+	uint16_t block_align;
+	/** Container size of a sample, in bits */
+	uint16_t bits_per_sample;
+	/** Significant bits of a sample (extensible layout, else bits_per_sample) */
+	uint16_t valid_bits;
+	/** Speaker position mask (extensible layout, else 0) */
+	uint32_t channel_mask;
+};
+
 /*----------------------------------------------------------------------------
  *        Exported functions
  *----------------------------------------------------------------------------*/
@@ -79,4 +116,27 @@ extern bool wav_is_valid(const struct _wav_header *header);
 
 extern void wav_display_info(const struct _wav_header *header);
 
+/**
+ * \brief Decode the payload of a "fmt " chunk (basic, WAVEFORMATEX or
+ * WAVEFORMATEXTENSIBLE layout).
+ * \param data    Chunk payload, without the 8-byte chunk header
+ * \param size    Size of the payload
+ * \param format  Decoded format
+ * \return 0 on success, -EINVAL if the chunk is malformed
+ */
+extern int wav_parse_format(const uint8_t *data, uint32_t size,
+		struct _wav_format *format);
+
+/**
+ * \brief Encode the payload of a "fmt " chunk. The extensible layout is
+ * used when the format cannot be described by the basic one (more than two
+ * channels, more than 16 bits, padded samples or channel mask set).
+ * \param format  Format to encode, byte_rate and block_align are computed
+ * \param data    Output buffer, WAV_FMT_EXTENSIBLE_SIZE bytes
+ * \return Size of the payload written (WAV_FMT_SIZE or
+ * WAV_FMT_EXTENSIBLE_SIZE)
+ */
+extern uint32_t wav_build_format(const struct _wav_format *format,
+		uint8_t *data);
+
 #endif /* #ifndef WAV_H */
@@ -0,0 +1,435 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <string.h>
+
+#include "compiler.h"
+#include "errno.h"
+#include "intmath.h"
+#include "wav_file.h"
+
+/*----------------------------------------------------------------------------
+ *        Definitions
+ *----------------------------------------------------------------------------*/
+
+#define WAV_ID_RIFF WAV_FOURCC('R', 'I', 'F', 'F')
+#define WAV_ID_WAVE WAV_FOURCC('W', 'A', 'V', 'E')
+#define WAV_ID_FMT  WAV_FOURCC('f', 'm', 't', ' ')
+#define WAV_ID_FACT WAV_FOURCC('f', 'a', 'c', 't')
+#define WAV_ID_LIST WAV_FOURCC('L', 'I', 'S', 'T')
+#define WAV_ID_JUNK WAV_FOURCC('J', 'U', 'N', 'K')
+#define WAV_ID_DATA WAV_FOURCC('d', 'a', 't', 'a')
+
+/** Largest header written by wav_file_create(), JUNK chunk header included */
+#define WAV_HEADER_MAX_SIZE (12 + 8 + WAV_FMT_EXTENSIBLE_SIZE + 12 + 8)
+
+/*----------------------------------------------------------------------------
+ *        Local functions
+ *----------------------------------------------------------------------------*/
+
+static uint32_t _get_le32(const uint8_t *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void _put_le32(uint8_t *p, uint32_t v)
+{
+	p[0] = v & 0xff;
+	p[1] = (v >> 8) & 0xff;
+	p[2] = (v >> 16) & 0xff;
+	p[3] = v >> 24;
+}
+
+static int _fs_error(FRESULT res)
+{
+	switch (res) {
+	case FR_OK:
+		return 0;
+	case FR_NO_FILE:
+	case FR_NO_PATH:
+		return -ENOENT;
+	case FR_INVALID_NAME:
+	case FR_INVALID_PARAMETER:
+		return -EINVAL;
+	case FR_WRITE_PROTECTED:
+		return -EROFS;
+	default:
+		return -EIO;
+	}
+}
+
+static uint32_t _cluster_size(const FIL *file)
+{
+	const FATFS *fs = file->obj.fs;
+#if _MAX_SS == _MIN_SS
+	return fs->csize * _MAX_SS;
+#else
+	return fs->csize * fs->ssize;
+#endif
+}
+
+static int _read_at(FIL *file, uint32_t offset, void *buffer, uint32_t size)
+{
+	FRESULT res;
+	UINT br;
+
+	res = f_lseek(file, offset);
+	if (res == FR_OK)
+		res = f_read(file, buffer, size, &br);
+	if (res != FR_OK)
+		return _fs_error(res);
+	return br == size ? 0 : -EINVAL;
+}
+
+static int _parse_chunks(struct _wav_file *wav)
+{
+	FIL *file = wav->file;
+	uint32_t file_size = f_size(file);
+	uint32_t offset = 12;
+	bool have_format = false;
+	uint8_t buf[WAV_FMT_EXTENSIBLE_SIZE];
+	int err;
+
+	err = _read_at(file, 0, buf, 12);
+	if (err < 0)
+		return err;
+	if (_get_le32(&buf[0]) != WAV_ID_RIFF
+	    || _get_le32(&buf[8]) != WAV_ID_WAVE)
+		return -EINVAL;
+
+	while (offset + 8 <= file_size) {
+		uint32_t id, size, payload;
+
+		err = _read_at(file, offset, buf, 8);
+		if (err < 0)
+			return err;
+		id = _get_le32(&buf[0]);
+		size = _get_le32(&buf[4]);
+		payload = offset + 8;
+
+		switch (id) {
+		case WAV_ID_FMT:
+			err = _read_at(file, payload, buf,
+					min_u32(size, sizeof(buf)));
+			if (err < 0)
+				return err;
+			err = wav_parse_format(buf, min_u32(size, sizeof(buf)),
+					&wav->format);
+			if (err < 0)
+				return err;
+			have_format = true;
+			break;
+
+		case WAV_ID_FACT:
+			if (size < 4)
+				break;
+			err = _read_at(file, payload, buf, 4);
+			if (err < 0)
+				return err;
+			wav->fact_frames = _get_le32(buf);
+			wav->fact_offset = payload;
+			break;
+
+		case WAV_ID_LIST:
+			wav->list_offset = payload;
+			wav->list_size = size;
+			break;
+
+		case WAV_ID_DATA:
+			if (!have_format)
+				return -EINVAL;
+			if (size == 0 || size > file_size - payload)
+				size = file_size - payload;
+			wav->data_offset = payload;
+			wav->data_size = size;
+			return _fs_error(f_lseek(file, payload));
+
+		default:
+			break;
+		}
+
+		/* chunks are padded to an even size */
+		if (size > file_size - payload)
+			break;
+		offset = payload + size + (size & 1);
+	}
+
+	return -EINVAL;
+}
+
+#if !_FS_READONLY
+
+static int _write_at(FIL *file, uint32_t offset, const void *buffer,
+		uint32_t size)
+{
+	FRESULT res;
+	UINT bw;
+
+	res = f_lseek(file, offset);
+	if (res == FR_OK)
+		res = f_write(file, buffer, size, &bw);
+	if (res != FR_OK)
+		return _fs_error(res);
+	return bw == size ? 0 : -ENOSPC;
+}
+
+static int _write_le32_at(FIL *file, uint32_t offset, uint32_t value)
+{
+	uint8_t buf[4];
+
+	_put_le32(buf, value);
+	return _write_at(file, offset, buf, sizeof(buf));
+}
+
+#endif /* !_FS_READONLY */
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+int wav_file_open(struct _wav_file *wav, FIL *file, const TCHAR *path)
+{
+	FRESULT res;
+	int err;
+
+	memset(wav, 0, sizeof(*wav));
+	wav->file = file;
+
+	res = f_open(file, path, FA_READ);
+	if (res != FR_OK)
+		return _fs_error(res);
+
+	wav->block_size = _cluster_size(file);
+
+	err = _parse_chunks(wav);
+	if (err < 0)
+		f_close(file);
+	return err;
+}
+
+int wav_file_read(struct _wav_file *wav, void *buffer, uint32_t size,
+		uint32_t *read)
+{
+	uint32_t misalign;
+	FRESULT res;
+	UINT br;
+
+	*read = 0;
+	size = min_u32(size, wav->data_size - wav->position);
+	if (size == 0)
+		return 0;
+
+	/* keep the file position on block boundaries so that FatFs reads
+	 * whole sectors directly into the buffer */
+	misalign = (wav->data_offset + wav->position) % wav->block_size;
+	if (misalign)
+		size = min_u32(size, wav->block_size - misalign);
+	else if (size >= wav->block_size)
+		size -= size % wav->block_size;
+
+	res = f_read(wav->file, buffer, size, &br);
+	if (res != FR_OK)
+		return _fs_error(res);
+
+	wav->position += br;
+	*read = br;
+	return 0;
+}
+
+int wav_file_seek(struct _wav_file *wav, uint32_t frame)
+{
+	uint32_t offset;
+	FRESULT res;
+
+	/* block_align is never 0 once the format chunk is parsed, check the
+	 * frame before multiplying so the offset cannot wrap */
+	if (frame > wav->data_size / wav->format.block_align)
+		return -EINVAL;
+	offset = frame * wav->format.block_align;
+
+	res = f_lseek(wav->file, wav->data_offset + offset);
+	if (res != FR_OK)
+		return _fs_error(res);
+
+	wav->position = offset;
+	return 0;
+}
+
+#if !_FS_READONLY
+
+int wav_file_create(struct _wav_file *wav, FIL *file,
+		const TCHAR *path, const struct _wav_format *format,
+		uint32_t align)
+{
+	uint8_t hdr[WAV_HEADER_MAX_SIZE];
+	uint32_t len, fmt_size;
+	FRESULT res;
+	int err;
+
+	if (format->num_channels == 0 || format->bits_per_sample == 0)
+		return -EINVAL;
+	if (align && !IS_POWER_OF_TWO(align))
+		return -EINVAL;
+
+	memset(wav, 0, sizeof(*wav));
+	wav->file = file;
+	wav->writing = true;
+
+	res = f_open(file, path, FA_WRITE | FA_CREATE_ALWAYS);
+	if (res != FR_OK)
+		return _fs_error(res);
+
+	wav->block_size = _cluster_size(file);
+	if (align == 0)
+		align = wav->block_size;
+
+	/* RIFF header and format chunk */
+	_put_le32(&hdr[0], WAV_ID_RIFF);
+	_put_le32(&hdr[4], 0);
+	_put_le32(&hdr[8], WAV_ID_WAVE);
+	_put_le32(&hdr[12], WAV_ID_FMT);
+	fmt_size = wav_build_format(format, &hdr[20]);
+	_put_le32(&hdr[16], fmt_size);
+	err = wav_parse_format(&hdr[20], fmt_size, &wav->format);
+	if (err < 0) {
+		/* block_align does not fit in 16 bits */
+		f_close(file);
+		return err;
+	}
+	len = 20 + fmt_size;
+
+	/* non-PCM formats require a fact chunk */
+	if (wav->format.audio_format != WAV_FORMAT_PCM) {
+		_put_le32(&hdr[len], WAV_ID_FACT);
+		_put_le32(&hdr[len + 4], 4);
+		_put_le32(&hdr[len + 8], 0);
+		wav->fact_offset = len + 8;
+		len += 12;
+	}
+
+	/* JUNK chunk padding the header up to the data alignment, the
+	 * padding itself is allocated but not written */
+	wav->data_offset = ROUND_UP_MULT(len + 16, align);
+	_put_le32(&hdr[len], WAV_ID_JUNK);
+	_put_le32(&hdr[len + 4], wav->data_offset - len - 16);
+	len += 8;
+
+	err = _write_at(file, 0, hdr, len);
+	if (err == 0) {
+		_put_le32(&hdr[0], WAV_ID_DATA);
+		_put_le32(&hdr[4], 0);
+		err = _write_at(file, wav->data_offset - 8, hdr, 8);
+	}
+	if (err < 0)
+		f_close(file);
+	return err;
+}
+
+int wav_file_write(struct _wav_file *wav, const void *buffer,
+		uint32_t size, uint32_t *written)
+{
+	FRESULT res;
+	UINT bw;
+
+	if (written)
+		*written = 0;
+	if (!wav->writing)
+		return -EINVAL;
+
+	res = f_write(wav->file, buffer, size, &bw);
+	if (res != FR_OK)
+		return _fs_error(res);
+
+	wav->position += bw;
+	wav->data_size = max_u32(wav->data_size, wav->position);
+	if (written)
+		*written = bw;
+	return bw == size ? 0 : -ENOSPC;
+}
+
+int wav_file_sync(struct _wav_file *wav)
+{
+	FIL *file = wav->file;
+	uint32_t pos = f_tell(file);
+	uint32_t riff_size;
+	int err;
+
+	if (!wav->writing)
+		return 0;
+
+	riff_size = wav->data_offset + wav->data_size +
+		(wav->data_size & 1) - 8;
+	err = _write_le32_at(file, 4, riff_size);
+	if (err == 0)
+		err = _write_le32_at(file, wav->data_offset - 4,
+				wav->data_size);
+	if (err == 0 && wav->fact_offset) {
+		wav->fact_frames = wav->data_size / wav->format.block_align;
+		err = _write_le32_at(file, wav->fact_offset,
+				wav->fact_frames);
+	}
+	if (err < 0)
+		return err;
+
+	err = _fs_error(f_lseek(file, pos));
+	if (err < 0)
+		return err;
+	return _fs_error(f_sync(file));
+}
+
+#endif /* !_FS_READONLY */
+
+int wav_file_close(struct _wav_file *wav)
+{
+	int err = 0;
+	FRESULT res;
+
+#if !_FS_READONLY
+	if (wav->writing) {
+		/* odd sized chunks are followed by a pad byte */
+		if (wav->data_size & 1) {
+			uint8_t pad = 0;
+			err = _write_at(wav->file,
+					wav->data_offset + wav->data_size,
+					&pad, 1);
+		}
+		if (err == 0)
+			err = wav_file_sync(wav);
+	}
+#endif
+
+	res = f_close(wav->file);
+	if (err == 0)
+		err = _fs_error(res);
+	return err;
+}
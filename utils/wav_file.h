@@ -0,0 +1,183 @@
+/* ----------------------------------------------------------------------------
+ *         SAM Software Package License
+ * ----------------------------------------------------------------------------
+ * Copyright (c) 2019, Atmel Corporation
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ * - Redistributions of source code must retain the above copyright notice,
+ * this list of conditions and the disclaimer below.
+ *
+ * Atmel's name may not be used to endorse or promote products derived from
+ * this software without specific prior written permission.
+ *
+ * DISCLAIMER: THIS SOFTWARE IS PROVIDED BY ATMEL "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NON-INFRINGEMENT ARE
+ * DISCLAIMED. IN NO EVENT SHALL ATMEL BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA,
+ * OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+ * EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ * ----------------------------------------------------------------------------
+ */
+
+#ifndef WAV_FILE_H
+#define WAV_FILE_H
+
+/*----------------------------------------------------------------------------
+ *        Headers
+ *----------------------------------------------------------------------------*/
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "fatfs/src/ff.h"
+
+#include "wav.h"
+
+/*----------------------------------------------------------------------------
+ *        Types
+ *----------------------------------------------------------------------------*/
+
+/**
+ * WAV file being streamed from or to a FatFs volume.
+ *
+ * Audio data is transferred in blocks of the volume cluster size, aligned on
+ * cluster boundaries in the file. FatFs then moves whole sectors directly
+ * between the disk and the caller buffer (no copy through the file window),
+ * so the buffers given to wav_file_read() and wav_file_write() are accessed
+ * by the SD/MMC DMA: they must be CACHE_ALIGNED and a multiple of
+ * L1_CACHE_BYTES long.
+ */
+struct _wav_file {
+	/** FatFs file object, provided by the caller */
+	FIL *file;
+	/** Audio format */
+	struct _wav_format format;
+	/** File offset of the first byte of audio data */
+	uint32_t data_offset;
+	/** Size of the audio data, in bytes */
+	uint32_t data_size;
+	/** Read/write position in the audio data, in bytes */
+	uint32_t position;
+	/** Frame count from the "fact" chunk, 0 if absent */
+	uint32_t fact_frames;
+	/** File offset of the "fact" frame count, 0 if absent */
+	uint32_t fact_offset;
+	/** File offset of the "LIST" chunk payload, 0 if absent */
+	uint32_t list_offset;
+	/** Size of the "LIST" chunk payload */
+	uint32_t list_size;
+	/** I/O block size, in bytes (cluster size of the volume) */
+	uint32_t block_size;
+	/** True if the file was created by wav_file_create() */
+	bool writing;
+};
+
+/*----------------------------------------------------------------------------
+ *        Exported functions
+ *----------------------------------------------------------------------------*/
+
+/**
+ * \brief Open a WAV file and parse its chunks.
+ *
+ * Chunks are walked until the "data" chunk: "fmt " (basic or extensible
+ * layout), "fact" and "LIST" are recorded, unknown chunks are skipped. A data
+ * chunk size of 0 or 0xFFFFFFFF (file left unfinalized by a recorder) is
+ * replaced by the remaining file size.
+ *
+ * \param wav   Pointer to the WAV file state
+ * \param file  FatFs file object to use
+ * \param path  Path of the file
+ * \return 0 on success, -ENOENT if the file does not exist, -EINVAL if it is
+ * not a valid WAV file, -EIO on other FatFs errors
+ */
+extern int wav_file_open(struct _wav_file *wav, FIL *file, const TCHAR *path);
+
+/**
+ * \brief Read audio data.
+ *
+ * The amount read may be smaller than requested: a read starting off a block
+ * boundary stops at the next boundary, and a read starting on a boundary is
+ * rounded down to a whole number of blocks, so that the following reads are
+ * aligned. 0 bytes read means the end of the data.
+ *
+ * \param wav     Pointer to the WAV file state
+ * \param buffer  Destination buffer (see struct _wav_file)
+ * \param size    Size of the buffer, in bytes
+ * \param read    Returns the number of bytes read
+ * \return 0 on success, -EIO on FatFs error
+ */
+extern int wav_file_read(struct _wav_file *wav, void *buffer, uint32_t size,
+		uint32_t *read);
+
+/**
+ * \brief Move the read/write position.
+ * \param wav    Pointer to the WAV file state
+ * \param frame  Index of the frame to move to
+ * \return 0 on success, -EINVAL if the frame is past the end of the data,
+ * -EIO on FatFs error
+ */
+extern int wav_file_seek(struct _wav_file *wav, uint32_t frame);
+
+#if !_FS_READONLY
+
+/**
+ * \brief Create a WAV file and write its header.
+ *
+ * The header is padded with a "JUNK" chunk so that the audio data starts on
+ * an \a align boundary. The chunk sizes are left at 0 and filled in by
+ * wav_file_sync() and wav_file_close().
+ *
+ * \param wav     Pointer to the WAV file state
+ * \param file    FatFs file object to use
+ * \param path    Path of the file, an existing file is overwritten
+ * \param format  Audio format of the data
+ * \param align   Alignment of the audio data in the file, power of two; 0 to
+ *                align on the cluster size of the volume
+ * \return 0 on success, -EINVAL on invalid parameter, -EIO on FatFs error
+ */
+extern int wav_file_create(struct _wav_file *wav, FIL *file,
+		const TCHAR *path, const struct _wav_format *format,
+		uint32_t align);
+
+/**
+ * \brief Append audio data.
+ *
+ * Writing whole blocks keeps the file position on block boundaries and lets
+ * FatFs write directly from \a buffer.
+ *
+ * \param wav      Pointer to the WAV file state
+ * \param buffer   Source buffer (see struct _wav_file)
+ * \param size     Number of bytes to write
+ * \param written  Returns the number of bytes written (optional)
+ * \return 0 on success, -ENOSPC if the volume is full, -EIO on FatFs error
+ */
+extern int wav_file_write(struct _wav_file *wav, const void *buffer,
+		uint32_t size, uint32_t *written);
+
+/**
+ * \brief Update the chunk sizes in the header and flush the file, so that
+ * the data recorded so far survives a power loss.
+ * \param wav  Pointer to the WAV file state
+ * \return 0 on success, -EIO on FatFs error
+ */
+extern int wav_file_sync(struct _wav_file *wav);
+
+#endif /* !_FS_READONLY */
+
+/**
+ * \brief Close a WAV file. For a file being written, the header is updated
+ * first.
+ * \param wav  Pointer to the WAV file state
+ * \return 0 on success, -EIO on FatFs error
+ */
+extern int wav_file_close(struct _wav_file *wav);
+
+#endif /* #ifndef WAV_FILE_H */